@@ -55,6 +55,31 @@ android {
         compose = true
     }
     
+    // Host extraction harness (ExtractionHarnessTest): the host-built
+    // libmedextract, where to write the report and the baseline it's
+    // compared against, if one has been kept, and the shipped lexicon CSV
+    testOptions {
+        unitTests.all {
+            it.systemProperty("java.library.path", rootProject.file("build-tools").absolutePath)
+            it.systemProperty(
+                "extraction.harness.report",
+                layout.buildDirectory.file("reports/extraction-harness.json").get().asFile.absolutePath
+            )
+            it.systemProperty(
+                "extraction.harness.baseline",
+                rootProject.file("test_transcripts/extraction_baseline.json").absolutePath
+            )
+            it.systemProperty(
+                "medication.vocabulary",
+                file("src/main/cpp/tools/medication_vocabulary.txt").absolutePath
+            )
+            it.systemProperty(
+                "medication.lexicon",
+                file("src/main/assets/medication_lexicon.csv").absolutePath
+            )
+        }
+    }
+    
     externalNativeBuild {
         cmake {
             path = file("src/main/cpp/CMakeLists.txt")
@@ -91,6 +116,34 @@ android {
     }
 }
 
+// Host libmedextract for the JVM unit tests, built into build-tools (the
+// java.library.path above) before any test task runs. Needs cmake, a C++
+// compiler and a JDK on the build machine; the test task fails without them.
+val hostToolsDir = rootProject.file("build-tools")
+
+val configureHostExtraction by tasks.registering(Exec::class) {
+    commandLine(
+        "cmake", "-S", file("src/main/cpp/tools").absolutePath,
+        "-B", hostToolsDir.absolutePath, "-DCMAKE_BUILD_TYPE=Release"
+    )
+}
+
+val buildHostExtraction by tasks.registering(Exec::class) {
+    dependsOn(configureHostExtraction)
+    commandLine("cmake", "--build", hostToolsDir.absolutePath, "--target", "medextract")
+}
+
+tasks.withType<Test>().configureEach {
+    dependsOn(buildHostExtraction)
+}
+
+// Keeps the last harness report as the baseline later runs are compared with
+val updateExtractionBaseline by tasks.registering(Copy::class) {
+    from(layout.buildDirectory.file("reports/extraction-harness.json"))
+    into(rootProject.file("test_transcripts"))
+    rename { "extraction_baseline.json" }
+}
+
 dependencies {
     implementation(libs.androidx.core.ktx)
     implementation(libs.androidx.lifecycle.runtime.ktx)
@@ -115,6 +168,8 @@ dependencies {
     implementation("com.squareup.okhttp3:okhttp:4.12.0")
     
     testImplementation(libs.junit)
+    // Real org.json for the harness report (android.jar only has stubs)
+    testImplementation("org.json:json:20240303")
     androidTestImplementation(libs.androidx.junit)
     androidTestImplementation(libs.androidx.espresso.core)
     androidTestImplementation(platform(libs.androidx.compose.bom))
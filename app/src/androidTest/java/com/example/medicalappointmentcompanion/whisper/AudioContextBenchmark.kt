@@ -0,0 +1,139 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import android.os.SystemClock
+import android.util.Log
+import com.example.medicalappointmentcompanion.audio.WHISPER_SAMPLE_RATE
+import com.example.medicalappointmentcompanion.audio.WaveHelper
+import java.io.File
+
+private const val LOG_TAG = "AudioContextBenchmark"
+
+/**
+ * Latency vs. accuracy of reduced encoder windows on short clips
+ *
+ * Each clip is a WAV file with a sibling .txt holding its reference
+ * transcript. Every clip is transcribed at the full window, in adaptive
+ * mode and at a few fixed audio_ctx sizes; the report gives mean latency,
+ * mean encoder time and word error rate per setting.
+ */
+object AudioContextBenchmark {
+
+    /**
+     * audio_ctx settings compared by default
+     */
+    val DEFAULT_SETTINGS = listOf(
+        WhisperContext.AUDIO_CTX_FULL,
+        WhisperContext.AUDIO_CTX_ADAPTIVE,
+        768,
+        512,
+        384
+    )
+
+    data class Clip(
+        val name: String,
+        val samples: FloatArray,
+        val reference: String
+    )
+
+    /**
+     * Load every `<name>.wav` in [dir] that has a matching `<name>.txt`
+     */
+    fun loadClips(dir: File): List<Clip> =
+        dir.listFiles { file -> file.extension == "wav" }
+            ?.sortedBy { it.name }
+            ?.mapNotNull { wav ->
+                val reference = File(dir, "${wav.nameWithoutExtension}.txt")
+                if (!reference.exists()) {
+                    Log.w(LOG_TAG, "Skipping ${wav.name}: no reference transcript")
+                    return@mapNotNull null
+                }
+                Clip(wav.nameWithoutExtension, WaveHelper.decodeWaveFile(wav), reference.readText())
+            }
+            ?: emptyList()
+
+    /**
+     * Transcribe every clip under each setting and report the trade-off
+     */
+    suspend fun run(
+        context: WhisperContext,
+        clips: List<Clip>,
+        settings: List<Int> = DEFAULT_SETTINGS
+    ): String {
+        require(clips.isNotEmpty()) { "No benchmark clips" }
+
+        // Untimed pass so the first measured setting doesn't pay for cold caches
+        context.transcribeWithSegments(clips.first().samples)
+
+        val meanSeconds = clips.sumOf { it.samples.size } / clips.size.toFloat() / WHISPER_SAMPLE_RATE
+
+        return buildString {
+            append(String.format("audio_ctx bench: %d clips, mean %.1fs\n", clips.size, meanSeconds))
+            append(String.format("%-10s %10s %10s %8s %8s\n", "audio_ctx", "total ms", "encode ms", "WER", "retries"))
+
+            for (setting in settings) {
+                var totalMs = 0f
+                var encodeMs = 0f
+                var errors = 0
+                var words = 0
+                var retries = 0
+
+                for (clip in clips) {
+                    val start = SystemClock.elapsedRealtime()
+                    val segments = context.transcribeWithSegments(clip.samples, audioCtx = setting)
+                    totalMs += SystemClock.elapsedRealtime() - start
+
+                    val timings = context.getTimings()
+                    encodeMs += timings.encodeMs
+                    retries += timings.audioCtxRetries
+
+                    val (clipErrors, clipWords) = wordErrors(clip.reference, segments.joinToString(" ") { it.text })
+                    errors += clipErrors
+                    words += clipWords
+                }
+
+                val label = when (setting) {
+                    WhisperContext.AUDIO_CTX_FULL -> "full"
+                    WhisperContext.AUDIO_CTX_ADAPTIVE -> "adaptive"
+                    else -> setting.toString()
+                }
+                append(String.format(
+                    "%-10s %10.1f %10.1f %7.1f%% %8d\n",
+                    label,
+                    totalMs / clips.size,
+                    encodeMs / clips.size,
+                    100f * errors / words.coerceAtLeast(1),
+                    retries
+                ))
+            }
+        }
+    }
+
+    /**
+     * Word-level edit distance between normalised transcripts,
+     * returned with the reference word count
+     */
+    fun wordErrors(reference: String, hypothesis: String): Pair<Int, Int> {
+        val ref = normalize(reference)
+        val hyp = normalize(hypothesis)
+
+        var prev = IntArray(hyp.size + 1) { it }
+        var curr = IntArray(hyp.size + 1)
+        for (i in 1..ref.size) {
+            curr[0] = i
+            for (j in 1..hyp.size) {
+                val substitution = prev[j - 1] + if (ref[i - 1] == hyp[j - 1]) 0 else 1
+                curr[j] = minOf(substitution, prev[j] + 1, curr[j - 1] + 1)
+            }
+            val tmp = prev
+            prev = curr
+            curr = tmp
+        }
+        return prev[hyp.size] to ref.size
+    }
+
+    private fun normalize(text: String): List<String> =
+        text.lowercase()
+            .replace(Regex("[^a-z0-9' ]"), " ")
+            .split(' ')
+            .filter { it.isNotBlank() }
+}
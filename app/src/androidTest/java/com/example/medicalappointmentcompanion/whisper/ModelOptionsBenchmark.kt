@@ -0,0 +1,138 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import android.util.Log
+import com.example.medicalappointmentcompanion.audio.WHISPER_SAMPLE_RATE
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+
+private const val LOG_TAG = "ModelOptionsBenchmark"
+
+/**
+ * Speed and memory of each [ModelOptions] under each decoding strategy
+ *
+ * Runs the [AudioContextBenchmark] clips at the full encoder window: for
+ * every options value the model is loaded afresh and warmed up, then all
+ * clips are transcribed once per decoding strategy. The report gives the
+ * real-time factor (processing time / audio time), mean encode and decode
+ * time, WER, the resident memory the model adds and the peak during the
+ * run, each with its delta to the first options value under the same
+ * decoding.
+ */
+object ModelOptionsBenchmark {
+
+    val DEFAULT_OPTIONS = listOf(
+        ModelOptions(flashAttention = false),
+        ModelOptions(flashAttention = true)
+    )
+
+    /**
+     * Greedy keeps one decoder sequence, beam search five, so the KV
+     * cache traffic differs by about that factor
+     */
+    val DEFAULT_DECODING = listOf(
+        "greedy" to DecodingParams.BALANCED,
+        "beam" to DecodingParams.ACCURATE
+    )
+
+    private class Row(
+        val options: ModelOptions,
+        val decoding: String,
+        val rtf: Float,
+        val encodeMs: Float,
+        val decodeMs: Float,
+        val wer: Float,
+        val residentMb: Float,
+        val peakMb: Float
+    )
+
+    /**
+     * @param load Loads the model under test with the given options
+     */
+    suspend fun run(
+        load: (ModelOptions) -> WhisperContext,
+        clips: List<AudioContextBenchmark.Clip>,
+        options: List<ModelOptions> = DEFAULT_OPTIONS,
+        decoding: List<Pair<String, DecodingParams>> = DEFAULT_DECODING
+    ): String {
+        require(clips.isNotEmpty()) { "No benchmark clips" }
+        require(options.isNotEmpty() && decoding.isNotEmpty()) { "Empty benchmark matrix" }
+
+        val audioMs = clips.sumOf { it.samples.size } * 1000f / WHISPER_SAMPLE_RATE
+        val rows = mutableListOf<Row>()
+        var peakScoped = true
+
+        for (opts in options) {
+            val baseline = WhisperContext.readMemoryUsage().residentBytes
+            val context = withContext(Dispatchers.IO) { load(opts) }
+            try {
+                context.warmUp()
+                for ((label, params) in decoding) {
+                    context.setDecodingParams(params)
+                    peakScoped = WhisperContext.resetPeakMemory() && peakScoped
+
+                    var totalMs = 0f
+                    var encodeMs = 0f
+                    var decodeMs = 0f
+                    var errors = 0
+                    var words = 0
+                    for (clip in clips) {
+                        val segments = context.transcribeWithSegments(clip.samples)
+                        val timings = context.getTimings()
+                        totalMs += timings.totalMs
+                        encodeMs += timings.encodeMs
+                        decodeMs += timings.decodeMs
+
+                        val (clipErrors, clipWords) =
+                            AudioContextBenchmark.wordErrors(clip.reference, segments.joinToString(" ") { it.text })
+                        errors += clipErrors
+                        words += clipWords
+                    }
+
+                    val memory = WhisperContext.readMemoryUsage()
+                    rows += Row(
+                        options = opts,
+                        decoding = label,
+                        rtf = totalMs / audioMs,
+                        encodeMs = encodeMs / clips.size,
+                        decodeMs = decodeMs / clips.size,
+                        wer = 100f * errors / words.coerceAtLeast(1),
+                        residentMb = (memory.residentBytes - baseline) / MB,
+                        peakMb = (memory.peakResidentBytes - baseline) / MB
+                    )
+                    Log.d(LOG_TAG, "$opts / $label done")
+                }
+            } finally {
+                context.release()
+            }
+        }
+
+        return buildString {
+            append(String.format("model options bench: %d clips, %.1f s of audio\n", clips.size, audioMs / 1000f))
+            if (!peakScoped) {
+                append("(peak reset unavailable: peak covers the whole process)\n")
+            }
+            append(String.format(
+                "%-12s %-7s %7s %7s %10s %10s %7s %9s %9s %9s\n",
+                "options", "decode", "RTF", "dRTF", "encode ms", "decode ms", "WER", "RSS MB", "peak MB", "dpeak MB"
+            ))
+            for (row in rows) {
+                val base = rows.first { it.decoding == row.decoding }
+                append(String.format(
+                    "%-12s %-7s %7.3f %+6.1f%% %10.1f %10.1f %6.1f%% %9.1f %9.1f %+9.1f\n",
+                    row.options.toString(),
+                    row.decoding,
+                    row.rtf,
+                    100f * (row.rtf - base.rtf) / base.rtf.coerceAtLeast(1e-6f),
+                    row.encodeMs,
+                    row.decodeMs,
+                    row.wer,
+                    row.residentMb,
+                    row.peakMb,
+                    row.peakMb - base.peakMb
+                ))
+            }
+        }
+    }
+
+    private const val MB = 1024f * 1024f
+}
@@ -0,0 +1,72 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertTrue
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+
+private const val LOG_TAG = "WhisperBenchmarkTest"
+
+/**
+ * On-device entry point for [AudioContextBenchmark] and
+ * [ModelOptionsBenchmark]
+ *
+ * Opt-in: runs only when the `model` instrumentation argument names a
+ * ggml model on the device; `clips` is the directory of WAV + reference
+ * .txt pairs (default: the model's directory). Each report is logged and
+ * written to the app's external files dir under `benchmarks/`.
+ */
+@RunWith(AndroidJUnit4::class)
+class WhisperBenchmarkTest {
+
+    private val arguments = InstrumentationRegistry.getArguments()
+
+    @Test
+    fun audioContextMatrix() = runBlocking {
+        val model = modelFile()
+        val context = WhisperContext.createFromFile(model.absolutePath)
+        try {
+            context.warmUp()
+            report("audio_ctx", AudioContextBenchmark.run(context, clips(model)))
+        } finally {
+            context.release()
+        }
+    }
+
+    @Test
+    fun modelOptionsMatrix() = runBlocking {
+        val model = modelFile()
+        val report = ModelOptionsBenchmark.run(
+            load = { options -> WhisperContext.createFromFile(model.absolutePath, options) },
+            clips = clips(model)
+        )
+        report("model_options", report)
+    }
+
+    private fun modelFile(): File {
+        val path = arguments.getString("model")
+        assumeTrue("Pass -e model <path to ggml model> to run the benchmarks", path != null)
+        val model = File(path!!)
+        assertTrue("Model not found: $model", model.isFile)
+        return model
+    }
+
+    private fun clips(model: File): List<AudioContextBenchmark.Clip> {
+        val dir = arguments.getString("clips")?.let { File(it) } ?: model.parentFile!!
+        return AudioContextBenchmark.loadClips(dir).also {
+            assertTrue("No WAV + .txt clips in $dir", it.isNotEmpty())
+        }
+    }
+
+    private fun report(name: String, text: String) {
+        Log.i(LOG_TAG, text)
+        val targetContext = InstrumentationRegistry.getInstrumentation().targetContext
+        val dir = File(targetContext.getExternalFilesDir(null), "benchmarks").also { it.mkdirs() }
+        File(dir, "$name.txt").writeText(text)
+    }
+}
@@ -0,0 +1,519 @@
+/**
+ * Compressed audio archive for stored appointments
+ *
+ * See audio_archive.h for the file layout.
+ */
+
+#include "audio_archive.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+// Unary quotients this long are replaced by a raw 32-bit value
+#define RICE_ESCAPE 24
+#define RICE_MAX_K 30
+
+// ============================================================================
+// Bit I/O
+// ============================================================================
+
+struct bit_writer {
+    std::vector<uint8_t> &bytes;
+    uint64_t acc = 0;
+    int n_bits = 0;
+
+    explicit bit_writer(std::vector<uint8_t> &out) : bytes(out) {}
+
+    void put(uint32_t value, int count) {
+        // count <= 32, acc never holds more than 7 pending bits on entry
+        acc = (acc << count) | (value & (count == 32 ? 0xFFFFFFFFu : ((1u << count) - 1)));
+        n_bits += count;
+        while (n_bits >= 8) {
+            n_bits -= 8;
+            bytes.push_back((uint8_t)(acc >> n_bits));
+        }
+    }
+
+    void put_zeros(int count) {
+        while (count > 0) {
+            const int n = std::min(count, 24);
+            put(0, n);
+            count -= n;
+        }
+    }
+
+    void flush() {
+        if (n_bits > 0) {
+            bytes.push_back((uint8_t)(acc << (8 - n_bits)));
+            n_bits = 0;
+        }
+    }
+};
+
+struct bit_reader {
+    const uint8_t *data;
+    size_t size;
+    size_t pos = 0;         // in bits
+
+    bit_reader(const uint8_t *d, size_t n) : data(d), size(n) {}
+
+    bool bit(uint32_t &out) {
+        if (pos >= size * 8) return false;
+        out = (data[pos >> 3] >> (7 - (pos & 7))) & 1u;
+        pos++;
+        return true;
+    }
+
+    bool get(int count, uint32_t &out) {
+        out = 0;
+        for (int i = 0; i < count; i++) {
+            uint32_t b;
+            if (!bit(b)) return false;
+            out = (out << 1) | b;
+        }
+        return true;
+    }
+};
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+// ============================================================================
+// Prediction
+// ============================================================================
+
+static inline int32_t fixed_residual(const int16_t *x, int n, int order) {
+    switch (order) {
+        case 0:  return x[n];
+        case 1:  return x[n] - x[n - 1];
+        case 2:  return x[n] - 2 * x[n - 1] + x[n - 2];
+        case 3:  return x[n] - 3 * x[n - 1] + 3 * x[n - 2] - x[n - 3];
+        default: return x[n] - 4 * x[n - 1] + 6 * x[n - 2] - 4 * x[n - 3] + x[n - 4];
+    }
+}
+
+static inline int32_t fixed_predict(const int16_t *x, int n, int order) {
+    switch (order) {
+        case 0:  return 0;
+        case 1:  return x[n - 1];
+        case 2:  return 2 * x[n - 1] - x[n - 2];
+        case 3:  return 3 * x[n - 1] - 3 * x[n - 2] + x[n - 3];
+        default: return 4 * x[n - 1] - 6 * x[n - 2] + 4 * x[n - 3] - x[n - 4];
+    }
+}
+
+static uint64_t rice_cost(const std::vector<uint32_t> &u, int k) {
+    uint64_t bits = 0;
+    for (uint32_t v : u) {
+        const uint32_t q = v >> k;
+        bits += (q >= RICE_ESCAPE) ? (RICE_ESCAPE + 32) : (q + 1 + k);
+    }
+    return bits;
+}
+
+static void encode_block(const int16_t *x, int n, std::vector<uint8_t> &out) {
+    // Pick the predictor with the smallest absolute residual sum
+    int order = 0;
+    uint64_t best_sum = UINT64_MAX;
+    const int max_order = std::min(ARCHIVE_MAX_ORDER, n);
+    for (int o = 0; o <= max_order; o++) {
+        uint64_t sum = 0;
+        for (int i = o; i < n; i++) {
+            sum += (uint64_t)std::abs(fixed_residual(x, i, o));
+        }
+        if (sum < best_sum) {
+            best_sum = sum;
+            order = o;
+        }
+    }
+
+    std::vector<uint32_t> u;
+    u.reserve(n - order);
+    uint64_t u_sum = 0;
+    for (int i = order; i < n; i++) {
+        u.push_back(zigzag(fixed_residual(x, i, order)));
+        u_sum += u.back();
+    }
+
+    // Estimate k from the mean, then refine against the exact bit cost
+    int k = 0;
+    if (!u.empty()) {
+        const uint64_t mean = u_sum / u.size();
+        while (k < RICE_MAX_K && (1ull << (k + 1)) <= mean) k++;
+    }
+    uint64_t best_cost = rice_cost(u, k);
+    for (int cand : { k - 1, k + 1 }) {
+        if (cand < 0 || cand > RICE_MAX_K) continue;
+        const uint64_t cost = rice_cost(u, cand);
+        if (cost < best_cost) {
+            best_cost = cost;
+            k = cand;
+        }
+    }
+
+    std::vector<uint8_t> payload;
+    payload.reserve(order * 2 + best_cost / 8 + 1);
+    for (int i = 0; i < order; i++) {
+        const uint16_t s = (uint16_t)x[i];
+        payload.push_back((uint8_t)(s & 0xFF));
+        payload.push_back((uint8_t)(s >> 8));
+    }
+
+    bit_writer bw(payload);
+    for (uint32_t v : u) {
+        const uint32_t q = v >> k;
+        if (q >= RICE_ESCAPE) {
+            bw.put_zeros(RICE_ESCAPE);
+            bw.put(v, 32);
+        } else {
+            bw.put_zeros((int)q);
+            bw.put(1, 1);
+            if (k > 0) bw.put(v, k);
+        }
+    }
+    bw.flush();
+
+    const uint32_t payload_bytes = (uint32_t)payload.size();
+    const uint8_t header[8] = {
+        (uint8_t)(payload_bytes), (uint8_t)(payload_bytes >> 8),
+        (uint8_t)(payload_bytes >> 16), (uint8_t)(payload_bytes >> 24),
+        (uint8_t)(n & 0xFF), (uint8_t)(n >> 8),
+        (uint8_t)order, (uint8_t)k
+    };
+    out.insert(out.end(), header, header + 8);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+static void put_u16(std::vector<uint8_t> &out, uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+    put_u16(out, (uint16_t)v);
+    put_u16(out, (uint16_t)(v >> 16));
+}
+
+// True if the archive at path decodes to exactly pcm[0, n_samples)
+static bool archive_matches(const char *path, const int16_t *pcm, size_t n_samples) {
+    audio_archive_reader *reader = audio_archive_open(path);
+    if (!reader || reader->n_samples != n_samples) {
+        audio_archive_close(reader);
+        return false;
+    }
+    size_t offset = 0;
+    int n;
+    bool identical = true;
+    while ((n = audio_archive_read_block(reader)) > 0) {
+        if (offset + n > n_samples || memcmp(reader->block.data(), pcm + offset, n * 2) != 0) {
+            identical = false;
+            break;
+        }
+        offset += n;
+    }
+    audio_archive_close(reader);
+
+    return identical && n == 0 && offset == n_samples;
+}
+
+bool audio_archive_encode(const int16_t *pcm, size_t n_samples, int sample_rate,
+                          const char *path, audio_archive_stats *stats) {
+    const auto t_start = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> out;
+    out.reserve(24 + n_samples);
+    out.insert(out.end(), ARCHIVE_MAGIC, ARCHIVE_MAGIC + 4);
+    put_u16(out, ARCHIVE_VERSION);
+    put_u16(out, 1);
+    put_u32(out, (uint32_t)sample_rate);
+    put_u32(out, (uint32_t)(n_samples & 0xFFFFFFFFu));
+    put_u32(out, (uint32_t)((uint64_t)n_samples >> 32));
+    put_u32(out, ARCHIVE_BLOCK_SIZE);
+
+    for (size_t offset = 0; offset < n_samples; offset += ARCHIVE_BLOCK_SIZE) {
+        const int n = (int)std::min<size_t>(ARCHIVE_BLOCK_SIZE, n_samples - offset);
+        encode_block(pcm + offset, n, out);
+    }
+
+    if (stats) {
+        stats->n_samples = n_samples;
+        stats->sample_rate = sample_rate;
+        stats->input_bytes = n_samples * 2 + 44;
+        stats->output_bytes = out.size();
+        stats->encode_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t_start).count();
+    }
+
+    // Written beside the target and renamed over it only once it decodes
+    // back exactly, so a crash or a full disk never leaves a partial archive
+    const std::string tmp_path = std::string(path) + ".tmp";
+    FILE *f = fopen(tmp_path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (fflush(f) == 0) && ok;
+    ok = (fsync(fileno(f)) == 0) && ok;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || !archive_matches(tmp_path.c_str(), pcm, n_samples) || rename(tmp_path.c_str(), path) != 0) {
+        remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Minimal RIFF reader for the 16-bit mono recordings we write ourselves
+static bool read_wav_s16_mono(const char *path, std::vector<int16_t> &pcm, int *sample_rate) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    if (data.size() < 44 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    int channels = 0, bits = 0;
+    size_t offset = 12;
+    while (offset + 8 <= data.size()) {
+        uint32_t size;
+        memcpy(&size, data.data() + offset + 4, 4);
+        if (memcmp(data.data() + offset, "fmt ", 4) == 0 && offset + 24 <= data.size()) {
+            uint16_t ch, bps;
+            uint32_t rate;
+            memcpy(&ch, data.data() + offset + 10, 2);
+            memcpy(&rate, data.data() + offset + 12, 4);
+            memcpy(&bps, data.data() + offset + 22, 2);
+            channels = ch;
+            bits = bps;
+            *sample_rate = (int)rate;
+        } else if (memcmp(data.data() + offset, "data", 4) == 0) {
+            if (channels != 1 || bits != 16) return false;
+            const size_t start = offset + 8;
+            const size_t len = std::min<size_t>(size, data.size() - start);
+            pcm.resize(len / 2);
+            memcpy(pcm.data(), data.data() + start, pcm.size() * 2);
+            return true;
+        }
+        offset += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+bool audio_archive_encode_wav(const char *wav_path, const char *archive_path, audio_archive_stats *stats) {
+    std::vector<int16_t> pcm;
+    int sample_rate = 0;
+    if (!read_wav_s16_mono(wav_path, pcm, &sample_rate)) {
+        return false;
+    }
+
+    // Only succeeds once the archive round-trips exactly, so the caller
+    // can delete the WAV
+    return audio_archive_encode(pcm.data(), pcm.size(), sample_rate, archive_path, stats);
+}
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+audio_archive_reader *audio_archive_open(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return nullptr;
+
+    uint8_t h[24];
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) || memcmp(h, ARCHIVE_MAGIC, 4) != 0) {
+        fclose(f);
+        return nullptr;
+    }
+
+    uint16_t version, channels;
+    uint32_t rate, n_lo, n_hi, block_size;
+    memcpy(&version, h + 4, 2);
+    memcpy(&channels, h + 6, 2);
+    memcpy(&rate, h + 8, 4);
+    memcpy(&n_lo, h + 12, 4);
+    memcpy(&n_hi, h + 16, 4);
+    memcpy(&block_size, h + 20, 4);
+
+    if (version != ARCHIVE_VERSION || channels != 1) {
+        fclose(f);
+        return nullptr;
+    }
+
+    audio_archive_reader *reader = new audio_archive_reader();
+    reader->file = f;
+    reader->sample_rate = (int)rate;
+    reader->channels = channels;
+    reader->n_samples = ((uint64_t)n_hi << 32) | n_lo;
+    reader->n_decoded = 0;
+    reader->block_size = block_size;
+    reader->block.reserve(block_size);
+    return reader;
+}
+
+bool audio_archive_check(const char *path) {
+    audio_archive_reader *reader = audio_archive_open(path);
+    if (!reader) return false;
+
+    // Walk the block headers without decoding: the counts must add up to
+    // the header's and the last payload must end at the end of the file
+    uint64_t n_total = 0;
+    bool ok = true;
+    while (ok && n_total < reader->n_samples) {
+        uint8_t h[8];
+        uint32_t payload_bytes;
+        uint16_t n;
+        if (fread(h, 1, sizeof(h), reader->file) != sizeof(h)) {
+            ok = false;
+            break;
+        }
+        memcpy(&payload_bytes, h, 4);
+        memcpy(&n, h + 4, 2);
+        ok = n > 0 && n <= reader->block_size && fseek(reader->file, payload_bytes, SEEK_CUR) == 0;
+        n_total += n;
+    }
+    if (ok) {
+        const long end = ftell(reader->file);
+        ok = n_total == reader->n_samples && fseek(reader->file, 0, SEEK_END) == 0 && ftell(reader->file) == end;
+    }
+    audio_archive_close(reader);
+    return ok;
+}
+
+void audio_archive_close(audio_archive_reader *reader) {
+    if (!reader) return;
+    if (reader->file) fclose(reader->file);
+    delete reader;
+}
+
+int audio_archive_read_block(audio_archive_reader *reader) {
+    reader->block.clear();
+    if (reader->n_decoded >= reader->n_samples) return 0;
+
+    uint8_t h[8];
+    if (fread(h, 1, sizeof(h), reader->file) != sizeof(h)) return -1;
+
+    uint32_t payload_bytes;
+    uint16_t n;
+    memcpy(&payload_bytes, h, 4);
+    memcpy(&n, h + 4, 2);
+    const int order = h[6];
+    const int k = h[7];
+    if (order > ARCHIVE_MAX_ORDER || order > n || k > RICE_MAX_K || n > reader->block_size) return -1;
+
+    reader->payload.resize(payload_bytes);
+    if (fread(reader->payload.data(), 1, payload_bytes, reader->file) != payload_bytes) return -1;
+    if (payload_bytes < (uint32_t)order * 2) return -1;
+
+    reader->block.resize(n);
+    int16_t *x = reader->block.data();
+    for (int i = 0; i < order; i++) {
+        x[i] = (int16_t)(reader->payload[2 * i] | (reader->payload[2 * i + 1] << 8));
+    }
+
+    bit_reader br(reader->payload.data() + order * 2, payload_bytes - order * 2);
+    for (int i = order; i < n; i++) {
+        uint32_t q = 0, b = 0, v = 0;
+        while (q < RICE_ESCAPE) {
+            if (!br.bit(b)) return -1;
+            if (b) break;
+            q++;
+        }
+        if (q == RICE_ESCAPE) {
+            if (!br.get(32, v)) return -1;
+        } else {
+            uint32_t low = 0;
+            if (k > 0 && !br.get(k, low)) return -1;
+            v = (q << k) | low;
+        }
+        x[i] = (int16_t)(fixed_predict(x, i, order) + unzigzag(v));
+    }
+
+    reader->n_decoded += n;
+    return n;
+}
+
+bool audio_archive_decode_float(const char *path, std::vector<float> &out, int *sample_rate) {
+    audio_archive_reader *reader = audio_archive_open(path);
+    if (!reader) return false;
+
+    if (sample_rate) *sample_rate = reader->sample_rate;
+    out.clear();
+    out.reserve(reader->n_samples);
+
+    const float scale = 1.0f / 32768.0f;
+    int n;
+    while ((n = audio_archive_read_block(reader)) > 0) {
+        for (int i = 0; i < n; i++) {
+            out.push_back(reader->block[i] * scale);
+        }
+    }
+    audio_archive_close(reader);
+    return n == 0;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+std::string audio_bench_archive(const char *tmp_dir) {
+    // 5 minutes of 16 kHz "speech": formant tones under a syllable-rate
+    // envelope plus low-level noise, with pauses
+    const int rate = 16000;
+    const int seconds = 300;
+    const size_t n = (size_t)rate * seconds;
+    std::vector<int16_t> pcm(n);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < n; i++) {
+        const double t = (double)i / rate;
+        const double envelope = std::max(0.0, std::sin(2.0 * M_PI * 4.0 * t)) * (std::fmod(t, 6.0) < 4.5 ? 1.0 : 0.0);
+        const double voiced = 0.5 * std::sin(2.0 * M_PI * 140.0 * t)
+                            + 0.3 * std::sin(2.0 * M_PI * 700.0 * t)
+                            + 0.2 * std::sin(2.0 * M_PI * 1200.0 * t);
+        seed = seed * 1664525u + 1013904223u;
+        const double noise = ((int32_t)(seed >> 16) - 32768) / 32768.0;
+        pcm[i] = (int16_t)(6000.0 * envelope * voiced + 150.0 * noise);
+    }
+
+    const std::string path = std::string(tmp_dir) + "/bench_archive.vbla";
+    char line[256];
+
+    audio_archive_stats stats = {};
+    if (!audio_archive_encode(pcm.data(), n, rate, path.c_str(), &stats)) {
+        return "archive bench: failed to write " + path + "\n";
+    }
+
+    const auto t_start = std::chrono::steady_clock::now();
+    std::vector<float> decoded;
+    audio_archive_decode_float(path.c_str(), decoded, nullptr);
+    const double decode_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t_start).count();
+    remove(path.c_str());
+
+    snprintf(line, sizeof(line),
+             "archive %d s @ %d Hz: %.1f KB -> %.1f KB (ratio %.2f), "
+             "encode %.1f ms (%.0fx realtime), decode %.1f ms (%.0fx realtime)\n",
+             seconds, rate, stats.input_bytes / 1024.0, stats.output_bytes / 1024.0,
+             (double)stats.input_bytes / stats.output_bytes,
+             stats.encode_ms, seconds * 1000.0 / stats.encode_ms,
+             decode_ms, seconds * 1000.0 / decode_ms);
+    return line;
+}
@@ -0,0 +1,95 @@
+/**
+ * Compressed audio archive for stored appointments
+ *
+ * Lossless FLAC-style codec for 16-bit mono recordings: each block picks
+ * the best fixed polynomial predictor (order 0-4) and Rice-codes the
+ * residual. Speech typically shrinks to 40-60% of the WAV size, and the
+ * decoder is block-streaming so long recordings can be fed to whisper
+ * without a temporary WAV.
+ *
+ * File layout (little-endian):
+ *   header:  "VBLA" | u16 version | u16 channels | u32 sample_rate
+ *            | u64 n_samples | u32 block_size
+ *   blocks:  u32 payload_bytes | u16 n_samples | u8 order | u8 rice_k
+ *            | payload (warm-up samples as raw s16, then Rice residuals)
+ */
+
+#ifndef AUDIO_ARCHIVE_H
+#define AUDIO_ARCHIVE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define ARCHIVE_MAGIC "VBLA"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BLOCK_SIZE 2048
+#define ARCHIVE_MAX_ORDER 4
+
+struct audio_archive_stats {
+    uint64_t n_samples;
+    int sample_rate;
+    uint64_t input_bytes;
+    uint64_t output_bytes;
+    double encode_ms;
+};
+
+/**
+ * Streaming reader; decodes one block at a time
+ */
+struct audio_archive_reader {
+    FILE *file;
+    int sample_rate;
+    int channels;
+    uint64_t n_samples;
+    uint64_t n_decoded;
+    uint32_t block_size;
+
+    std::vector<uint8_t> payload;
+    std::vector<int16_t> block;
+};
+
+/**
+ * Encode 16-bit mono PCM to an archive file. It is written to path.tmp
+ * and renamed over path only once it decodes back to identical samples,
+ * so path is never left partly written. Returns false on I/O error.
+ */
+bool audio_archive_encode(const int16_t *pcm, size_t n_samples, int sample_rate,
+                          const char *path, audio_archive_stats *stats);
+
+/**
+ * Encode a 16-bit mono WAV file to an archive, verifying the result
+ * decodes back to identical samples before returning true.
+ */
+bool audio_archive_encode_wav(const char *wav_path, const char *archive_path, audio_archive_stats *stats);
+
+audio_archive_reader *audio_archive_open(const char *path);
+
+/**
+ * Cheap integrity check for choosing an archive over its WAV: the header
+ * is valid and the block headers account for every sample and end at the
+ * end of the file. Payloads aren't decoded.
+ */
+bool audio_archive_check(const char *path);
+
+void audio_archive_close(audio_archive_reader *reader);
+
+/**
+ * Decode the next block into reader->block.
+ * Returns the number of samples decoded, 0 at end of stream, -1 on corrupt data.
+ */
+int audio_archive_read_block(audio_archive_reader *reader);
+
+/**
+ * Decode a whole archive to normalized float samples, as whisper expects
+ */
+bool audio_archive_decode_float(const char *path, std::vector<float> &out, int *sample_rate);
+
+/**
+ * Compression ratio and encode/decode throughput on synthetic speech-like
+ * audio; tmp_dir must be writable (e.g. the app cache directory)
+ */
+std::string audio_bench_archive(const char *tmp_dir);
+
+#endif // AUDIO_ARCHIVE_H
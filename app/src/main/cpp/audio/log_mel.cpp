@@ -0,0 +1,504 @@
+/**
+ * Whisper-compatible log-mel spectrogram
+ *
+ * Mirrors log_mel_spectrogram() in whisper.cpp: reflective pad of half a
+ * window at the start, 30 s of zeros at the end, power spectrum, mel
+ * projection, log10 and the (max - 8) clamp followed by (x + 4) / 4
+ * scaling.
+ *
+ * The 400-point real FFT is computed as a 200-point complex FFT of the
+ * even/odd sample pairs (Stockham, radices 2,2,2,5,5) plus a split step.
+ * Each SIMD lane carries a different frame, so every butterfly works on
+ * four frames at once and the results land as four consecutive frames
+ * of one band, matching the band-major output layout.
+ */
+
+#include "log_mel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LOG_MEL_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LOG_MEL_SSE 1
+#endif
+
+#define LOG_MEL_LANES 4
+#define LOG_MEL_N_CPLX (LOG_MEL_N_FFT / 2)
+
+// Samples needed for one group of four consecutive frames
+#define LOG_MEL_GROUP_SPAN (LOG_MEL_N_FFT + (LOG_MEL_LANES - 1) * LOG_MEL_HOP)
+#define LOG_MEL_GROUP_STEP (LOG_MEL_LANES * LOG_MEL_HOP)
+
+// ============================================================================
+// Vector kernels
+// ============================================================================
+
+#if defined(LOG_MEL_NEON)
+typedef float32x4_t f4;
+static inline f4 f4_set1(float v) { return vdupq_n_f32(v); }
+static inline f4 f4_set(float a, float b, float c, float d) {
+    const float v[4] = { a, b, c, d };
+    return vld1q_f32(v);
+}
+static inline f4 f4_add(f4 a, f4 b) { return vaddq_f32(a, b); }
+static inline f4 f4_sub(f4 a, f4 b) { return vsubq_f32(a, b); }
+static inline f4 f4_mul(f4 a, f4 b) { return vmulq_f32(a, b); }
+static inline f4 f4_madd(f4 acc, f4 a, f4 b) { return vmlaq_f32(acc, a, b); }
+static inline void f4_store(float *p, f4 v) { vst1q_f32(p, v); }
+#elif defined(LOG_MEL_SSE)
+typedef __m128 f4;
+static inline f4 f4_set1(float v) { return _mm_set1_ps(v); }
+static inline f4 f4_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline f4 f4_add(f4 a, f4 b) { return _mm_add_ps(a, b); }
+static inline f4 f4_sub(f4 a, f4 b) { return _mm_sub_ps(a, b); }
+static inline f4 f4_mul(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+static inline f4 f4_madd(f4 acc, f4 a, f4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+static inline void f4_store(float *p, f4 v) { _mm_storeu_ps(p, v); }
+#else
+struct f4 {
+    float v[4];
+};
+static inline f4 f4_set1(float x) { return f4{ { x, x, x, x } }; }
+static inline f4 f4_set(float a, float b, float c, float d) { return f4{ { a, b, c, d } }; }
+static inline f4 f4_add(f4 a, f4 b) { return f4{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+static inline f4 f4_sub(f4 a, f4 b) { return f4{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+static inline f4 f4_mul(f4 a, f4 b) { return f4{ { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+static inline f4 f4_madd(f4 acc, f4 a, f4 b) { return f4_add(acc, f4_mul(a, b)); }
+static inline void f4_store(float *p, f4 v) { std::copy(v.v, v.v + 4, p); }
+#endif
+
+// ============================================================================
+// Filterbank
+// ============================================================================
+
+static double hz_to_mel(double hz) {
+    // Slaney scale: linear below 1 kHz, logarithmic above
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+    return hz < min_log_hz ? hz / f_sp : min_log_mel + std::log(hz / min_log_hz) / logstep;
+}
+
+static double mel_to_hz(double mel) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+    return mel < min_log_mel ? mel * f_sp : min_log_hz * std::exp(logstep * (mel - min_log_mel));
+}
+
+void mel_filterbank_init(mel_filterbank &filters, int n_mel) {
+    filters.n_mel = n_mel;
+    filters.weights.assign((size_t)n_mel * LOG_MEL_N_BINS, 0.0f);
+
+    const double mel_min = hz_to_mel(0.0);
+    const double mel_max = hz_to_mel(LOG_MEL_SAMPLE_RATE / 2.0);
+
+    std::vector<double> hz_points(n_mel + 2);
+    for (int i = 0; i < n_mel + 2; i++) {
+        hz_points[i] = mel_to_hz(mel_min + (mel_max - mel_min) * i / (n_mel + 1));
+    }
+
+    for (int m = 0; m < n_mel; m++) {
+        const double lower = hz_points[m];
+        const double center = hz_points[m + 1];
+        const double upper = hz_points[m + 2];
+        const double enorm = 2.0 / (upper - lower);
+
+        for (int k = 0; k < LOG_MEL_N_BINS; k++) {
+            const double freq = (double)k * LOG_MEL_SAMPLE_RATE / LOG_MEL_N_FFT;
+            const double rising = (freq - lower) / (center - lower);
+            const double falling = (upper - freq) / (upper - center);
+            const double w = std::max(0.0, std::min(rising, falling));
+            filters.weights[(size_t)m * LOG_MEL_N_BINS + k] = (float)(w * enorm);
+        }
+    }
+}
+
+// ============================================================================
+// Plan
+// ============================================================================
+
+struct fft_stage {
+    int radix;
+    int n;                      // sub-transform length entering the stage
+    int stride;
+    std::vector<float> tw_re;   // exp(-2*pi*i*j*q/n) at [q * radix + j]
+    std::vector<float> tw_im;
+};
+
+struct log_mel_plan {
+    int n_mel;
+    float hann[LOG_MEL_N_FFT];
+
+    std::vector<fft_stage> stages;
+    float dft5_re[25];          // exp(-2*pi*i*j*r/5) at [j * 5 + r]
+    float dft5_im[25];
+
+    float split_re[LOG_MEL_N_BINS];   // exp(-2*pi*i*k/N_FFT) for the real-FFT split
+    float split_im[LOG_MEL_N_BINS];
+
+    // Sparse filterbank: band m covers bins [band_start[m], band_start[m] + band_len[m])
+    std::vector<int> band_start;
+    std::vector<int> band_len;
+    std::vector<float> band_weights;  // packed, band_offset[m] into it
+    std::vector<int> band_offset;
+};
+
+static log_mel_plan *log_mel_plan_init(int n_mel) {
+    log_mel_plan *plan = new log_mel_plan();
+    plan->n_mel = n_mel;
+
+    for (int i = 0; i < LOG_MEL_N_FFT; i++) {
+        plan->hann[i] = (float)(0.5 * (1.0 - std::cos(2.0 * M_PI * i / LOG_MEL_N_FFT)));
+    }
+
+    const int radices[] = { 2, 2, 2, 5, 5 };
+    int n = LOG_MEL_N_CPLX;
+    int stride = 1;
+    for (int radix : radices) {
+        fft_stage stage;
+        stage.radix = radix;
+        stage.n = n;
+        stage.stride = stride;
+        const int m = n / radix;
+        stage.tw_re.resize((size_t)m * radix);
+        stage.tw_im.resize((size_t)m * radix);
+        for (int q = 0; q < m; q++) {
+            for (int j = 0; j < radix; j++) {
+                const double a = -2.0 * M_PI * j * q / n;
+                stage.tw_re[q * radix + j] = (float)std::cos(a);
+                stage.tw_im[q * radix + j] = (float)std::sin(a);
+            }
+        }
+        plan->stages.push_back(stage);
+        n = m;
+        stride *= radix;
+    }
+
+    for (int j = 0; j < 5; j++) {
+        for (int r = 0; r < 5; r++) {
+            const double a = -2.0 * M_PI * ((j * r) % 5) / 5.0;
+            plan->dft5_re[j * 5 + r] = (float)std::cos(a);
+            plan->dft5_im[j * 5 + r] = (float)std::sin(a);
+        }
+    }
+
+    for (int k = 0; k < LOG_MEL_N_BINS; k++) {
+        const double a = -2.0 * M_PI * k / LOG_MEL_N_FFT;
+        plan->split_re[k] = (float)std::cos(a);
+        plan->split_im[k] = (float)std::sin(a);
+    }
+
+    mel_filterbank filters;
+    mel_filterbank_init(filters, n_mel);
+    for (int m = 0; m < n_mel; m++) {
+        const float *w = filters.weights.data() + (size_t)m * LOG_MEL_N_BINS;
+        int lo = 0;
+        while (lo < LOG_MEL_N_BINS && w[lo] == 0.0f) lo++;
+        int hi = LOG_MEL_N_BINS;
+        while (hi > lo && w[hi - 1] == 0.0f) hi--;
+
+        plan->band_start.push_back(lo);
+        plan->band_len.push_back(hi - lo);
+        plan->band_offset.push_back((int)plan->band_weights.size());
+        plan->band_weights.insert(plan->band_weights.end(), w + lo, w + hi);
+    }
+
+    return plan;
+}
+
+// ============================================================================
+// Frame group
+// ============================================================================
+
+/**
+ * Log10 mel energies of the four frames starting at x, x + hop, ...;
+ * writes raw[band * 4 + lane]
+ */
+static void log_mel_group(const log_mel_plan &plan, const float *x, float *raw) {
+    f4 buf_re[2][LOG_MEL_N_CPLX];
+    f4 buf_im[2][LOG_MEL_N_CPLX];
+    f4 power[LOG_MEL_N_BINS];
+
+    // Window and pack even/odd samples as complex input, one frame per lane
+    f4 *in_re = buf_re[0];
+    f4 *in_im = buf_im[0];
+    for (int n = 0; n < LOG_MEL_N_CPLX; n++) {
+        const int j = 2 * n;
+        const float h0 = plan.hann[j];
+        const float h1 = plan.hann[j + 1];
+        in_re[n] = f4_set(x[j] * h0, x[LOG_MEL_HOP + j] * h0,
+                          x[2 * LOG_MEL_HOP + j] * h0, x[3 * LOG_MEL_HOP + j] * h0);
+        in_im[n] = f4_set(x[j + 1] * h1, x[LOG_MEL_HOP + j + 1] * h1,
+                          x[2 * LOG_MEL_HOP + j + 1] * h1, x[3 * LOG_MEL_HOP + j + 1] * h1);
+    }
+
+    // Stockham autosort, decimation in frequency
+    int cur = 0;
+    for (const fft_stage &st : plan.stages) {
+        const f4 *xr = buf_re[cur];
+        const f4 *xi = buf_im[cur];
+        f4 *yr = buf_re[cur ^ 1];
+        f4 *yi = buf_im[cur ^ 1];
+        const int m = st.n / st.radix;
+        const int s = st.stride;
+
+        for (int q = 0; q < m; q++) {
+            const float *twr = st.tw_re.data() + q * st.radix;
+            const float *twi = st.tw_im.data() + q * st.radix;
+
+            if (st.radix == 2) {
+                const f4 wr = f4_set1(twr[1]);
+                const f4 wi = f4_set1(twi[1]);
+                for (int k = 0; k < s; k++) {
+                    const int ia = k + s * q;
+                    const int ib = k + s * (q + m);
+                    const f4 dr = f4_sub(xr[ia], xr[ib]);
+                    const f4 di = f4_sub(xi[ia], xi[ib]);
+                    const int o = k + s * (2 * q);
+                    yr[o] = f4_add(xr[ia], xr[ib]);
+                    yi[o] = f4_add(xi[ia], xi[ib]);
+                    yr[o + s] = f4_sub(f4_mul(dr, wr), f4_mul(di, wi));
+                    yi[o + s] = f4_add(f4_mul(dr, wi), f4_mul(di, wr));
+                }
+                continue;
+            }
+
+            // Radix 5
+            for (int k = 0; k < s; k++) {
+                f4 ar[5], ai[5];
+                for (int r = 0; r < 5; r++) {
+                    ar[r] = xr[k + s * (q + m * r)];
+                    ai[r] = xi[k + s * (q + m * r)];
+                }
+                for (int j = 0; j < 5; j++) {
+                    f4 sr = ar[0];
+                    f4 si = ai[0];
+                    for (int r = 1; r < 5; r++) {
+                        const f4 cr = f4_set1(plan.dft5_re[j * 5 + r]);
+                        const f4 ci = f4_set1(plan.dft5_im[j * 5 + r]);
+                        sr = f4_add(sr, f4_sub(f4_mul(ar[r], cr), f4_mul(ai[r], ci)));
+                        si = f4_add(si, f4_add(f4_mul(ar[r], ci), f4_mul(ai[r], cr)));
+                    }
+                    const int o = k + s * (5 * q + j);
+                    if (j == 0) {
+                        yr[o] = sr;
+                        yi[o] = si;
+                    } else {
+                        const f4 wr = f4_set1(twr[j]);
+                        const f4 wi = f4_set1(twi[j]);
+                        yr[o] = f4_sub(f4_mul(sr, wr), f4_mul(si, wi));
+                        yi[o] = f4_add(f4_mul(sr, wi), f4_mul(si, wr));
+                    }
+                }
+            }
+        }
+        cur ^= 1;
+    }
+
+    // Split the packed transform into the real 400-point spectrum and take |X|^2
+    const f4 *zr = buf_re[cur];
+    const f4 *zi = buf_im[cur];
+    const f4 half = f4_set1(0.5f);
+    for (int k = 0; k < LOG_MEL_N_BINS; k++) {
+        const int a = k % LOG_MEL_N_CPLX;
+        const int b = (LOG_MEL_N_CPLX - k) % LOG_MEL_N_CPLX;
+
+        // even = (Z[k] + conj(Z[-k])) / 2, odd = (Z[k] - conj(Z[-k])) / 2i
+        const f4 er = f4_mul(f4_add(zr[a], zr[b]), half);
+        const f4 ei = f4_mul(f4_sub(zi[a], zi[b]), half);
+        const f4 or_ = f4_mul(f4_add(zi[a], zi[b]), half);
+        const f4 oi = f4_mul(f4_sub(zr[b], zr[a]), half);
+
+        const f4 wr = f4_set1(plan.split_re[k]);
+        const f4 wi = f4_set1(plan.split_im[k]);
+        const f4 xr = f4_add(er, f4_sub(f4_mul(or_, wr), f4_mul(oi, wi)));
+        const f4 xi = f4_add(ei, f4_add(f4_mul(or_, wi), f4_mul(oi, wr)));
+        power[k] = f4_madd(f4_mul(xr, xr), xi, xi);
+    }
+
+    // Sparse mel projection; each band only touches a handful of bins
+    for (int m = 0; m < plan.n_mel; m++) {
+        const float *w = plan.band_weights.data() + plan.band_offset[m];
+        const f4 *p = power + plan.band_start[m];
+        f4 acc = f4_set1(0.0f);
+        for (int k = 0; k < plan.band_len[m]; k++) {
+            acc = f4_madd(acc, p[k], f4_set1(w[k]));
+        }
+
+        float lanes[LOG_MEL_LANES];
+        f4_store(lanes, acc);
+        for (int l = 0; l < LOG_MEL_LANES; l++) {
+            raw[m * LOG_MEL_LANES + l] = std::log10(std::max(lanes[l], 1e-10f));
+        }
+    }
+}
+
+// ============================================================================
+// Spectrogram
+// ============================================================================
+
+static int log_mel_n_len(uint64_t n_samples) {
+    return (int)((n_samples + LOG_MEL_PAD_SAMPLES) / LOG_MEL_HOP);
+}
+
+// Groups that can contain real audio; later frames only see zero padding
+static int log_mel_n_groups(uint64_t n_samples) {
+    const int n_frames = std::min(log_mel_n_len(n_samples),
+                                  (int)((n_samples + LOG_MEL_N_FFT / 2 - 1) / LOG_MEL_HOP) + 1);
+    return (n_frames + LOG_MEL_LANES - 1) / LOG_MEL_LANES;
+}
+
+// Transpose [group][band][lane] into band-major frames, fill the silent tail and normalise
+static void log_mel_finalize(int n_mel, uint64_t n_samples, const std::vector<float> &raw, int n_groups,
+                             log_mel_spectrogram &mel) {
+    mel.n_mel = n_mel;
+    mel.n_len = log_mel_n_len(n_samples);
+    mel.n_len_org = 1 + (int)((n_samples + LOG_MEL_N_FFT / 2 - LOG_MEL_N_FFT) / LOG_MEL_HOP);
+    mel.data.assign((size_t)n_mel * mel.n_len, std::log10(1e-10f));
+
+    const int n_computed = std::min(n_groups * LOG_MEL_LANES, mel.n_len);
+    for (int m = 0; m < n_mel; m++) {
+        float *row = mel.data.data() + (size_t)m * mel.n_len;
+        for (int f = 0; f < n_computed; f++) {
+            const int g = f / LOG_MEL_LANES;
+            const int l = f % LOG_MEL_LANES;
+            row[f] = raw[((size_t)g * n_mel + m) * LOG_MEL_LANES + l];
+        }
+    }
+
+    // Clamp to 80 dB below the peak and rescale
+    float mmax = -1e20f;
+    for (float v : mel.data) {
+        mmax = std::max(mmax, v);
+    }
+    mmax -= 8.0f;
+    for (float &v : mel.data) {
+        v = (std::max(v, mmax) + 4.0f) / 4.0f;
+    }
+}
+
+bool log_mel_compute(const float *samples, int n_samples, int n_mel, int n_threads,
+                     log_mel_spectrogram &mel) {
+    const int pad = LOG_MEL_N_FFT / 2;
+    if (n_samples <= pad) return false;
+
+    const int n_groups = log_mel_n_groups((uint64_t)n_samples);
+
+    // Reflective pad at the start, zeros past the end up to the last group's window
+    const size_t padded_size = (size_t)(n_groups - 1) * LOG_MEL_GROUP_STEP + LOG_MEL_GROUP_SPAN;
+    std::vector<float> padded(std::max(padded_size, (size_t)n_samples + pad), 0.0f);
+    std::copy(samples, samples + n_samples, padded.begin() + pad);
+    std::reverse_copy(samples + 1, samples + 1 + pad, padded.begin());
+
+    log_mel_plan *plan = log_mel_plan_init(n_mel);
+    std::vector<float> raw((size_t)n_groups * n_mel * LOG_MEL_LANES);
+
+    auto worker = [&](int ith, int nth) {
+        for (int g = ith; g < n_groups; g += nth) {
+            log_mel_group(*plan, padded.data() + (size_t)g * LOG_MEL_GROUP_STEP,
+                          raw.data() + (size_t)g * n_mel * LOG_MEL_LANES);
+        }
+    };
+
+    n_threads = std::max(1, n_threads);
+    std::vector<std::thread> workers;
+    for (int ith = 1; ith < n_threads; ith++) {
+        workers.emplace_back(worker, ith, n_threads);
+    }
+    worker(0, n_threads);
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    log_mel_finalize(n_mel, (uint64_t)n_samples, raw, n_groups, mel);
+    delete plan;
+    return true;
+}
+
+// ============================================================================
+// Streaming
+// ============================================================================
+
+log_mel_stream *log_mel_stream_init(int n_mel) {
+    if (n_mel <= 0) return nullptr;
+
+    log_mel_stream *stream = new log_mel_stream();
+    stream->n_mel = n_mel;
+    stream->plan = log_mel_plan_init(n_mel);
+    stream->n_samples = 0;
+    stream->n_groups = 0;
+    stream->started = false;
+    return stream;
+}
+
+void log_mel_stream_free(log_mel_stream *stream) {
+    if (!stream) return;
+    delete stream->plan;
+    delete stream;
+}
+
+// Compute every group whose window lies inside `pending`
+static void log_mel_stream_drain(log_mel_stream *stream) {
+    size_t offset = 0;
+    while (offset + LOG_MEL_GROUP_SPAN <= stream->pending.size()) {
+        stream->raw.resize(stream->raw.size() + (size_t)stream->n_mel * LOG_MEL_LANES);
+        float *out = stream->raw.data() + (size_t)stream->n_groups * stream->n_mel * LOG_MEL_LANES;
+        log_mel_group(*stream->plan, stream->pending.data() + offset, out);
+        stream->n_groups++;
+        offset += LOG_MEL_GROUP_STEP;
+    }
+    stream->pending.erase(stream->pending.begin(), stream->pending.begin() + offset);
+}
+
+// The reflective head needs samples[1..pad]; buffer raw samples until it can be built
+static void log_mel_stream_start(log_mel_stream *stream) {
+    const int pad = LOG_MEL_N_FFT / 2;
+    std::vector<float> head(pad);
+    std::reverse_copy(stream->pending.begin() + 1, stream->pending.begin() + 1 + pad, head.begin());
+    stream->pending.insert(stream->pending.begin(), head.begin(), head.end());
+    stream->started = true;
+}
+
+void log_mel_stream_push(log_mel_stream *stream, const float *samples, size_t n_samples) {
+    if (n_samples == 0) return;
+
+    stream->pending.insert(stream->pending.end(), samples, samples + n_samples);
+    stream->n_samples += n_samples;
+
+    if (!stream->started) {
+        if (stream->n_samples <= (uint64_t)LOG_MEL_N_FFT / 2) return;
+        log_mel_stream_start(stream);
+    }
+    log_mel_stream_drain(stream);
+}
+
+bool log_mel_stream_finish(log_mel_stream *stream, log_mel_spectrogram &mel) {
+    if (stream->n_samples <= (uint64_t)LOG_MEL_N_FFT / 2) return false;
+
+    // Zero tail for the groups still overlapping real audio
+    const int n_groups = log_mel_n_groups(stream->n_samples);
+    const int remaining = n_groups - stream->n_groups;
+    if (remaining > 0) {
+        const size_t needed = (size_t)(remaining - 1) * LOG_MEL_GROUP_STEP + LOG_MEL_GROUP_SPAN;
+        if (stream->pending.size() < needed) {
+            stream->pending.resize(needed, 0.0f);
+        }
+        log_mel_stream_drain(stream);
+    }
+
+    log_mel_finalize(stream->n_mel, stream->n_samples, stream->raw, stream->n_groups, mel);
+
+    stream->pending.clear();
+    stream->pending.shrink_to_fit();
+    stream->raw.clear();
+    stream->raw.shrink_to_fit();
+    return true;
+}
@@ -0,0 +1,92 @@
+/**
+ * Whisper-compatible log-mel spectrogram
+ *
+ * Reproduces whisper.cpp's front end (400-sample Hann window, 160-sample
+ * hop, Slaney mel filterbank, log10 + dynamic range clamp) so the result
+ * can be handed to whisper_set_mel() instead of recomputing it from PCM
+ * inside whisper_full().
+ *
+ * Frames are computed four at a time, one per SIMD lane (NEON/SSE), with
+ * a 400-point real FFT done as a 200-point complex mixed-radix FFT and a
+ * sparse filterbank. The streaming variant consumes audio as it is
+ * captured so only the tail of the recording is left to do at the end.
+ */
+
+#ifndef AUDIO_LOG_MEL_H
+#define AUDIO_LOG_MEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define LOG_MEL_SAMPLE_RATE 16000
+#define LOG_MEL_N_FFT       400
+#define LOG_MEL_HOP         160
+#define LOG_MEL_N_BINS      (LOG_MEL_N_FFT / 2 + 1)
+
+// whisper pads 30 s of silence after the audio before computing the mel
+#define LOG_MEL_PAD_SAMPLES (LOG_MEL_SAMPLE_RATE * 30)
+
+/**
+ * Band-major spectrogram: data[band * n_len + frame], the layout
+ * whisper_set_mel() expects
+ */
+struct log_mel_spectrogram {
+    int n_mel;
+    int n_len;          // frames including the 30 s of trailing padding
+    int n_len_org;      // frames covering the real audio
+    std::vector<float> data;
+};
+
+/**
+ * Mel filterbank weights, n_mel rows of LOG_MEL_N_BINS
+ */
+struct mel_filterbank {
+    int n_mel;
+    std::vector<float> weights;
+};
+
+struct log_mel_plan;
+
+/**
+ * Incremental spectrogram of 16 kHz mono audio pushed in arbitrary chunks
+ */
+struct log_mel_stream {
+    int n_mel;
+    log_mel_plan *plan;
+    uint64_t n_samples;             // real samples pushed so far
+    int n_groups;                   // 4-frame groups computed so far
+    bool started;                   // reflective head pad applied
+    std::vector<float> pending;     // padded samples from frame n_groups * 4 onward
+    std::vector<float> raw;         // log10 energies, [group][band][lane]
+};
+
+/**
+ * Build the Slaney-normalised filterbank used by the whisper models
+ * (equivalent to librosa.filters.mel(sr=16000, n_fft=400, n_mels=n_mel))
+ */
+void mel_filterbank_init(mel_filterbank &filters, int n_mel);
+
+/**
+ * Compute the normalised log-mel spectrogram of 16 kHz mono audio
+ */
+bool log_mel_compute(const float *samples, int n_samples, int n_mel, int n_threads,
+                     log_mel_spectrogram &mel);
+
+log_mel_stream *log_mel_stream_init(int n_mel);
+
+void log_mel_stream_free(log_mel_stream *stream);
+
+/**
+ * Append samples and compute every frame whose window is now complete
+ */
+void log_mel_stream_push(log_mel_stream *stream, const float *samples, size_t n_samples);
+
+/**
+ * Pad, compute the remaining frames and normalise. Returns false if
+ * fewer than half a window of samples were pushed. The stream cannot
+ * be pushed to afterwards.
+ */
+bool log_mel_stream_finish(log_mel_stream *stream, log_mel_spectrogram &mel);
+
+#endif // AUDIO_LOG_MEL_H
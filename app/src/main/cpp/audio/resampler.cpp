@@ -0,0 +1,303 @@
+/**
+ * Polyphase resampler and channel down-mixer
+ *
+ * Windowed-sinc (Kaiser) FIR split into L polyphase branches so each
+ * output sample costs exactly `taps` multiply-adds regardless of the
+ * rate ratio. The inner dot product and the stereo down-mix use NEON
+ * on ARM and SSE on x86, with a scalar fallback for everything else.
+ */
+
+#include "resampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RESAMPLER_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RESAMPLER_SSE 1
+#endif
+
+#define KAISER_BETA 8.0
+#define RESAMPLER_ROLLOFF 0.85
+
+// ============================================================================
+// Filter design
+// ============================================================================
+
+// Zeroth-order modified Bessel function of the first kind (series expansion)
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double half_x = x / 2.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (half_x / k) * (half_x / k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+static void design_polyphase_filter(audio_resampler *rs) {
+    const int n = rs->up * rs->taps;
+    const double center = (n - 1) / 2.0;
+    // Cutoff relative to the upsampled rate, just below the lower Nyquist
+    const double cutoff = RESAMPLER_ROLLOFF * 0.5 / std::max(rs->up, rs->down);
+    const double i0_beta = bessel_i0(KAISER_BETA);
+
+    std::vector<double> proto(n);
+    for (int i = 0; i < n; i++) {
+        const double t = i - center;
+        const double x = 2.0 * cutoff * t;
+        const double sinc = (t == 0.0) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        const double r = 2.0 * i / (n - 1) - 1.0;
+        const double window = bessel_i0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        proto[i] = 2.0 * cutoff * sinc * window;
+    }
+
+    // Zero-stuffing by L divides the passband gain by L; compensate here
+    const double sum = std::accumulate(proto.begin(), proto.end(), 0.0);
+    const double gain = rs->up / sum;
+
+    // Branch p holds proto[p + k*L]; store reversed so it lines up with
+    // ascending input memory in the dot product
+    rs->coeffs.assign((size_t)n, 0.0f);
+    for (int p = 0; p < rs->up; p++) {
+        float *branch = rs->coeffs.data() + (size_t)p * rs->taps;
+        for (int k = 0; k < rs->taps; k++) {
+            branch[rs->taps - 1 - k] = (float)(proto[p + k * rs->up] * gain);
+        }
+    }
+}
+
+// ============================================================================
+// Vector kernels
+// ============================================================================
+
+static inline float dot_product(const float *a, const float *b, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(RESAMPLER_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    float lanes[4];
+    vst1q_f32(lanes, acc0);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(RESAMPLER_SSE)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc0);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void audio_downmix_s16(const int16_t *in, size_t n_frames, int channels, float *out) {
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+    if (channels == 1) {
+#if defined(RESAMPLER_NEON)
+        const float32x4_t vscale = vdupq_n_f32(scale);
+        for (; i + 8 <= n_frames; i += 8) {
+            int16x8_t s = vld1q_s16(in + i);
+            vst1q_f32(out + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))),  vscale));
+            vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), vscale));
+        }
+#endif
+        for (; i < n_frames; i++) {
+            out[i] = in[i] * scale;
+        }
+        return;
+    }
+
+    if (channels == 2) {
+        const float half_scale = scale * 0.5f;
+#if defined(RESAMPLER_NEON)
+        const float32x4_t vscale = vdupq_n_f32(half_scale);
+        for (; i + 8 <= n_frames; i += 8) {
+            int16x8x2_t lr = vld2q_s16(in + 2 * i);
+            int32x4_t lo = vaddl_s16(vget_low_s16(lr.val[0]),  vget_low_s16(lr.val[1]));
+            int32x4_t hi = vaddl_s16(vget_high_s16(lr.val[0]), vget_high_s16(lr.val[1]));
+            vst1q_f32(out + i,     vmulq_f32(vcvtq_f32_s32(lo), vscale));
+            vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(hi), vscale));
+        }
+#elif defined(RESAMPLER_SSE)
+        const __m128 vscale = _mm_set1_ps(half_scale);
+        for (; i + 4 <= n_frames; i += 4) {
+            // Sign-extend L/R pairs to 32 bits and sum them horizontally
+            __m128i s = _mm_loadu_si128((const __m128i *)(in + 2 * i));
+            __m128i sum = _mm_madd_epi16(s, _mm_set1_epi16(1));
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(sum), vscale));
+        }
+#endif
+        for (; i < n_frames; i++) {
+            out[i] = ((int32_t)in[2 * i] + in[2 * i + 1]) * half_scale;
+        }
+        return;
+    }
+
+    const float avg_scale = scale / channels;
+    for (; i < n_frames; i++) {
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++) {
+            sum += in[i * channels + c];
+        }
+        out[i] = sum * avg_scale;
+    }
+}
+
+// ============================================================================
+// Resampler
+// ============================================================================
+
+audio_resampler *audio_resampler_init(int in_rate, int out_rate, int taps) {
+    if (in_rate <= 0 || out_rate <= 0 || taps <= 0) {
+        return nullptr;
+    }
+
+    const int g = std::gcd(in_rate, out_rate);
+
+    audio_resampler *rs = new audio_resampler();
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->up = out_rate / g;
+    rs->down = in_rate / g;
+    rs->taps = taps;
+
+    design_polyphase_filter(rs);
+    audio_resampler_reset(rs);
+    return rs;
+}
+
+void audio_resampler_free(audio_resampler *rs) {
+    delete rs;
+}
+
+void audio_resampler_reset(audio_resampler *rs) {
+    rs->buffer.assign((size_t)rs->taps - 1, 0.0f);
+    rs->pos = (size_t)rs->taps - 1;
+    rs->phase = 0;
+}
+
+void audio_resampler_process(audio_resampler *rs, const float *in, size_t n_in, std::vector<float> &out) {
+    if (n_in == 0) return;
+
+    if (rs->up == 1 && rs->down == 1) {
+        out.insert(out.end(), in, in + n_in);
+        return;
+    }
+
+    rs->buffer.insert(rs->buffer.end(), in, in + n_in);
+
+    const size_t history = (size_t)rs->taps - 1;
+    const size_t n_buf = rs->buffer.size();
+    const float *buf = rs->buffer.data();
+
+    out.reserve(out.size() + (n_in * rs->up) / rs->down + 1);
+
+    while (rs->pos < n_buf) {
+        const float *branch = rs->coeffs.data() + (size_t)rs->phase * rs->taps;
+        out.push_back(dot_product(branch, buf + rs->pos - history, rs->taps));
+
+        rs->phase += rs->down;
+        rs->pos += rs->phase / rs->up;
+        rs->phase %= rs->up;
+    }
+
+    // Keep only the history needed for the next call
+    const size_t consumed = n_buf - history;
+    rs->buffer.erase(rs->buffer.begin(), rs->buffer.begin() + consumed);
+    rs->pos -= consumed;
+}
+
+void audio_resampler_flush(audio_resampler *rs, std::vector<float> &out) {
+    if (rs->up == 1 && rs->down == 1) return;
+
+    // Push half a filter of silence so the last real samples reach the output
+    std::vector<float> tail((size_t)rs->taps / 2, 0.0f);
+    audio_resampler_process(rs, tail.data(), tail.size(), out);
+}
+
+std::vector<float> audio_convert_to_whisper(const int16_t *in, size_t n_frames, int channels, int sample_rate) {
+    std::vector<float> mono(n_frames);
+    audio_downmix_s16(in, n_frames, channels, mono.data());
+
+    if (sample_rate == 16000) {
+        return mono;
+    }
+
+    std::vector<float> out;
+    audio_resampler *rs = audio_resampler_init(sample_rate, 16000);
+    if (!rs) {
+        return out;
+    }
+    audio_resampler_process(rs, mono.data(), mono.size(), out);
+    audio_resampler_flush(rs, out);
+    audio_resampler_free(rs);
+    return out;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+std::string audio_bench_resampler(void) {
+    struct bench_case {
+        int rate;
+        int channels;
+    };
+    const bench_case cases[] = {
+        { 48000, 1 },
+        { 48000, 2 },
+        { 44100, 1 },
+        { 44100, 2 },
+    };
+
+    // 60 seconds of a 440 Hz tone per case
+    const int seconds = 60;
+    std::string result;
+    char line[160];
+
+    for (const auto &c : cases) {
+        const size_t n_frames = (size_t)c.rate * seconds;
+        std::vector<int16_t> pcm(n_frames * c.channels);
+        for (size_t i = 0; i < n_frames; i++) {
+            const int16_t v = (int16_t)(8000.0 * std::sin(2.0 * M_PI * 440.0 * i / c.rate));
+            for (int ch = 0; ch < c.channels; ch++) {
+                pcm[i * c.channels + ch] = v;
+            }
+        }
+
+        const auto t_start = std::chrono::steady_clock::now();
+        std::vector<float> out = audio_convert_to_whisper(pcm.data(), n_frames, c.channels, c.rate);
+        const auto t_end = std::chrono::steady_clock::now();
+
+        const double secs = std::chrono::duration<double>(t_end - t_start).count();
+        snprintf(line, sizeof(line),
+                 "resample %5d Hz x%d -> 16000 Hz: %8.2f Msamples/s in, %7.1fx realtime (%zu out)\n",
+                 c.rate, c.channels, n_frames / secs / 1e6, seconds / secs, out.size());
+        result += line;
+    }
+
+    return result;
+}
@@ -0,0 +1,74 @@
+/**
+ * Polyphase resampler and channel down-mixer
+ *
+ * Converts device-rate PCM (44.1/48 kHz, mono or stereo) into the
+ * 16 kHz mono float format whisper expects. The resampler is streaming:
+ * it keeps its filter history between calls so audio can be fed in
+ * whatever buffer sizes AudioRecord hands us.
+ */
+
+#ifndef AUDIO_RESAMPLER_H
+#define AUDIO_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Filter taps per polyphase branch; 64 keeps the transition band under ~3.5 kHz at 48 kHz input
+#define RESAMPLER_DEFAULT_TAPS 64
+
+struct audio_resampler {
+    int in_rate;
+    int out_rate;
+    int up;                         // interpolation factor L
+    int down;                       // decimation factor M
+    int taps;                       // taps per phase
+
+    std::vector<float> coeffs;      // up * taps, each phase stored time-reversed
+    std::vector<float> buffer;      // (taps - 1) samples of history + pending input
+    size_t pos;                     // index in buffer of the newest sample of the next output
+    int phase;                      // current polyphase branch [0, up)
+};
+
+/**
+ * Create a resampler converting in_rate to out_rate.
+ * Returns nullptr if either rate is not positive.
+ */
+audio_resampler *audio_resampler_init(int in_rate, int out_rate, int taps = RESAMPLER_DEFAULT_TAPS);
+
+void audio_resampler_free(audio_resampler *rs);
+
+/**
+ * Clear filter history so the resampler can be reused for a new stream
+ */
+void audio_resampler_reset(audio_resampler *rs);
+
+/**
+ * Resample n_in mono samples, appending the produced samples to out
+ */
+void audio_resampler_process(audio_resampler *rs, const float *in, size_t n_in, std::vector<float> &out);
+
+/**
+ * Drain the filter delay line at end of stream
+ */
+void audio_resampler_flush(audio_resampler *rs, std::vector<float> &out);
+
+/**
+ * Down-mix interleaved 16-bit PCM to mono float in [-1, 1].
+ * out must hold n_frames samples.
+ */
+void audio_downmix_s16(const int16_t *in, size_t n_frames, int channels, float *out);
+
+/**
+ * One-shot conversion of interleaved 16-bit PCM at any rate to 16 kHz mono
+ */
+std::vector<float> audio_convert_to_whisper(const int16_t *in, size_t n_frames, int channels, int sample_rate);
+
+/**
+ * Throughput benchmark for the common capture/import conversions,
+ * reported in input samples per second.
+ */
+std::string audio_bench_resampler(void);
+
+#endif // AUDIO_RESAMPLER_H
@@ -0,0 +1,293 @@
+/**
+ * Bit-parallel approximate substring matcher (Myers/Hyyrö)
+ *
+ * Column j of the edit-distance matrix between pattern P (rows) and
+ * text T (columns) is kept as vertical deltas Pv/Mv (+1/-1 from row i-1
+ * to row i); the last row's score is tracked explicitly. Row 0 is zero in
+ * every column, which makes the search approximate-substring rather than
+ * whole-string: the horizontal deltas are shifted in with no carry.
+ */
+
+#include "approx_matcher.h"
+#include "lexicon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+approx_matcher *approx_matcher_init(const std::vector<std::u16string> &patterns,
+                                    const std::vector<int32_t> &max_errors) {
+    if (patterns.empty() || patterns.size() != max_errors.size()) return nullptr;
+
+    approx_matcher *am = new approx_matcher();
+    am->n_patterns = (int)patterns.size();
+
+    memset(am->symbol, 0, sizeof(am->symbol));
+    am->n_symbols = 1;
+    for (const std::u16string &pattern : patterns) {
+        if (pattern.empty() || pattern.size() > APPROX_MATCHER_MAX_LEN) {
+            delete am;
+            return nullptr;
+        }
+        for (char16_t c : pattern) {
+            if (c >= APPROX_MATCHER_ASCII) {
+                delete am;
+                return nullptr;
+            }
+            if (am->symbol[c] == 0) am->symbol[c] = (uint8_t)am->n_symbols++;
+        }
+    }
+
+    am->peq.assign((size_t)am->n_symbols * am->n_patterns, 0);
+    am->high_bit.resize(am->n_patterns);
+    am->lengths.resize(am->n_patterns);
+    am->max_errors = max_errors;
+    am->patterns = patterns;
+    for (int p = 0; p < am->n_patterns; p++) {
+        const std::u16string &pattern = patterns[p];
+        for (size_t i = 0; i < pattern.size(); i++) {
+            am->peq[(size_t)am->symbol[pattern[i]] * am->n_patterns + p] |= 1ull << i;
+        }
+        am->lengths[p] = (int32_t)pattern.size();
+        am->high_bit[p] = 1ull << (pattern.size() - 1);
+        const std::string ascii(pattern.begin(), pattern.end());
+        am->codes.push_back(lexicon_phonetic_code(ascii.data(), ascii.size()));
+    }
+    return am;
+}
+
+void approx_matcher_free(approx_matcher *am) {
+    delete am;
+}
+
+// ============================================================================
+// Scanning
+// ============================================================================
+
+void approx_matcher_scan(const approx_matcher *am, const char16_t *text, size_t n,
+                         approx_scratch &scratch, std::vector<approx_match> &matches) {
+    const int np = am->n_patterns;
+    scratch.pv.assign(np, ~0ull);
+    scratch.mv.assign(np, 0);
+    scratch.score.assign(am->lengths.begin(), am->lengths.end());
+    scratch.best.assign(am->lengths.begin(), am->lengths.end());
+    scratch.best_end.assign(np, 0);
+
+    // Separate arrays, no aliasing: the inner loop vectorises across patterns
+    uint64_t *__restrict pv = scratch.pv.data();
+    uint64_t *__restrict mv = scratch.mv.data();
+    int32_t *__restrict score = scratch.score.data();
+    int32_t *__restrict best = scratch.best.data();
+    int32_t *__restrict best_end = scratch.best_end.data();
+    const uint64_t *__restrict high_bit = am->high_bit.data();
+
+    for (size_t j = 0; j < n; j++) {
+        const char16_t c = text[j];
+        const int a = c < APPROX_MATCHER_ASCII ? am->symbol[c] : 0;
+        const uint64_t *__restrict eq_row = &am->peq[(size_t)a * np];
+        const int32_t end = (int32_t)(j + 1);
+
+        for (int p = 0; p < np; p++) {
+            const uint64_t eq = eq_row[p];
+            const uint64_t v = pv[p];
+            const uint64_t xv = eq | mv[p];
+            const uint64_t xh = (((eq & v) + v) ^ v) | eq;
+            uint64_t ph = mv[p] | ~(xh | v);
+            uint64_t mh = v & xh;
+
+            const int32_t s = score[p] + (int32_t)((ph & high_bit[p]) != 0) - (int32_t)((mh & high_bit[p]) != 0);
+            score[p] = s;
+
+            ph <<= 1;
+            mh <<= 1;
+            pv[p] = mh | ~(xv | ph);
+            mv[p] = ph & xv;
+
+            const bool better = s < best[p];
+            best[p] = better ? s : best[p];
+            best_end[p] = better ? end : best_end[p];
+        }
+    }
+
+    for (int p = 0; p < np; p++) {
+        if (best[p] <= am->max_errors[p] && best[p] < am->lengths[p]) {
+            matches.push_back({ p, best[p], best_end[p] });
+        }
+    }
+}
+
+// ============================================================================
+// Whole-word confirmation
+// ============================================================================
+
+static bool is_word_char(char16_t c) {
+    return (c >= u'a' && c <= u'z') || (c >= u'0' && c <= u'9');
+}
+
+// Levenshtein distance between key[0, n) and pattern, or bound + 1 once
+// it must exceed bound; one DP row on the stack
+static int32_t bounded_distance(const char *key, int n, const std::u16string &pattern, int32_t bound) {
+    const int m = (int)pattern.size();
+    int32_t row[APPROX_MATCHER_MAX_LEN + 1];
+    for (int j = 0; j <= m; j++) row[j] = j;
+
+    for (int i = 1; i <= n; i++) {
+        int32_t diag = row[0];
+        row[0] = i;
+        int32_t row_min = row[0];
+        for (int j = 1; j <= m; j++) {
+            const int32_t up = row[j];
+            row[j] = std::min({ up + 1, row[j - 1] + 1, diag + ((char16_t)key[i - 1] != pattern[j - 1] ? 1 : 0) });
+            diag = up;
+            row_min = std::min(row_min, row[j]);
+        }
+        if (row_min > bound) return bound + 1;
+    }
+    return row[m];
+}
+
+void approx_matcher_confirm(const approx_matcher *am, const char16_t *text, size_t n, int max_words,
+                            std::vector<approx_match> &matches) {
+    // A run longer than its pattern plus the bound can't be within it
+    char key[2 * APPROX_MATCHER_MAX_LEN + 1];
+    size_t kept = 0;
+
+    for (const approx_match &match : matches) {
+        const std::u16string &pattern = am->patterns[match.pattern];
+        const int m = (int)pattern.size();
+        const int32_t bound = am->max_errors[match.pattern];
+        const int max_len = std::min(m + bound, 2 * APPROX_MATCHER_MAX_LEN);
+        int32_t best = bound + 1;
+        int32_t best_end = 0;
+
+        for (size_t w = 0; w < n; w++) {
+            if (!is_word_char(text[w]) || (w > 0 && is_word_char(text[w - 1]))) continue;
+
+            // Extend the run from word w one word at a time
+            int len = 0;
+            size_t at = w;
+            for (int k = 0; k < max_words && at < n; k++) {
+                while (at < n && is_word_char(text[at]) && len <= max_len) key[len++] = (char)text[at++];
+                if (len > max_len) break;
+                if (len >= m - bound) {
+                    const int32_t errors = bounded_distance(key, len, pattern, bound);
+                    if (errors < best &&
+                        lexicon_phonetic_code(key, (size_t)len) == am->codes[match.pattern]) {
+                        best = errors;
+                        best_end = (int32_t)at;
+                    }
+                }
+                while (at < n && !is_word_char(text[at])) at++;
+            }
+        }
+
+        if (best <= bound) matches[kept++] = { match.pattern, best, best_end };
+    }
+    matches.resize(kept);
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+static double ms_since(std::chrono::steady_clock::time_point t_start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+}
+
+// Sellers: one DP column per text char, minimum of the last row
+static void dp_scan(const approx_matcher *am, const std::u16string &text, std::vector<approx_match> &matches) {
+    std::vector<int32_t> column(APPROX_MATCHER_MAX_LEN + 1);
+    for (int p = 0; p < am->n_patterns; p++) {
+        const std::u16string &pattern = am->patterns[p];
+        const int m = (int)pattern.size();
+        for (int i = 0; i <= m; i++) column[i] = i;
+
+        int32_t best = m;
+        int32_t best_end = 0;
+        for (size_t j = 0; j < text.size(); j++) {
+            int32_t diag = column[0];
+            column[0] = 0;
+            for (int i = 1; i <= m; i++) {
+                const int32_t up = column[i];
+                column[i] = std::min({ column[i - 1] + 1, up + 1, diag + (pattern[i - 1] != text[j] ? 1 : 0) });
+                diag = up;
+            }
+            if (column[m] < best) {
+                best = column[m];
+                best_end = (int32_t)(j + 1);
+            }
+        }
+        if (best <= am->max_errors[p] && best < m) {
+            matches.push_back({ p, best, best_end });
+        }
+    }
+}
+
+std::string approx_matcher_bench(const approx_matcher *am, int minutes) {
+    static const char *filler[] = {
+        "so", "i", "think", "we", "should", "have", "a", "look", "at", "your", "chest",
+        "and", "it", "has", "been", "about", "two", "weeks", "now", "the", "cough",
+        "is", "still", "there", "you", "can", "take", "this", "morning", "with", "food",
+        "come", "back", "if", "it", "gets", "worse", "okay", "thank", "doctor"
+    };
+    const int n_filler = (int)(sizeof(filler) / sizeof(filler[0]));
+
+    // ~150 spoken words a minute, one in twenty a pattern with a random edit
+    std::u16string text;
+    uint32_t seed = 12345;
+    auto rand = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    const int n_words = 150 * minutes;
+    for (int w = 0; w < n_words; w++) {
+        if (w > 0) text += u' ';
+        if (rand() % 20 == 0) {
+            std::u16string word = am->patterns[rand() % am->n_patterns];
+            const size_t at = rand() % word.size();
+            switch (rand() % 3) {
+                case 0: word[at] = (char16_t)('a' + rand() % 26); break;
+                case 1: if (word.size() > 1) word.erase(at, 1); break;
+                default: word.insert(at, 1, (char16_t)('a' + rand() % 26)); break;
+            }
+            text += word;
+        } else {
+            for (const char *c = filler[rand() % n_filler]; *c; c++) text += (char16_t)*c;
+        }
+    }
+
+    // Sentence-sized scans, as the extractor does them
+    const size_t sentence = 120;
+    approx_scratch scratch;
+    std::vector<approx_match> fast;
+    std::vector<approx_match> slow;
+
+    auto t_start = std::chrono::steady_clock::now();
+    for (size_t off = 0; off < text.size(); off += sentence) {
+        const size_t len = std::min(sentence, text.size() - off);
+        approx_matcher_scan(am, text.data() + off, len, scratch, fast);
+    }
+    const double fast_ms = ms_since(t_start);
+
+    t_start = std::chrono::steady_clock::now();
+    for (size_t off = 0; off < text.size(); off += sentence) {
+        dp_scan(am, text.substr(off, sentence), slow);
+    }
+    const double slow_ms = ms_since(t_start);
+
+    bool agree = fast.size() == slow.size();
+    for (size_t i = 0; agree && i < fast.size(); i++) {
+        agree = fast[i].pattern == slow[i].pattern && fast[i].errors == slow[i].errors && fast[i].end == slow[i].end;
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "approx matcher bench: %d min transcript (%zu chars), %d patterns, %zu matches\n"
+             "bit-parallel %.1f ms (%.2f MB/s), DP %.1f ms, %.1fx, %s\n",
+             minutes, text.size(), am->n_patterns, fast.size(),
+             fast_ms, text.size() * 2 / 1e3 / std::max(fast_ms, 1e-3), slow_ms,
+             slow_ms / std::max(fast_ms, 1e-3), agree ? "results agree" : "RESULTS DIFFER");
+    return std::string(buf);
+}
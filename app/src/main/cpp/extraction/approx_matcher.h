@@ -0,0 +1,95 @@
+/**
+ * Bit-parallel approximate substring matcher (Myers/Hyyrö)
+ *
+ * Finds, for each of a fixed set of patterns, the best place it occurs in
+ * a text within a per-pattern edit-distance bound: the minimum over all
+ * substrings of the text of the Levenshtein distance to the pattern. Each
+ * pattern's DP column lives in two 64-bit vectors, so one text character
+ * costs a handful of word operations per pattern; all patterns advance in
+ * lockstep in a single pass over the text and the match-vector table is
+ * laid out so that pass reads one contiguous row per character.
+ *
+ * Used for medication names that the transcriber mangled ("amoxicilin",
+ * "ibuprofin"). Patterns are 1..64 ASCII chars; text is UTF-16 with any
+ * character outside the patterns' alphabet counting as a mismatch.
+ */
+
+#ifndef APPROX_MATCHER_H
+#define APPROX_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define APPROX_MATCHER_MAX_LEN 64
+#define APPROX_MATCHER_ASCII 128
+
+struct approx_match {
+    int32_t pattern;                // index into the build list
+    int32_t errors;                 // edit distance of the best occurrence
+    int32_t end;                    // one past its last char (earliest on ties)
+};
+
+struct approx_matcher {
+    int n_patterns;
+    int n_symbols;                  // symbol 0 = in no pattern
+    uint8_t symbol[APPROX_MATCHER_ASCII];
+
+    std::vector<uint64_t> peq;      // n_symbols * n_patterns match vectors, one row per symbol
+    std::vector<uint64_t> high_bit; // per pattern, bit of the last pattern char
+    std::vector<int32_t> lengths;
+    std::vector<int32_t> max_errors;
+    std::vector<std::u16string> patterns;
+    std::vector<std::string> codes; // per pattern, its lexicon phonetic code
+};
+
+/**
+ * Per-scan pattern state, reused between scans so a scan allocates
+ * nothing once the scratch has grown to the matcher's size
+ */
+struct approx_scratch {
+    std::vector<uint64_t> pv;
+    std::vector<uint64_t> mv;
+    std::vector<int32_t> score;
+    std::vector<int32_t> best;
+    std::vector<int32_t> best_end;
+};
+
+/**
+ * Build a matcher; max_errors[i] bounds the edit distance reported for
+ * pattern i. Returns nullptr on an empty list, a size mismatch, or a
+ * pattern that is empty, longer than APPROX_MATCHER_MAX_LEN or not ASCII.
+ */
+approx_matcher *approx_matcher_init(const std::vector<std::u16string> &patterns,
+                                    const std::vector<int32_t> &max_errors);
+
+void approx_matcher_free(approx_matcher *am);
+
+/**
+ * Append one entry for each pattern that occurs in text[0, n) within its
+ * bound, in pattern order. Safe from several threads with one scratch each.
+ */
+void approx_matcher_scan(const approx_matcher *am, const char16_t *text, size_t n,
+                         approx_scratch &scratch, std::vector<approx_match> &matches);
+
+/**
+ * Keep the matches of a scan that whole words of text[0, n) also spell,
+ * for a scan of the text with its spaces removed, whose substrings can
+ * start or end mid-word. A match is confirmed by a run of up to max_words
+ * words (runs of a-z0-9) that, joined without spaces, is within the
+ * pattern's bound and has its phonetic code; its errors become the fewest
+ * edits of such a run. Allocates nothing but the phonetic codes of runs
+ * within bound.
+ */
+void approx_matcher_confirm(const approx_matcher *am, const char16_t *text, size_t n, int max_words,
+                            std::vector<approx_match> &matches);
+
+/**
+ * Bit-parallel scan against a per-pattern dynamic-programming scan
+ * (Sellers) on a synthetic transcript of the given length, with
+ * mis-spelled pattern occurrences mixed in; checks both agree
+ */
+std::string approx_matcher_bench(const approx_matcher *am, int minutes);
+
+#endif // APPROX_MATCHER_H
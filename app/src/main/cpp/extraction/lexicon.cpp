@@ -0,0 +1,580 @@
+/**
+ * Compiled medication lexicon with a trie and a phonetic index
+ *
+ * The builder lays the file out as header | entries | trie nodes |
+ * phonetic index | string pool, each section 4-byte aligned, written in
+ * host byte order (little-endian on every ABI the app ships). The trie is
+ * flattened breadth first so each node's children sit next to each other
+ * and a step is a short scan of at most 36 labels.
+ */
+
+#include "lexicon.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// ============================================================================
+// Keys and phonetic codes
+// ============================================================================
+
+static inline bool is_key_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+}
+
+static inline char to_lower_ascii(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+static std::string make_key(const std::string &name) {
+    std::string key;
+    key.reserve(name.size());
+    for (char c : name) {
+        c = to_lower_ascii(c);
+        if (is_key_char(c)) key += c;
+    }
+    return key;
+}
+
+static inline bool is_vowel(char c) {
+    return c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u' || c == 'y';
+}
+
+std::string lexicon_phonetic_code(const char *key, size_t len) {
+    std::string code;
+    code.reserve(len + 1);
+    auto push = [&code](char c) {
+        if (code.empty() || code.back() != c) code += c;
+    };
+
+    for (size_t i = 0; i < len; i++) {
+        const char c = key[i];
+        const char next = i + 1 < len ? key[i + 1] : '\0';
+        if (c >= '0' && c <= '9') {
+            push(c);
+            continue;
+        }
+        if (is_vowel(c)) {
+            if (i == 0) push('A');
+            continue;
+        }
+        switch (c) {
+            case 'b': push('B'); break;
+            case 'c':
+                if (next == 'h') { push('X'); i++; }
+                else if (next == 'e' || next == 'i' || next == 'y') push('S');
+                else { push('K'); if (next == 'k') i++; }
+                break;
+            case 'd': push('T'); break;
+            case 'f': case 'v': push('F'); break;
+            case 'g':
+                if (next == 'h') { push('K'); i++; }
+                else if (next == 'e' || next == 'i' || next == 'y') push('J');
+                else push('K');
+                break;
+            case 'j': push('J'); break;
+            case 'k': case 'q': push('K'); break;
+            case 'l': push('L'); break;
+            case 'm': push('M'); break;
+            case 'n': push('N'); break;
+            case 'p':
+                if (next == 'h') { push('F'); i++; }
+                else push('P');
+                break;
+            case 'r': push('R'); break;
+            case 's':
+                if (next == 'h') { push('X'); i++; }
+                else push('S');
+                break;
+            case 't':
+                if (next == 'h') { push('0'); i++; }
+                else push('T');
+                break;
+            case 'x':
+                if (i == 0) push('S');
+                else { push('K'); push('S'); }
+                break;
+            case 'z': push('S'); break;
+            default: break;             // h, w: silent between letters
+        }
+    }
+    return code;
+}
+
+static int max_errors(size_t key_len) {
+    return key_len < LEXICON_FUZZY_MIN_LENGTH ? 0 : (int)(key_len / LEXICON_CHARS_PER_ERROR);
+}
+
+// Levenshtein distance, or bound + 1 once it must exceed bound
+static int bounded_distance(const char *a, size_t n, const char *b, size_t m, int bound) {
+    if ((int)(n > m ? n - m : m - n) > bound) return bound + 1;
+    int row[LEXICON_MAX_KEY + 1];
+    for (size_t j = 0; j <= m; j++) row[j] = (int)j;
+    for (size_t i = 1; i <= n; i++) {
+        int diag = row[0];
+        row[0] = (int)i;
+        int row_min = row[0];
+        for (size_t j = 1; j <= m; j++) {
+            const int up = row[j];
+            row[j] = std::min({ up + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1]) });
+            diag = up;
+            row_min = std::min(row_min, row[j]);
+        }
+        if (row_min > bound) return bound + 1;
+    }
+    return row[m];
+}
+
+// ============================================================================
+// Building
+// ============================================================================
+
+static uint32_t align4(size_t n) {
+    return (uint32_t)((n + 3) & ~(size_t)3);
+}
+
+bool lexicon_build(const std::vector<lexicon_source_entry> &source, std::vector<uint8_t> &out,
+                   std::string *error) {
+    struct staged {
+        std::string name;
+        std::string key;
+        std::string code;
+        uint32_t canonical;
+    };
+    std::vector<staged> staged_entries;
+    std::unordered_map<std::string, uint32_t> by_key;
+
+    auto add = [&](const std::string &name) -> int64_t {
+        std::string key = make_key(name);
+        if (key.empty() || key.size() > LEXICON_MAX_KEY || name.size() > UINT16_MAX) return -1;
+        auto it = by_key.find(key);
+        if (it != by_key.end()) return it->second;
+        const uint32_t index = (uint32_t)staged_entries.size();
+        std::string code = lexicon_phonetic_code(key.data(), key.size());
+        staged_entries.push_back({ name, std::move(key), std::move(code), index });
+        by_key.emplace(staged_entries.back().key, index);
+        return index;
+    };
+
+    // Names first so their order decides which of a shared key wins, then
+    // the canonical names they point at
+    std::vector<int64_t> indices;
+    indices.reserve(source.size());
+    for (const lexicon_source_entry &e : source) indices.push_back(add(e.name));
+    for (size_t i = 0; i < source.size(); i++) {
+        if (indices[i] < 0 || source[i].canonical.empty()) continue;
+        const int64_t canonical = add(source[i].canonical);
+        if (canonical >= 0 && staged_entries[indices[i]].canonical == (uint32_t)indices[i]) {
+            staged_entries[indices[i]].canonical = (uint32_t)canonical;
+        }
+    }
+    if (staged_entries.empty()) {
+        if (error) *error = "no usable entries";
+        return false;
+    }
+
+    // Resolve chains (brand -> misspelling -> generic) to their end
+    for (staged &e : staged_entries) {
+        for (int step = 0; step < 8 && staged_entries[e.canonical].canonical != e.canonical; step++) {
+            e.canonical = staged_entries[e.canonical].canonical;
+        }
+    }
+
+    // Trie over the keys, flattened breadth first
+    struct trie_node {
+        std::map<char, uint32_t> children;
+        int32_t entry = -1;
+    };
+    std::vector<trie_node> trie(1);
+    for (uint32_t i = 0; i < staged_entries.size(); i++) {
+        uint32_t s = 0;
+        for (char c : staged_entries[i].key) {
+            auto it = trie[s].children.find(c);
+            if (it == trie[s].children.end()) {
+                const uint32_t t = (uint32_t)trie.size();
+                trie[s].children.emplace(c, t);
+                trie.emplace_back();
+                s = t;
+            } else {
+                s = it->second;
+            }
+        }
+        trie[s].entry = (int32_t)i;
+    }
+
+    std::vector<uint32_t> order;        // BFS position -> trie node
+    std::vector<char> labels;
+    order.reserve(trie.size());
+    labels.reserve(trie.size());
+    order.push_back(0);
+    labels.push_back('\0');
+    for (size_t head = 0; head < order.size(); head++) {
+        for (const auto &child : trie[order[head]].children) {
+            order.push_back(child.second);
+            labels.push_back(child.first);
+        }
+    }
+
+    // String pool
+    std::string pool;
+    std::vector<lexicon_entry> entries(staged_entries.size());
+    for (size_t i = 0; i < staged_entries.size(); i++) {
+        const staged &e = staged_entries[i];
+        entries[i].name_off = (uint32_t)pool.size();
+        entries[i].name_len = (uint16_t)e.name.size();
+        pool += e.name;
+        entries[i].key_off = (uint32_t)pool.size();
+        entries[i].key_len = (uint8_t)e.key.size();
+        pool += e.key;
+        entries[i].code_off = (uint32_t)pool.size();
+        entries[i].code_len = (uint8_t)e.code.size();
+        pool += e.code;
+        entries[i].canonical = e.canonical;
+    }
+
+    // Phonetic index: entries by code, shorter keys first
+    std::vector<uint32_t> phonetic(staged_entries.size());
+    for (uint32_t i = 0; i < phonetic.size(); i++) phonetic[i] = i;
+    std::stable_sort(phonetic.begin(), phonetic.end(), [&](uint32_t a, uint32_t b) {
+        const int c = staged_entries[a].code.compare(staged_entries[b].code);
+        return c != 0 ? c < 0 : staged_entries[a].key.size() < staged_entries[b].key.size();
+    });
+
+    // Layout
+    lexicon_header header = {};
+    header.magic = LEXICON_MAGIC;
+    header.version = LEXICON_VERSION;
+    header.n_entries = (uint32_t)entries.size();
+    header.n_nodes = (uint32_t)order.size();
+    header.entries_off = align4(sizeof(lexicon_header));
+    header.nodes_off = align4(header.entries_off + entries.size() * sizeof(lexicon_entry));
+    header.phonetic_off = align4(header.nodes_off + order.size() * sizeof(lexicon_node));
+    header.strings_off = align4(header.phonetic_off + phonetic.size() * sizeof(uint32_t));
+    header.strings_size = (uint32_t)pool.size();
+    header.file_size = header.strings_off + header.strings_size;
+
+    out.assign(header.file_size, 0);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + header.entries_off, entries.data(), entries.size() * sizeof(lexicon_entry));
+
+    std::vector<uint32_t> position(trie.size());
+    for (uint32_t p = 0; p < order.size(); p++) position[order[p]] = p;
+    lexicon_node *nodes = (lexicon_node *)(out.data() + header.nodes_off);
+    for (uint32_t p = 0; p < order.size(); p++) {
+        const trie_node &t = trie[order[p]];
+        nodes[p].first_child = t.children.empty() ? 0 : position[t.children.begin()->second];
+        nodes[p].n_children = (uint16_t)t.children.size();
+        nodes[p].ch = (uint8_t)labels[p];
+        nodes[p].pad = 0;
+        nodes[p].entry = t.entry;
+    }
+
+    memcpy(out.data() + header.phonetic_off, phonetic.data(), phonetic.size() * sizeof(uint32_t));
+    memcpy(out.data() + header.strings_off, pool.data(), pool.size());
+    return true;
+}
+
+// Next CSV field from line[pos], honouring double quotes
+static std::string csv_field(const std::string &line, size_t &pos) {
+    std::string field;
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
+    if (pos < line.size() && line[pos] == '"') {
+        pos++;
+        while (pos < line.size()) {
+            if (line[pos] == '"') {
+                if (pos + 1 < line.size() && line[pos + 1] == '"') {
+                    field += '"';
+                    pos += 2;
+                    continue;
+                }
+                pos++;
+                break;
+            }
+            field += line[pos++];
+        }
+        while (pos < line.size() && line[pos] != ',') pos++;
+    } else {
+        while (pos < line.size() && line[pos] != ',') field += line[pos++];
+        while (!field.empty() && (field.back() == ' ' || field.back() == '\t')) field.pop_back();
+    }
+    if (pos < line.size()) pos++;   // the comma
+    return field;
+}
+
+bool lexicon_read_csv(const char *path, std::vector<lexicon_source_entry> &entries, std::string *error) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        if (error) *error = std::string("can't open ") + path;
+        return false;
+    }
+
+    std::string line;
+    bool first = true;
+    int c;
+    do {
+        c = fgetc(f);
+        if (c != '\n' && c != EOF) {
+            if (c != '\r') line += (char)c;
+            continue;
+        }
+        // Strip a UTF-8 byte order mark on the first line
+        if (first && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+
+        size_t pos = 0;
+        const std::string name = csv_field(line, pos);
+        const std::string canonical = csv_field(line, pos);
+        const bool header = first && make_key(name) == "name";
+        if (!name.empty() && name[0] != '#' && !header) {
+            entries.push_back({ name, canonical });
+        }
+        first = false;
+        line.clear();
+    } while (c != EOF);
+
+    fclose(f);
+    return true;
+}
+
+// Make a rename in the directory holding path durable
+static void sync_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    const std::string dir = slash ? std::string(path, slash == path ? 1 : slash - path) : ".";
+    const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+bool lexicon_write(const std::vector<uint8_t> &bytes, const char *out_path, std::string *error) {
+    const std::string tmp_path = std::string(out_path) + ".tmp";
+    FILE *f = fopen(tmp_path.c_str(), "wb");
+    if (!f) {
+        if (error) *error = std::string("can't write ") + tmp_path;
+        return false;
+    }
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    // On disk before the rename, so a crash never leaves a short file under
+    // the lexicon's name
+    ok = (fflush(f) == 0) && ok;
+    ok = (fsync(fileno(f)) == 0) && ok;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmp_path.c_str(), out_path) != 0) {
+        remove(tmp_path.c_str());
+        if (error) *error = std::string("can't write ") + out_path;
+        return false;
+    }
+    sync_parent_dir(out_path);
+    return true;
+}
+
+bool lexicon_compile_csv(const char *csv_path, const char *out_path, std::string *error) {
+    std::vector<lexicon_source_entry> entries;
+    std::vector<uint8_t> bytes;
+    return lexicon_read_csv(csv_path, entries, error) &&
+           lexicon_build(entries, bytes, error) &&
+           lexicon_write(bytes, out_path, error);
+}
+
+// ============================================================================
+// Opening
+// ============================================================================
+
+static bool lexicon_validate(lexicon *lex) {
+    if (lex->size < sizeof(lexicon_header)) return false;
+    const lexicon_header *h = (const lexicon_header *)lex->base;
+    if (h->magic != LEXICON_MAGIC || h->version != LEXICON_VERSION) return false;
+    if (h->file_size != lex->size || h->n_entries == 0 || h->n_nodes == 0) return false;
+
+    const uint64_t entries_end = (uint64_t)h->entries_off + (uint64_t)h->n_entries * sizeof(lexicon_entry);
+    const uint64_t nodes_end = (uint64_t)h->nodes_off + (uint64_t)h->n_nodes * sizeof(lexicon_node);
+    const uint64_t phonetic_end = (uint64_t)h->phonetic_off + (uint64_t)h->n_entries * sizeof(uint32_t);
+    const uint64_t strings_end = (uint64_t)h->strings_off + h->strings_size;
+    if (entries_end > lex->size || nodes_end > lex->size || phonetic_end > lex->size || strings_end > lex->size) {
+        return false;
+    }
+    if ((h->entries_off | h->nodes_off | h->phonetic_off) & 3) return false;
+
+    lex->header = h;
+    lex->entries = (const lexicon_entry *)(lex->base + h->entries_off);
+    lex->nodes = (const lexicon_node *)(lex->base + h->nodes_off);
+    lex->phonetic = (const uint32_t *)(lex->base + h->phonetic_off);
+    lex->strings = (const char *)(lex->base + h->strings_off);
+
+    // Everything a lookup dereferences stays in bounds
+    for (uint32_t i = 0; i < h->n_entries; i++) {
+        const lexicon_entry &e = lex->entries[i];
+        if ((uint64_t)e.name_off + e.name_len > h->strings_size ||
+            (uint64_t)e.key_off + e.key_len > h->strings_size ||
+            (uint64_t)e.code_off + e.code_len > h->strings_size ||
+            e.key_len > LEXICON_MAX_KEY || e.canonical >= h->n_entries || lex->phonetic[i] >= h->n_entries) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->n_nodes; i++) {
+        const lexicon_node &node = lex->nodes[i];
+        if ((uint64_t)node.first_child + node.n_children > h->n_nodes ||
+            node.entry >= (int32_t)h->n_entries) {
+            return false;
+        }
+    }
+    return true;
+}
+
+lexicon *lexicon_open(const char *path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+
+    lexicon *lex = new lexicon();
+    lex->base = (const uint8_t *)data;
+    lex->size = (size_t)st.st_size;
+    lex->mapped = true;
+    if (!lexicon_validate(lex)) {
+        lexicon_close(lex);
+        return nullptr;
+    }
+    return lex;
+}
+
+lexicon *lexicon_from_memory(const uint8_t *data, size_t size) {
+    lexicon *lex = new lexicon();
+    lex->base = data;
+    lex->size = size;
+    lex->mapped = false;
+    if (!lexicon_validate(lex)) {
+        delete lex;
+        return nullptr;
+    }
+    return lex;
+}
+
+void lexicon_close(lexicon *lex) {
+    if (!lex) return;
+    if (lex->mapped) munmap((void *)lex->base, lex->size);
+    delete lex;
+}
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+static inline int32_t trie_step(const lexicon *lex, int32_t s, char c) {
+    const lexicon_node &node = lex->nodes[s];
+    for (uint32_t k = node.first_child; k < node.first_child + node.n_children; k++) {
+        if (lex->nodes[k].ch == (uint8_t)c) return (int32_t)k;
+    }
+    return -1;
+}
+
+// Fewest errors, then longest key, then leftmost
+static inline bool better(const lexicon *lex, const lexicon_match &a, const lexicon_match &b) {
+    if (a.errors != b.errors) return a.errors < b.errors;
+    const int la = lex->entries[a.entry].key_len;
+    const int lb = lex->entries[b.entry].key_len;
+    if (la != lb) return la > lb;
+    return a.start < b.start;
+}
+
+// Codes compare like std::string: bytes, then length
+static inline int compare_code(const lexicon *lex, uint32_t entry, const std::string &code) {
+    const lexicon_entry &e = lex->entries[entry];
+    const int c = memcmp(lex->strings + e.code_off, code.data(), std::min<size_t>(e.code_len, code.size()));
+    if (c != 0) return c;
+    return (int)e.code_len - (int)code.size();
+}
+
+// Candidates sharing the window's phonetic code, within their bound
+static void phonetic_candidates(const lexicon *lex, const char *key, size_t len, int32_t start, int32_t end,
+                                lexicon_match &best, bool &found) {
+    const std::string code = lexicon_phonetic_code(key, len);
+    const uint32_t *last = lex->phonetic + lex->header->n_entries;
+    const uint32_t *p = std::lower_bound(lex->phonetic, last, code, [lex](uint32_t entry, const std::string &c) {
+        return compare_code(lex, entry, c) < 0;
+    });
+
+    for (; p != last && compare_code(lex, *p, code) == 0; p++) {
+        const lexicon_entry &e = lex->entries[*p];
+        const int bound = max_errors(e.key_len);
+        if (bound == 0) continue;       // exact-only keys were tried on the trie
+        const int errors = bounded_distance(key, len, lex->strings + e.key_off, e.key_len, bound);
+        if (errors > bound) continue;
+
+        const lexicon_match candidate = { (int32_t)*p, (int32_t)e.canonical, errors, start, end };
+        if (!found || better(lex, candidate, best)) {
+            best = candidate;
+            found = true;
+        }
+    }
+}
+
+static inline bool is_key_char16(char16_t c) {
+    return (c >= u'a' && c <= u'z') || (c >= u'0' && c <= u'9') || (c >= u'A' && c <= u'Z');
+}
+
+bool lexicon_find(const lexicon *lex, const char16_t *text, size_t n, lexicon_match &match) {
+    // Words: runs of a-z0-9
+    struct word {
+        int32_t start;
+        int32_t end;
+    };
+    std::vector<word> words;
+    for (size_t i = 0; i < n; ) {
+        if (!is_key_char16(text[i])) {
+            i++;
+            continue;
+        }
+        const size_t start = i;
+        while (i < n && is_key_char16(text[i])) i++;
+        words.push_back({ (int32_t)start, (int32_t)i });
+    }
+
+    bool found = false;
+    char key[LEXICON_MAX_KEY];
+    for (size_t w = 0; w < words.size(); w++) {
+        size_t len = 0;
+        int32_t s = 0;                  // trie state, -1 once no key continues the window
+
+        for (size_t k = w; k < words.size() && k < w + LEXICON_MAX_WINDOW; k++) {
+            const size_t word_start = len;
+            if (len + (size_t)(words[k].end - words[k].start) > LEXICON_MAX_KEY) break;
+            for (int32_t i = words[k].start; i < words[k].end; i++) {
+                key[len++] = to_lower_ascii((char)text[i]);
+            }
+            for (size_t i = word_start; i < len && s >= 0; i++) s = trie_step(lex, s, key[i]);
+
+            const int32_t start = words[w].start;
+            const int32_t end = words[k].end;
+            if (s >= 0 && lex->nodes[s].entry >= 0) {
+                const int32_t entry = lex->nodes[s].entry;
+                const lexicon_match candidate = { entry, (int32_t)lex->entries[entry].canonical, 0, start, end };
+                if (!found || better(lex, candidate, match)) {
+                    match = candidate;
+                    found = true;
+                }
+                continue;
+            }
+
+            // Nothing fuzzy beats an exact match
+            if (found && match.errors == 0) continue;
+            if (len >= LEXICON_FUZZY_MIN_LENGTH) phonetic_candidates(lex, key, len, start, end, match, found);
+        }
+    }
+    return found;
+}
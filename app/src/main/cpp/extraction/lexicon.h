@@ -0,0 +1,166 @@
+/**
+ * Compiled medication lexicon with a trie and a phonetic index
+ *
+ * A lexicon is a flat, little-endian file meant to be memory-mapped and
+ * read in place: a header, the entries, a trie over the entries' keys,
+ * the entry indices sorted by phonetic code, and one string pool. Nothing
+ * is parsed or allocated when it is opened, so a lexicon of tens of
+ * thousands of names costs page-cache only for the parts lookups touch.
+ *
+ * Each entry has a display name, a key (the name lower-cased with
+ * everything but a-z and 0-9 removed, so "Co-codamol" and "co codamol"
+ * share "cocodamol"), a phonetic code of the key, and the entry it stands
+ * for: a brand or a known mis-transcription can point at its generic
+ * name.
+ *
+ * Lookups work on token windows: runs of 1..LEXICON_MAX_WINDOW consecutive
+ * words of lower-cased text, joined into one key. The trie is walked word
+ * by word from each start, so windows no key continues are abandoned
+ * early; windows with no exact key look up their phonetic code and keep
+ * the candidate with the fewest edits within the per-length bound.
+ *
+ * The phonetic code is a simplified Metaphone: consonant classes with
+ * common digraphs (ph, th, sh, ch, ck) folded, vowels dropped after the
+ * first letter, and repeats collapsed.
+ */
+
+#ifndef LEXICON_H
+#define LEXICON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define LEXICON_MAGIC 0x58454C4D         // "MLEX"
+#define LEXICON_VERSION 1
+#define LEXICON_MAX_KEY 64
+#define LEXICON_MAX_WINDOW 4            // words per token window
+
+// Keys shorter than this must match exactly; longer ones may differ by one
+// edit per LEXICON_CHARS_PER_ERROR chars
+#define LEXICON_FUZZY_MIN_LENGTH 6
+#define LEXICON_CHARS_PER_ERROR 5
+
+// ============================================================================
+// File layout
+// ============================================================================
+
+struct lexicon_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_entries;
+    uint32_t n_nodes;
+    uint32_t entries_off;           // lexicon_entry[n_entries]
+    uint32_t nodes_off;             // lexicon_node[n_nodes], root first
+    uint32_t phonetic_off;          // uint32_t[n_entries], entry indices by code
+    uint32_t strings_off;           // string pool
+    uint32_t strings_size;
+    uint32_t file_size;
+};
+
+struct lexicon_entry {
+    uint32_t name_off;              // display name, UTF-8, in the pool
+    uint32_t key_off;               // a-z0-9 key
+    uint32_t code_off;              // phonetic code of the key
+    uint16_t name_len;
+    uint8_t key_len;
+    uint8_t code_len;
+    uint32_t canonical;             // entry this name stands for (itself if none)
+};
+
+struct lexicon_node {
+    uint32_t first_child;           // children are contiguous, sorted by ch
+    uint16_t n_children;
+    uint8_t ch;                     // edge label from the parent
+    uint8_t pad;
+    int32_t entry;                  // entry whose key ends here, or -1
+};
+
+// ============================================================================
+// Building
+// ============================================================================
+
+struct lexicon_source_entry {
+    std::string name;
+    std::string canonical;          // empty: the name stands for itself
+};
+
+/**
+ * Compile entries into lexicon file bytes. Names with an empty or too long
+ * key are skipped; of names sharing a key, the first wins. A canonical
+ * name that isn't an entry itself is added as one. Returns false if no
+ * entry is left.
+ */
+bool lexicon_build(const std::vector<lexicon_source_entry> &entries, std::vector<uint8_t> &out,
+                   std::string *error = nullptr);
+
+/**
+ * Read "name,canonical" rows (canonical optional, double quotes allowed,
+ * '#' comments and a "name,..." header line skipped)
+ */
+bool lexicon_read_csv(const char *path, std::vector<lexicon_source_entry> &entries, std::string *error = nullptr);
+
+/**
+ * lexicon_read_csv then lexicon_build, written to out_path via a temp
+ * file and rename
+ */
+bool lexicon_compile_csv(const char *csv_path, const char *out_path, std::string *error = nullptr);
+
+bool lexicon_write(const std::vector<uint8_t> &bytes, const char *out_path, std::string *error = nullptr);
+
+// ============================================================================
+// Lookup
+// ============================================================================
+
+struct lexicon {
+    const uint8_t *base;
+    size_t size;
+    bool mapped;                    // base is an mmap to unmap on close
+
+    const lexicon_header *header;
+    const lexicon_entry *entries;
+    const lexicon_node *nodes;
+    const uint32_t *phonetic;
+    const char *strings;
+};
+
+struct lexicon_match {
+    int32_t entry;                  // matched name
+    int32_t canonical;              // entry it stands for
+    int32_t errors;                 // edits between the window and the key
+    int32_t start;                  // window's first char in the text
+    int32_t end;                    // one past its last char
+};
+
+/**
+ * Memory-map a lexicon file. Returns nullptr if it can't be read or fails
+ * validation.
+ */
+lexicon *lexicon_open(const char *path);
+
+/**
+ * Use lexicon bytes in place (they must outlive the lexicon)
+ */
+lexicon *lexicon_from_memory(const uint8_t *data, size_t size);
+
+void lexicon_close(lexicon *lex);
+
+/**
+ * Best candidate over every token window of lower-cased text[0, n): fewest
+ * errors, then longest key, then leftmost. Returns false if none is within
+ * its bound. Read-only, safe from several threads.
+ */
+bool lexicon_find(const lexicon *lex, const char16_t *text, size_t n, lexicon_match &match);
+
+/**
+ * Phonetic code of an a-z0-9 key
+ */
+std::string lexicon_phonetic_code(const char *key, size_t len);
+
+inline std::string lexicon_name(const lexicon *lex, int32_t entry) {
+    const lexicon_entry &e = lex->entries[entry];
+    return std::string(lex->strings + e.name_off, e.name_len);
+}
+
+#endif // LEXICON_H
@@ -0,0 +1,201 @@
+/**
+ * Multi-pattern substring matcher (Aho–Corasick)
+ *
+ * The trie is built with -1 for missing edges, then a breadth-first pass
+ * computes failure links and fills every missing edge with the failure
+ * state's edge, which turns the trie into a complete DFA. Each state also
+ * keeps a dictionary link to the nearest shorter suffix that ends a
+ * pattern, so emitting the hits at a position only walks states that
+ * actually have output.
+ *
+ * Folding happens on the fly: the scanner reads a whole number as one '#'
+ * symbol, or a run of whitespace as one ' ', and remembers where the last
+ * few symbols started in a small ring, which maps a hit's start back to
+ * the original text.
+ */
+
+#include "pattern_matcher.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+static int add_state(pattern_matcher *pm) {
+    pm->next.resize(pm->next.size() + pm->n_symbols, -1);
+    return pm->n_states++;
+}
+
+pattern_matcher *pattern_matcher_init(const std::vector<std::u16string> &patterns, int flags) {
+    if (patterns.empty()) return nullptr;
+
+    pattern_matcher *pm = new pattern_matcher();
+    pm->flags = flags;
+
+    // Alphabet: the characters patterns actually use, everything else is 0
+    memset(pm->symbol, 0, sizeof(pm->symbol));
+    pm->n_symbols = 1;
+    for (const std::u16string &pattern : patterns) {
+        if (pattern.empty()) {
+            delete pm;
+            return nullptr;
+        }
+        for (char16_t c : pattern) {
+            if (c >= PATTERN_MATCHER_ASCII) {
+                delete pm;
+                return nullptr;
+            }
+            if (pm->symbol[c] == 0) pm->symbol[c] = (uint8_t)pm->n_symbols++;
+        }
+    }
+
+    // Trie
+    pm->n_states = 0;
+    add_state(pm);
+    std::vector<std::vector<int32_t>> own(1);
+    pm->lengths.resize(patterns.size());
+    pm->max_length = 0;
+    for (size_t p = 0; p < patterns.size(); p++) {
+        int s = 0;
+        for (char16_t c : patterns[p]) {
+            const size_t edge = (size_t)s * pm->n_symbols + pm->symbol[c];
+            if (pm->next[edge] < 0) {
+                const int t = add_state(pm);
+                pm->next[edge] = t;
+                own.emplace_back();
+            }
+            s = pm->next[edge];
+        }
+        own[s].push_back((int32_t)p);
+        pm->lengths[p] = (int32_t)patterns[p].size();
+        pm->max_length = std::max(pm->max_length, pm->lengths[p]);
+    }
+
+    // Failure and dictionary links, breadth first so both are final for
+    // every shallower state by the time a state is reached
+    std::vector<int32_t> fail(pm->n_states, 0);
+    pm->dict.assign(pm->n_states, 0);
+    std::vector<int32_t> queue;
+    queue.reserve(pm->n_states);
+
+    for (int a = 0; a < pm->n_symbols; a++) {
+        int32_t &edge = pm->next[a];
+        if (edge < 0) {
+            edge = 0;
+        } else {
+            queue.push_back(edge);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        const int s = queue[head];
+        const int f = fail[s];
+        pm->dict[s] = own[f].empty() ? pm->dict[f] : f;
+
+        int32_t *edges = &pm->next[(size_t)s * pm->n_symbols];
+        const int32_t *fail_edges = &pm->next[(size_t)f * pm->n_symbols];
+        for (int a = 0; a < pm->n_symbols; a++) {
+            if (edges[a] < 0) {
+                edges[a] = fail_edges[a];
+            } else {
+                fail[edges[a]] = fail_edges[a];
+                queue.push_back(edges[a]);
+            }
+        }
+    }
+
+    // Flatten the per-state outputs
+    pm->out_begin.resize(pm->n_states + 1);
+    pm->out.clear();
+    pm->out.reserve(patterns.size());
+    for (int s = 0; s < pm->n_states; s++) {
+        pm->out_begin[s] = (int32_t)pm->out.size();
+        pm->out.insert(pm->out.end(), own[s].begin(), own[s].end());
+    }
+    pm->out_begin[pm->n_states] = (int32_t)pm->out.size();
+
+    return pm;
+}
+
+void pattern_matcher_free(pattern_matcher *pm) {
+    delete pm;
+}
+
+// ============================================================================
+// Scanning
+// ============================================================================
+
+static inline bool is_digit(char16_t c) {
+    return c >= u'0' && c <= u'9';
+}
+
+static inline bool is_space(char16_t c) {
+    return c == u' ' || (c >= u'\t' && c <= u'\r');
+}
+
+// Emit the patterns ending in state s; start_of(len) gives the start of
+// a pattern of that many symbols ending here
+template <typename StartOf>
+static inline void emit_hits(const pattern_matcher *pm, int32_t s, int32_t end, StartOf start_of,
+                             std::vector<pattern_hit> &hits) {
+    for (int32_t t = s; t != 0; t = pm->dict[t]) {
+        for (int32_t k = pm->out_begin[t]; k < pm->out_begin[t + 1]; k++) {
+            const int32_t p = pm->out[k];
+            hits.push_back({ p, start_of(pm->lengths[p]), end });
+        }
+    }
+}
+
+void pattern_matcher_scan(const pattern_matcher *pm, const char16_t *text, size_t n,
+                          std::vector<pattern_hit> &hits) {
+    const int32_t *next = pm->next.data();
+    const int n_symbols = pm->n_symbols;
+    int32_t s = 0;
+
+    if (!(pm->flags & (PATTERN_MATCHER_FOLD_NUMBERS | PATTERN_MATCHER_FOLD_SPACES))) {
+        for (size_t i = 0; i < n; i++) {
+            const char16_t c = text[i];
+            const int a = c < PATTERN_MATCHER_ASCII ? pm->symbol[c] : 0;
+            s = next[(size_t)s * n_symbols + a];
+
+            const int32_t end = (int32_t)(i + 1);
+            emit_hits(pm, s, end, [end](int32_t len) { return end - len; }, hits);
+        }
+        return;
+    }
+
+    // Start offsets of the last ring_size symbols, indexed by symbol count
+    size_t ring_size = 1;
+    while (ring_size < (size_t)pm->max_length) ring_size <<= 1;
+    std::vector<int32_t> ring(ring_size);
+    const size_t mask = ring_size - 1;
+    const bool fold_numbers = pm->flags & PATTERN_MATCHER_FOLD_NUMBERS;
+    const bool fold_spaces = pm->flags & PATTERN_MATCHER_FOLD_SPACES;
+    const int number = pm->symbol[u'#'];
+
+    size_t k = 0;
+    for (size_t i = 0; i < n; ) {
+        const size_t start = i;
+        int a;
+        if (fold_numbers && is_digit(text[i])) {
+            while (i < n && is_digit(text[i])) i++;
+            if (i + 1 < n && text[i] == u'.' && is_digit(text[i + 1])) {
+                i++;
+                while (i < n && is_digit(text[i])) i++;
+            }
+            a = number;
+        } else if (fold_spaces && is_space(text[i])) {
+            while (i < n && is_space(text[i])) i++;
+            a = pm->symbol[u' '];
+        } else {
+            const char16_t c = text[i++];
+            a = c < PATTERN_MATCHER_ASCII && !(fold_numbers && c == u'#') ? pm->symbol[c] : 0;
+        }
+        ring[k & mask] = (int32_t)start;
+        k++;
+        s = next[(size_t)s * n_symbols + a];
+
+        emit_hits(pm, s, (int32_t)i, [&ring, k, mask](int32_t len) { return ring[(k - len) & mask]; }, hits);
+    }
+}
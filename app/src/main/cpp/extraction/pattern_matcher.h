@@ -0,0 +1,72 @@
+/**
+ * Multi-pattern substring matcher (Aho–Corasick)
+ *
+ * Compiles a fixed set of literal patterns into one automaton and reports
+ * every occurrence of every pattern, overlapping ones included, in a
+ * single pass over the text. The goto/failure structure is flattened into
+ * a full DFA transition table at build time, so scanning costs one table
+ * lookup per character regardless of the number of patterns.
+ *
+ * Text is UTF-16 (Java chars) so hit offsets are Java string indices.
+ * Matching is exact and case-sensitive; callers lower-case both sides.
+ * Patterns must be non-empty ASCII. Characters that occur in no pattern
+ * share one alphabet symbol that resets the automaton to the root.
+ *
+ * With PATTERN_MATCHER_FOLD_NUMBERS, each number in the text (digits with
+ * an optional decimal part, e.g. "500" or "2.5") is read as a single '#',
+ * so "every # hours" matches "every 12 hours". With
+ * PATTERN_MATCHER_FOLD_SPACES, each run of whitespace reads as one ' ', so
+ * "# mg" matches "500  mg" and "500\tmg". Hit offsets still refer to the
+ * unfolded text.
+ */
+
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define PATTERN_MATCHER_ASCII 128
+
+#define PATTERN_MATCHER_FOLD_NUMBERS 1  // '#' in a pattern matches a number in the text
+#define PATTERN_MATCHER_FOLD_SPACES  2  // ' ' in a pattern matches a run of whitespace
+
+struct pattern_hit {
+    int32_t pattern;                // index into the build list
+    int32_t start;                  // first char
+    int32_t end;                    // one past the last char
+};
+
+struct pattern_matcher {
+    int flags;
+    int n_symbols;                  // alphabet size, symbol 0 = not in any pattern
+    uint8_t symbol[PATTERN_MATCHER_ASCII];
+
+    int n_states;
+    std::vector<int32_t> next;      // n_states * n_symbols DFA transitions
+    std::vector<int32_t> dict;      // nearest state down the failure chain that ends a pattern, 0 if none
+    std::vector<int32_t> out_begin; // n_states + 1 offsets into out
+    std::vector<int32_t> out;       // patterns ending exactly at each state
+    std::vector<int32_t> lengths;   // per pattern
+    int32_t max_length;
+};
+
+/**
+ * Build a matcher. Duplicate patterns are allowed and each reports its
+ * own hits. Returns nullptr if the list is empty or a pattern is empty
+ * or not ASCII.
+ */
+pattern_matcher *pattern_matcher_init(const std::vector<std::u16string> &patterns, int flags = 0);
+
+void pattern_matcher_free(pattern_matcher *pm);
+
+/**
+ * Append every occurrence in text[0, n) to hits, ordered by end offset
+ * (longest first on ties). Safe to call from several threads at once.
+ */
+void pattern_matcher_scan(const pattern_matcher *pm, const char16_t *text, size_t n,
+                          std::vector<pattern_hit> &hits);
+
+#endif // PATTERN_MATCHER_H
@@ -0,0 +1,65 @@
+/**
+ * Sentence tokenizer for transcript text
+ *
+ * Lower-casing and boundary detection share the loop: a boundary is
+ * noticed at the whitespace after the punctuation, so the last char of a
+ * piece can only be decided once the next piece arrives.
+ */
+
+#include "sentence_tokenizer.h"
+
+// ============================================================================
+// Characters
+// ============================================================================
+
+static inline bool is_space(char16_t c) {
+    if (c <= u' ') return c == u' ' || (c >= u'\t' && c <= u'\r');
+    return c == 0x0085 || c == 0x00A0 || c == 0x1680 || (c >= 0x2000 && c <= 0x200A) ||
+           c == 0x2028 || c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000;
+}
+
+static inline bool is_sentence_end(char16_t c) {
+    return c == u'.' || c == u'!' || c == u'?';
+}
+
+static inline char16_t to_lower(char16_t c) {
+    if (c >= u'A' && c <= u'Z') return (char16_t)(c + (u'a' - u'A'));
+    if (c < 0x80) return c;
+    if (c == 0x0130) return u'i';   // capital I with dot above
+    if (c == 0x212A) return u'k';   // Kelvin sign
+    return c;
+}
+
+// ============================================================================
+// Tokenizing
+// ============================================================================
+
+static void add_sentence(const char16_t *text, size_t start, size_t end, std::vector<sentence_span> &spans) {
+    while (start < end && is_space(text[start])) start++;
+    while (end > start && is_space(text[end - 1])) end--;
+    if (end - start >= SENTENCE_MIN_LENGTH) {
+        spans.push_back({ (int32_t)start, (int32_t)end });
+    }
+}
+
+size_t sentence_tokenize(const char16_t *text, size_t n, size_t from, bool final,
+                         char16_t *lower, std::vector<sentence_span> &spans, size_t *checked) {
+    size_t start = 0;
+    for (size_t i = from; i < n; i++) {
+        const char16_t c = text[i];
+        lower[i] = to_lower(c);
+
+        // Whitespace after sentence punctuation ends the sentence
+        if (i > 0 && is_space(c) && is_sentence_end(text[i - 1])) {
+            add_sentence(text, start, i, spans);
+            start = i;
+        }
+    }
+    *checked = n;
+
+    if (final) {
+        add_sentence(text, start, n, spans);
+        return n;
+    }
+    return start;
+}
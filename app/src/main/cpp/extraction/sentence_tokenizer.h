@@ -0,0 +1,49 @@
+/**
+ * Sentence tokenizer for transcript text
+ *
+ * One pass over the text both lower-cases it into a caller buffer (same
+ * length, same offsets) and finds the sentences: a sentence ends after
+ * '.', '!' or '?' followed by whitespace, and is trimmed of surrounding
+ * whitespace. Sentences are reported as [start, end) offsets, so every
+ * extractor reads the one lower-cased buffer, and the original text at
+ * the same offsets, without copying.
+ *
+ * Text can arrive in pieces: a call only reports the sentences that are
+ * known to have ended, and says how much of the text they used up; the
+ * rest is passed again, with more text appended, on the next call.
+ *
+ * Lower-casing folds ASCII plus the two non-ASCII letters whose lower
+ * case is ASCII (U+0130, U+212A); everything else is copied, which is
+ * all the ASCII-only keyword and quantity patterns can tell apart.
+ */
+
+#ifndef SENTENCE_TOKENIZER_H
+#define SENTENCE_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define SENTENCE_MIN_LENGTH 4       // shorter sentences ("Ok.", "Um.") are dropped
+
+struct sentence_span {
+    int32_t start;                  // first char
+    int32_t end;                    // one past the last char
+};
+
+/**
+ * Tokenize text[0, n), appending each complete sentence to spans.
+ *
+ * Chars before `from` were lower-cased into lower[] by an earlier call on
+ * the same text and are not checked again; pass the previous return of
+ * *checked. With `final`, the text after the last sentence end is a
+ * sentence too.
+ *
+ * Returns the offset the next call's text should start at: the end of the
+ * last complete sentence (n when final). *checked is set to the number of
+ * chars that are lower-cased and need no re-checking.
+ */
+size_t sentence_tokenize(const char16_t *text, size_t n, size_t from, bool final,
+                         char16_t *lower, std::vector<sentence_span> &spans, size_t *checked);
+
+#endif // SENTENCE_TOKENIZER_H
@@ -0,0 +1,386 @@
+/**
+ * Medical Appointment Companion - Extraction JNI Bridge
+ *
+ * Native matchers behind SchemaGuidedExtractor. Built as its own small
+ * library (libmedextract) so extraction never pulls in whisper or ggml.
+ * It also builds for a desktop JVM (tools/CMakeLists.txt), for the host
+ * extraction harness; there it logs to stderr.
+ */
+
+#include <jni.h>
+#include <string>
+#include <vector>
+#include "approx_matcher.h"
+#include "lexicon.h"
+#include "pattern_matcher.h"
+#include "sentence_tokenizer.h"
+
+#define UNUSED(x) (void)(x)
+#define TAG "ExtractionJNI"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOG_HOST(level, ...) (fprintf(stderr, level " " TAG ": " __VA_ARGS__), fputc('\n', stderr))
+#define LOGI(...) LOG_HOST("I", __VA_ARGS__)
+#define LOGW(...) LOG_HOST("W", __VA_ARGS__)
+#define LOGE(...) LOG_HOST("E", __VA_ARGS__)
+#endif
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static std::u16string to_u16string(JNIEnv *env, jstring str) {
+    const jsize len = env->GetStringLength(str);
+    std::u16string out((size_t)len, u'\0');
+    env->GetStringRegion(str, 0, len, (jchar *)&out[0]);
+    return out;
+}
+
+static std::string to_utf8(JNIEnv *env, jstring str) {
+    const char *chars = env->GetStringUTFChars(str, nullptr);
+    std::string out(chars);
+    env->ReleaseStringUTFChars(str, chars);
+    return out;
+}
+
+static std::vector<std::u16string> to_u16strings(JNIEnv *env, jobjectArray array) {
+    const jsize n = env->GetArrayLength(array);
+    std::vector<std::u16string> out;
+    out.reserve(n);
+    for (jsize i = 0; i < n; i++) {
+        jstring str = (jstring)env->GetObjectArrayElement(array, i);
+        out.push_back(to_u16string(env, str));
+        env->DeleteLocalRef(str);
+    }
+    return out;
+}
+
+// ============================================================================
+// Pattern matcher (Aho–Corasick)
+// ============================================================================
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_createPatternMatcher(
+        JNIEnv *env, jobject thiz, jobjectArray patterns, jboolean fold_numbers, jboolean fold_spaces) {
+    UNUSED(thiz);
+
+    const int flags = (fold_numbers ? PATTERN_MATCHER_FOLD_NUMBERS : 0) |
+                      (fold_spaces ? PATTERN_MATCHER_FOLD_SPACES : 0);
+    pattern_matcher *pm = pattern_matcher_init(to_u16strings(env, patterns), flags);
+    if (!pm) {
+        LOGE("Pattern matcher: empty or non-ASCII pattern");
+        return 0;
+    }
+    LOGI("Pattern matcher: %zu patterns, %d states, %d symbols%s%s",
+         pm->lengths.size(), pm->n_states, pm->n_symbols,
+         fold_numbers ? ", numbers folded" : "", fold_spaces ? ", spaces folded" : "");
+    return (jlong)pm;
+}
+
+/**
+ * Hits packed as (pattern, start, end) triples, ordered by end
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_patternMatcherScan(
+        JNIEnv *env, jobject thiz, jlong matcher_ptr, jstring text) {
+    UNUSED(thiz);
+
+    const pattern_matcher *pm = (const pattern_matcher *)matcher_ptr;
+    const jsize len = env->GetStringLength(text);
+
+    std::vector<pattern_hit> hits;
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    pattern_matcher_scan(pm, (const char16_t *)chars, (size_t)len, hits);
+    env->ReleaseStringCritical(text, chars);
+
+    static_assert(sizeof(pattern_hit) == 3 * sizeof(jint), "pattern_hit must pack as 3 ints");
+    const jsize n = (jsize)(hits.size() * 3);
+    jintArray result = env->NewIntArray(n);
+    if (result && n > 0) {
+        env->SetIntArrayRegion(result, 0, n, (const jint *)hits.data());
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_freePatternMatcher(
+        JNIEnv *env, jobject thiz, jlong matcher_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+
+    pattern_matcher_free((pattern_matcher *)matcher_ptr);
+}
+
+// ============================================================================
+// Approximate matcher (Myers/Hyyrö)
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_createApproxMatcher(
+        JNIEnv *env, jobject thiz, jobjectArray patterns, jintArray max_errors) {
+    UNUSED(thiz);
+
+    const jsize n = env->GetArrayLength(max_errors);
+    std::vector<int32_t> bounds(n);
+    env->GetIntArrayRegion(max_errors, 0, n, bounds.data());
+
+    approx_matcher *am = approx_matcher_init(to_u16strings(env, patterns), bounds);
+    if (!am) {
+        LOGE("Approximate matcher: patterns must be 1..%d ASCII chars", APPROX_MATCHER_MAX_LEN);
+        return 0;
+    }
+    LOGI("Approximate matcher: %d patterns, %d symbols", am->n_patterns, am->n_symbols);
+    return (jlong)am;
+}
+
+/**
+ * Matches packed as (pattern, errors, end) triples, in pattern order
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_approxMatcherScan(
+        JNIEnv *env, jobject thiz, jlong matcher_ptr, jstring text) {
+    UNUSED(thiz);
+
+    // Per-thread pattern state, so a scan allocates nothing after the first
+    static thread_local approx_scratch scratch;
+
+    const approx_matcher *am = (const approx_matcher *)matcher_ptr;
+    const jsize len = env->GetStringLength(text);
+
+    std::vector<approx_match> matches;
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    approx_matcher_scan(am, (const char16_t *)chars, (size_t)len, scratch, matches);
+    env->ReleaseStringCritical(text, chars);
+
+    static_assert(sizeof(approx_match) == 3 * sizeof(jint), "approx_match must pack as 3 ints");
+    const jsize n = (jsize)(matches.size() * 3);
+    jintArray result = env->NewIntArray(n);
+    if (result && n > 0) {
+        env->SetIntArrayRegion(result, 0, n, (const jint *)matches.data());
+    }
+    return result;
+}
+
+/**
+ * The (pattern, errors, end) triples of a scan that whole words of text
+ * confirm, with their errors and end from the confirming run of words
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_approxMatcherConfirm(
+        JNIEnv *env, jobject thiz, jlong matcher_ptr, jintArray scanned, jstring text, jint max_words) {
+    UNUSED(thiz);
+
+    const approx_matcher *am = (const approx_matcher *)matcher_ptr;
+    std::vector<approx_match> matches((size_t)env->GetArrayLength(scanned) / 3);
+    env->GetIntArrayRegion(scanned, 0, (jsize)(matches.size() * 3), (jint *)matches.data());
+
+    const jsize len = env->GetStringLength(text);
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    approx_matcher_confirm(am, (const char16_t *)chars, (size_t)len, max_words, matches);
+    env->ReleaseStringCritical(text, chars);
+
+    const jsize n = (jsize)(matches.size() * 3);
+    jintArray result = env->NewIntArray(n);
+    if (result && n > 0) {
+        env->SetIntArrayRegion(result, 0, n, (const jint *)matches.data());
+    }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_freeApproxMatcher(
+        JNIEnv *env, jobject thiz, jlong matcher_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+
+    approx_matcher_free((approx_matcher *)matcher_ptr);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_benchApproxMatcher(
+        JNIEnv *env, jobject thiz, jlong matcher_ptr, jint minutes) {
+    UNUSED(thiz);
+
+    std::string result = approx_matcher_bench((const approx_matcher *)matcher_ptr, minutes);
+    LOGI("%s", result.c_str());
+    return env->NewStringUTF(result.c_str());
+}
+
+// ============================================================================
+// Sentence tokenizer
+// ============================================================================
+
+/**
+ * Lower-cases text[from, len) into lower and returns the consumed length
+ * followed by (start, end) pairs, one per complete sentence
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_tokenizeSentences(
+        JNIEnv *env, jobject thiz, jstring text, jint from, jboolean final, jcharArray lower) {
+    UNUSED(thiz);
+
+    const jsize len = env->GetStringLength(text);
+    if (from < 0 || from > len || env->GetArrayLength(lower) < len) {
+        LOGE("Sentence tokenizer: bad offsets (from %d, text %d)", from, len);
+        return nullptr;
+    }
+
+    std::vector<sentence_span> spans;
+    size_t checked = 0;
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    jchar *lowered = (jchar *)env->GetPrimitiveArrayCritical(lower, nullptr);
+    const size_t consumed = sentence_tokenize((const char16_t *)chars, (size_t)len, (size_t)from, final,
+                                              (char16_t *)lowered, spans, &checked);
+    env->ReleasePrimitiveArrayCritical(lower, lowered, 0);
+    env->ReleaseStringCritical(text, chars);
+
+    static_assert(sizeof(sentence_span) == 2 * sizeof(jint), "sentence_span must pack as 2 ints");
+    const jsize n = (jsize)(1 + spans.size() * 2);
+    jintArray result = env->NewIntArray(n);
+    if (result) {
+        const jint head = (jint)consumed;
+        env->SetIntArrayRegion(result, 0, 1, &head);
+        if (!spans.empty()) {
+            env->SetIntArrayRegion(result, 1, n - 1, (const jint *)spans.data());
+        }
+    }
+    return result;
+}
+
+// ============================================================================
+// Medication lexicon
+// ============================================================================
+
+/**
+ * Compile names (with the canonical name each stands for, "" for itself)
+ * into a lexicon file at out_path
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_compileLexicon(
+        JNIEnv *env, jobject thiz, jobjectArray names, jobjectArray canonicals, jstring out_path) {
+    UNUSED(thiz);
+
+    const jsize n = env->GetArrayLength(names);
+    if (env->GetArrayLength(canonicals) != n) {
+        LOGE("Lexicon: %d names but %d canonical names", n, env->GetArrayLength(canonicals));
+        return JNI_FALSE;
+    }
+    std::vector<lexicon_source_entry> entries((size_t)n);
+    for (jsize i = 0; i < n; i++) {
+        jstring name = (jstring)env->GetObjectArrayElement(names, i);
+        jstring canonical = (jstring)env->GetObjectArrayElement(canonicals, i);
+        entries[i].name = to_utf8(env, name);
+        entries[i].canonical = to_utf8(env, canonical);
+        env->DeleteLocalRef(name);
+        env->DeleteLocalRef(canonical);
+    }
+
+    const std::string path = to_utf8(env, out_path);
+    std::vector<uint8_t> bytes;
+    std::string error;
+    if (!lexicon_build(entries, bytes, &error) || !lexicon_write(bytes, path.c_str(), &error)) {
+        LOGE("Lexicon: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    LOGI("Lexicon: %d names compiled to %s (%zu bytes)", n, path.c_str(), bytes.size());
+    return JNI_TRUE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_compileLexiconCsv(
+        JNIEnv *env, jobject thiz, jstring csv_path, jstring out_path) {
+    UNUSED(thiz);
+
+    const std::string csv = to_utf8(env, csv_path);
+    const std::string path = to_utf8(env, out_path);
+    std::string error;
+    if (!lexicon_compile_csv(csv.c_str(), path.c_str(), &error)) {
+        LOGE("Lexicon: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    LOGI("Lexicon: %s compiled to %s", csv.c_str(), path.c_str());
+    return JNI_TRUE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_openLexicon(
+        JNIEnv *env, jobject thiz, jstring path) {
+    UNUSED(thiz);
+
+    const std::string file = to_utf8(env, path);
+    lexicon *lex = lexicon_open(file.c_str());
+    if (!lex) {
+        LOGE("Lexicon: failed to open %s", file.c_str());
+        return 0;
+    }
+    LOGI("Lexicon: %u entries, %u trie nodes mapped from %s",
+         lex->header->n_entries, lex->header->n_nodes, file.c_str());
+    return (jlong)lex;
+}
+
+/**
+ * Best candidate in lower-cased text as (entry, canonical, errors, start,
+ * end), or an empty array
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_lexiconFind(
+        JNIEnv *env, jobject thiz, jlong lexicon_ptr, jstring text) {
+    UNUSED(thiz);
+
+    const lexicon *lex = (const lexicon *)lexicon_ptr;
+    const jsize len = env->GetStringLength(text);
+
+    lexicon_match match = {};
+    const jchar *chars = env->GetStringCritical(text, nullptr);
+    const bool found = lexicon_find(lex, (const char16_t *)chars, (size_t)len, match);
+    env->ReleaseStringCritical(text, chars);
+
+    static_assert(sizeof(lexicon_match) == 5 * sizeof(jint), "lexicon_match must pack as 5 ints");
+    const jsize n = found ? 5 : 0;
+    jintArray result = env->NewIntArray(n);
+    if (result && n > 0) {
+        env->SetIntArrayRegion(result, 0, n, (const jint *)&match);
+    }
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_lexiconName(
+        JNIEnv *env, jobject thiz, jlong lexicon_ptr, jint entry) {
+    UNUSED(thiz);
+
+    const lexicon *lex = (const lexicon *)lexicon_ptr;
+    if (entry < 0 || (uint32_t)entry >= lex->header->n_entries) {
+        LOGE("Lexicon: no entry %d", entry);
+        return nullptr;
+    }
+    return env->NewStringUTF(lexicon_name(lex, entry).c_str());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_lexiconSize(
+        JNIEnv *env, jobject thiz, jlong lexicon_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+
+    return (jint)((const lexicon *)lexicon_ptr)->header->n_entries;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_extraction_ExtractionLib_00024Companion_closeLexicon(
+        JNIEnv *env, jobject thiz, jlong lexicon_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+
+    lexicon_close((lexicon *)lexicon_ptr);
+}
+
+} // extern "C"
@@ -9,11 +9,19 @@
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <sys/sysinfo.h>
-#include "whisper.h"
+#include <unistd.h>
+#include "whisper_wrapper.h"
 #include "ggml.h"
+#include "resampler.h"
+#include "audio_archive.h"
+#include "log_mel.h"
+#include "mel_cache.h"
+#include "mel_bench.h"
+#include "result_pack.h"
 
 #define UNUSED(x) (void)(x)
 #define TAG "WhisperJNI"
@@ -86,7 +94,8 @@ static void asset_close(void *ctx) {
 static struct whisper_context *whisper_init_from_asset(
         JNIEnv *env,
         jobject assetManager,
-        const char *asset_path) {
+        const char *asset_path,
+        struct whisper_context_params params) {
     LOGI("Loading model from asset: %s", asset_path);
     
     AAssetManager *asset_manager = AAssetManager_fromJava(env, assetManager);
@@ -108,7 +117,42 @@ static struct whisper_context *whisper_init_from_asset(
         .close = &asset_close
     };
     
-    return whisper_init_with_params(&loader, whisper_context_default_params());
+    return whisper_init_with_params_no_state(&loader, params);
+}
+
+/**
+ * Load-time params from ModelOptions. Flash attention runs the attention
+ * as one fused kernel over the KV cache instead of materialising the
+ * attention matrix, shrinking the compute buffers and the memory traffic
+ * of each decoder step. The KV cache type and size are fixed by whisper
+ * (F16, n_text_ctx) and not exposed.
+ */
+static struct whisper_context_params context_params(jboolean flash_attn) {
+    struct whisper_context_params params = whisper_context_default_params();
+    params.flash_attn = flash_attn == JNI_TRUE;
+    LOGI("Context params: flash attention %s", params.flash_attn ? "on" : "off");
+    return params;
+}
+
+// Wrap a freshly loaded (stateless) context in the handle handed to Kotlin
+static jlong bridge_wrap(struct whisper_context *context) {
+    if (!context) {
+        return 0;
+    }
+    struct whisper_state *state = whisper_init_state(context);
+    if (!state) {
+        LOGE("Failed to allocate whisper state");
+        whisper_free(context);
+        return 0;
+    }
+    struct bridge_context *bc = new bridge_context();
+    bc->ctx = context;
+    bc->state = state;
+    bc->timings.mel_cache = MEL_CACHE_UNUSED;
+    
+    // Tuned for potentially quiet audio until Kotlin sets its own
+    decoding_preset("balanced", bc->decoding);
+    return (jlong)bc;
 }
 
 // ============================================================================
@@ -119,7 +163,7 @@ extern "C" {
 
 JNIEXPORT jlong JNICALL
 Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_initContextFromInputStream(
-        JNIEnv *env, jobject thiz, jobject input_stream) {
+        JNIEnv *env, jobject thiz, jobject input_stream, jboolean flash_attn) {
     UNUSED(thiz);
     
     struct whisper_context *context = nullptr;
@@ -142,37 +186,38 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_i
     
     loader.eof(loader.context);
     
-    context = whisper_init(&loader);
-    return (jlong)context;
+    context = whisper_init_with_params_no_state(&loader, context_params(flash_attn));
+    return bridge_wrap(context);
 }
 
 JNIEXPORT jlong JNICALL
 Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_initContextFromAsset(
-        JNIEnv *env, jobject thiz, jobject assetManager, jstring asset_path_str) {
+        JNIEnv *env, jobject thiz, jobject assetManager, jstring asset_path_str, jboolean flash_attn) {
     UNUSED(thiz);
     
     const char *asset_path_chars = env->GetStringUTFChars(asset_path_str, nullptr);
-    struct whisper_context *context = whisper_init_from_asset(env, assetManager, asset_path_chars);
+    struct whisper_context *context = whisper_init_from_asset(env, assetManager, asset_path_chars,
+                                                              context_params(flash_attn));
     env->ReleaseStringUTFChars(asset_path_str, asset_path_chars);
     
-    return (jlong)context;
+    return bridge_wrap(context);
 }
 
 JNIEXPORT jlong JNICALL
 Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_initContext(
-        JNIEnv *env, jobject thiz, jstring model_path_str) {
+        JNIEnv *env, jobject thiz, jstring model_path_str, jboolean flash_attn) {
     UNUSED(thiz);
     
     const char *model_path_chars = env->GetStringUTFChars(model_path_str, nullptr);
     LOGI("Loading model from file: %s", model_path_chars);
     
-    struct whisper_context *context = whisper_init_from_file_with_params(
+    struct whisper_context *context = whisper_init_from_file_with_params_no_state(
         model_path_chars, 
-        whisper_context_default_params()
+        context_params(flash_attn)
     );
     
     env->ReleaseStringUTFChars(model_path_str, model_path_chars);
-    return (jlong)context;
+    return bridge_wrap(context);
 }
 
 JNIEXPORT void JNICALL
@@ -181,10 +226,12 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_f
     UNUSED(env);
     UNUSED(thiz);
     
-    struct whisper_context *context = (struct whisper_context *)context_ptr;
-    if (context) {
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    if (bc) {
         LOGI("Freeing whisper context");
-        whisper_free(context);
+        whisper_free_state(bc->state);
+        whisper_free(bc->ctx);
+        delete bc;
     }
 }
 
@@ -192,86 +239,1010 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_f
 // JNI Functions - Transcription
 // ============================================================================
 
-JNIEXPORT void JNICALL
-Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_fullTranscribe(
-        JNIEnv *env, jobject thiz, jlong context_ptr, jint num_threads, jfloatArray audio_data) {
-    UNUSED(thiz);
+static float elapsed_ms(int64_t t_start_us) {
+    return (ggml_time_us() - t_start_us) / 1000.0f;
+}
+
+/**
+ * Re-create a state freed by trimMemory, reporting the time taken in
+ * resume_ms. False if it can't be allocated.
+ */
+static bool ensure_state(struct whisper_context *context, struct whisper_state **state, float *resume_ms) {
+    if (*state) {
+        return true;
+    }
+    const int64_t t_start_us = ggml_time_us();
+    *state = whisper_init_state(context);
+    if (!*state) {
+        LOGE("Failed to re-allocate whisper state");
+        return false;
+    }
+    *resume_ms = elapsed_ms(t_start_us);
+    LOGI("Compute buffers re-allocated in %.1f ms", *resume_ms);
+    return true;
+}
+
+/**
+ * Install the mel for n_samples of audio in the context, taking it from
+ * the cache, from a stream fed during capture, or computing it here.
+ * samples/stream may be null when only the cache is usable. A freshly
+ * computed mel is written to cache_path if given.
+ * Returns the real frame count, or 0 if nothing was installed.
+ */
+static int prepare_mel(struct bridge_context *bc, int num_threads, const float *samples, uint64_t n_samples,
+                       log_mel_stream *stream, const char *cache_path) {
+    const int64_t t_start_us = ggml_time_us();
+    const int n_mel = whisper_model_n_mels(bc->ctx);
     
-    struct whisper_context *context = (struct whisper_context *)context_ptr;
-    jfloat *audio_data_arr = env->GetFloatArrayElements(audio_data, nullptr);
-    const jsize audio_data_length = env->GetArrayLength(audio_data);
+    log_mel_spectrogram mel;
+    bool ready = false;
+    const char *source = "computed";
     
-    // Diagnostic: analyze audio data
-    float min_val = 0, max_val = 0, sum_abs = 0;
-    int non_zero = 0;
-    for (int i = 0; i < audio_data_length; i++) {
-        float v = audio_data_arr[i];
-        if (v < min_val) min_val = v;
-        if (v > max_val) max_val = v;
-        sum_abs += (v >= 0 ? v : -v);
-        if (v != 0) non_zero++;
+    if (cache_path) {
+        ready = mel_cache_load(cache_path, n_mel, n_samples, mel);
+        bc->timings.mel_cache = ready ? MEL_CACHE_HIT : MEL_CACHE_MISS;
+        source = "cache";
     }
-    float avg_abs = sum_abs / audio_data_length;
-    
-    LOGI("Audio data analysis:");
-    LOGI("  Samples: %d (%.2fs)", audio_data_length, audio_data_length / 16000.0f);
-    LOGI("  Range: [%.6f, %.6f]", min_val, max_val);
-    LOGI("  Avg absolute: %.6f", avg_abs);
-    LOGI("  Non-zero: %d (%.1f%%)", non_zero, (non_zero * 100.0f / audio_data_length));
+    if (!ready && stream && stream->n_mel == n_mel && stream->n_samples == n_samples) {
+        ready = log_mel_stream_finish(stream, mel);
+        source = "capture stream";
+    }
+    if (!ready && samples) {
+        ready = log_mel_compute(samples, (int)n_samples, n_mel, num_threads, mel);
+        source = "computed";
+    }
+    if (!ready) {
+        return 0;
+    }
+    if (whisper_set_mel_with_state(bc->ctx, bc->state, mel.data.data(), mel.n_len, mel.n_mel) != 0) {
+        LOGW("whisper_set_mel rejected %d x %d mel, leaving it to whisper", mel.n_mel, mel.n_len);
+        return 0;
+    }
+    bc->timings.mel_ms = elapsed_ms(t_start_us);
     
-    if (avg_abs < 0.001f) {
-        LOGW("Audio appears silent! avg_abs=%.6f", avg_abs);
+    if (cache_path && bc->timings.mel_cache == MEL_CACHE_MISS && !mel_cache_save(cache_path, mel, n_samples)) {
+        LOGW("Failed to write mel cache %s", cache_path);
+    }
+    LOGI("Mel ready from %s: %d x %d frames in %.1f ms", source, mel.n_mel, mel.n_len, bc->timings.mel_ms);
+    return mel.n_len_org;
+}
+
+/**
+ * Encoder context for an AUDIO_CTX_* request on a clip of n_frames mel
+ * frames; 0 means the model's full window
+ */
+static int resolve_audio_ctx(struct whisper_context *context, int requested, int n_frames) {
+    const int n_audio_ctx = whisper_model_n_audio_ctx(context);
+    if (requested > 0) {
+        return requested < n_audio_ctx ? requested : 0;
+    }
+    if (requested != AUDIO_CTX_ADAPTIVE || n_frames * 10 > ADAPTIVE_CTX_MAX_MS) {
+        return 0;
     }
     
-    // Configure transcription parameters for medical conversations
-    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    params.print_realtime = false;
-    params.print_progress = false;
+    // The encoder downsamples mel frames by 2
+    int audio_ctx = (n_frames + 1) / 2 + ADAPTIVE_CTX_MARGIN;
+    audio_ctx = (audio_ctx + ADAPTIVE_CTX_ALIGN - 1) / ADAPTIVE_CTX_ALIGN * ADAPTIVE_CTX_ALIGN;
+    if (audio_ctx < ADAPTIVE_CTX_MIN) {
+        audio_ctx = ADAPTIVE_CTX_MIN;
+    }
+    return audio_ctx < n_audio_ctx ? audio_ctx : 0;
+}
+
+static bool has_text(struct whisper_state *state) {
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; i++) {
+        for (const char *c = whisper_full_get_segment_text_from_state(state, i); *c; c++) {
+            if (*c != ' ') return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * whisper.cpp doesn't expose its fallback count, nor stage timings for a
+ * state, so both are derived from callbacks: the encoder runs once per
+ * window, and each decode attempt (the first try and every temperature
+ * fallback) begins with exactly one logits filter call on an empty token
+ * sequence, right after the prompt pass
+ */
+static bool count_window(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    UNUSED(ctx);
+    UNUSED(state);
+    struct bridge_timings *timings = (struct bridge_timings *)user_data;
+    timings->windows++;
+    timings->window_start_us = ggml_time_us();
+    timings->window_encoding = true;
+    return true;
+}
+
+static void count_attempt(struct whisper_context *ctx, struct whisper_state *state,
+                          const whisper_token_data *tokens, int n_tokens, float *logits, void *user_data) {
+    UNUSED(ctx);
+    UNUSED(state);
+    UNUSED(tokens);
+    UNUSED(logits);
+    struct bridge_timings *timings = (struct bridge_timings *)user_data;
+    if (timings->window_encoding) {
+        timings->encode_ms += elapsed_ms(timings->window_start_us);
+        timings->window_encoding = false;
+    }
+    if (n_tokens == 0) {
+        timings->fallbacks++;
+    }
+}
+
+/**
+ * whisper_full parameters for a decoding strategy, with
+ * window and fallback counting into timings. No prompt is set.
+ */
+static struct whisper_full_params full_params(const struct bridge_decoding_params &decoding,
+                                              struct bridge_timings *timings, int num_threads) {
+    struct whisper_full_params params = decoding_full_params(decoding, num_threads);
     params.print_timestamps = true;
-    params.print_special = false;
-    params.translate = false;
-    params.language = "en";
-    params.n_threads = num_threads;
-    params.offset_ms = 0;
-    params.no_context = true;
-    params.single_segment = false;
+    timings->threads = num_threads;
+    
+    params.encoder_begin_callback = count_window;
+    params.encoder_begin_callback_user_data = timings;
+    params.logits_filter_callback = count_attempt;
+    params.logits_filter_callback_user_data = timings;
+    return params;
+}
+
+/**
+ * Close the timings of a call started at t_start_us. count_attempt counts
+ * every attempt, but the first one per window isn't a fallback. Whatever
+ * the mel, resume and encoder stages didn't take was decoding.
+ *
+ * Each attempt starts with a prompt pass over prompt_tokens plus the start
+ * token, which whisper gives no callback around: the first of a window is
+ * timed with the encoder and the rest with decoding. prompt_est_ms is only
+ * an estimate of their sum, at the warm-up pass's speed (prompt_token_ms)
+ * scaled as if linear in threads, and is not taken out of either stage.
+ */
+static void finish_timings(struct bridge_timings *timings, int64_t t_start_us, float prompt_token_ms) {
+    timings->fallbacks -= timings->windows;
+    if (timings->fallbacks < 0) {
+        timings->fallbacks = 0;
+    }
+    timings->total_ms = elapsed_ms(t_start_us);
+    
+    if (prompt_token_ms <= 0 || timings->threads <= 0) {
+        timings->prompt_est_ms = -1;
+    } else {
+        const float pass_ms = (timings->prompt_tokens + 1) * prompt_token_ms / timings->threads;
+        timings->prompt_est_ms = (timings->windows + timings->fallbacks) * pass_ms;
+    }
+    timings->decode_ms = timings->total_ms - timings->mel_ms - timings->resume_ms - timings->encode_ms;
+    if (timings->decode_ms < 0) {
+        timings->decode_ms = 0;
+    }
+}
+
+/**
+ * A Kotlin SegmentListener, called from whisper's new segment callback on
+ * the transcribing thread as each window's segments are committed
+ */
+struct segment_listener {
+    JNIEnv *env;
+    jobject listener;
+    jmethodID on_segment;   // onSegment(String, long, long)
+};
+
+static struct segment_listener segment_listener_from(JNIEnv *env, jobject listener) {
+    struct segment_listener sl = {env, listener, nullptr};
+    if (listener) {
+        jclass cls = env->GetObjectClass(listener);
+        sl.on_segment = env->GetMethodID(cls, "onSegment", "(Ljava/lang/String;JJ)V");
+        env->DeleteLocalRef(cls);
+    }
+    return sl;
+}
+
+static void emit_segments(struct whisper_context *ctx, struct whisper_state *state, int n_new, void *user_data) {
+    UNUSED(ctx);
+    struct segment_listener *sl = (struct segment_listener *)user_data;
+    if (!sl->on_segment) return;
+    
+    JNIEnv *env = sl->env;
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = n_segments - n_new; i < n_segments; i++) {
+        jstring text = env->NewStringUTF(whisper_full_get_segment_text_from_state(state, i));
+        env->CallVoidMethod(sl->listener, sl->on_segment, text,
+                            (jlong)whisper_full_get_segment_t0_from_state(state, i) * 10,
+                            (jlong)whisper_full_get_segment_t1_from_state(state, i) * 10);
+        env->DeleteLocalRef(text);
+        if (env->ExceptionCheck()) {
+            // The transcription itself is unaffected; stop calling back
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+            LOGW("Segment listener threw, no more segments are passed to it");
+            sl->on_segment = nullptr;
+            return;
+        }
+    }
+}
+
+/**
+ * Run whisper_full on PCM, or on the mel already installed in the context's
+ * state when mel_frames > 0 (samples may then be null). Committed segments
+ * are passed to listener, if any, as they are decoded.
+ */
+static void run_full_transcribe(struct bridge_context *bc, int num_threads,
+                                const float *audio_data_arr, int audio_data_length,
+                                int mel_frames, int audio_ctx, int64_t t_start_us,
+                                struct segment_listener *listener) {
+    struct whisper_context *context = bc->ctx;
+    
+    if (audio_data_arr) {
+        // Diagnostic: analyze audio data
+        float min_val = 0, max_val = 0, sum_abs = 0;
+        int non_zero = 0;
+        for (int i = 0; i < audio_data_length; i++) {
+            float v = audio_data_arr[i];
+            if (v < min_val) min_val = v;
+            if (v > max_val) max_val = v;
+            sum_abs += (v >= 0 ? v : -v);
+            if (v != 0) non_zero++;
+        }
+        float avg_abs = sum_abs / audio_data_length;
+        
+        LOGI("Audio data analysis:");
+        LOGI("  Samples: %d (%.2fs)", audio_data_length, audio_data_length / 16000.0f);
+        LOGI("  Range: [%.6f, %.6f]", min_val, max_val);
+        LOGI("  Avg absolute: %.6f", avg_abs);
+        LOGI("  Non-zero: %d (%.1f%%)", non_zero, (non_zero * 100.0f / audio_data_length));
+        
+        if (avg_abs < 0.001f) {
+            LOGW("Audio appears silent! avg_abs=%.6f", avg_abs);
+        }
+    }
+    
+    struct whisper_full_params params = full_params(bc->decoding, &bc->timings, num_threads);
     
-    // Tune for potentially quiet audio
-    params.entropy_thold = 2.8f;        // Increase from default 2.4 (less strict)
-    params.logprob_thold = -1.5f;       // Increase from default -1.0 (less strict)
-    params.no_speech_thold = 0.3f;      // Decrease from default 0.6 (more sensitive)
+    // Cached vocabulary prompt; with no_context it is the only text
+    // whisper carries into the first window
+    if (!bc->prompt_tokens.empty()) {
+        params.prompt_tokens = bc->prompt_tokens.data();
+        params.prompt_n_tokens = (int)bc->prompt_tokens.size();
+        bc->timings.prompt_tokens = params.prompt_n_tokens;
+    }
+    
+    if (listener) {
+        params.new_segment_callback = emit_segments;
+        params.new_segment_callback_user_data = listener;
+    }
     
-    whisper_reset_timings(context);
+    const int n_frames = mel_frames > 0 ? mel_frames : audio_data_length / WHISPER_HOP_LENGTH;
+    params.audio_ctx = resolve_audio_ctx(context, audio_ctx, n_frames);
     
-    LOGI("Starting transcription with %d threads", num_threads);
+    // whisper_set_mel() treats the padded length as real audio; bound the
+    // decode to the recording itself, exactly as the PCM path would
+    if (mel_frames > 0) {
+        params.duration_ms = mel_frames * 10;
+        audio_data_arr = nullptr;
+        audio_data_length = 0;
+    }
     
-    if (whisper_full(context, params, audio_data_arr, audio_data_length) != 0) {
+    LOGI("Starting transcription with %d threads, audio_ctx %d, %s", num_threads, params.audio_ctx,
+         params.strategy == WHISPER_SAMPLING_BEAM_SEARCH ? "beam search" : "greedy");
+    
+    int ret = whisper_full_with_state(context, bc->state, params, audio_data_arr, audio_data_length);
+    
+    // A shrunk encoder window occasionally loses a short utterance entirely;
+    // never return less than the full window would have. The listener has
+    // only seen blank segments from the first run.
+    if (ret == 0 && params.audio_ctx > 0 && audio_ctx == AUDIO_CTX_ADAPTIVE && !has_text(bc->state)) {
+        LOGW("No text with audio_ctx %d, retrying with the full window", params.audio_ctx);
+        params.audio_ctx = 0;
+        bc->timings.audio_ctx_retries++;
+        ret = whisper_full_with_state(context, bc->state, params, audio_data_arr, audio_data_length);
+    }
+    bc->timings.audio_ctx = params.audio_ctx;
+    
+    finish_timings(&bc->timings, t_start_us, bc->prompt_token_ms);
+    
+    if (ret != 0) {
         LOGE("Failed to run transcription");
     } else {
-        int n_segments = whisper_full_n_segments(context);
-        LOGI("Transcription complete: %d segments", n_segments);
+        int n_segments = whisper_full_n_segments_from_state(bc->state);
+        LOGI("Transcription complete: %d segments, %d windows, %d fallback re-decodes",
+             n_segments, bc->timings.windows, bc->timings.fallbacks);
         for (int i = 0; i < n_segments && i < 5; i++) {
-            const char* text = whisper_full_get_segment_text(context, i);
+            const char* text = whisper_full_get_segment_text_from_state(bc->state, i);
             LOGI("  Segment %d: %s", i, text);
         }
-        whisper_print_timings(context);
+        LOGI("Timings: mel %.1f ms, resume %.1f ms, encode %.1f ms, decode %.1f ms, total %.1f ms (prompt ~%.1f ms)",
+             bc->timings.mel_ms, bc->timings.resume_ms, bc->timings.encode_ms, bc->timings.decode_ms,
+             bc->timings.total_ms, bc->timings.prompt_est_ms);
+    }
+}
+
+// Decoding params as passed from DecodingParams through JNI
+static struct bridge_decoding_params decoding_from_jni(
+        JNIEnv *env, jint strategy, jint best_of, jint beam_size, jfloat temperature, jfloat temperature_inc,
+        jfloat entropy_thold, jfloat logprob_thold, jfloat no_speech_thold, jint max_len,
+        jboolean token_timestamps, jstring language_str) {
+    struct bridge_decoding_params decoding;
+    decoding.strategy = strategy == WHISPER_SAMPLING_BEAM_SEARCH ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+    decoding.best_of = best_of;
+    decoding.beam_size = beam_size;
+    decoding.temperature = temperature;
+    decoding.temperature_inc = temperature_inc;
+    decoding.entropy_thold = entropy_thold;
+    decoding.logprob_thold = logprob_thold;
+    decoding.no_speech_thold = no_speech_thold;
+    decoding.max_len = max_len;
+    decoding.token_timestamps = token_timestamps == JNI_TRUE;
+    
+    if (language_str) {
+        const char *language = env->GetStringUTFChars(language_str, nullptr);
+        decoding.language = language;
+        env->ReleaseStringUTFChars(language_str, language);
+    }
+    
+    LOGI("Decoding params: %s, best_of %d, beam %d, t %.2f + %.2f, thresholds %.2f/%.2f/%.2f, max_len %d, lang %s",
+         decoding.strategy == WHISPER_SAMPLING_BEAM_SEARCH ? "beam search" : "greedy",
+         best_of, beam_size, temperature, temperature_inc, entropy_thold, logprob_thold, no_speech_thold,
+         max_len, decoding.language.empty() ? "auto" : decoding.language.c_str());
+    return decoding;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_setDecodingParams(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jint strategy, jint best_of, jint beam_size,
+        jfloat temperature, jfloat temperature_inc, jfloat entropy_thold, jfloat logprob_thold,
+        jfloat no_speech_thold, jint max_len, jboolean token_timestamps, jstring language_str) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    struct bridge_decoding_params decoding = decoding_from_jni(
+            env, strategy, best_of, beam_size, temperature, temperature_inc, entropy_thold, logprob_thold,
+            no_speech_thold, max_len, token_timestamps, language_str);
+    
+    std::lock_guard<std::mutex> lock(bc->settings_lock);
+    bc->decoding = decoding;
+}
+
+/**
+ * Tokenize the vocabulary prompt "<prefix> term, term, ..." once and keep
+ * it on the context for every later transcription. Terms are added in
+ * order until max_tokens would be exceeded, so the list should be sorted
+ * by importance; whisper itself only keeps the last n_text_ctx / 2
+ * prompt tokens. Null or empty terms clear the prompt.
+ * Returns the number of tokens cached.
+ */
+JNIEXPORT jint JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_setPrompt(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jstring prefix_str, jobjectArray terms, jint max_tokens) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    const int64_t t_start_us = ggml_time_us();
+    
+    const jsize n_terms = terms ? env->GetArrayLength(terms) : 0;
+    if (n_terms == 0) {
+        std::lock_guard<std::mutex> lock(bc->settings_lock);
+        bc->prompt_tokens.clear();
+        LOGI("Vocabulary prompt cleared");
+        return 0;
+    }
+    
+    std::vector<std::string> term_list;
+    term_list.reserve(n_terms);
+    for (jsize i = 0; i < n_terms; i++) {
+        jstring term_str = (jstring)env->GetObjectArrayElement(terms, i);
+        const char *term = env->GetStringUTFChars(term_str, nullptr);
+        term_list.emplace_back(term);
+        env->ReleaseStringUTFChars(term_str, term);
+        env->DeleteLocalRef(term_str);
+    }
+    
+    const char *prefix = prefix_str ? env->GetStringUTFChars(prefix_str, nullptr) : nullptr;
+    std::vector<whisper_token> tokens;
+    const int n_used = decoding_vocabulary_prompt(bc->ctx, prefix, term_list, max_tokens, tokens);
+    if (prefix) env->ReleaseStringUTFChars(prefix_str, prefix);
+    
+    {
+        std::lock_guard<std::mutex> lock(bc->settings_lock);
+        bc->prompt_tokens.swap(tokens);
     }
+    LOGI("Vocabulary prompt: %d of %d terms, %d tokens, tokenized in %.1f ms",
+         n_used, (int)n_terms, (int)bc->prompt_tokens.size(), elapsed_ms(t_start_us));
+    return (jint)bc->prompt_tokens.size();
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_fullTranscribe(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jint num_threads, jfloatArray audio_data,
+        jstring mel_cache_path_str, jlong mel_stream_ptr, jint audio_ctx, jobject listener) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    const int64_t t_start_us = ggml_time_us();
+    bc->timings = {};
+    bc->timings.mel_cache = MEL_CACHE_UNUSED;
+    if (!ensure_state(bc->ctx, &bc->state, &bc->timings.resume_ms)) {
+        finish_timings(&bc->timings, t_start_us, bc->prompt_token_ms);
+        return;
+    }
+    
+    jfloat *audio_data_arr = env->GetFloatArrayElements(audio_data, nullptr);
+    const jsize audio_data_length = env->GetArrayLength(audio_data);
+    const char *mel_cache_path = mel_cache_path_str ? env->GetStringUTFChars(mel_cache_path_str, nullptr) : nullptr;
+    
+    const int mel_frames = decoding_token_times(bc->decoding) ? 0 :
+            prepare_mel(bc, num_threads, audio_data_arr, (uint64_t)audio_data_length,
+                        (log_mel_stream *)mel_stream_ptr, mel_cache_path);
+    
+    if (mel_cache_path) {
+        env->ReleaseStringUTFChars(mel_cache_path_str, mel_cache_path);
+    }
+    
+    struct segment_listener sl = segment_listener_from(env, listener);
+    run_full_transcribe(bc, num_threads, audio_data_arr, audio_data_length, mel_frames, audio_ctx, t_start_us,
+                        listener ? &sl : nullptr);
     
     env->ReleaseFloatArrayElements(audio_data, audio_data_arr, JNI_ABORT);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_transcribeArchive(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jint num_threads, jstring archive_path_str,
+        jstring mel_cache_path_str, jobject listener) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    const int64_t t_start_us = ggml_time_us();
+    bc->timings = {};
+    bc->timings.mel_cache = MEL_CACHE_UNUSED;
+    if (!ensure_state(bc->ctx, &bc->state, &bc->timings.resume_ms)) {
+        finish_timings(&bc->timings, t_start_us, bc->prompt_token_ms);
+        return JNI_FALSE;
+    }
+    
+    const char *archive_path = env->GetStringUTFChars(archive_path_str, nullptr);
+    const char *mel_cache_path = mel_cache_path_str ? env->GetStringUTFChars(mel_cache_path_str, nullptr) : nullptr;
+    
+    // A cache hit only needs the sample count from the archive header
+    const bool pcm_only = decoding_token_times(bc->decoding);
+    int mel_frames = 0;
+    if (mel_cache_path && !pcm_only) {
+        audio_archive_reader *reader = audio_archive_open(archive_path);
+        if (reader) {
+            mel_frames = prepare_mel(bc, num_threads, nullptr, reader->n_samples, nullptr, mel_cache_path);
+            audio_archive_close(reader);
+        }
+    }
+    
+    // Otherwise decode straight into whisper's input buffer - no WAV or Java array round trip
+    std::vector<float> samples;
+    bool ok = true;
+    if (mel_frames == 0) {
+        int sample_rate = 0;
+        ok = audio_archive_decode_float(archive_path, samples, &sample_rate) && sample_rate == WHISPER_SAMPLE_RATE;
+        if (!ok) {
+            LOGE("Failed to decode archive %s (rate=%d)", archive_path, sample_rate);
+        } else if (!pcm_only) {
+            mel_frames = prepare_mel(bc, num_threads, samples.data(), samples.size(), nullptr, mel_cache_path);
+        }
+    }
+    
+    if (mel_cache_path) {
+        env->ReleaseStringUTFChars(mel_cache_path_str, mel_cache_path);
+    }
+    env->ReleaseStringUTFChars(archive_path_str, archive_path);
+    
+    if (!ok) {
+        return JNI_FALSE;
+    }
+    struct segment_listener sl = segment_listener_from(env, listener);
+    run_full_transcribe(bc, num_threads, samples.empty() ? nullptr : samples.data(), (int)samples.size(),
+                        mel_frames, AUDIO_CTX_FULL, t_start_us, listener ? &sl : nullptr);
+    return JNI_TRUE;
+}
+
+/**
+ * Warm the context up with one full-window encode of a second of silence
+ * and a prompt pass: this faults in every encoder and decoder weight,
+ * sizes the compute buffers and spins up the thread pool, so the first
+ * real transcription runs at steady-state speed. The pass is over the
+ * vocabulary prompt (or as many start tokens when there is none) plus
+ * the start token, and its time per token sets prompt_token_ms, the
+ * basis of prompt_est_ms. Returns
+ * the warm-up time in ms, or -1.
+ */
+JNIEXPORT jfloat JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_warmUp(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jint num_threads) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    const int64_t t_start_us = ggml_time_us();
+    
+    std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+    const whisper_token sot = whisper_token_sot(bc->ctx);
+    std::vector<whisper_token> prompt(bc->prompt_tokens);
+    if (prompt.empty()) {
+        prompt.assign(DECODING_PROMPT_TOKENS, sot);
+    }
+    prompt.push_back(sot);
+    
+    float resume_ms = 0;
+    bool ok = ensure_state(bc->ctx, &bc->state, &resume_ms);
+    ok = ok && whisper_pcm_to_mel_with_state(bc->ctx, bc->state, silence.data(), (int)silence.size(), num_threads) == 0;
+    ok = ok && whisper_encode_with_state(bc->ctx, bc->state, 0, num_threads) == 0;
+    
+    const int64_t t_prompt_us = ggml_time_us();
+    ok = ok && whisper_decode_with_state(bc->ctx, bc->state, prompt.data(), (int)prompt.size(), 0, num_threads) == 0;
+    const float prompt_ms = elapsed_ms(t_prompt_us);
+    
+    const float warm_up_ms = elapsed_ms(t_start_us);
+    if (!ok) {
+        LOGE("Warm-up failed after %.1f ms", warm_up_ms);
+        return -1.0f;
+    }
+    {
+        std::lock_guard<std::mutex> lock(bc->settings_lock);
+        bc->prompt_token_ms = prompt_ms * num_threads / prompt.size();
+    }
+    LOGI("Warm-up with %d threads: %.1f ms, prompt pass of %d tokens %.1f ms",
+         num_threads, warm_up_ms, (int)prompt.size(), prompt_ms);
+    return warm_up_ms;
+}
+
+/**
+ * Timings of the last transcription, in the order read by TranscriptionTimings:
+ * [total, mel, encode, decode, prompt_est, mel_cache, audio_ctx, audio_ctx_retries,
+ *  windows, fallbacks, prompt_tokens, threads, resume]
+ * prompt_est is estimated from warmUp (see finish_timings).
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_getTimings(
+        JNIEnv *env, jobject thiz, jlong context_ptr) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    float values[13] = {
+        bc->timings.total_ms,
+        bc->timings.mel_ms,
+        bc->timings.encode_ms,
+        bc->timings.decode_ms,
+        bc->timings.prompt_est_ms,
+        (float)bc->timings.mel_cache,
+        (float)bc->timings.audio_ctx,
+        (float)bc->timings.audio_ctx_retries,
+        (float)bc->timings.windows,
+        (float)bc->timings.fallbacks,
+        (float)bc->timings.prompt_tokens,
+        (float)bc->timings.threads,
+        bc->timings.resume_ms,
+    };
+    
+    const jsize n_values = (jsize)(sizeof(values) / sizeof(values[0]));
+    jfloatArray result = env->NewFloatArray(n_values);
+    env->SetFloatArrayRegion(result, 0, n_values, values);
+    return result;
+}
+
+// ============================================================================
+// JNI Functions - Streaming Session
+// ============================================================================
+
+// Take the context's current decoding params and vocabulary
+static void session_snapshot(struct bridge_session *session) {
+    std::lock_guard<std::mutex> lock(session->bc->settings_lock);
+    session->decoding = session->bc->decoding;
+    session->vocab = session->bc->prompt_tokens;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_createSession(
+        JNIEnv *env, jobject thiz, jlong context_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    struct whisper_state *state = whisper_init_state(bc->ctx);
+    if (!state) {
+        LOGE("Failed to allocate session state");
+        return 0;
+    }
+    
+    struct bridge_session *session = new bridge_session();
+    session->bc = bc;
+    session->state = state;
+    session->timings.mel_cache = MEL_CACHE_UNUSED;
+    session_snapshot(session);
+    return (jlong)session;
+}
+
+/**
+ * Decode the next chunk of the recording. Whisper's KV cache lives only
+ * for a single whisper_full call, so context is carried as the text
+ * tokens of earlier chunks instead, decoded in one batched prompt pass.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionTranscribe(
+        JNIEnv *env, jobject thiz, jlong session_ptr, jint num_threads, jfloatArray audio_data, jint length) {
+    UNUSED(thiz);
+    
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    struct bridge_context *bc = session->bc;
+    const int64_t t_start_us = ggml_time_us();
+    session->timings = {};
+    session->timings.mel_cache = MEL_CACHE_UNUSED;
+    if (!ensure_state(bc->ctx, &session->state, &session->timings.resume_ms)) {
+        finish_timings(&session->timings, t_start_us, 0);
+        return JNI_FALSE;
+    }
+    
+    struct whisper_full_params params = full_params(session->decoding, &session->timings, num_threads);
+    
+    // whisper keeps at most n_text_ctx / 2 prompt tokens, dropping the
+    // oldest; trim the carried text so the vocabulary is never the part lost
+    const size_t n_limit = (size_t)(whisper_n_text_ctx(bc->ctx) / 2 - 1);
+    const size_t n_past_max = n_limit > session->vocab.size() ? n_limit - session->vocab.size() : 0;
+    if (session->past_tokens.size() > n_past_max) {
+        session->past_tokens.erase(session->past_tokens.begin(),
+                                   session->past_tokens.end() - n_past_max);
+    }
+    session->prompt.assign(session->vocab.begin(), session->vocab.end());
+    session->prompt.insert(session->prompt.end(), session->past_tokens.begin(), session->past_tokens.end());
+    if (!session->prompt.empty()) {
+        params.prompt_tokens = session->prompt.data();
+        params.prompt_n_tokens = (int)session->prompt.size();
+        session->timings.prompt_tokens = params.prompt_n_tokens;
+    }
+    
+    jfloat *audio_data_arr = env->GetFloatArrayElements(audio_data, nullptr);
+    const int n_samples = length < env->GetArrayLength(audio_data) ? length : env->GetArrayLength(audio_data);
+    
+    const int ret = whisper_full_with_state(bc->ctx, session->state, params, audio_data_arr, n_samples);
+    
+    env->ReleaseFloatArrayElements(audio_data, audio_data_arr, JNI_ABORT);
+    float prompt_token_ms;
+    {
+        std::lock_guard<std::mutex> lock(bc->settings_lock);
+        prompt_token_ms = bc->prompt_token_ms;
+    }
+    finish_timings(&session->timings, t_start_us, prompt_token_ms);
+    
+    session->chunk_offset = session->offset;
+    session->offset += n_samples / WHISPER_HOP_LENGTH;
+    session->n_chunks++;
+    
+    if (ret != 0) {
+        LOGE("Session chunk %d failed", session->n_chunks);
+        return JNI_FALSE;
+    }
+    
+    // Carry this chunk's text (no special or timestamp tokens) forward
+    const whisper_token token_eot = whisper_token_eot(bc->ctx);
+    const int n_segments = whisper_full_n_segments_from_state(session->state);
+    session->chunk_segments.clear();
+    for (int i = 0; i < n_segments; i++) {
+        session->chunk_segments.emplace_back(
+                session->chunk_offset + whisper_full_get_segment_t0_from_state(session->state, i),
+                session->past_tokens.size());
+        const int n_tokens = whisper_full_n_tokens_from_state(session->state, i);
+        for (int j = 0; j < n_tokens; j++) {
+            const whisper_token id = whisper_full_get_token_id_from_state(session->state, i, j);
+            if (id < token_eot) {
+                session->past_tokens.push_back(id);
+            }
+        }
+    }
+    
+    LOGI("Session chunk %d: %d segments, %d prompt tokens, %d fallbacks, %.1f ms",
+         session->n_chunks, n_segments, session->timings.prompt_tokens, session->timings.fallbacks,
+         session->timings.total_ms);
+    return JNI_TRUE;
+}
+
+/**
+ * Forget the carried context and restart timestamps at zero, e.g. when a
+ * new appointment starts. Picks up the context's current decoding params
+ * and vocabulary.
+ */
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionReset(
+        JNIEnv *env, jobject thiz, jlong session_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    session->past_tokens.clear();
+    session->chunk_segments.clear();
+    session->offset = 0;
+    session->chunk_offset = 0;
+    session->n_chunks = 0;
+    session_snapshot(session);
+}
+
+/**
+ * Override the decoding params of this session only, until its next reset
+ */
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionSetDecodingParams(
+        JNIEnv *env, jobject thiz, jlong session_ptr, jint strategy, jint best_of, jint beam_size,
+        jfloat temperature, jfloat temperature_inc, jfloat entropy_thold, jfloat logprob_thold,
+        jfloat no_speech_thold, jint max_len, jboolean token_timestamps, jstring language_str) {
+    UNUSED(thiz);
+    
+    ((struct bridge_session *)session_ptr)->decoding = decoding_from_jni(
+            env, strategy, best_of, beam_size, temperature, temperature_inc, entropy_thold, logprob_thold,
+            no_speech_thold, max_len, token_timestamps, language_str);
+}
+
+/**
+ * Set where the next chunk starts in the recording (10 ms units), keeping
+ * the carried context - for resuming a recording, or re-decoding from the
+ * start of a segment that a chunk boundary cut off. The text of segments
+ * of the last chunk from there on is dropped from the context, so the
+ * next chunk isn't prompted with the words it is about to decode.
+ */
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionSeek(
+        JNIEnv *env, jobject thiz, jlong session_ptr, jlong offset) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    if (offset < session->offset) {
+        for (const auto &segment : session->chunk_segments) {
+            if (segment.first >= offset) {
+                session->past_tokens.resize(segment.second);
+                break;
+            }
+        }
+    }
+    session->chunk_segments.clear();
+    session->offset = offset;
+}
+
+/**
+ * Carry already committed text into the next chunk, as if the session had
+ * decoded it - for resuming a recording on a freshly reset session. Only
+ * the tail within the prompt limit is kept, as in sessionTranscribe.
+ */
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionRestoreContext(
+        JNIEnv *env, jobject thiz, jlong session_ptr, jstring text_str) {
+    UNUSED(thiz);
+
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    const char *text = env->GetStringUTFChars(text_str, nullptr);
+    session->past_tokens.clear();
+    if (!decoding_append_tokens(session->bc->ctx, text, session->past_tokens)) {
+        LOGW("Failed to tokenize the restored session context");
+    }
+    env->ReleaseStringUTFChars(text_str, text);
+    session->chunk_segments.clear();
+}
+
+/**
+ * Timings and counters of the last chunk, in the getTimings layout. The
+ * session never computes the mel itself, so the mel slots are unused.
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionGetTimings(
+        JNIEnv *env, jobject thiz, jlong session_ptr) {
+    UNUSED(thiz);
+    
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    float values[13] = {
+        session->timings.total_ms,
+        0,
+        session->timings.encode_ms,
+        session->timings.decode_ms,
+        session->timings.prompt_est_ms,
+        (float)session->timings.mel_cache,
+        0,
+        0,
+        (float)session->timings.windows,
+        (float)session->timings.fallbacks,
+        (float)session->timings.prompt_tokens,
+        (float)session->timings.threads,
+        session->timings.resume_ms,
+    };
+    
+    const jsize n_values = (jsize)(sizeof(values) / sizeof(values[0]));
+    jfloatArray result = env->NewFloatArray(n_values);
+    env->SetFloatArrayRegion(result, 0, n_values, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_freeSession(
+        JNIEnv *env, jobject thiz, jlong session_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    whisper_free_state(session->state);
+    delete session;
+}
+
+// ============================================================================
+// JNI Functions - Memory
+// ============================================================================
+
+// Resident set size of the process in bytes, 0 if unreadable
+static int64_t resident_bytes() {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    long n_pages = 0;
+    long n_resident = 0;
+    const int n_read = fscanf(f, "%ld %ld", &n_pages, &n_resident);
+    fclose(f);
+    return n_read == 2 ? (int64_t)n_resident * sysconf(_SC_PAGESIZE) : 0;
+}
+
+// Peak resident set size (VmHWM) in bytes, 0 if unreadable
+static int64_t peak_resident_bytes() {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) {
+        return 0;
+    }
+    char line[128];
+    long peak_kb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmHWM: %ld kB", &peak_kb) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    return (int64_t)peak_kb * 1024;
+}
+
+/**
+ * Free a state, returning how far the resident set shrank. Approximate:
+ * other threads allocate at the same time. 0 if already freed.
+ */
+static int64_t trim_state(struct whisper_state **state) {
+    if (!*state) {
+        return 0;
+    }
+    const int64_t rss_before = resident_bytes();
+    whisper_free_state(*state);
+    *state = nullptr;
+    const int64_t reclaimed = rss_before - resident_bytes();
+    return reclaimed > 0 ? reclaimed : 0;
+}
+
+/**
+ * Free the context's KV caches, compute buffers and last results, keeping
+ * the model weights; the next call that needs them re-creates them (see
+ * resume in getTimings). Must not overlap a transcription on the context.
+ * Returns the bytes reclaimed.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_trimMemory(
+        JNIEnv *env, jobject thiz, jlong context_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    const bool resident = bc->state != nullptr;
+    const int64_t reclaimed = trim_state(&bc->state);
+    if (resident) {
+        LOGI("Context trimmed: %.1f MB reclaimed", reclaimed / (1024.0 * 1024.0));
+    }
+    return (jlong)reclaimed;
+}
+
+/**
+ * Same for a session between chunks; the carried text and offsets are
+ * kept, so the next chunk continues where the last one ended
+ */
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_sessionTrimMemory(
+        JNIEnv *env, jobject thiz, jlong session_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    return (jlong)trim_state(&((struct bridge_session *)session_ptr)->state);
+}
+
+/**
+ * Resident and peak resident set size of the process, in bytes:
+ * [resident, peak]
+ */
+JNIEXPORT jlongArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_getMemoryUsage(
+        JNIEnv *env, jobject thiz) {
+    UNUSED(thiz);
+    
+    const jlong values[2] = { (jlong)resident_bytes(), (jlong)peak_resident_bytes() };
+    jlongArray result = env->NewLongArray(2);
+    env->SetLongArrayRegion(result, 0, 2, values);
+    return result;
+}
+
+/**
+ * Restart peak tracking from the current resident set (Linux 4.0+), so a
+ * benchmark can measure the peak of one configuration. False if the
+ * kernel or the sandbox doesn't allow it.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_resetPeakMemory(
+        JNIEnv *env, jobject thiz) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (!f) {
+        return JNI_FALSE;
+    }
+    const bool written = fputs("5", f) >= 0;
+    return fclose(f) == 0 && written ? JNI_TRUE : JNI_FALSE;
+}
+
 // ============================================================================
 // JNI Functions - Result Retrieval
 // ============================================================================
 
+static jbyteArray to_byte_array(JNIEnv *env, const std::vector<uint8_t> &data) {
+    jbyteArray result = env->NewByteArray((jsize)data.size());
+    env->SetByteArrayRegion(result, 0, (jsize)data.size(), (const jbyte *)data.data());
+    return result;
+}
+
+static int result_flags(const struct bridge_decoding_params &decoding, jboolean with_tokens) {
+    if (!with_tokens) {
+        return 0;
+    }
+    return RESULT_PACK_TOKENS | (decoding_token_times(decoding) ? RESULT_PACK_TOKEN_TIMES : 0);
+}
+
+/**
+ * All segments of the last transcription, and optionally their tokens
+ * with probabilities and timestamps, in the result_pack layout
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_getResults(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jboolean with_tokens) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    std::vector<uint8_t> packed;
+    if (bc->state) {
+        result_pack(bc->ctx, bc->state, 0, result_flags(bc->decoding, with_tokens), packed);
+    } else {
+        // Trimmed: no results, just an empty header
+        packed.assign(RESULT_PACK_HEADER_FIELDS * sizeof(int32_t), 0);
+    }
+    return to_byte_array(env, packed);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_getSessionResults(
+        JNIEnv *env, jobject thiz, jlong session_ptr, jboolean with_tokens) {
+    UNUSED(thiz);
+    
+    struct bridge_session *session = (struct bridge_session *)session_ptr;
+    std::vector<uint8_t> packed;
+    if (session->state) {
+        result_pack(session->bc->ctx, session->state, session->chunk_offset,
+                    result_flags(session->decoding, with_tokens), packed);
+    } else {
+        packed.assign(RESULT_PACK_HEADER_FIELDS * sizeof(int32_t), 0);
+    }
+    return to_byte_array(env, packed);
+}
+
 JNIEXPORT jint JNICALL
 Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_getTextSegmentCount(
         JNIEnv *env, jobject thiz, jlong context_ptr) {
     UNUSED(env);
     UNUSED(thiz);
     
-    struct whisper_context *context = (struct whisper_context *)context_ptr;
-    return whisper_full_n_segments(context);
+    struct whisper_state *state = ((struct bridge_context *)context_ptr)->state;
+    return state ? whisper_full_n_segments_from_state(state) : 0;
 }
 
 JNIEXPORT jstring JNICALL
@@ -279,8 +1250,8 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_g
         JNIEnv *env, jobject thiz, jlong context_ptr, jint index) {
     UNUSED(thiz);
     
-    struct whisper_context *context = (struct whisper_context *)context_ptr;
-    const char *text = whisper_full_get_segment_text(context, index);
+    struct whisper_state *state = ((struct bridge_context *)context_ptr)->state;
+    const char *text = whisper_full_get_segment_text_from_state(state, index);
     return env->NewStringUTF(text);
 }
 
@@ -290,8 +1261,8 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_g
     UNUSED(env);
     UNUSED(thiz);
     
-    struct whisper_context *context = (struct whisper_context *)context_ptr;
-    return whisper_full_get_segment_t0(context, index);
+    struct whisper_state *state = ((struct bridge_context *)context_ptr)->state;
+    return whisper_full_get_segment_t0_from_state(state, index);
 }
 
 JNIEXPORT jlong JNICALL
@@ -300,8 +1271,202 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_g
     UNUSED(env);
     UNUSED(thiz);
     
-    struct whisper_context *context = (struct whisper_context *)context_ptr;
-    return whisper_full_get_segment_t1(context, index);
+    struct whisper_state *state = ((struct bridge_context *)context_ptr)->state;
+    return whisper_full_get_segment_t1_from_state(state, index);
+}
+
+// ============================================================================
+// JNI Functions - Audio Conversion
+// ============================================================================
+
+static jfloatArray to_float_array(JNIEnv *env, const std::vector<float> &data) {
+    jfloatArray result = env->NewFloatArray((jsize)data.size());
+    if (result && !data.empty()) {
+        env->SetFloatArrayRegion(result, 0, (jsize)data.size(), data.data());
+    }
+    return result;
+}
+
+// Throws IllegalArgumentException unless length samples of channels
+// interleaved channels fit in pcm
+static bool check_pcm(JNIEnv *env, jshortArray pcm, jint length, jint channels) {
+    if (channels > 0 && length >= 0 && length <= env->GetArrayLength(pcm)) {
+        return true;
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "Invalid PCM: %d samples, %d channels", length, channels);
+    env->ThrowNew(env->FindClass("java/lang/IllegalArgumentException"), message);
+    return false;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_createResampler(
+        JNIEnv *env, jobject thiz, jint in_rate, jint out_rate) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    audio_resampler *rs = audio_resampler_init(in_rate, out_rate);
+    if (!rs) {
+        LOGE("Invalid resampler rates: %d -> %d", in_rate, out_rate);
+        return 0;
+    }
+    LOGI("Resampler created: %d -> %d Hz (L=%d, M=%d, %d taps/phase)",
+         in_rate, out_rate, rs->up, rs->down, rs->taps);
+    return (jlong)rs;
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_resamplerProcess(
+        JNIEnv *env, jobject thiz, jlong resampler_ptr, jshortArray pcm, jint length, jint channels) {
+    UNUSED(thiz);
+    
+    if (!check_pcm(env, pcm, length, channels)) {
+        return nullptr;
+    }
+    audio_resampler *rs = (audio_resampler *)resampler_ptr;
+    const size_t n_frames = (size_t)(length / channels);
+    
+    jshort *pcm_arr = env->GetShortArrayElements(pcm, nullptr);
+    std::vector<float> mono(n_frames);
+    audio_downmix_s16(pcm_arr, n_frames, channels, mono.data());
+    env->ReleaseShortArrayElements(pcm, pcm_arr, JNI_ABORT);
+    
+    std::vector<float> out;
+    audio_resampler_process(rs, mono.data(), mono.size(), out);
+    return to_float_array(env, out);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_resamplerFlush(
+        JNIEnv *env, jobject thiz, jlong resampler_ptr) {
+    UNUSED(thiz);
+    
+    audio_resampler *rs = (audio_resampler *)resampler_ptr;
+    std::vector<float> out;
+    audio_resampler_flush(rs, out);
+    return to_float_array(env, out);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_freeResampler(
+        JNIEnv *env, jobject thiz, jlong resampler_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    audio_resampler_free((audio_resampler *)resampler_ptr);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_convertToWhisper(
+        JNIEnv *env, jobject thiz, jshortArray pcm, jint channels, jint sample_rate) {
+    UNUSED(thiz);
+    
+    const jsize length = env->GetArrayLength(pcm);
+    if (!check_pcm(env, pcm, length, channels)) {
+        return nullptr;
+    }
+    jshort *pcm_arr = env->GetShortArrayElements(pcm, nullptr);
+    std::vector<float> out = audio_convert_to_whisper(pcm_arr, (size_t)(length / channels), channels, sample_rate);
+    env->ReleaseShortArrayElements(pcm, pcm_arr, JNI_ABORT);
+    
+    LOGI("Converted %d samples (%d ch @ %d Hz) to %zu samples @ 16 kHz",
+         length, channels, sample_rate, out.size());
+    return to_float_array(env, out);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_archiveEncodeWave(
+        JNIEnv *env, jobject thiz, jstring wav_path_str, jstring archive_path_str) {
+    UNUSED(thiz);
+    
+    const char *wav_path = env->GetStringUTFChars(wav_path_str, nullptr);
+    const char *archive_path = env->GetStringUTFChars(archive_path_str, nullptr);
+    
+    audio_archive_stats stats = {};
+    const bool ok = audio_archive_encode_wav(wav_path, archive_path, &stats);
+    if (ok) {
+        LOGI("Archived %s: %llu -> %llu bytes (ratio %.2f) in %.1f ms",
+             wav_path, (unsigned long long)stats.input_bytes, (unsigned long long)stats.output_bytes,
+             (double)stats.input_bytes / stats.output_bytes, stats.encode_ms);
+    } else {
+        LOGE("Failed to archive %s", wav_path);
+    }
+    
+    env->ReleaseStringUTFChars(archive_path_str, archive_path);
+    env->ReleaseStringUTFChars(wav_path_str, wav_path);
+    return ok ? (jlong)stats.output_bytes : -1;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_archiveCheck(
+        JNIEnv *env, jobject thiz, jstring archive_path_str) {
+    UNUSED(thiz);
+    
+    const char *archive_path = env->GetStringUTFChars(archive_path_str, nullptr);
+    const bool ok = audio_archive_check(archive_path);
+    if (!ok) {
+        LOGW("Archive %s is incomplete or corrupt", archive_path);
+    }
+    env->ReleaseStringUTFChars(archive_path_str, archive_path);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_archiveDecode(
+        JNIEnv *env, jobject thiz, jstring archive_path_str) {
+    UNUSED(thiz);
+    
+    const char *archive_path = env->GetStringUTFChars(archive_path_str, nullptr);
+    std::vector<float> samples;
+    const bool ok = audio_archive_decode_float(archive_path, samples, nullptr);
+    if (!ok) {
+        LOGE("Failed to decode archive %s", archive_path);
+    }
+    env->ReleaseStringUTFChars(archive_path_str, archive_path);
+    
+    return ok ? to_float_array(env, samples) : nullptr;
+}
+
+// ============================================================================
+// JNI Functions - Mel Spectrogram
+// ============================================================================
+
+JNIEXPORT jint JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_getModelMelBands(
+        JNIEnv *env, jobject thiz, jlong context_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    struct whisper_context *context = ((struct bridge_context *)context_ptr)->ctx;
+    return whisper_model_n_mels(context);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_createMelStream(
+        JNIEnv *env, jobject thiz, jint n_mel) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    return (jlong)log_mel_stream_init(n_mel);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_melStreamPush(
+        JNIEnv *env, jobject thiz, jlong stream_ptr, jfloatArray samples, jint length) {
+    UNUSED(thiz);
+    
+    jfloat *samples_arr = env->GetFloatArrayElements(samples, nullptr);
+    log_mel_stream_push((log_mel_stream *)stream_ptr, samples_arr, (size_t)length);
+    env->ReleaseFloatArrayElements(samples, samples_arr, JNI_ABORT);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_freeMelStream(
+        JNIEnv *env, jobject thiz, jlong stream_ptr) {
+    UNUSED(env);
+    UNUSED(thiz);
+    
+    log_mel_stream_free((log_mel_stream *)stream_ptr);
 }
 
 // ============================================================================
@@ -335,4 +1500,38 @@ Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_b
     return env->NewStringUTF(bench_result);
 }
 
+JNIEXPORT jstring JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_benchResampler(
+        JNIEnv *env, jobject thiz) {
+    UNUSED(thiz);
+    
+    std::string bench_result = audio_bench_resampler();
+    return env->NewStringUTF(bench_result.c_str());
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_benchArchive(
+        JNIEnv *env, jobject thiz, jstring tmp_dir_str) {
+    UNUSED(thiz);
+    
+    const char *tmp_dir = env->GetStringUTFChars(tmp_dir_str, nullptr);
+    std::string bench_result = audio_bench_archive(tmp_dir);
+    env->ReleaseStringUTFChars(tmp_dir_str, tmp_dir);
+    return env->NewStringUTF(bench_result.c_str());
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_example_medicalappointmentcompanion_whisper_WhisperLib_00024Companion_benchMel(
+        JNIEnv *env, jobject thiz, jlong context_ptr, jint n_threads, jint minutes) {
+    UNUSED(thiz);
+    
+    struct bridge_context *bc = (struct bridge_context *)context_ptr;
+    float resume_ms = 0;
+    if (!ensure_state(bc->ctx, &bc->state, &resume_ms)) {
+        return env->NewStringUTF("mel bench: no whisper state");
+    }
+    std::string bench_result = mel_bench(bc->ctx, bc->state, n_threads, minutes);
+    return env->NewStringUTF(bench_result.c_str());
+}
+
 } // extern "C"
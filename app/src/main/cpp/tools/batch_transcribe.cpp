@@ -0,0 +1,487 @@
+/**
+ * Batch re-transcription of an appointment audio archive (host CLI)
+ *
+ * Streams over every recording (.wav / .vbla) in a copy of the app's
+ * files/audio directory, e.g. pulled with `adb pull`, and re-transcribes
+ * it with a new model before the model ships. One model is loaded and
+ * shared by N worker threads, each with its own whisper_state. Workers
+ * pause between 30 s windows while the hottest thermal zone is above
+ * --max-temp, so the same binary can run under `adb shell` on a device.
+ *
+ * Recordings are decoded as the app decodes them: the same DecodingParams
+ * preset (BALANCED unless --decoding says otherwise) and the medication
+ * vocabulary prompt, both set up by the shared decoding.cpp, so the
+ * transcripts can be compared with the app's. An archive is only used
+ * when it is complete; otherwise its WAV is, as in LocalStorage.
+ *
+ * Each recording's transcript is written as <id>.json in the app's
+ * Transcription JSON shape, replaced atomically (temporary file + rename),
+ * and the run reports throughput in audio-hours per wall-hour.
+ *
+ * Usage:
+ *   batch_transcribe -m model.bin -i audio_dir -o out_dir
+ *                    [-w workers] [-t threads] [-l lang] [--decoding preset]
+ *                    [--vocab file | --no-vocab] [--max-temp C] [--flash-attn] [-f]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "whisper.h"
+#include "audio_archive.h"
+#include "decoding.h"
+#include "resampler.h"
+
+#define WHISPER_SAMPLE_RATE 16000
+
+// The app's vocabulary prompt terms (set by CMake to tools/medication_vocabulary.txt)
+#ifndef DEFAULT_VOCAB_PATH
+#define DEFAULT_VOCAB_PATH ""
+#endif
+
+// Resume below the limit minus this much, so workers don't flap
+#define THERMAL_HYSTERESIS_C 5.0f
+#define THERMAL_POLL_MS      2000
+
+struct batch_options {
+    std::string model;
+    std::string input_dir;
+    std::string output_dir;
+    std::string language;       // empty: the preset's
+    std::string decoding = "balanced";
+    std::string vocab = DEFAULT_VOCAB_PATH;     // one term per line; empty: no prompt
+    int workers = 2;
+    int threads = 0;            // 0 = hardware concurrency
+    float max_temp_c = 0.0f;    // 0 = no thermal throttling
+    bool flash_attn = false;
+    bool force = false;
+};
+
+struct batch_totals {
+    std::atomic<int> done{0};
+    std::atomic<int> failed{0};
+    std::atomic<int> skipped{0};
+    std::atomic<int64_t> audio_ms{0};
+    std::atomic<int64_t> throttled_ms{0};
+};
+
+struct worker_context {
+    const batch_options *opts;
+    batch_totals *totals;
+};
+
+// Decoding shared by every worker, read-only once the workers start
+struct batch_decoding {
+    bridge_decoding_params params;
+    std::vector<whisper_token> prompt;
+};
+
+// ============================================================================
+// Audio
+// ============================================================================
+
+static bool ends_with(const std::string &s, const char *suffix) {
+    const size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+/**
+ * 16-bit PCM WAV at any rate/channel count, converted to 16 kHz mono
+ */
+static bool read_wav(const char *path, std::vector<float> &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    char riff[12];
+    if (fread(riff, 1, 12, f) != 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return false;
+    }
+
+    int channels = 0;
+    int sample_rate = 0;
+    int bits = 0;
+    std::vector<int16_t> pcm;
+
+    char id[4];
+    uint32_t size;
+    while (fread(id, 1, 4, f) == 4 && fread(&size, 4, 1, f) == 1) {
+        if (memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, 16, f) != 16) break;
+            channels = fmt[2] | (fmt[3] << 8);
+            sample_rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(f, size - 16 + (size & 1), SEEK_CUR);
+        } else if (memcmp(id, "data", 4) == 0) {
+            pcm.resize(size / sizeof(int16_t));
+            pcm.resize(fread(pcm.data(), sizeof(int16_t), pcm.size(), f));
+            break;
+        } else {
+            fseek(f, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fclose(f);
+
+    if (bits != 16 || channels < 1 || sample_rate <= 0 || pcm.empty()) return false;
+    out = audio_convert_to_whisper(pcm.data(), pcm.size() / channels, channels, sample_rate);
+    return true;
+}
+
+/**
+ * Vocabulary terms, one per line in order; blank lines and '#' comments
+ * are skipped
+ */
+static bool read_terms(const std::string &path, std::vector<std::string> &terms) {
+    FILE *f = fopen(path.c_str(), "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        std::string term = line;
+        term.erase(term.find_last_not_of(" \t\r\n") + 1);
+        term.erase(0, term.find_first_not_of(" \t"));
+        if (!term.empty() && term[0] != '#') terms.push_back(term);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool load_recording(const std::string &path, std::vector<float> &out) {
+    if (ends_with(path, ".vbla")) {
+        int sample_rate = 0;
+        return audio_archive_decode_float(path.c_str(), out, &sample_rate) && sample_rate == WHISPER_SAMPLE_RATE;
+    }
+    return read_wav(path.c_str(), out);
+}
+
+/**
+ * Recordings in the archive, one per appointment: when a WAV and its
+ * compressed archive both exist the archive wins if it is complete, as in
+ * LocalStorage. An incomplete archive with no WAV is reported and left out.
+ */
+static std::vector<std::string> list_recordings(const std::string &dir) {
+    std::vector<std::string> names;
+    DIR *d = opendir(dir.c_str());
+    if (!d) return names;
+    while (struct dirent *e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (ends_with(name, ".vbla")) {
+            const std::string wav = dir + "/" + name.substr(0, name.size() - 5) + ".wav";
+            if (audio_archive_check((dir + "/" + name).c_str())) {
+                names.push_back(name);
+            } else if (access(wav.c_str(), F_OK) != 0) {
+                fprintf(stderr, "%s: incomplete archive and no WAV, skipped\n", name.c_str());
+            }
+        } else if (ends_with(name, ".wav")) {
+            const std::string archive = dir + "/" + name.substr(0, name.size() - 4) + ".vbla";
+            if (!audio_archive_check(archive.c_str())) names.push_back(name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// ============================================================================
+// Thermal throttling
+// ============================================================================
+
+/**
+ * Hottest thermal zone in °C, or a negative value if none is readable
+ */
+static float max_zone_temp_c() {
+    float hottest = -1.0f;
+    for (int i = 0; i < 64; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/temp", i);
+        FILE *f = fopen(path, "r");
+        if (!f) {
+            if (i > 0) break;
+            continue;
+        }
+        long millideg = 0;
+        if (fscanf(f, "%ld", &millideg) == 1) {
+            hottest = std::max(hottest, millideg / 1000.0f);
+        }
+        fclose(f);
+    }
+    return hottest;
+}
+
+/**
+ * Called by whisper before each 30 s window: blocks while the device is
+ * too hot, so throttling happens between windows rather than mid-decode
+ */
+static bool thermal_gate(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    (void)ctx;
+    (void)state;
+    auto *wc = (worker_context *)user_data;
+    const float limit = wc->opts->max_temp_c;
+    if (limit <= 0.0f || max_zone_temp_c() < limit) return true;
+
+    const auto t_start = std::chrono::steady_clock::now();
+    while (max_zone_temp_c() >= limit - THERMAL_HYSTERESIS_C) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(THERMAL_POLL_MS));
+    }
+    wc->totals->throttled_ms += std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t_start).count();
+    return true;
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+static void json_escape(std::string &out, const char *s) {
+    for (; *s; s++) {
+        const unsigned char c = (unsigned char)*s;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+}
+
+/**
+ * Transcript in LocalStorage's Transcription JSON shape
+ */
+static std::string transcript_json(struct whisper_state *state, const std::string &language) {
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    std::string full_text;
+    std::string segments;
+
+    for (int i = 0; i < n_segments; i++) {
+        std::string text = whisper_full_get_segment_text_from_state(state, i);
+        text.erase(0, text.find_first_not_of(' '));
+        if (text.empty()) continue;
+
+        if (!full_text.empty()) full_text += ' ';
+        full_text += text;
+
+        char times[96];
+        snprintf(times, sizeof(times), "\",\"startMs\":%lld,\"endMs\":%lld}",
+                 (long long)whisper_full_get_segment_t0_from_state(state, i) * 10,
+                 (long long)whisper_full_get_segment_t1_from_state(state, i) * 10);
+        segments += segments.empty() ? "{\"text\":\"" : ",{\"text\":\"";
+        json_escape(segments, text.c_str());
+        segments += times;
+    }
+
+    const long long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::string json = "{\"fullText\":\"";
+    json_escape(json, full_text.c_str());
+    json += "\",\"language\":\"";
+    json_escape(json, language.c_str());
+    json += "\",\"processedAt\":" + std::to_string(now_ms);
+    json += ",\"segments\":[" + segments + "]}\n";
+    return json;
+}
+
+/**
+ * Replace path with data so readers only ever see the old or new file
+ */
+static bool write_atomically(const std::string &path, const std::string &data) {
+    const std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = fflush(f) == 0 && ok;
+    ok = fsync(fileno(f)) == 0 && ok;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+static void run_worker(struct whisper_context *ctx, const batch_options *opts, const batch_decoding *decoding,
+                       int n_threads, const std::vector<std::string> *names, std::atomic<size_t> *next,
+                       batch_totals *totals, std::mutex *log_lock) {
+    struct whisper_state *state = whisper_init_state(ctx);
+    if (!state) {
+        std::lock_guard<std::mutex> lock(*log_lock);
+        fprintf(stderr, "failed to allocate a whisper state\n");
+        return;
+    }
+
+    worker_context wc = { opts, totals };
+    std::vector<float> samples;
+
+    for (size_t i = (*next)++; i < names->size(); i = (*next)++) {
+        const std::string &name = (*names)[i];
+        const std::string id = name.substr(0, name.rfind('.'));
+        const std::string out_path = opts->output_dir + "/" + id + ".json";
+
+        if (!opts->force && access(out_path.c_str(), F_OK) == 0) {
+            totals->skipped++;
+            continue;
+        }
+
+        const auto t_start = std::chrono::steady_clock::now();
+        bool ok = load_recording(opts->input_dir + "/" + name, samples);
+
+        if (ok) {
+            struct whisper_full_params params = decoding_full_params(decoding->params, n_threads);
+            if (!decoding->prompt.empty()) {
+                params.prompt_tokens = decoding->prompt.data();
+                params.prompt_n_tokens = (int)decoding->prompt.size();
+            }
+            params.encoder_begin_callback = thermal_gate;
+            params.encoder_begin_callback_user_data = &wc;
+
+            ok = whisper_full_with_state(ctx, state, params, samples.data(), (int)samples.size()) == 0
+                && write_atomically(out_path, transcript_json(state, decoding->params.language));
+        }
+
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        const int64_t audio_ms = ok ? (int64_t)samples.size() * 1000 / WHISPER_SAMPLE_RATE : 0;
+        if (ok) {
+            totals->done++;
+            totals->audio_ms += audio_ms;
+        } else {
+            totals->failed++;
+        }
+
+        std::lock_guard<std::mutex> lock(*log_lock);
+        if (ok) {
+            printf("%-40s %8.1f s audio %8.1f s wall\n", name.c_str(), audio_ms / 1000.0, wall_s);
+        } else {
+            fprintf(stderr, "%-40s FAILED\n", name.c_str());
+        }
+        fflush(stdout);
+    }
+
+    whisper_free_state(state);
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s -m model.bin -i audio_dir -o out_dir [-w workers] [-t threads]\n"
+            "          [-l lang] [--decoding preset] [--vocab file | --no-vocab]\n"
+            "          [--max-temp C] [--flash-attn] [-f]\n"
+            "  -w N          worker states sharing the model (default 2)\n"
+            "  -t N          total CPU threads, split between workers (default: all)\n"
+            "  -l LANG       transcription language (default: the preset's, en)\n"
+            "  --decoding P  DecodingParams preset: fast, balanced (default) or accurate\n"
+            "  --vocab FILE  vocabulary prompt terms, one per line (default: the app's\n"
+            "                medication vocabulary)\n"
+            "  --no-vocab    no vocabulary prompt (as with the app's prompt turned off)\n"
+            "  --max-temp C  pause between windows while a thermal zone is above C\n"
+            "  --flash-attn  fused flash-attention kernel (as ModelOptions.flashAttention)\n"
+            "  -f            re-transcribe recordings that already have output\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    batch_options opts;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-m" && has_value) opts.model = argv[++i];
+        else if (arg == "-i" && has_value) opts.input_dir = argv[++i];
+        else if (arg == "-o" && has_value) opts.output_dir = argv[++i];
+        else if (arg == "-w" && has_value) opts.workers = atoi(argv[++i]);
+        else if (arg == "-t" && has_value) opts.threads = atoi(argv[++i]);
+        else if (arg == "-l" && has_value) opts.language = argv[++i];
+        else if (arg == "--decoding" && has_value) opts.decoding = argv[++i];
+        else if (arg == "--vocab" && has_value) opts.vocab = argv[++i];
+        else if (arg == "--no-vocab") opts.vocab.clear();
+        else if (arg == "--max-temp" && has_value) opts.max_temp_c = (float)atof(argv[++i]);
+        else if (arg == "--flash-attn") opts.flash_attn = true;
+        else if (arg == "-f") opts.force = true;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    batch_decoding decoding;
+    if (opts.model.empty() || opts.input_dir.empty() || opts.output_dir.empty() || opts.workers < 1 ||
+        !decoding_preset(opts.decoding, decoding.params)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!opts.language.empty()) decoding.params.language = opts.language;
+
+    std::vector<std::string> terms;
+    if (!opts.vocab.empty() && !read_terms(opts.vocab, terms)) {
+        fprintf(stderr, "can't read vocabulary %s\n", opts.vocab.c_str());
+        return 1;
+    }
+
+    const std::vector<std::string> names = list_recordings(opts.input_dir);
+    if (names.empty()) {
+        fprintf(stderr, "no recordings in %s\n", opts.input_dir.c_str());
+        return 1;
+    }
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.flash_attn = opts.flash_attn;
+    struct whisper_context *ctx = whisper_init_from_file_with_params(opts.model.c_str(), cparams);
+    if (!ctx) {
+        fprintf(stderr, "failed to load %s\n", opts.model.c_str());
+        return 1;
+    }
+
+    const int n_terms = decoding_vocabulary_prompt(ctx, DECODING_PROMPT_PREFIX, terms, DECODING_PROMPT_TOKENS,
+                                                   decoding.prompt);
+    printf("decoding: %s, vocabulary prompt %d of %zu terms (%zu tokens)\n",
+           opts.decoding.c_str(), n_terms, terms.size(), decoding.prompt.size());
+
+    const int total_threads = opts.threads > 0 ? opts.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    const int workers = std::min<int>(opts.workers, (int)names.size());
+    const int n_threads = std::max(1, total_threads / workers);
+    printf("%zu recordings, %d workers x %d threads\n", names.size(), workers, n_threads);
+
+    batch_totals totals;
+    std::atomic<size_t> next{0};
+    std::mutex log_lock;
+    const auto t_start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; w++) {
+        threads.emplace_back(run_worker, ctx, &opts, &decoding, n_threads, &names, &next, &totals, &log_lock);
+    }
+    for (auto &t : threads) t.join();
+
+    const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+    printf("\n%d transcribed, %d skipped, %d failed\n", totals.done.load(), totals.skipped.load(), totals.failed.load());
+    printf("%.2f h audio in %.2f h wall: %.1f audio-hours per wall-hour (%.0f s thermal pauses)\n",
+           totals.audio_ms / 3.6e6, wall_ms / 3.6e6,
+           wall_ms > 0 ? totals.audio_ms / wall_ms : 0.0,
+           totals.throttled_ms / 1000.0);
+
+    whisper_free(ctx);
+    return totals.failed > 0 ? 2 : 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * Medication lexicon compiler (host CLI)
+ *
+ * Compiles a "name,canonical" CSV (BNF or RxNorm exports trimmed to those
+ * two columns; canonical is optional and points a brand or a known
+ * mis-transcription at its generic name) into the memory-mappable
+ * lexicon file the app loads. Ship the CSV as the app's
+ * medication_lexicon.csv asset and the app compiles it the same way on
+ * first run; use this tool to check a CSV and time lookups before that.
+ *
+ * Usage:
+ *   build_lexicon -i medications.csv -o medications.mlex [-q "sentence" ...]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "lexicon.h"
+
+#define QUERY_REPEATS 1000
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s -i medications.csv -o medications.mlex [-q \"sentence\" ...]\n"
+            "  -i CSV       name,canonical rows (canonical optional)\n"
+            "  -o FILE      lexicon to write\n"
+            "  -q TEXT      look up the best candidate in TEXT with the new lexicon\n",
+            argv0);
+}
+
+static std::u16string to_u16(const std::string &s) {
+    // Lookups only match ASCII, so anything else can stand in as one char
+    std::u16string out;
+    out.reserve(s.size());
+    for (unsigned char c : s) {
+        if (c < 0x80) out += (char16_t)c;
+        else if ((c & 0xC0) != 0x80) out += u'�';
+    }
+    return out;
+}
+
+int main(int argc, char **argv) {
+    std::string input;
+    std::string output;
+    std::vector<std::string> queries;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-i" && has_value) input = argv[++i];
+        else if (arg == "-o" && has_value) output = argv[++i];
+        else if (arg == "-q" && has_value) queries.push_back(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (input.empty() || output.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (!lexicon_compile_csv(input.c_str(), output.c_str(), &error)) {
+        fprintf(stderr, "failed: %s\n", error.c_str());
+        return 1;
+    }
+    const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    lexicon *lex = lexicon_open(output.c_str());
+    if (!lex) {
+        fprintf(stderr, "failed to map %s\n", output.c_str());
+        return 1;
+    }
+    printf("%s: %u entries, %u trie nodes, %zu bytes, built in %.1f ms\n",
+           output.c_str(), lex->header->n_entries, lex->header->n_nodes, lex->size, build_ms);
+
+    for (const std::string &query : queries) {
+        const std::u16string text = to_u16(query);
+        lexicon_match match = {};
+        bool found = false;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < QUERY_REPEATS; r++) {
+            found = lexicon_find(lex, text.data(), text.size(), match);
+        }
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count()
+                          / QUERY_REPEATS;
+        if (found) {
+            printf("\"%s\": %s -> %s, %d errors, chars %d-%d (%.1f us)\n", query.c_str(),
+                   lexicon_name(lex, match.entry).c_str(), lexicon_name(lex, match.canonical).c_str(),
+                   match.errors, match.start, match.end, us);
+        } else {
+            printf("\"%s\": no candidate (%.1f us)\n", query.c_str(), us);
+        }
+    }
+
+    lexicon_close(lex);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * Decoding setup shared by the app and the host tools
+ *
+ * See decoding.h.
+ */
+
+#include "decoding.h"
+
+bool decoding_preset(const std::string &name, bridge_decoding_params &out) {
+    // DecodingParams defaults (BALANCED), tuned for potentially quiet audio
+    out.strategy = WHISPER_SAMPLING_GREEDY;
+    out.best_of = 5;
+    out.beam_size = 5;
+    out.temperature = 0.0f;
+    out.temperature_inc = 0.2f;
+    out.entropy_thold = 2.8f;       // whisper default 2.4 (less strict)
+    out.logprob_thold = -1.5f;      // whisper default -1.0 (less strict)
+    out.no_speech_thold = 0.3f;     // whisper default 0.6 (more sensitive)
+    out.max_len = 0;
+    out.token_timestamps = false;
+    out.language = "en";
+
+    if (name == "balanced") return true;
+    if (name == "fast") {
+        out.best_of = 1;
+        out.temperature_inc = 0.0f;
+        return true;
+    }
+    if (name == "accurate") {
+        out.strategy = WHISPER_SAMPLING_BEAM_SEARCH;
+        out.entropy_thold = 2.4f;
+        out.logprob_thold = -1.0f;
+        out.no_speech_thold = 0.6f;
+        return true;
+    }
+    return false;
+}
+
+bool decoding_token_times(const bridge_decoding_params &decoding) {
+    return decoding.token_timestamps || decoding.max_len > 0;
+}
+
+struct whisper_full_params decoding_full_params(const bridge_decoding_params &decoding, int n_threads) {
+    const enum whisper_sampling_strategy strategy = (enum whisper_sampling_strategy)decoding.strategy;
+
+    struct whisper_full_params params = whisper_full_default_params(strategy);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.translate = false;
+    params.language = decoding.language.empty() ? "auto" : decoding.language.c_str();
+    params.n_threads = n_threads;
+    params.offset_ms = 0;
+    params.no_context = true;
+    params.single_segment = false;
+
+    params.greedy.best_of = decoding.best_of;
+    params.beam_search.beam_size = decoding.beam_size;
+    params.temperature = decoding.temperature;
+    params.temperature_inc = decoding.temperature_inc;
+    params.entropy_thold = decoding.entropy_thold;
+    params.logprob_thold = decoding.logprob_thold;
+    params.no_speech_thold = decoding.no_speech_thold;
+
+    // whisper only splits segments by length when token timestamps are on
+    params.token_timestamps = decoding_token_times(decoding);
+    if (decoding.max_len > 0) {
+        params.max_len = decoding.max_len;
+        params.split_on_word = true;
+    }
+    return params;
+}
+
+bool decoding_append_tokens(struct whisper_context *ctx, const std::string &text, std::vector<whisper_token> &out) {
+    const size_t n_out = out.size();
+    out.resize(n_out + text.size() + 1);
+    int n = whisper_tokenize(ctx, text.c_str(), out.data() + n_out, (int)(out.size() - n_out));
+    if (n < 0) {
+        out.resize(n_out - n);
+        n = whisper_tokenize(ctx, text.c_str(), out.data() + n_out, -n);
+    }
+    out.resize(n_out + (n > 0 ? n : 0));
+    return n > 0;
+}
+
+int decoding_vocabulary_prompt(struct whisper_context *ctx, const char *prefix,
+                               const std::vector<std::string> &terms, int max_tokens,
+                               std::vector<whisper_token> &out) {
+    out.clear();
+    if (terms.empty()) return 0;
+
+    const int n_limit = whisper_n_text_ctx(ctx) / 2 - 1;
+    const int budget = max_tokens > 0 && max_tokens < n_limit ? max_tokens : n_limit;
+
+    if (prefix) decoding_append_tokens(ctx, prefix, out);
+
+    // whisper's BPE splits before each space, so tokenizing " term," on its
+    // own gives the same tokens as tokenizing the whole prompt
+    int n_used = 0;
+    for (size_t i = 0; i < terms.size(); i++) {
+        const std::string piece = " " + terms[i] + (i + 1 < terms.size() ? "," : ".");
+        const size_t n_before = out.size();
+        if (!decoding_append_tokens(ctx, piece, out) || (int)out.size() > budget) {
+            out.resize(n_before);
+            break;
+        }
+        n_used++;
+    }
+    return n_used;
+}
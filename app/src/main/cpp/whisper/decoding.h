@@ -0,0 +1,77 @@
+/**
+ * Decoding setup shared by the app and the host tools
+ *
+ * The whisper_full parameters for a DecodingParams preset and the
+ * tokenized medication vocabulary prompt are built here, so that
+ * batch_transcribe decodes a recording exactly as the app would and its
+ * transcripts can be compared with the app's.
+ *
+ * The presets mirror DecodingParams.FAST / BALANCED / ACCURATE, and the
+ * prompt defaults mirror WhisperContext.DEFAULT_PROMPT_PREFIX and
+ * DEFAULT_PROMPT_TOKENS; keep them in step.
+ */
+
+#ifndef DECODING_H
+#define DECODING_H
+
+#include <string>
+#include <vector>
+
+#include "whisper.h"
+
+#define DECODING_PROMPT_PREFIX "Medications discussed:"
+#define DECODING_PROMPT_TOKENS 128
+
+/**
+ * Decoding strategy set once from Kotlin (WhisperContext.setDecodingParams)
+ * and applied to every whisper_full() call on the context
+ */
+struct bridge_decoding_params {
+    int strategy;           // whisper_sampling_strategy
+    int best_of;            // greedy: candidates sampled at temperature > 0
+    int beam_size;          // beam search width
+    float temperature;
+    float temperature_inc;  // fallback step; 0 disables temperature fallback
+    float entropy_thold;
+    float logprob_thold;
+    float no_speech_thold;
+    int max_len;            // max segment length in characters; 0 = unlimited
+    bool token_timestamps;  // per-token t0/t1 (needs PCM, so bypasses the mel cache)
+    std::string language;   // empty = auto-detect
+};
+
+/**
+ * The DecodingParams preset called name ("fast", "balanced" or
+ * "accurate"); false if there is none by that name
+ */
+bool decoding_preset(const std::string &name, bridge_decoding_params &out);
+
+/**
+ * Whether runs compute token timestamps. whisper derives them from the
+ * PCM energy envelope, which it only has when it computes the mel
+ * itself, so these runs must not use a bridge-installed mel.
+ */
+bool decoding_token_times(const bridge_decoding_params &decoding);
+
+/**
+ * whisper_full parameters for a decoding strategy. No prompt or callbacks
+ * are set, and nothing is printed.
+ */
+struct whisper_full_params decoding_full_params(const bridge_decoding_params &decoding, int n_threads);
+
+/**
+ * Append the tokens of text to out. Returns false if it doesn't tokenize.
+ */
+bool decoding_append_tokens(struct whisper_context *ctx, const std::string &text, std::vector<whisper_token> &out);
+
+/**
+ * Tokenize the vocabulary prompt "<prefix> term, term, ...". Terms are
+ * added in order until max_tokens (capped at whisper's n_text_ctx / 2 - 1
+ * prompt limit; 0 for the cap itself) would be exceeded. Returns the
+ * number of terms used.
+ */
+int decoding_vocabulary_prompt(struct whisper_context *ctx, const char *prefix,
+                               const std::vector<std::string> &terms, int max_tokens,
+                               std::vector<whisper_token> &out);
+
+#endif // DECODING_H
@@ -0,0 +1,87 @@
+/**
+ * Log-mel front-end benchmark
+ */
+
+#include "mel_bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "log_mel.h"
+
+static double ms_since(std::chrono::steady_clock::time_point t_start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+}
+
+std::string mel_bench(struct whisper_context *ctx, struct whisper_state *state, int n_threads, int minutes) {
+    // Voiced harmonics with a wandering pitch plus a little noise
+    const int n_samples = LOG_MEL_SAMPLE_RATE * 60 * minutes;
+    std::vector<float> samples(n_samples);
+    uint32_t seed = 12345;
+    double phase = 0.0;
+    for (int i = 0; i < n_samples; i++) {
+        const double t = (double)i / LOG_MEL_SAMPLE_RATE;
+        const double f0 = 140.0 + 30.0 * std::sin(2.0 * M_PI * 0.7 * t);
+        phase += 2.0 * M_PI * f0 / LOG_MEL_SAMPLE_RATE;
+        seed = seed * 1664525u + 1013904223u;
+        const double noise = ((seed >> 9) / 8388608.0 - 1.0) * 0.01;
+        const double envelope = 0.5 + 0.5 * std::sin(2.0 * M_PI * 3.0 * t);
+        samples[i] = (float)(0.2 * envelope * (std::sin(phase) + 0.5 * std::sin(2 * phase) + 0.25 * std::sin(3 * phase)) + noise);
+    }
+
+    const int n_mel = whisper_model_n_mels(ctx);
+    const double audio_ms = 1000.0 * n_samples / LOG_MEL_SAMPLE_RATE;
+    std::string result;
+    char line[192];
+
+    snprintf(line, sizeof(line), "mel bench: %d min of audio, %d mel bands, %d threads\n",
+             minutes, n_mel, n_threads);
+    result += line;
+
+    auto t_start = std::chrono::steady_clock::now();
+    whisper_pcm_to_mel_with_state(ctx, state, samples.data(), n_samples, n_threads);
+    const double builtin_ms = ms_since(t_start);
+    snprintf(line, sizeof(line), "  whisper_pcm_to_mel:      %9.1f ms (%6.0fx realtime)\n",
+             builtin_ms, audio_ms / builtin_ms);
+    result += line;
+
+    log_mel_spectrogram mel;
+    t_start = std::chrono::steady_clock::now();
+    log_mel_compute(samples.data(), n_samples, n_mel, n_threads, mel);
+    const double bridge_ms = ms_since(t_start);
+    snprintf(line, sizeof(line), "  bridge one-shot:         %9.1f ms (%6.0fx realtime, %.1fx built-in)\n",
+             bridge_ms, audio_ms / bridge_ms, builtin_ms / bridge_ms);
+    result += line;
+
+    // Capture-time path: 100 ms chunks as the recorder delivers them, then
+    // the work left once recording stops
+    log_mel_stream *stream = log_mel_stream_init(n_mel);
+    const int chunk = LOG_MEL_SAMPLE_RATE / 10;
+    t_start = std::chrono::steady_clock::now();
+    for (int offset = 0; offset < n_samples; offset += chunk) {
+        log_mel_stream_push(stream, samples.data() + offset, std::min(chunk, n_samples - offset));
+    }
+    const double push_ms = ms_since(t_start);
+    t_start = std::chrono::steady_clock::now();
+    log_mel_spectrogram streamed;
+    log_mel_stream_finish(stream, streamed);
+    const double finish_ms = ms_since(t_start);
+    log_mel_stream_free(stream);
+
+    float max_diff = 0.0f;
+    for (size_t i = 0; i < mel.data.size() && i < streamed.data.size(); i++) {
+        max_diff = std::max(max_diff, std::fabs(mel.data[i] - streamed.data[i]));
+    }
+
+    snprintf(line, sizeof(line), "  bridge streaming:        %9.1f ms during capture (%.2f%% of one core)\n",
+             push_ms, 100.0 * push_ms / audio_ms);
+    result += line;
+    snprintf(line, sizeof(line), "  bridge after stop:       %9.1f ms (%.1fx faster than built-in), max diff %.2g\n",
+             finish_ms, builtin_ms / finish_ms, max_diff);
+    result += line;
+
+    return result;
+}
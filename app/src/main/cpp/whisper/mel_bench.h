@@ -0,0 +1,21 @@
+/**
+ * Log-mel front-end benchmark
+ *
+ * Compares whisper.cpp's built-in whisper_pcm_to_mel() against the
+ * bridge's vectorized one-shot and capture-time streaming paths.
+ */
+
+#ifndef MEL_BENCH_H
+#define MEL_BENCH_H
+
+#include <string>
+
+#include "whisper.h"
+
+/**
+ * Time each mel path on `minutes` of synthetic speech-like audio; the
+ * built-in one computes into state
+ */
+std::string mel_bench(struct whisper_context *ctx, struct whisper_state *state, int n_threads, int minutes);
+
+#endif // MEL_BENCH_H
@@ -0,0 +1,118 @@
+/**
+ * Persistent log-mel spectrogram cache
+ *
+ * Values are stored as fp16: the normalised log-mel lives in roughly
+ * [-1.5, 2.5], where half precision keeps ~1e-3 resolution while halving
+ * the file (about 1 MB per minute of audio for 80-band models).
+ */
+
+#include "mel_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "ggml.h"
+
+#define MEL_CACHE_HEADER_BYTES 28
+
+bool mel_cache_load(const char *path, int n_mel, uint64_t n_samples, log_mel_spectrogram &mel) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    uint8_t h[MEL_CACHE_HEADER_BYTES];
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) || memcmp(h, MEL_CACHE_MAGIC, 4) != 0) {
+        fclose(f);
+        return false;
+    }
+
+    uint16_t version, file_n_mel, n_fft, hop;
+    uint32_t n_len, n_len_org, n_lo, n_hi;
+    memcpy(&version, h + 4, 2);
+    memcpy(&file_n_mel, h + 6, 2);
+    memcpy(&n_fft, h + 8, 2);
+    memcpy(&hop, h + 10, 2);
+    memcpy(&n_len, h + 12, 4);
+    memcpy(&n_len_org, h + 16, 4);
+    memcpy(&n_lo, h + 20, 4);
+    memcpy(&n_hi, h + 24, 4);
+
+    const uint64_t file_n_samples = ((uint64_t)n_hi << 32) | n_lo;
+    if (version != MEL_CACHE_VERSION || file_n_mel != n_mel || n_fft != LOG_MEL_N_FFT ||
+        hop != LOG_MEL_HOP || file_n_samples != n_samples || n_len_org > n_len) {
+        fclose(f);
+        return false;
+    }
+
+    const size_t n_values = (size_t)n_mel * n_len;
+    std::vector<ggml_fp16_t> half(n_values);
+    const bool ok = fread(half.data(), sizeof(ggml_fp16_t), n_values, f) == n_values;
+    fclose(f);
+    if (!ok) return false;
+
+    mel.n_mel = n_mel;
+    mel.n_len = (int)n_len;
+    mel.n_len_org = (int)n_len_org;
+    mel.data.resize(n_values);
+    ggml_fp16_to_fp32_row(half.data(), mel.data.data(), (int64_t)n_values);
+    return true;
+}
+
+static void put_u16(std::vector<uint8_t> &out, uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+    put_u16(out, (uint16_t)v);
+    put_u16(out, (uint16_t)(v >> 16));
+}
+
+// Make a rename in the directory holding path durable
+static void sync_parent_dir(const char *path) {
+    const char *slash = strrchr(path, '/');
+    const std::string dir = slash ? std::string(path, slash == path ? 1 : slash - path) : ".";
+    const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+bool mel_cache_save(const char *path, const log_mel_spectrogram &mel, uint64_t n_samples) {
+    std::vector<uint8_t> header;
+    header.reserve(MEL_CACHE_HEADER_BYTES);
+    header.insert(header.end(), MEL_CACHE_MAGIC, MEL_CACHE_MAGIC + 4);
+    put_u16(header, MEL_CACHE_VERSION);
+    put_u16(header, (uint16_t)mel.n_mel);
+    put_u16(header, LOG_MEL_N_FFT);
+    put_u16(header, LOG_MEL_HOP);
+    put_u32(header, (uint32_t)mel.n_len);
+    put_u32(header, (uint32_t)mel.n_len_org);
+    put_u32(header, (uint32_t)(n_samples & 0xFFFFFFFFu));
+    put_u32(header, (uint32_t)(n_samples >> 32));
+
+    std::vector<ggml_fp16_t> half(mel.data.size());
+    ggml_fp32_to_fp16_row(mel.data.data(), half.data(), (int64_t)half.size());
+
+    const std::string tmp_path = std::string(path) + ".tmp";
+    FILE *f = fopen(tmp_path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(header.data(), 1, header.size(), f) == header.size();
+    ok = ok && fwrite(half.data(), sizeof(ggml_fp16_t), half.size(), f) == half.size();
+    // On disk before the rename, so a crash never leaves a short file under
+    // the cache's name
+    ok = (fflush(f) == 0) && ok;
+    ok = (fsync(fileno(f)) == 0) && ok;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmp_path.c_str(), path) != 0) {
+        remove(tmp_path.c_str());
+        return false;
+    }
+    sync_parent_dir(path);
+    return true;
+}
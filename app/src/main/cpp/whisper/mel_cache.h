@@ -0,0 +1,37 @@
+/**
+ * Persistent log-mel spectrogram cache
+ *
+ * Stores the normalised log-mel of a recording next to its audio so
+ * re-transcriptions (different model size, different decoding params)
+ * can skip the FFT stage. Entries are keyed by the mel configuration and
+ * the sample count; a model with a different n_mel or a changed
+ * recording simply misses and overwrites the entry.
+ *
+ * File layout (little-endian):
+ *   "VBML" | u16 version | u16 n_mel | u16 n_fft | u16 hop
+ *   | u32 n_len | u32 n_len_org | u64 n_samples | fp16 data[n_mel * n_len]
+ */
+
+#ifndef MEL_CACHE_H
+#define MEL_CACHE_H
+
+#include <cstdint>
+
+#include "log_mel.h"
+
+#define MEL_CACHE_MAGIC "VBML"
+#define MEL_CACHE_VERSION 1
+
+/**
+ * Load a cached mel if it matches n_mel and n_samples.
+ * Returns false on a missing, stale or corrupt entry.
+ */
+bool mel_cache_load(const char *path, int n_mel, uint64_t n_samples, log_mel_spectrogram &mel);
+
+/**
+ * Write a mel to the cache (via a temporary file, so a crash never
+ * leaves a truncated entry behind)
+ */
+bool mel_cache_save(const char *path, const log_mel_spectrogram &mel, uint64_t n_samples);
+
+#endif // MEL_CACHE_H
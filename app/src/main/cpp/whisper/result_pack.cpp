@@ -0,0 +1,128 @@
+/**
+ * Packed transcription results
+ *
+ * Built in one pass: segment and token records go straight into their
+ * tables while the texts are appended to a side buffer, which is copied
+ * behind the tables at the end.
+ */
+
+#include "result_pack.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+// The whisper result getters come in context and state flavours
+struct result_source {
+    whisper_context *ctx;
+    whisper_state *state;
+
+    int n_segments() const {
+        return state ? whisper_full_n_segments_from_state(state) : whisper_full_n_segments(ctx);
+    }
+    int64_t t0(int i) const {
+        return state ? whisper_full_get_segment_t0_from_state(state, i) : whisper_full_get_segment_t0(ctx, i);
+    }
+    int64_t t1(int i) const {
+        return state ? whisper_full_get_segment_t1_from_state(state, i) : whisper_full_get_segment_t1(ctx, i);
+    }
+    const char *text(int i) const {
+        return state ? whisper_full_get_segment_text_from_state(state, i) : whisper_full_get_segment_text(ctx, i);
+    }
+    int n_tokens(int i) const {
+        return state ? whisper_full_n_tokens_from_state(state, i) : whisper_full_n_tokens(ctx, i);
+    }
+    whisper_token_data token_data(int i, int j) const {
+        return state ? whisper_full_get_token_data_from_state(state, i, j) : whisper_full_get_token_data(ctx, i, j);
+    }
+    const char *token_text(int i, int j) const {
+        return state ? whisper_full_get_token_text_from_state(ctx, state, i, j) : whisper_full_get_token_text(ctx, i, j);
+    }
+};
+
+void put_i32(std::vector<uint8_t> &out, int32_t v) {
+    const size_t n = out.size();
+    out.resize(n + 4);
+    memcpy(out.data() + n, &v, 4);
+}
+
+void put_f32(std::vector<uint8_t> &out, float v) {
+    const size_t n = out.size();
+    out.resize(n + 4);
+    memcpy(out.data() + n, &v, 4);
+}
+
+void set_i32(std::vector<uint8_t> &out, size_t pos, int32_t v) {
+    memcpy(out.data() + pos, &v, 4);
+}
+
+// Append text, returning its offset
+int32_t put_text(std::string &texts, const char *text) {
+    const int32_t off = (int32_t)texts.size();
+    texts += text ? text : "";
+    return off;
+}
+
+} // namespace
+
+void result_pack(struct whisper_context *ctx, struct whisper_state *state, int64_t offset,
+                 int flags, std::vector<uint8_t> &out) {
+    const result_source src = { ctx, state };
+    const bool with_tokens = (flags & RESULT_PACK_TOKENS) != 0;
+    const bool with_times = (flags & RESULT_PACK_TOKEN_TIMES) != 0;
+    const whisper_token token_eot = whisper_token_eot(ctx);
+    const int n_segments = src.n_segments();
+
+    out.clear();
+    out.reserve(4 * (RESULT_PACK_HEADER_FIELDS + n_segments * RESULT_PACK_SEGMENT_FIELDS));
+    put_i32(out, n_segments);
+    put_i32(out, 0);            // n_tokens, patched below
+    put_i32(out, 0);            // text_bytes, patched below
+    put_i32(out, flags);
+
+    // Segment table first, with token ranges filled in as tokens are collected
+    const size_t segments_pos = out.size();
+    out.resize(segments_pos + (size_t)n_segments * RESULT_PACK_SEGMENT_FIELDS * 4);
+
+    std::vector<uint8_t> tokens;
+    std::string texts;
+    int32_t n_tokens_total = 0;
+
+    for (int i = 0; i < n_segments; i++) {
+        const int32_t text_off = put_text(texts, src.text(i));
+        const int32_t text_len = (int32_t)texts.size() - text_off;
+        const int32_t first_token = n_tokens_total;
+
+        if (with_tokens) {
+            const int n_tokens = src.n_tokens(i);
+            for (int j = 0; j < n_tokens; j++) {
+                const whisper_token_data data = src.token_data(i, j);
+                if (data.id >= token_eot) {
+                    continue;
+                }
+                const int32_t token_off = put_text(texts, src.token_text(i, j));
+                put_i32(tokens, data.id);
+                put_f32(tokens, data.p);
+                put_i32(tokens, with_times ? (int32_t)(offset + data.t0) : -1);
+                put_i32(tokens, with_times ? (int32_t)(offset + data.t1) : -1);
+                put_i32(tokens, token_off);
+                put_i32(tokens, (int32_t)texts.size() - token_off);
+                n_tokens_total++;
+            }
+        }
+
+        const size_t pos = segments_pos + (size_t)i * RESULT_PACK_SEGMENT_FIELDS * 4;
+        set_i32(out, pos, (int32_t)(offset + src.t0(i)));
+        set_i32(out, pos + 4, (int32_t)(offset + src.t1(i)));
+        set_i32(out, pos + 8, text_off);
+        set_i32(out, pos + 12, text_len);
+        set_i32(out, pos + 16, first_token);
+        set_i32(out, pos + 20, n_tokens_total - first_token);
+    }
+
+    set_i32(out, 4, n_tokens_total);
+    set_i32(out, 8, (int32_t)texts.size());
+    out.insert(out.end(), tokens.begin(), tokens.end());
+    out.insert(out.end(), texts.begin(), texts.end());
+}
@@ -0,0 +1,40 @@
+/**
+ * Packed transcription results
+ *
+ * Serialises every segment (and optionally every text token) of the last
+ * whisper_full run into one buffer, so Kotlin reads a whole result with a
+ * single JNI call instead of several calls per segment.
+ *
+ * Layout (little-endian, all fields 32-bit, times in 10 ms units):
+ *   header:   n_segments | n_tokens | text_bytes | flags
+ *   segments: n_segments x { t0 | t1 | text_off | text_len | first_token | n_tokens }
+ *   tokens:   n_tokens   x { id | p (f32) | t0 | t1 | text_off | text_len }
+ *   text:     text_bytes of UTF-8, segment and token texts referenced by offset
+ *
+ * Token times are -1 unless RESULT_PACK_TOKEN_TIMES is set in flags.
+ * Special and timestamp tokens are left out.
+ */
+
+#ifndef RESULT_PACK_H
+#define RESULT_PACK_H
+
+#include <cstdint>
+#include <vector>
+
+#include "whisper.h"
+
+#define RESULT_PACK_TOKENS      1   // token table present
+#define RESULT_PACK_TOKEN_TIMES 2   // token t0/t1 computed (token_timestamps)
+
+#define RESULT_PACK_HEADER_FIELDS  4
+#define RESULT_PACK_SEGMENT_FIELDS 6
+#define RESULT_PACK_TOKEN_FIELDS   6
+
+/**
+ * Pack the results held by state, or by the context's default state when
+ * state is null. offset (10 ms units) is added to every timestamp.
+ */
+void result_pack(struct whisper_context *ctx, struct whisper_state *state, int64_t offset,
+                 int flags, std::vector<uint8_t> &out);
+
+#endif // RESULT_PACK_H
@@ -1,6 +1,6 @@
 /**
  * Whisper wrapper header for Medical Appointment Companion
- * 
+ *
  * This folder contains any project-specific whisper extensions.
  * The main whisper.h is included from the whisper.cpp library.
  */
@@ -10,6 +10,108 @@
 
 // Include the main whisper header
 #include "whisper.h"
+#include "decoding.h"
 
-#endif // WHISPER_WRAPPER_H
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Mel cache status reported in bridge_timings
+#define MEL_CACHE_UNUSED -1
+#define MEL_CACHE_MISS    0
+#define MEL_CACHE_HIT     1
+
+// audio_ctx request values; positive values are used as-is
+#define AUDIO_CTX_FULL      0   // full 30 s encoder window (whisper default)
+#define AUDIO_CTX_ADAPTIVE -1   // sized to the clip for short inputs
+
+// Adaptive audio_ctx guardrails: only clips up to this long are shrunk,
+// never below ADAPTIVE_CTX_MIN positions (20 ms each), with a margin of
+// trailing silence so the decoder still sees the end of speech
+#define ADAPTIVE_CTX_MAX_MS  20000
+#define ADAPTIVE_CTX_MIN     384
+#define ADAPTIVE_CTX_MARGIN  64
+#define ADAPTIVE_CTX_ALIGN   64
+
+/**
+ * Timings of the last transcription as seen by the bridge. whisper only
+ * times its context-default state, which the bridge doesn't use, so the
+ * stages inside whisper_full() are measured from its callbacks: the span
+ * from the encoder start to the first sampled logits of each window is
+ * the encoder plus the prompt pass, and decode_ms is the remainder.
+ * whisper has no callback between the two, so the prompt passes can't be
+ * timed; prompt_est_ms estimates them from the decoder speed warmUp
+ * measured and is reported alongside, not taken out of, the other stages.
+ */
+struct bridge_timings {
+    float total_ms;
+    float mel_ms;           // bridge-side mel compute or cache load; 0 if whisper computed it
+    float encode_ms;        // encoder plus each window's first prompt pass, summed over windows
+    float decode_ms;        // sampling and decoder steps, including fallbacks and their prompt passes
+    float prompt_est_ms;    // estimated prompt passes (see finish_timings); -1 before warmUp
+    float resume_ms;        // re-allocating trimmed compute buffers; 0 if they were resident
+    int mel_cache;          // MEL_CACHE_*
+    int audio_ctx;          // encoder positions used; 0 = full window
+    int audio_ctx_retries;  // reduced-context runs redone at full context
+    int windows;            // 30 s windows decoded
+    int fallbacks;          // re-decodes at a higher temperature, summed over windows
+    int prompt_tokens;      // cached vocabulary prompt tokens fed to the decoder
+    int threads;            // n_threads of the call (set per chunk by the Kotlin scheduler)
+    
+    // Callback bookkeeping, not reported
+    int64_t window_start_us;
+    bool window_encoding;
+};
 
+/**
+ * Native handle behind WhisperContext.ptr: the whisper context plus the
+ * bridge state that has to outlive a single JNI call.
+ *
+ * The context is loaded without whisper's default state; transcriptions
+ * run on state instead, which holds the KV caches, compute buffers and
+ * the last results. It is freed by trimMemory when the app goes idle and
+ * re-created on next use, leaving only the model weights resident.
+ *
+ * decoding, prompt_tokens and prompt_token_ms are only written on the
+ * context's thread, under settings_lock, so sessions on other threads can
+ * read them.
+ */
+struct bridge_context {
+    struct whisper_context *ctx;
+    struct whisper_state *state;                // null while trimmed
+    struct bridge_timings timings;
+    struct bridge_decoding_params decoding;
+    std::vector<whisper_token> prompt_tokens;   // vocabulary prompt, tokenized once
+    float prompt_token_ms;                      // warm-up decoder ms x threads per prompt token; 0 until warmUp
+    std::mutex settings_lock;
+};
+
+/**
+ * Streaming session over consecutive chunks of one recording. Each chunk
+ * is decoded on the session's own whisper_state, prompted with the
+ * vocabulary plus the tail of the text decoded so far, so a chunk starts
+ * from the conversation's context instead of from nothing.
+ *
+ * Sessions only share the model with the context, so several can decode
+ * in parallel on their own threads (the Kotlin StatePool). Decoding
+ * params and vocabulary are snapshot at creation and on reset. Like the
+ * context's, the state is null while trimmed; the carried text survives.
+ */
+struct bridge_session {
+    struct bridge_context *bc;
+    struct whisper_state *state;               // null while trimmed
+    struct bridge_decoding_params decoding;
+    std::vector<whisper_token> vocab;
+    std::vector<whisper_token> past_tokens;    // text tokens carried into the next chunk
+    std::vector<whisper_token> prompt;         // vocabulary + past_tokens for the current chunk
+    // Start (10 ms units) of each of the last chunk's segments and where its
+    // tokens begin in past_tokens, to drop a segment that is decoded again
+    std::vector<std::pair<int64_t, size_t>> chunk_segments;
+    int64_t offset;                            // start of the next chunk, 10 ms units
+    int64_t chunk_offset;                      // start of the last decoded chunk, 10 ms units
+    int n_chunks;
+    struct bridge_timings timings;
+};
+
+#endif // WHISPER_WRAPPER_H
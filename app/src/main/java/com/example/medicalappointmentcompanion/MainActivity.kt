@@ -4,9 +4,9 @@ import android.os.Bundle
 import androidx.activity.ComponentActivity
 import androidx.activity.compose.setContent
 import androidx.activity.enableEdgeToEdge
+import androidx.activity.viewModels
 import androidx.compose.runtime.collectAsState
 import androidx.compose.runtime.getValue
-import androidx.lifecycle.viewmodel.compose.viewModel
 import com.example.medicalappointmentcompanion.ui.MainScreen
 import com.example.medicalappointmentcompanion.ui.MainViewModel
 import com.example.medicalappointmentcompanion.ui.theme.MedicalAppointmentCompanionTheme
@@ -25,13 +25,14 @@ import com.example.medicalappointmentcompanion.ui.theme.MedicalAppointmentCompan
  */
 class MainActivity : ComponentActivity() {
 
+    private val viewModel: MainViewModel by viewModels()
+
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         enableEdgeToEdge()
 
         setContent {
             MedicalAppointmentCompanionTheme {
-                val viewModel: MainViewModel = viewModel()
                 val state by viewModel.state.collectAsState()
                 
                 MainScreen(
@@ -48,4 +49,9 @@ class MainActivity : ComponentActivity() {
     }
 }
     }
+
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        viewModel.onTrimMemory(level)
+    }
 }
@@ -0,0 +1,100 @@
+package com.example.medicalappointmentcompanion.audio
+
+import android.util.Log
+import com.example.medicalappointmentcompanion.whisper.WhisperLib
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+private const val LOG_TAG = "AudioArchive"
+
+/**
+ * Compressed archive format for stored recordings
+ * 
+ * Lossless native codec (fixed linear prediction + Rice coding) that
+ * typically halves the size of a 16kHz WAV. Archives can be decoded
+ * back to whisper's float format or transcribed directly by
+ * [com.example.medicalappointmentcompanion.whisper.WhisperContext].
+ */
+object AudioArchive {
+    
+    const val EXTENSION = "vbla"
+    
+    // See audio_archive.h for the header layout
+    private const val HEADER_SIZE = 24
+    private const val SAMPLE_COUNT_OFFSET = 12
+    
+    /**
+     * Check whether a file is a compressed archive
+     */
+    fun isArchive(file: File): Boolean = file.extension == EXTENSION
+    
+    /**
+     * Whether a file is a complete archive: its header and block headers
+     * account for every sample and end with the file. A crash mid-write
+     * can't leave a partial archive, but one damaged since is never
+     * preferred over its WAV.
+     */
+    fun isComplete(file: File): Boolean =
+        isArchive(file) && file.exists() && WhisperLib.archiveCheck(file.absolutePath)
+    
+    /**
+     * Compress a 16-bit mono WAV recording
+     * 
+     * The archive is written beside its final name and only renamed into
+     * place once it decodes to identical samples; on any failure null is
+     * returned. The WAV is kept: the caller deletes it once nothing refers
+     * to it any more.
+     * 
+     * @param wavFile Recording to compress
+     * @return The archive file, or null if compression failed
+     */
+    fun compress(wavFile: File): File? {
+        val archiveFile = File(wavFile.parentFile, "${wavFile.nameWithoutExtension}.$EXTENSION")
+        val archivedBytes = WhisperLib.archiveEncodeWave(wavFile.absolutePath, archiveFile.absolutePath)
+        
+        if (archivedBytes < 0) {
+            return null
+        }
+        
+        Log.d(LOG_TAG, "Archived ${wavFile.name}: ${wavFile.length()} -> $archivedBytes bytes")
+        return archiveFile
+    }
+    
+    /**
+     * Number of samples stored in an archive, read from its header
+     */
+    fun sampleCount(file: File): Long {
+        val header = ByteArray(HEADER_SIZE)
+        file.inputStream().use { input ->
+            if (input.read(header) != HEADER_SIZE) {
+                throw RuntimeException("Truncated archive: ${file.name}")
+            }
+        }
+        return ByteBuffer.wrap(header).order(ByteOrder.LITTLE_ENDIAN).getLong(SAMPLE_COUNT_OFFSET)
+    }
+    
+    /**
+     * Decode an archive to normalized 16kHz float samples
+     */
+    fun decode(file: File): FloatArray =
+        WhisperLib.archiveDecode(file.absolutePath)
+            ?: throw RuntimeException("Failed to decode archive: ${file.name}")
+    
+    /**
+     * Decode a stored recording, WAV or archive, to 16kHz float samples
+     * 
+     * A WAV that has been compressed since its path was recorded is
+     * read from the archive next to it.
+     */
+    fun decodeRecording(file: File): FloatArray {
+        if (file.exists()) {
+            return if (isArchive(file)) decode(file) else WaveHelper.decodeWaveFile(file)
+        }
+        val archive = File(file.parentFile, "${file.nameWithoutExtension}.$EXTENSION")
+        if (isComplete(archive)) {
+            return decode(archive)
+        }
+        throw IllegalArgumentException("Recording not found: ${file.path}")
+    }
+}
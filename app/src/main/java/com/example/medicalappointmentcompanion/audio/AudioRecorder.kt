@@ -24,7 +24,9 @@ const val WHISPER_SAMPLE_RATE = 16000
 /**
  * Audio recorder optimized for whisper.cpp transcription
  * 
- * Records audio at 16kHz mono PCM, which is the format required by whisper.
+ * Captures mono PCM at the device's native rate (typically 48kHz) to avoid
+ * the platform's own resampling path, and converts to the 16kHz format
+ * required by whisper with the native [Resampler] as buffers arrive.
  * Can save to WAV file or return raw audio data for direct transcription.
  */
 class AudioRecorder(private val context: Context? = null) {
@@ -44,10 +46,12 @@ class AudioRecorder(private val context: Context? = null) {
      * Start recording audio to a file
      * 
      * @param outputFile File to save the WAV recording
+     * @param melStream Optional mel spectrogram fed with every 16kHz chunk
      * @param onError Callback for recording errors
      */
     suspend fun startRecording(
         outputFile: File, 
+        melStream: MelStream? = null,
         onError: (Exception) -> Unit = {}
     ) = withContext(scope.coroutineContext) {
         if (recordThread?.isRecording == true) {
@@ -69,7 +73,7 @@ class AudioRecorder(private val context: Context? = null) {
             }
         }
         
-        recordThread = AudioRecordThread(outputFile, context, onError)
+        recordThread = AudioRecordThread(outputFile, context, melStream, onError)
         recordThread?.start()
     }
     
@@ -114,6 +118,7 @@ class AudioRecorder(private val context: Context? = null) {
 private class AudioRecordThread(
     private val outputFile: File,
     private val context: Context?,
+    private val melStream: MelStream?,
     private val onError: (Exception) -> Unit
 ) : Thread("AudioRecordThread") {
     
@@ -125,8 +130,9 @@ private class AudioRecordThread(
     @SuppressLint("MissingPermission")
     override fun run() {
         try {
+            val requestedRate = nativeCaptureRate()
             val bufferSize = AudioRecord.getMinBufferSize(
-                WHISPER_SAMPLE_RATE,
+                requestedRate,
                 AudioFormat.CHANNEL_IN_MONO,
                 AudioFormat.ENCODING_PCM_16BIT
             ) * 4  // Use 4x minimum for smoother recording
@@ -151,7 +157,7 @@ private class AudioRecordThread(
                 try {
                     val testRecord = AudioRecord(
                         source,
-                        WHISPER_SAMPLE_RATE,
+                        requestedRate,
                         AudioFormat.CHANNEL_IN_MONO,
                         AudioFormat.ENCODING_PCM_16BIT,
                         bufferSize
@@ -166,7 +172,7 @@ private class AudioRecordThread(
                             Thread.sleep(50)
                             
                             // Read a small sample to test audio levels (0.2 seconds)
-                            val testBuffer = ShortArray(WHISPER_SAMPLE_RATE / 5)
+                            val testBuffer = ShortArray(requestedRate / 5)
                             val read = testRecord.read(testBuffer, 0, testBuffer.size)
                             
                             if (read > 0) {
@@ -222,7 +228,7 @@ private class AudioRecordThread(
                     try {
                         val testRecord = AudioRecord(
                             source,
-                            WHISPER_SAMPLE_RATE,
+                            requestedRate,
                             AudioFormat.CHANNEL_IN_MONO,
                             AudioFormat.ENCODING_PCM_16BIT,
                             bufferSize
@@ -247,15 +253,19 @@ private class AudioRecordThread(
             }
             
             val finalAudioRecord = audioRecord
+            // What the device actually captures at, which may not be what was asked for
+            val captureRate = finalAudioRecord.sampleRate
+            val resampler = if (captureRate != WHISPER_SAMPLE_RATE) Resampler(captureRate) else null
             
             try {
                 finalAudioRecord.startRecording()
-                Log.d(LOG_TAG, "Recording started at ${WHISPER_SAMPLE_RATE}Hz with source $selectedSource")
+                Log.d(LOG_TAG, "Recording started at ${captureRate}Hz with source $selectedSource")
                 
                 // Small delay to let microphone stabilize
                 Thread.sleep(100)
                 
-                val allData = mutableListOf<Short>()
+                // 16kHz chunks, resampled as they are read
+                val chunks = mutableListOf<FloatArray>()
                 
                 var maxAmplitude: Short = 0
                 var totalRead = 0
@@ -265,13 +275,16 @@ private class AudioRecordThread(
                     if (read > 0) {
                         totalRead += read
                         for (i in 0 until read) {
-                            allData.add(buffer[i])
                             val abs = if (buffer[i] < 0) (-buffer[i]).toShort() else buffer[i]
                             if (abs > maxAmplitude) maxAmplitude = abs
                         }
+                        val chunk = resampler?.process(buffer, read)
+                            ?: WaveHelper.shortToFloat(buffer.copyOf(read))
+                        chunks.add(chunk)
+                        melStream?.push(chunk)
                         // Log progress every second
-                        if (totalRead % WHISPER_SAMPLE_RATE < read) {
-                            val seconds = totalRead / WHISPER_SAMPLE_RATE
+                        if (totalRead % captureRate < read) {
+                            val seconds = totalRead / captureRate
                             Log.d(LOG_TAG, "Recording... ${seconds}s, max amp: $maxAmplitude")
                             
                             // Warn if amplitude is suspiciously low (likely no audio)
@@ -302,18 +315,29 @@ private class AudioRecordThread(
                 }
                 
                 finalAudioRecord.stop()
+                resampler?.let {
+                    val tail = it.flush()
+                    chunks.add(tail)
+                    melStream?.push(tail)
+                }
                 
-                // Save to WAV file
-                val shortArray = allData.toShortArray()
-                WaveHelper.encodeWaveFile(outputFile, shortArray)
+                // Join the 16kHz chunks for whisper
+                val samples = FloatArray(chunks.sumOf { it.size })
+                var offset = 0
+                for (chunk in chunks) {
+                    chunk.copyInto(samples, offset)
+                    offset += chunk.size
+                }
+                audioData = samples
                 
-                // Convert to float array for whisper
-                audioData = WaveHelper.shortToFloat(shortArray)
+                // Save to WAV file at 16kHz
+                WaveHelper.encodeWaveFile(outputFile, WaveHelper.floatToShort(samples))
                 
-                Log.d(LOG_TAG, "Recording saved: ${allData.size} samples, " +
-                        "${allData.size / WHISPER_SAMPLE_RATE.toFloat()}s")
+                Log.d(LOG_TAG, "Recording saved: ${samples.size} samples, " +
+                        "${samples.size / WHISPER_SAMPLE_RATE.toFloat()}s (captured at ${captureRate}Hz)")
                 
             } finally {
+                resampler?.close()
                 finalAudioRecord.release()
                 
                 // Reset audio mode
@@ -337,5 +361,27 @@ private class AudioRecordThread(
     }
     
     fun getAudioData(): FloatArray? = audioData
+    
+    /**
+     * Rate to request capture at: the device's mixer rate (Android reports
+     * no input rate, and the output rate is the one its HAL usually runs
+     * at), falling back to 16kHz when it can't be determined or
+     * AudioRecord doesn't support it. The rate actually used is read back
+     * from the AudioRecord.
+     */
+    private fun nativeCaptureRate(): Int {
+        val audioManager = context?.getSystemService(Context.AUDIO_SERVICE) as? AudioManager
+        val nativeRate = audioManager
+            ?.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE)
+            ?.toIntOrNull()
+            ?: return WHISPER_SAMPLE_RATE
+        
+        val minBuffer = AudioRecord.getMinBufferSize(
+            nativeRate,
+            AudioFormat.CHANNEL_IN_MONO,
+            AudioFormat.ENCODING_PCM_16BIT
+        )
+        return if (minBuffer > 0) nativeRate else WHISPER_SAMPLE_RATE
+    }
 }
 
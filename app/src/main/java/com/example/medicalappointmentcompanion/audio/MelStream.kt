@@ -0,0 +1,41 @@
+package com.example.medicalappointmentcompanion.audio
+
+import com.example.medicalappointmentcompanion.whisper.WhisperLib
+import java.io.Closeable
+
+/**
+ * Log-mel spectrogram computed incrementally while audio is captured
+ * 
+ * The recorder pushes each 16kHz chunk as it is resampled, so by the time
+ * recording stops only the last few frames and the normalisation are left.
+ * Pass the stream to WhisperContext.transcribeWithSegments together with
+ * the same samples; it is consumed by that transcription.
+ * 
+ * Not thread-safe - push from a single thread (the record thread).
+ */
+class MelStream(val melBands: Int) : Closeable {
+    
+    internal var ptr: Long = WhisperLib.createMelStream(melBands)
+        private set
+    
+    init {
+        if (ptr == 0L) {
+            throw IllegalArgumentException("Unsupported mel band count: $melBands")
+        }
+    }
+    
+    /**
+     * Append the first [length] 16kHz samples of [samples]
+     */
+    fun push(samples: FloatArray, length: Int = samples.size) {
+        require(ptr != 0L) { "MelStream has been released" }
+        WhisperLib.melStreamPush(ptr, samples, length)
+    }
+    
+    override fun close() {
+        if (ptr != 0L) {
+            WhisperLib.freeMelStream(ptr)
+            ptr = 0
+        }
+    }
+}
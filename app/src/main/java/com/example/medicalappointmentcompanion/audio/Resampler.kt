@@ -0,0 +1,59 @@
+package com.example.medicalappointmentcompanion.audio
+
+import com.example.medicalappointmentcompanion.whisper.WhisperLib
+import java.io.Closeable
+
+/**
+ * Streaming resampler backed by the native polyphase filter
+ * 
+ * Converts interleaved 16-bit PCM at the device's native rate into
+ * 16kHz mono float samples for whisper. Filter state is kept between
+ * calls, so buffers can be fed as they arrive from AudioRecord.
+ * 
+ * Not thread-safe - use from a single thread (e.g. the record thread).
+ */
+class Resampler(
+    val inputRate: Int,
+    private val channels: Int = 1,
+    val outputRate: Int = WHISPER_SAMPLE_RATE
+) : Closeable {
+    
+    private var ptr: Long = WhisperLib.createResampler(inputRate, outputRate)
+    
+    init {
+        if (ptr == 0L) {
+            throw IllegalArgumentException("Unsupported resampling: $inputRate Hz -> $outputRate Hz")
+        }
+    }
+    
+    /**
+     * Resample the first [length] values of [pcm] (interleaved if multi-channel)
+     */
+    fun process(pcm: ShortArray, length: Int = pcm.size): FloatArray {
+        require(ptr != 0L) { "Resampler has been released" }
+        return WhisperLib.resamplerProcess(ptr, pcm, length, channels)
+    }
+    
+    /**
+     * Drain the filter at end of stream
+     */
+    fun flush(): FloatArray {
+        require(ptr != 0L) { "Resampler has been released" }
+        return WhisperLib.resamplerFlush(ptr)
+    }
+    
+    override fun close() {
+        if (ptr != 0L) {
+            WhisperLib.freeResampler(ptr)
+            ptr = 0
+        }
+    }
+    
+    companion object {
+        /**
+         * One-shot conversion of a whole PCM buffer to whisper's format
+         */
+        fun toWhisperFormat(pcm: ShortArray, channels: Int, sampleRate: Int): FloatArray =
+            WhisperLib.convertToWhisper(pcm, channels, sampleRate)
+    }
+}
@@ -16,8 +16,11 @@ object WaveHelper {
     /**
      * Decode a WAV file to float array for whisper
      * 
-     * @param file WAV file to decode
-     * @return Float array of normalized samples [-1.0, 1.0]
+     * Reads the sample rate and channel count from the fmt chunk; files
+     * that are not already 16kHz mono are down-mixed and resampled natively.
+     * 
+     * @param file WAV file to decode (16-bit PCM)
+     * @return Float array of normalized samples [-1.0, 1.0] at 16kHz
      */
     fun decodeWaveFile(file: File): FloatArray {
         val baos = ByteArrayOutputStream()
@@ -26,27 +29,70 @@ object WaveHelper {
         val buffer = ByteBuffer.wrap(baos.toByteArray())
         buffer.order(ByteOrder.LITTLE_ENDIAN)
         
-        // Read channel count from WAV header (offset 22)
-        val channels = buffer.getShort(22).toInt()
+        val format = readFormat(buffer)
+        if (format.bitsPerSample != 16) {
+            throw IllegalArgumentException("Unsupported WAV format: ${format.bitsPerSample}-bit (16-bit PCM required)")
+        }
         
-        // Skip header and read audio data (offset 44)
-        buffer.position(44)
+        buffer.position(format.dataOffset)
+        buffer.limit(minOf(buffer.capacity(), format.dataOffset + format.dataLength))
         val shortBuffer = buffer.asShortBuffer()
         val shortArray = ShortArray(shortBuffer.limit())
         shortBuffer.get(shortArray)
         
-        // Convert to mono float
-        return FloatArray(shortArray.size / channels) { index ->
-            when (channels) {
-                1 -> (shortArray[index] / 32767.0f).coerceIn(-1f, 1f)
-                else -> {
-                    // Mix stereo to mono
-                    val left = shortArray[2 * index]
-                    val right = shortArray[2 * index + 1]
-                    ((left + right) / 32767.0f / 2.0f).coerceIn(-1f, 1f)
-                }
+        if (format.channels == 1 && format.sampleRate == WHISPER_SAMPLE_RATE) {
+            return shortToFloat(shortArray)
+        }
+        
+        return Resampler.toWhisperFormat(shortArray, format.channels, format.sampleRate)
+    }
+    
+    /**
+     * Format fields of a WAV file needed for decoding
+     */
+    private data class WaveFormat(
+        val channels: Int,
+        val sampleRate: Int,
+        val bitsPerSample: Int,
+        val dataOffset: Int,
+        val dataLength: Int
+    )
+    
+    /**
+     * Walk the RIFF chunks to find "fmt " and "data"
+     * 
+     * Falls back to the canonical 44-byte layout if the chunks can't be found.
+     */
+    private fun readFormat(buffer: ByteBuffer): WaveFormat {
+        var channels = buffer.getShort(22).toInt()
+        var sampleRate = buffer.getInt(24)
+        var bitsPerSample = buffer.getShort(34).toInt()
+        var dataOffset = 44
+        var dataLength = buffer.capacity() - 44
+        
+        var offset = 12
+        while (offset + 8 <= buffer.capacity()) {
+            val id = String(ByteArray(4) { buffer.get(offset + it) }, Charsets.US_ASCII)
+            // Sizes are unsigned; streamed WAVs leave 0xFFFFFFFF in "data"
+            val size = buffer.getInt(offset + 4).toLong() and 0xFFFFFFFFL
+            val remaining = (buffer.capacity() - offset - 8).toLong()
+            if (id == "data") {
+                dataOffset = offset + 8
+                dataLength = minOf(size, remaining).toInt()
+                break
+            }
+            // A chunk running past the end is corrupt; keep what was read
+            if (size > remaining) break
+            if (id == "fmt " && size >= 16) {
+                channels = buffer.getShort(offset + 10).toInt()
+                sampleRate = buffer.getInt(offset + 12)
+                bitsPerSample = buffer.getShort(offset + 22).toInt()
             }
+            // Chunks are word-aligned
+            offset += 8 + size.toInt() + (size.toInt() and 1)
         }
+        
+        return WaveFormat(channels.coerceAtLeast(1), sampleRate, bitsPerSample, dataOffset, dataLength)
     }
     
     /**
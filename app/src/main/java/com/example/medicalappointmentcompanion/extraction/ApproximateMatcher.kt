@@ -0,0 +1,88 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import java.io.Closeable
+
+/**
+ * Finds keywords that occur in a text within a bounded number of edits,
+ * backed by the native bit-parallel (Myers/Hyyrö) matcher
+ *
+ * One pass over the text checks every pattern: the distance for a pattern
+ * is the smallest edit distance between it and any substring of the text,
+ * so a mis-transcribed name is found inside a whole sentence. Patterns
+ * are 1..64 ASCII chars; matching is case-sensitive.
+ *
+ * Scanning only reads the matcher and is safe from several threads.
+ */
+internal class ApproximateMatcher(
+    val patterns: List<String>,
+    maxErrors: IntArray
+) : Closeable {
+
+    private var ptr: Long
+
+    init {
+        require(patterns.size == maxErrors.size) { "One error bound per pattern" }
+        ptr = ExtractionLib.createApproxMatcher(patterns.toTypedArray(), maxErrors)
+        if (ptr == 0L) {
+            throw IllegalArgumentException("Patterns must be 1..64 ASCII chars")
+        }
+    }
+
+    /**
+     * Raw matches as (pattern, errors, end) triples, one per pattern found
+     * within its bound, in pattern order
+     */
+    fun scan(text: String): IntArray {
+        require(ptr != 0L) { "ApproximateMatcher has been released" }
+        return ExtractionLib.approxMatcherScan(ptr, text)
+    }
+
+    /**
+     * The [matches] of a scan of [text] with its spaces removed that runs
+     * of up to [maxWords] whole words of [text] also spell: within the
+     * pattern's bound and with its phonetic code once joined. Their errors
+     * and end come from the best such run.
+     */
+    fun confirm(matches: IntArray, text: String, maxWords: Int): IntArray {
+        require(ptr != 0L) { "ApproximateMatcher has been released" }
+        if (matches.isEmpty()) return matches
+        return ExtractionLib.approxMatcherConfirm(ptr, matches, text, maxWords)
+    }
+
+    /**
+     * Index of the pattern found with the fewest errors per char (the
+     * earliest pattern on ties), or -1. [exactOnly] ignores any match with
+     * errors.
+     */
+    fun closest(matches: IntArray, exactOnly: Boolean = false): Int {
+        var best = -1
+        var bestRate = Float.MAX_VALUE
+        for (i in matches.indices step 3) {
+            val pattern = matches[i]
+            val errors = matches[i + 1]
+            if (exactOnly && errors > 0) continue
+            val rate = errors.toFloat() / patterns[pattern].length
+            if (rate < bestRate) {
+                best = pattern
+                bestRate = rate
+            }
+        }
+        return best
+    }
+
+    /**
+     * Bit-parallel against plain dynamic programming on a synthetic
+     * transcript of [minutes] length
+     */
+    fun bench(minutes: Int): String {
+        require(ptr != 0L) { "ApproximateMatcher has been released" }
+        return ExtractionLib.benchApproxMatcher(ptr, minutes)
+    }
+
+    override fun close() {
+        if (ptr != 0L) {
+            ExtractionLib.freeApproxMatcher(ptr)
+            ptr = 0
+        }
+    }
+}
@@ -0,0 +1,41 @@
+package com.example.medicalappointmentcompanion.extraction
+
+/**
+ * JNI bindings for the native extraction matchers (libmedextract).
+ *
+ * A separate library from whisper: it has no model dependency and loads
+ * on any ABI without variant selection.
+ */
+internal class ExtractionLib {
+    companion object {
+        init {
+            System.loadLibrary("medextract")
+        }
+
+        // JNI methods - Pattern matching
+        external fun createPatternMatcher(patterns: Array<String>, foldNumbers: Boolean, foldSpaces: Boolean): Long
+        external fun patternMatcherScan(matcherPtr: Long, text: String): IntArray
+        external fun freePatternMatcher(matcherPtr: Long)
+
+        // JNI methods - Approximate matching
+        external fun createApproxMatcher(patterns: Array<String>, maxErrors: IntArray): Long
+        external fun approxMatcherScan(matcherPtr: Long, text: String): IntArray
+        external fun approxMatcherConfirm(matcherPtr: Long, matches: IntArray, text: String, maxWords: Int): IntArray
+        external fun freeApproxMatcher(matcherPtr: Long)
+
+        // JNI methods - Sentence tokenizer
+        external fun tokenizeSentences(text: String, from: Int, final: Boolean, lower: CharArray): IntArray
+
+        // JNI methods - Medication lexicon
+        external fun compileLexicon(names: Array<String>, canonicals: Array<String>, outPath: String): Boolean
+        external fun compileLexiconCsv(csvPath: String, outPath: String): Boolean
+        external fun openLexicon(path: String): Long
+        external fun lexiconFind(lexiconPtr: Long, text: String): IntArray
+        external fun lexiconName(lexiconPtr: Long, entry: Int): String
+        external fun lexiconSize(lexiconPtr: Long): Int
+        external fun closeLexicon(lexiconPtr: Long)
+
+        // JNI methods - Benchmarks
+        external fun benchApproxMatcher(matcherPtr: Long, minutes: Int): String
+    }
+}
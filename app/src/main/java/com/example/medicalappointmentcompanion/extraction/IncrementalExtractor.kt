@@ -0,0 +1,171 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import com.example.medicalappointmentcompanion.model.EvidenceSpan
+import com.example.medicalappointmentcompanion.model.MedicalExtraction
+import com.example.medicalappointmentcompanion.model.Transcription
+import com.example.medicalappointmentcompanion.model.TranscriptionSegmentData
+
+/**
+ * Schema-guided extraction that keeps up with a transcription as its
+ * segments are committed
+ *
+ * Segments are joined with a space, as in the saved transcript. The
+ * native tokenizer lower-cases each char once and finds the sentence
+ * boundaries in the same pass; a sentence is extracted as soon as the
+ * punctuation ending it and the whitespace after it have arrived, so each
+ * segment costs only its own sentences. The unfinished tail is carried
+ * over to the next segment, and [finish] only has that tail left to do.
+ *
+ * Every quote carries its [EvidenceSpan]: the segment and offset it
+ * starts at and, for timed segments ([addSegment] with a
+ * [TranscriptionSegmentData]), the time it was said. A batch of sentences is handed to the
+ * schema's stages together, which fan out over it when it is large (a
+ * whole transcript at once); [timings] says where the time went.
+ *
+ * Not thread-safe: feed it from one coroutine.
+ */
+class IncrementalExtractor(private val recordingDurationSeconds: Int? = null) {
+
+    private val state = SchemaGuidedExtractor.ExtractionState()
+
+    private val pending = StringBuilder()       // text after the last extracted sentence
+    private var lower = CharArray(256)          // pending, lower-cased up to checked
+    private var checked = 0                     // pending chars the tokenizer has seen
+    private var pendingStart = 0                // transcript offset of pending
+    private var hasText = false
+
+    // Transcript offset where each segment starts, with its times (-1 if untimed)
+    private val segmentOffsets = mutableListOf<Int>()
+    private val segmentStartMs = mutableListOf<Long>()
+    private val segmentEndMs = mutableListOf<Long>()
+
+    private var totalNanos = 0L
+    private var scanNanos = 0L
+
+    // Built from state when read, so a batch of sentences costs only its own work
+    private var built: MedicalExtraction? = null
+
+    /**
+     * Extraction from the sentences completed so far, built on first read
+     * after a segment added any
+     */
+    val extraction: MedicalExtraction
+        get() = built ?: state.toExtraction(recordingDurationSeconds).also { built = it }
+
+    /**
+     * Time spent so far, overall and per stage
+     */
+    val timings: ExtractionTimings
+        get() = state.timings(totalNanos, scanNanos)
+
+    /**
+     * Add the next committed segment
+     */
+    suspend fun addSegment(segment: TranscriptionSegmentData) {
+        append(segment.text, segment.startMs, segment.endMs)
+    }
+
+    /**
+     * Add the next piece of untimed transcript text
+     */
+    suspend fun addSegment(text: String) {
+        append(text, -1, -1)
+    }
+
+    /**
+     * Extract the trailing sentence once the transcription has ended
+     */
+    suspend fun finish(): MedicalExtraction {
+        tokenize(final = true)
+        return extraction
+    }
+
+    private suspend fun append(text: String, startMs: Long, endMs: Long) {
+        if (hasText) pending.append(Transcription.SEGMENT_SEPARATOR)
+        hasText = true
+        segmentOffsets += pendingStart + pending.length
+        segmentStartMs += startMs
+        segmentEndMs += endMs
+        pending.append(text)
+        tokenize(final = false)
+    }
+
+    private suspend fun tokenize(final: Boolean) {
+        val start = System.nanoTime()
+        if (lower.size < pending.length) {
+            lower = lower.copyOf(maxOf(lower.size * 2, pending.length))
+        }
+        val text = pending.toString()
+        val result = ExtractionLib.tokenizeSentences(text, checked, final, lower)
+        checked = text.length
+
+        // Consumed length, then (start, end) per complete sentence
+        val consumed = result[0]
+        val spans = List((result.size - 1) / 2) { i -> result[1 + 2 * i] until result[2 + 2 * i] }
+        val sentences = if (spans.isEmpty()) emptyList() else {
+            SchemaGuidedExtractor.sentences(text, String(lower, 0, consumed), spans, ::evidenceOf)
+        }
+        scanNanos += System.nanoTime() - start
+
+        if (sentences.isNotEmpty()) {
+            state.add(sentences)
+            built = null
+        }
+        if (consumed > 0) {
+            pending.delete(0, consumed)
+            System.arraycopy(lower, consumed, lower, 0, checked - consumed)
+            checked -= consumed
+            pendingStart += consumed
+        }
+        totalNanos += System.nanoTime() - start
+    }
+
+    /**
+     * Where a span of pending text is in the transcript: the segment it
+     * starts in and the offset there, with the start time of that segment
+     * and the end time of the one it ends in
+     */
+    private fun evidenceOf(span: IntRange): EvidenceSpan {
+        val offset = pendingStart + span.first
+        val first = segmentAt(offset)
+        val last = segmentAt(pendingStart + span.last)
+        val startMs = segmentStartMs[first]
+        val endMs = segmentEndMs[last]
+        val timed = startMs >= 0 && endMs >= 0
+        return EvidenceSpan(
+            segment = first,
+            offset = offset - segmentOffsets[first],
+            length = span.last + 1 - span.first,
+            startMs = if (timed) startMs else null,
+            endMs = if (timed) endMs else null
+        )
+    }
+
+    private fun segmentAt(offset: Int): Int {
+        val i = segmentOffsets.binarySearch(offset)
+        return if (i >= 0) i else maxOf(-i - 2, 0)
+    }
+}
+
+/**
+ * Where an [IncrementalExtractor]'s time went, summed over every segment
+ *
+ * [scanMs] is tokenizing and the keyword and quantity scans, up to the
+ * stages. The stage times are each stage's own work; a large batch runs
+ * them at the same time, so [totalMs] is less than their sum and is
+ * bounded by the slowest.
+ */
+data class ExtractionTimings(
+    val totalMs: Float,
+    val scanMs: Float,
+    val medicationsMs: Float,
+    val testsMs: Float,
+    val followUpMs: Float,
+    val safetyMs: Float,
+    val notesMs: Float
+) {
+    override fun toString(): String = String.format(
+        "extraction %.1f ms: scan %.1f, medications %.1f, tests %.1f, follow-up %.1f, safety %.1f, notes %.1f",
+        totalMs, scanMs, medicationsMs, testsMs, followUpMs, safetyMs, notesMs
+    )
+}
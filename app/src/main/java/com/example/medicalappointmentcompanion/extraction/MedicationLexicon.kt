@@ -0,0 +1,144 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import android.content.Context
+import android.util.Log
+import java.io.Closeable
+import java.io.File
+import java.io.FileNotFoundException
+import java.io.InputStream
+
+private const val LOG_TAG = "MedicationLexicon"
+
+/**
+ * A compiled medication lexicon, memory-mapped by the native library
+ *
+ * Drug names in one flat file with a trie over their keys and a phonetic
+ * index, so the best candidate for a sentence is found in microseconds
+ * however long the list is. The app ships about 200 common primary care
+ * names ([ASSET_NAME]) on top of the extractor's own; a BNF or RxNorm
+ * export cut down to the same columns compiles the same way. Names can
+ * stand for another: a brand or a known mis-transcription points at its
+ * generic name, and [find] reports both.
+ *
+ * Lookups only read the mapping and are safe from several threads.
+ */
+internal class MedicationLexicon private constructor(private var ptr: Long) : Closeable {
+
+    /**
+     * [name] as found in the text at [range], standing for [canonical],
+     * [errors] edits away. [id] is the canonical entry's index, the same
+     * for every name of one medication.
+     */
+    data class Match(val name: String, val canonical: String, val id: Int, val errors: Int, val range: IntRange)
+
+    val size: Int
+        get() {
+            require(ptr != 0L) { "MedicationLexicon has been released" }
+            return ExtractionLib.lexiconSize(ptr)
+        }
+
+    /**
+     * Best candidate over every window of up to four words of lower-cased
+     * [text]: fewest errors, then longest name, then leftmost
+     */
+    fun find(text: String): Match? {
+        require(ptr != 0L) { "MedicationLexicon has been released" }
+        val match = ExtractionLib.lexiconFind(ptr, text)
+        if (match.isEmpty()) return null
+        // (entry, canonical, errors, start, end)
+        return Match(
+            name = ExtractionLib.lexiconName(ptr, match[0]),
+            canonical = ExtractionLib.lexiconName(ptr, match[1]),
+            id = match[1],
+            errors = match[2],
+            range = match[3] until match[4]
+        )
+    }
+
+    override fun close() {
+        if (ptr != 0L) {
+            ExtractionLib.closeLexicon(ptr)
+            ptr = 0
+        }
+    }
+
+    companion object {
+        /**
+         * Asset of "name,canonical" rows (canonical empty or left out for
+         * a name that stands for itself); without it only the built-in
+         * names are compiled
+         */
+        const val ASSET_NAME = "medication_lexicon.csv"
+
+        private const val FILE_NAME = "medications.mlex"
+
+        /**
+         * Compile (name, canonical) pairs into a lexicon file; a canonical
+         * of "" means the name stands for itself
+         */
+        fun compile(entries: List<Pair<String, String>>, file: File): Boolean =
+            ExtractionLib.compileLexicon(
+                entries.map { it.first }.toTypedArray(),
+                entries.map { it.second }.toTypedArray(),
+                file.absolutePath
+            )
+
+        /**
+         * Compile a "name,canonical" CSV into a lexicon file
+         */
+        fun compile(csv: File, file: File): Boolean =
+            ExtractionLib.compileLexiconCsv(csv.absolutePath, file.absolutePath)
+
+        /**
+         * Map a compiled lexicon, or null if it is missing or invalid
+         */
+        fun open(file: File): MedicationLexicon? {
+            if (!file.exists()) return null
+            val ptr = ExtractionLib.openLexicon(file.absolutePath)
+            return if (ptr == 0L) null else MedicationLexicon(ptr)
+        }
+
+        /**
+         * The app's lexicon, compiled into internal storage on first run and
+         * again after an app update: the [ASSET_NAME] rows if the app ships
+         * them, then the extractor's own names (which the asset's rows take
+         * precedence over). Blocking; call off the main thread.
+         */
+        fun load(context: Context): MedicationLexicon? {
+            val file = File(context.filesDir, FILE_NAME)
+            val installed = context.packageManager.getPackageInfo(context.packageName, 0).lastUpdateTime
+            if (!file.exists() || file.lastModified() < installed) {
+                if (!build(context, file)) return null
+            }
+            return open(file)
+        }
+
+        /**
+         * Compile the "name,canonical" rows of [csv] followed by the
+         * extractor's own names, as [load] does with the asset; [scratch]
+         * holds the combined CSV meanwhile
+         */
+        fun compileWithBuiltIn(csv: InputStream, file: File, scratch: File): Boolean {
+            val builtIn = SchemaGuidedExtractor.lexiconEntries
+            return try {
+                scratch.outputStream().use { output ->
+                    csv.copyTo(output)
+                    output.write(builtIn.joinToString("\n", prefix = "\n") { "${it.first},${it.second}" }.toByteArray())
+                }
+                compile(scratch, file)
+            } finally {
+                scratch.delete()
+            }
+        }
+
+        private fun build(context: Context, file: File): Boolean {
+            return try {
+                context.assets.open(ASSET_NAME).use { input ->
+                    compileWithBuiltIn(input, file, File(context.cacheDir, ASSET_NAME))
+                }.also { Log.d(LOG_TAG, "Compiled $ASSET_NAME with built-in names: $it") }
+            } catch (e: FileNotFoundException) {
+                compile(SchemaGuidedExtractor.lexiconEntries, file).also { Log.d(LOG_TAG, "Compiled built-in names: $it") }
+            }
+        }
+    }
+}
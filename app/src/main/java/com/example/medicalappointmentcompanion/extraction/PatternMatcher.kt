@@ -0,0 +1,187 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import java.io.Closeable
+
+/**
+ * Finds every occurrence of every keyword in one pass over the text,
+ * backed by the native Aho–Corasick automaton
+ *
+ * Keywords are grouped into categories of [C]. Each keeps its position in
+ * its category's list, so [Matches.first] gives the same answer as the
+ * `list.firstOrNull { text.contains(it) }` scan it replaces. Matching is
+ * exact and case-sensitive, so lists and text should both be lower case.
+ *
+ * Two bits of pattern syntax stand in for the regexes the lists used to
+ * be: `(x)` marks optional text, so `hour(s)` matches "hour" and "hours";
+ * and with [foldNumbers], `#` matches a number ("12", "2.5"). With
+ * [foldSpaces], a space matches any run of whitespace, as `\s+` would.
+ *
+ * Scanning only reads the automaton and is safe from several threads.
+ */
+internal class PatternMatcher<C : Enum<C>>(
+    lists: Map<C, List<String>>,
+    foldNumbers: Boolean = false,
+    foldSpaces: Boolean = false
+) : Closeable {
+
+    private val entries: Array<String>          // list entry per pattern, before expansion
+    private val categoryOf: IntArray            // category ordinal per pattern
+    private val indexInList: IntArray           // position of its entry in the category's list
+    private val categoryCount: Int
+
+    private var ptr: Long
+
+    init {
+        val patterns = mutableListOf<String>()
+        val entryList = mutableListOf<String>()
+        val categoryList = mutableListOf<Int>()
+        val indexList = mutableListOf<Int>()
+        for ((category, list) in lists) {
+            list.forEachIndexed { index, entry ->
+                for (variant in expand(entry)) {
+                    patterns += variant
+                    entryList += entry
+                    categoryList += category.ordinal
+                    indexList += index
+                }
+            }
+        }
+        entries = entryList.toTypedArray()
+        categoryOf = categoryList.toIntArray()
+        indexInList = indexList.toIntArray()
+        categoryCount = (lists.keys.maxOfOrNull { it.ordinal } ?: -1) + 1
+
+        ptr = ExtractionLib.createPatternMatcher(patterns.toTypedArray(), foldNumbers, foldSpaces)
+        if (ptr == 0L) {
+            throw IllegalArgumentException("Patterns must be non-empty ASCII")
+        }
+    }
+
+    /**
+     * Raw hits as (pattern, start, end) triples ordered by end offset
+     */
+    fun scan(text: String): IntArray {
+        require(ptr != 0L) { "PatternMatcher has been released" }
+        return ExtractionLib.patternMatcherScan(ptr, text)
+    }
+
+    /**
+     * Matches anywhere in [text]
+     */
+    fun match(text: String): Matches {
+        val matches = Matches()
+        val hits = scan(text)
+        for (i in hits.indices step 3) {
+            matches.add(hits[i], hits[i + 1], hits[i + 2])
+        }
+        return matches
+    }
+
+    /**
+     * Scan [text] once and split the hits between [spans] (sorted,
+     * non-overlapping [start, end) char ranges). Hits that cross a span
+     * boundary belong to no span.
+     */
+    fun matchSpans(text: String, spans: List<IntRange>): List<Matches> {
+        val result = List(spans.size) { Matches() }
+        if (spans.isEmpty()) return result
+
+        val hits = scan(text)
+        var span = 0
+        for (i in hits.indices step 3) {
+            val start = hits[i + 1]
+            val end = hits[i + 2]
+            // Hits arrive in end order, so the current span only moves forward
+            while (span < spans.size && spans[span].last + 1 < end) span++
+            if (span == spans.size) break
+            if (start >= spans[span].first) {
+                result[span].add(hits[i], start, end)
+            }
+        }
+        return result
+    }
+
+    override fun close() {
+        if (ptr != 0L) {
+            ExtractionLib.freePatternMatcher(ptr)
+            ptr = 0
+        }
+    }
+
+    /**
+     * The hits in one span of text, queried by category
+     *
+     * Occurrences are ranked the way a regex search of each list entry in
+     * turn would pick them: by entry, then leftmost, then longest.
+     */
+    inner class Matches {
+        private var hits = IntArray(3 * 4)
+        private var size = 0
+
+        internal fun add(pattern: Int, start: Int, end: Int) {
+            if (size + 3 > hits.size) hits = hits.copyOf(hits.size * 2)
+            hits[size] = pattern
+            hits[size + 1] = start
+            hits[size + 2] = end
+            size += 3
+        }
+
+        fun has(category: C): Boolean = select(category, FIRST_ENTRY) >= 0
+
+        /** The first entry of the category's list that occurs */
+        fun first(category: C): String? = select(category, FIRST_ENTRY).let { if (it < 0) null else entries[hits[it]] }
+
+        /** Position in the category's list of the first entry that occurs, or -1 */
+        fun firstIndex(category: C): Int = select(category, FIRST_ENTRY).let { if (it < 0) -1 else indexInList[hits[it]] }
+
+        /** Where the first entry that occurs does so */
+        fun firstMatch(category: C): IntRange? = range(select(category, FIRST_ENTRY))
+
+        /** Where the last entry that occurs does so */
+        fun lastMatch(category: C): IntRange? = range(select(category, LAST_ENTRY))
+
+        /** The leftmost (then longest) occurrence of any entry */
+        fun leftmostMatch(category: C): IntRange? = range(select(category, ANY_ENTRY))
+
+        private fun range(i: Int): IntRange? = if (i < 0) null else hits[i + 1] until hits[i + 2]
+
+        private fun select(category: C, entryOrder: Int): Int {
+            if (category.ordinal >= categoryCount) return -1
+            var best = -1
+            for (i in 0 until size step 3) {
+                if (categoryOf[hits[i]] != category.ordinal) continue
+                if (best < 0 || ranksBefore(i, best, entryOrder)) best = i
+            }
+            return best
+        }
+
+        private fun ranksBefore(i: Int, j: Int, entryOrder: Int): Boolean {
+            val byEntry = (indexInList[hits[i]] - indexInList[hits[j]]) * entryOrder
+            if (byEntry != 0) return byEntry < 0
+            if (hits[i + 1] != hits[j + 1]) return hits[i + 1] < hits[j + 1]
+            return hits[i + 2] - hits[i + 1] > hits[j + 2] - hits[j + 1]
+        }
+    }
+
+    private companion object {
+        const val FIRST_ENTRY = 1
+        const val LAST_ENTRY = -1
+        const val ANY_ENTRY = 0
+
+        /**
+         * Every variant of an entry with `(x)` optional groups
+         */
+        fun expand(entry: String): List<String> {
+            val open = entry.indexOf('(')
+            if (open < 0) return listOf(entry)
+            val close = entry.indexOf(')', open)
+            require(close > open) { "Unbalanced optional group in \"$entry\"" }
+
+            val head = entry.substring(0, open)
+            val optional = entry.substring(open + 1, close)
+            return expand(entry.substring(close + 1)).flatMap { tail ->
+                listOf(head + tail, head + optional + tail)
+            }
+        }
+    }
+}
@@ -1,6 +1,10 @@
 package com.example.medicalappointmentcompanion.extraction
 
 import com.example.medicalappointmentcompanion.model.*
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
 
 /**
  * Schema-Guided Medical Information Extractor
@@ -126,12 +130,34 @@ object SchemaGuidedExtractor {
         "ferrous sulfate", "calcichew", "adcal"
     )
     
+    // Entries above that are only there to catch known mis-transcriptions
+    private val MEDICATION_MISHEARINGS = setOf(
+        "amoxosilin", "a moxosilin", "a moxicillin", "amoxacillin"
+    )
+    
+    /**
+     * Correctly spelled medication names, in list order, for biasing the
+     * transcriber toward them (WhisperContext.setVocabularyPrompt)
+     */
+    val medicationVocabulary: List<String> =
+        COMMON_MEDICATIONS.filter { it !in MEDICATION_MISHEARINGS }
+    
+    // Quantity patterns: "#" is any number ("12", "2.5"), "(x)" is optional
+    // and a space is any run of whitespace
+    
+    // Dosage patterns: number + unit (mg, ml, tablets, etc.)
+    private val DOSAGE_PATTERNS = listOf(
+        "#( )mg", "#( )milligram(s)", "#( )mcg", "#( )microgram(s)",
+        "#( )ml", "#( )millilitre(s)",
+        "#( )tablet(s)", "#( )pill(s)", "#( )capsule(s)"
+    )
+    
     // Frequency patterns
     private val FREQUENCY_PATTERNS = listOf(
         "once a day", "twice a day", "three times a day", "four times a day",
         "once daily", "twice daily", "three times daily",
         "every morning", "every evening", "every night", "at night", "at bedtime",
-        "every \\d+ hours?", "every \\d+ to \\d+ hours?",
+        "every # hour(s)", "every # to # hour(s)",
         "in the morning", "in the evening", "with breakfast", "with lunch", "with dinner",
         "with food", "with meals", "after food", "before food", "on an empty stomach",
         "as needed", "when needed", "when required", "as required", "prn"
@@ -139,7 +165,7 @@ object SchemaGuidedExtractor {
     
     // Duration patterns  
     private val DURATION_PATTERNS = listOf(
-        "for \\d+ days?", "for \\d+ weeks?", "for \\d+ months?",
+        "for # day(s)", "for # week(s)", "for # month(s)",
         "for a week", "for two weeks", "for a month",
         "until finished", "until gone", "until the course is complete",
         "until you feel better", "until symptoms improve",
@@ -175,10 +201,10 @@ object SchemaGuidedExtractor {
     
     // Timeframe patterns
     private val TIMEFRAME_PATTERNS = listOf(
-        "in \\d+ days?", "in \\d+ weeks?", "in \\d+ months?",
+        "in # day(s)", "in # week(s)", "in # month(s)",
         "in a week", "in two weeks", "in a month", "in a fortnight",
         "next week", "next month",
-        "after \\d+ days?", "after \\d+ weeks?"
+        "after # day(s)", "after # week(s)"
     )
     
     // Safety/Warning triggers - CRITICAL
@@ -202,6 +228,206 @@ object SchemaGuidedExtractor {
         "confused", "confusion", "drowsy"
     )
     
+    // Strong emergency triggers, a warning on their own
+    private val EMERGENCY_TRIGGERS = listOf(
+        "a&e", "999", "emergency", "ambulance"
+    )
+    
+    // Special instructions attached to a medication
+    private val SPECIAL_INSTRUCTIONS = listOf(
+        "with food", "with meals", "after food", "before food",
+        "on an empty stomach", "with water", "with plenty of water",
+        "do not crush", "do not chew", "swallow whole"
+    )
+    
+    // Follow-up location/method keywords, in priority order, with the value reported
+    private val FOLLOWUP_METHODS = listOf(
+        "reception" to "reception",
+        "online" to "online",
+        "phone" to "phone",
+        "call" to "phone",
+        "gp" to "GP surgery",
+        "surgery" to "GP surgery"
+    )
+    
+    // Lifestyle advice patterns
+    private val LIFESTYLE_PATTERNS = listOf(
+        "exercise", "walk", "walking", "activity",
+        "diet", "eat", "eating", "food", "drink", "water", "alcohol",
+        "sleep", "rest", "relax",
+        "stress", "work", "smoking", "smoke", "quit"
+    )
+    
+    // Reassurance patterns
+    private val REASSURANCE_PATTERNS = listOf(
+        "nothing to worry", "don't worry", "not serious",
+        "common", "normal", "expected", "should improve",
+        "good news", "looking good"
+    )
+    
+    // ========================================================================
+    // KEYWORD MATCHING - every list above in one automaton
+    // ========================================================================
+    
+    internal enum class Keyword {
+        MEDICATION_TRIGGER, MEDICATION, SPECIAL_INSTRUCTION,
+        TEST_REFERRAL, URGENCY,
+        FOLLOWUP, FOLLOWUP_METHOD,
+        SAFETY_TRIGGER, SAFETY_CONDITION, EMERGENCY,
+        LIFESTYLE, REASSURANCE
+    }
+    
+    // Built on first use and kept for the life of the process
+    private val KEYWORDS by lazy {
+        PatternMatcher(mapOf(
+            Keyword.MEDICATION_TRIGGER to MEDICATION_TRIGGERS,
+            Keyword.MEDICATION to COMMON_MEDICATIONS,
+            Keyword.SPECIAL_INSTRUCTION to SPECIAL_INSTRUCTIONS,
+            Keyword.TEST_REFERRAL to TEST_REFERRAL_TRIGGERS,
+            Keyword.URGENCY to URGENCY_INDICATORS,
+            Keyword.FOLLOWUP to FOLLOWUP_TRIGGERS,
+            Keyword.FOLLOWUP_METHOD to FOLLOWUP_METHODS.map { it.first },
+            Keyword.SAFETY_TRIGGER to SAFETY_TRIGGERS,
+            Keyword.SAFETY_CONDITION to SAFETY_CONDITIONS,
+            Keyword.EMERGENCY to EMERGENCY_TRIGGERS,
+            Keyword.LIFESTYLE to LIFESTYLE_PATTERNS,
+            Keyword.REASSURANCE to REASSURANCE_PATTERNS
+        ))
+    }
+    
+    internal enum class Quantity { DOSAGE, FREQUENCY, DURATION, TIMEFRAME }
+    
+    // Every quantity pattern in one automaton, numbers folded to "#" and
+    // whitespace runs to one space
+    internal val QUANTITIES by lazy {
+        PatternMatcher(mapOf(
+            Quantity.DOSAGE to DOSAGE_PATTERNS,
+            Quantity.FREQUENCY to FREQUENCY_PATTERNS,
+            Quantity.DURATION to DURATION_PATTERNS,
+            Quantity.TIMEFRAME to TIMEFRAME_PATTERNS
+        ), foldNumbers = true, foldSpaces = true)
+    }
+    
+    // Known mis-transcriptions, found as written in the space-stripped sentence
+    private val MEDICATION_MISSPELLINGS = mapOf(
+        "moxosilin" to "amoxicillin",
+        "moxocillin" to "amoxicillin",
+        "moxicillin" to "amoxicillin",
+        "amoxacillin" to "amoxicillin",
+        "amoxocillin" to "amoxicillin"
+    )
+    
+    // Approximate matching: names shorter than this must match exactly,
+    // longer ones may differ by one edit per FUZZY_CHARS_PER_ERROR chars
+    private const val FUZZY_MIN_LENGTH = 6
+    private const val FUZZY_CHARS_PER_ERROR = 5
+    
+    // Words a fuzzy match may span, as in the lexicon's token windows
+    private const val FUZZY_MAX_WORDS = 4
+    
+    // The medication each entry of COMMON_MEDICATIONS stands for
+    private val MEDICATION_CANONICAL = COMMON_MEDICATIONS.map { if (it in MEDICATION_MISHEARINGS) "amoxicillin" else it }
+    
+    /**
+     * The names above as lexicon rows: (name, the name it stands for, or ""
+     * for itself). Mis-transcriptions stand for the medication they are of.
+     */
+    internal val lexiconEntries: List<Pair<String, String>> =
+        COMMON_MEDICATIONS.mapIndexed { i, name -> name to if (MEDICATION_CANONICAL[i] == name) "" else MEDICATION_CANONICAL[i] } +
+            MEDICATION_MISSPELLINGS.toList()
+    
+    /**
+     * A medication as reported: [id] is interned, the same for every name
+     * of one medication, so records merge on it in O(1)
+     */
+    private class MedicationName(val id: Int, val name: String)
+    
+    // Per COMMON_MEDICATIONS entry; ids are the canonical entry's index
+    private val BUILT_IN_MEDICATIONS: List<MedicationName> = run {
+        val index = HashMap<String, Int>()
+        COMMON_MEDICATIONS.forEachIndexed { i, name -> index.putIfAbsent(name, i) }
+        MEDICATION_CANONICAL.map { canonical ->
+            MedicationName(index.getValue(canonical), canonical.replaceFirstChar { it.uppercase() })
+        }
+    }
+    
+    // Lexicon ids come after the built-in ones
+    private val LEXICON_ID_BASE = COMMON_MEDICATIONS.size
+    
+    /**
+     * A loaded lexicon, with each COMMON_MEDICATIONS entry interned through
+     * it so a keyword hit and a lexicon hit for one medication share an id
+     */
+    private class LoadedLexicon(val lexicon: MedicationLexicon) {
+        val builtIn: List<MedicationName> = COMMON_MEDICATIONS.mapIndexed { i, name ->
+            lexicon.find(name)?.takeIf { it.errors == 0 && it.range.first == 0 && it.range.last == name.length - 1 }
+                ?.let { fromLexicon(it) } ?: BUILT_IN_MEDICATIONS[i]
+        }
+        
+        fun find(lower: String): MedicationName? = lexicon.find(lower)?.let { fromLexicon(it) }
+        
+        private fun fromLexicon(match: MedicationLexicon.Match) =
+            MedicationName(LEXICON_ID_BASE + match.id, match.canonical.replaceFirstChar { it.uppercase() })
+    }
+    
+    // Compiled lexicon, once loaded; replaces the approximate matching below
+    @Volatile
+    private var lexicon: LoadedLexicon? = null
+    
+    // Lexicon still being loaded; extraction waits for it
+    @Volatile
+    private var pendingLexicon: Deferred<MedicationLexicon?>? = null
+    
+    /**
+     * Look medication names up in [lexicon] (null to go back to the built-in
+     * list). The lexicon must stay open while it is in use.
+     */
+    internal fun useLexicon(lexicon: MedicationLexicon?) {
+        this.lexicon = lexicon?.let { LoadedLexicon(it) }
+        pendingLexicon = null
+    }
+    
+    /**
+     * Use the lexicon [loading] completes with (null for the built-in list).
+     * Extraction waits for it meanwhile, so a transcription finished during
+     * the load is read with the same names as every later one.
+     */
+    internal fun useLexicon(loading: Deferred<MedicationLexicon?>) {
+        pendingLexicon = loading
+    }
+    
+    private suspend fun awaitLexicon() {
+        val loading = pendingLexicon ?: return
+        val loaded = loading.await()
+        if (pendingLexicon === loading) useLexicon(loaded)
+    }
+    
+    // Medication names with spaces removed, for sentences normalised the same way
+    internal val COMPACT_MEDICATIONS by lazy {
+        val names = COMMON_MEDICATIONS.map { it.replace(" ", "") }
+        ApproximateMatcher(names, IntArray(names.size) { i -> fuzzyBound(names[i]) })
+    }
+    
+    private fun fuzzyBound(name: String): Int =
+        if (name.length < FUZZY_MIN_LENGTH) 0 else name.length / FUZZY_CHARS_PER_ERROR
+    
+    /**
+     * A sentence of the transcript, starting at [start], with the keywords
+     * and quantities it contains (their ranges use the same offsets) and
+     * the [evidence] span of the transcript it came from
+     */
+    internal class Sentence(
+        val start: Int,
+        val text: String,
+        val lower: String,
+        val keywords: PatternMatcher<Keyword>.Matches,
+        val quantities: PatternMatcher<Quantity>.Matches,
+        val evidence: EvidenceSpan
+    ) {
+        fun lowerAt(range: IntRange?): String? =
+            range?.let { lower.substring(it.first - start, it.last + 1 - start) }
+    }
+    
     // ========================================================================
     // MAIN EXTRACTION FUNCTION
     // ========================================================================
@@ -209,325 +435,418 @@ object SchemaGuidedExtractor {
     /**
      * Extract medical information using schema-guided approach
      * 
+     * The whole transcript as a single segment of an [IncrementalExtractor],
+     * so batch and streaming extraction give the same result.
+     * 
      * @param transcript The full transcript text
      * @param recordingDurationSeconds Optional recording duration
      * @return MedicalExtraction with only explicitly stated information
      */
-    fun extract(
+    suspend fun extract(
         transcript: String,
         recordingDurationSeconds: Int? = null
     ): MedicalExtraction {
-        val lowerTranscript = transcript.lowercase()
-        val sentences = splitIntoSentences(transcript)
+        val extractor = IncrementalExtractor(recordingDurationSeconds)
+        extractor.addSegment(transcript)
+        return extractor.finish()
+    }
+    
+    /**
+     * Extract from timed segments, so each quote carries when it was said
+     * 
+     * @param segments Transcript segments in order
+     * @param recordingDurationSeconds Optional recording duration
+     */
+    suspend fun extract(
+        segments: List<TranscriptionSegmentData>,
+        recordingDurationSeconds: Int? = null
+    ): MedicalExtraction {
+        val extractor = IncrementalExtractor(recordingDurationSeconds)
+        segments.forEach { extractor.addSegment(it) }
+        return extractor.finish()
+    }
+    
+    /**
+     * The sentences at [spans] of [text], read from its lower-cased copy
+     * [lower] (same offsets): scanned once for every keyword list and once
+     * for every quantity pattern, so the rules below read the per-sentence
+     * matches instead of searching the sentence again. [evidenceOf] places
+     * a span in the transcript.
+     */
+    internal fun sentences(
+        text: String,
+        lower: String,
+        spans: List<IntRange>,
+        evidenceOf: (IntRange) -> EvidenceSpan
+    ): List<Sentence> {
+        val keywords = KEYWORDS.matchSpans(lower, spans)
+        val quantities = QUANTITIES.matchSpans(lower, spans)
+        return spans.mapIndexed { i, span ->
+            Sentence(
+                span.first, text.substring(span), lower.substring(span), keywords[i], quantities[i],
+                evidenceOf(span)
+            )
+        }
+    }
+    
+    /**
+     * What has been extracted from the sentences added so far
+     * 
+     * Each category of the schema is a [Stage] with its own state, fed the
+     * sentences in transcript order. Every rule needs only the sentence and
+     * a little state from earlier ones, so the result after the last
+     * sentence is the same as a pass over the whole transcript. Sentences
+     * and their matches are read-only, so the stages can run at the same
+     * time over a large batch.
+     */
+    internal class ExtractionState {
+        private val medications = MedicationStage()
+        private val testsAndReferrals = TestReferralStage()
+        private val followUp = FollowUpStage()
+        private val safetyAdvice = SafetyStage()
+        private val additionalNotes = AdditionalNotesStage()
+        private val stages = listOf(medications, testsAndReferrals, followUp, safetyAdvice, additionalNotes)
+        
+        /**
+         * Feed every stage the [sentences]; a batch of at least
+         * [PARALLEL_MIN_SENTENCES] fans out, one coroutine per stage, so it
+         * takes as long as the slowest stage rather than their sum
+         */
+        suspend fun add(sentences: List<Sentence>) {
+            awaitLexicon()
+            if (sentences.size < PARALLEL_MIN_SENTENCES) {
+                stages.forEach { it.addAll(sentences) }
+                return
+            }
+            coroutineScope {
+                stages.forEach { stage -> launch(Dispatchers.Default) { stage.addAll(sentences) } }
+            }
+        }
         
-        return MedicalExtraction(
+        fun toExtraction(recordingDurationSeconds: Int?): MedicalExtraction = MedicalExtraction(
             appointmentMetadata = AppointmentMetadata(
                 recordingDurationSeconds = recordingDurationSeconds
             ),
-            medicationInstructions = extractMedications(sentences, lowerTranscript),
-            testsAndReferrals = extractTestsAndReferrals(sentences, lowerTranscript),
-            followUp = extractFollowUp(sentences, lowerTranscript),
-            safetyAdvice = extractSafetyAdvice(sentences, lowerTranscript),
-            additionalNotes = extractAdditionalNotes(sentences, lowerTranscript)
+            medicationInstructions = medications.result(),
+            testsAndReferrals = testsAndReferrals.result(),
+            followUp = followUp.result(),
+            safetyAdvice = safetyAdvice.result(),
+            additionalNotes = additionalNotes.result()
+        )
+        
+        fun timings(totalNanos: Long, scanNanos: Long) = ExtractionTimings(
+            totalMs = totalNanos / 1e6f,
+            scanMs = scanNanos / 1e6f,
+            medicationsMs = medications.nanos / 1e6f,
+            testsMs = testsAndReferrals.nanos / 1e6f,
+            followUpMs = followUp.nanos / 1e6f,
+            safetyMs = safetyAdvice.nanos / 1e6f,
+            notesMs = additionalNotes.nanos / 1e6f
         )
     }
     
+    /**
+     * One category of the schema; not thread-safe, but each stage only ever
+     * runs on one coroutine at a time
+     */
+    private abstract class Stage {
+        var nanos = 0L
+            private set
+        
+        abstract fun add(sentence: Sentence)
+        
+        fun addAll(sentences: List<Sentence>) {
+            val start = System.nanoTime()
+            sentences.forEach { add(it) }
+            nanos += System.nanoTime() - start
+        }
+    }
+    
     // ========================================================================
     // MEDICATION EXTRACTION - HIGHEST PRIORITY
     // ========================================================================
     
-    private fun extractMedications(
-        sentences: List<String>,
-        lowerTranscript: String
-    ): List<MedicationInstruction> {
-        val medications = mutableListOf<MedicationInstruction>()
+    // Words by which a sentence without a name refers back to one
+    private val ANAPHORA = Regex("\\b(it|this|these|they|them)\\b")
+    
+    private class MedicationStage : Stage() {
+        // Medications named in a sentence with a trigger, by interned id
+        private val triggered = LinkedHashMap<Int, MedicationRecord>()
+        // Medications named without one, until also named with a trigger
+        private val untriggered = LinkedHashMap<Int, MedicationRecord>()
+        private var previousHadTrigger = false
+        // Medication the previous sentence named or continued
+        private var continued: MedicationRecord? = null
         
-        // First pass: Look for medications with triggers in same sentence
-        for (sentence in sentences) {
-            val lowerSentence = sentence.lowercase()
-            
-            // Check if sentence contains medication triggers
-            val hasTrigger = MEDICATION_TRIGGERS.any { lowerSentence.contains(it) }
-            if (!hasTrigger) continue
+        override fun add(sentence: Sentence) {
+            val hasTrigger = sentence.keywords.has(Keyword.MEDICATION_TRIGGER)
             
-            // Find medication name - handle transcription errors (spaces, misspellings)
-            val medicationName = findMedicationName(lowerSentence)
+            // Handle transcription errors (spaces, misspellings)
+            val medication = findMedicationName(sentence)
             
-            if (medicationName != null) {
-                medications.add(
-                    MedicationInstruction(
-                        medicineName = medicationName,
-                        dosage = extractDosage(lowerSentence),
-                        frequency = extractFrequency(lowerSentence),
-                        duration = extractDuration(lowerSentence),
-                        specialInstructions = extractSpecialInstructions(lowerSentence),
-                        verbatimQuote = sentence.trim()
-                    )
-                )
+            continued = if (medication != null) {
+                // No trigger: extract if there's dosage/frequency (strong indicator)
+                // or the trigger was in the previous sentence,
+                // e.g., "I'm prescribing..." then "amoxicillin 500mg..."
+                val hasDosageOrFrequency = sentence.quantities.has(Quantity.DOSAGE) ||
+                                          sentence.quantities.has(Quantity.FREQUENCY)
+                if (hasTrigger || hasDosageOrFrequency || previousHadTrigger) {
+                    mention(medication, sentence, hasTrigger)
+                } else null
+            } else {
+                // Details without a name continue the previous sentence's
+                // medication only if they refer back to it, e.g. "I'm
+                // starting you on ramipril." then "Take it once a day.", not
+                // "My father was on 20 milligrams."
+                continued?.takeIf { ANAPHORA.containsMatchIn(sentence.lower) && it.add(sentence) }
             }
+            
+            previousHadTrigger = hasTrigger
         }
         
-        // Second pass: Look for medications even without explicit triggers
-        // (in case trigger is in previous sentence, e.g., "I'm prescribing..." then "amoxicillin 500mg...")
-        for (i in sentences.indices) {
-            val sentence = sentences[i]
-            val lowerSentence = sentence.lowercase()
-            
-            // Check if this sentence contains a medication name - handle transcription errors
-            val medicationName = findMedicationName(lowerSentence)
-            
-            if (medicationName != null) {
-                // Check if we already extracted this medication
-                val alreadyExtracted = medications.any { 
-                    it.medicineName.equals(medicationName, ignoreCase = true) 
-                }
-                
-                if (!alreadyExtracted) {
-                    // Check if previous sentence had a trigger, or if this sentence has dosage/frequency
-                    val hasDosageOrFrequency = extractDosage(lowerSentence) != null || 
-                                              extractFrequency(lowerSentence) != null
-                    val prevSentenceHasTrigger = i > 0 && MEDICATION_TRIGGERS.any { 
-                        sentences[i - 1].lowercase().contains(it) 
-                    }
-                    
-                    // Extract if there's dosage/frequency (strong indicator) or trigger in previous sentence
-                    if (hasDosageOrFrequency || prevSentenceHasTrigger) {
-                        medications.add(
-                            MedicationInstruction(
-                                medicineName = medicationName,
-                                dosage = extractDosage(lowerSentence),
-                                frequency = extractFrequency(lowerSentence),
-                                duration = extractDuration(lowerSentence),
-                                specialInstructions = extractSpecialInstructions(lowerSentence),
-                                verbatimQuote = sentence.trim()
-                            )
-                        )
-                    }
-                }
+        /**
+         * One record per medication: a later mention fills in what earlier
+         * ones left out, and a mention with a trigger takes precedence over
+         * those without
+         */
+        private fun mention(medication: MedicationName, sentence: Sentence, hasTrigger: Boolean): MedicationRecord {
+            val id = medication.id
+            triggered[id]?.let { record ->
+                record.add(sentence)
+                return record
+            }
+            val earlier = untriggered[id]
+            if (!hasTrigger) {
+                return earlier?.also { it.add(sentence) }
+                    ?: MedicationRecord(medication.name, sentence).also { untriggered[id] = it }
             }
+            val record = MedicationRecord(medication.name, sentence)
+            if (earlier != null) {
+                untriggered.remove(id)
+                record.add(earlier)
+            }
+            triggered[id] = record
+            return record
         }
         
-        return medications.distinctBy { it.medicineName.lowercase() }
-    }
-    
-    private fun extractDosage(sentence: String): String? {
-        // Pattern: number + unit (mg, ml, tablets, etc.)
-        val dosagePattern = Regex(
-            """(\d+(?:\.\d+)?)\s*(mg|milligrams?|mcg|micrograms?|ml|millilitres?|tablets?|pills?|capsules?)""",
-            RegexOption.IGNORE_CASE
-        )
-        return dosagePattern.find(sentence)?.value
+        fun result(): List<MedicationInstruction> =
+            (triggered.values + untriggered.values).map { it.toInstruction() }
     }
     
-    private fun extractFrequency(sentence: String): String? {
-        for (pattern in FREQUENCY_PATTERNS) {
-            val regex = Regex(pattern, RegexOption.IGNORE_CASE)
-            regex.find(sentence)?.let { return it.value }
+    /**
+     * A medication's details as they are found, the first value of each
+     * field winning. The quote is the first mention followed by every
+     * sentence a detail was taken from, each with its evidence span.
+     */
+    private class MedicationRecord(private val name: String, sentence: Sentence) {
+        private var dosage: String? = null
+        private var frequency: String? = null
+        private var duration: String? = null
+        private var specialInstructions: String? = null
+        private val quote = StringBuilder(sentence.text)
+        private val evidence = mutableListOf(sentence.evidence)
+        
+        init {
+            fill(sentence)
         }
-        return null
-    }
-    
-    private fun extractDuration(sentence: String): String? {
-        for (pattern in DURATION_PATTERNS) {
-            val regex = Regex(pattern, RegexOption.IGNORE_CASE)
-            regex.find(sentence)?.let { return it.value }
+        
+        /**
+         * Take details from [sentence] for the fields still empty, quoting
+         * it if it had any; false if it had none
+         */
+        fun add(sentence: Sentence): Boolean {
+            if (!fill(sentence)) return false
+            quote.append(' ').append(sentence.text)
+            evidence += sentence.evidence
+            return true
         }
-        return null
-    }
-    
-    private fun extractSpecialInstructions(sentence: String): String? {
-        val instructions = listOf(
-            "with food", "with meals", "after food", "before food",
-            "on an empty stomach", "with water", "with plenty of water",
-            "do not crush", "do not chew", "swallow whole"
+        
+        /**
+         * Take the details [other] found before this mention, and its quote
+         * and evidence ahead of this one's, so both stay in transcript order
+         */
+        fun add(other: MedicationRecord) {
+            dosage = dosage ?: other.dosage
+            frequency = frequency ?: other.frequency
+            duration = duration ?: other.duration
+            specialInstructions = specialInstructions ?: other.specialInstructions
+            quote.insert(0, ' ').insert(0, other.quote)
+            evidence.addAll(0, other.evidence)
+        }
+        
+        private fun fill(sentence: Sentence): Boolean {
+            val quantities = sentence.quantities
+            var filled = false
+            // First dosage in the sentence; first frequency/duration pattern in list order
+            if (dosage == null) {
+                dosage = sentence.lowerAt(quantities.leftmostMatch(Quantity.DOSAGE))
+                filled = filled || dosage != null
+            }
+            if (frequency == null) {
+                frequency = sentence.lowerAt(quantities.firstMatch(Quantity.FREQUENCY))
+                filled = filled || frequency != null
+            }
+            if (duration == null) {
+                duration = sentence.lowerAt(quantities.firstMatch(Quantity.DURATION))
+                filled = filled || duration != null
+            }
+            if (specialInstructions == null) {
+                specialInstructions = sentence.keywords.first(Keyword.SPECIAL_INSTRUCTION)
+                filled = filled || specialInstructions != null
+            }
+            return filled
+        }
+        
+        fun toInstruction() = MedicationInstruction(
+            medicineName = name,
+            dosage = dosage,
+            frequency = frequency,
+            duration = duration,
+            specialInstructions = specialInstructions,
+            verbatimQuote = quote.toString(),
+            evidence = evidence.toList()
         )
-        return instructions.firstOrNull { sentence.contains(it) }
     }
     
     // ========================================================================
     // TESTS AND REFERRALS EXTRACTION
     // ========================================================================
     
-    private fun extractTestsAndReferrals(
-        sentences: List<String>,
-        lowerTranscript: String
-    ): List<TestOrReferral> {
-        val testsAndReferrals = mutableListOf<TestOrReferral>()
+    private class TestReferralStage : Stage() {
+        // By position in TEST_REFERRAL_TRIGGERS
+        private val testsAndReferrals = LinkedHashMap<Int, TestOrReferral>()
         
-        for (sentence in sentences) {
-            val lowerSentence = sentence.lowercase()
-            
+        override fun add(sentence: Sentence) {
             // Find test/referral type
-            val testType = TEST_REFERRAL_TRIGGERS.firstOrNull { 
-                lowerSentence.contains(it) 
-            }
+            val key = sentence.keywords.firstIndex(Keyword.TEST_REFERRAL)
+            if (key < 0) return
+            val testType = TEST_REFERRAL_TRIGGERS[key]
             
-            if (testType != null) {
-                // Check for urgency - ONLY if explicitly stated
-                val urgency = URGENCY_INDICATORS.firstOrNull { 
-                    lowerSentence.contains(it) 
-                }
-                
-                testsAndReferrals.add(
-                    TestOrReferral(
-                        testOrReferralType = testType.replaceFirstChar { it.uppercase() },
-                        reasonIfStated = null, // Only extract if explicitly stated with "because", "for", etc.
+            // Check for urgency - ONLY if explicitly stated
+            val urgency = sentence.keywords.first(Keyword.URGENCY)
+            
+            // A later mention can only add the urgency the first one left out
+            testsAndReferrals[key]?.let { earlier ->
+                if (earlier.urgency == null && urgency != null) {
+                    testsAndReferrals[key] = earlier.copy(
                         urgency = urgency,
-                        verbatimQuote = sentence.trim()
+                        verbatimQuote = "${earlier.verbatimQuote} ${sentence.text}",
+                        evidence = earlier.evidence + sentence.evidence
                     )
-                )
+                }
+                return
             }
+            
+            testsAndReferrals[key] = TestOrReferral(
+                testOrReferralType = testType.replaceFirstChar { it.uppercase() },
+                reasonIfStated = null, // Only extract if explicitly stated with "because", "for", etc.
+                urgency = urgency,
+                verbatimQuote = sentence.text,
+                evidence = listOf(sentence.evidence)
+            )
         }
         
-        return testsAndReferrals.distinctBy { it.testOrReferralType.lowercase() }
+        fun result(): List<TestOrReferral> = testsAndReferrals.values.toList()
     }
     
     // ========================================================================
     // FOLLOW-UP EXTRACTION
     // ========================================================================
     
-    private fun extractFollowUp(
-        sentences: List<String>,
-        lowerTranscript: String
-    ): FollowUpInstruction? {
-        for (sentence in sentences) {
-            val lowerSentence = sentence.lowercase()
-            
-            val hasFollowUpTrigger = FOLLOWUP_TRIGGERS.any { lowerSentence.contains(it) }
-            if (!hasFollowUpTrigger) continue
+    private class FollowUpStage : Stage() {
+        private var followUp: FollowUpInstruction? = null
+        
+        override fun add(sentence: Sentence) {
+            // Only the first follow-up sentence counts
+            if (followUp != null || !sentence.keywords.has(Keyword.FOLLOWUP)) return
             
-            // Extract timeframe if stated
-            var timeframe: String? = null
-            for (pattern in TIMEFRAME_PATTERNS) {
-                val regex = Regex(pattern, RegexOption.IGNORE_CASE)
-                regex.find(lowerSentence)?.let { 
-                    timeframe = it.value
-                }
-            }
+            // Extract timeframe if stated (the last pattern in list order wins)
+            val timeframe = sentence.lowerAt(sentence.quantities.lastMatch(Quantity.TIMEFRAME))
             
             // Extract location/method if stated
-            val locationMethod = when {
-                lowerSentence.contains("reception") -> "reception"
-                lowerSentence.contains("online") -> "online"
-                lowerSentence.contains("phone") || lowerSentence.contains("call") -> "phone"
-                lowerSentence.contains("gp") || lowerSentence.contains("surgery") -> "GP surgery"
-                else -> null
-            }
+            val method = sentence.keywords.first(Keyword.FOLLOWUP_METHOD)
+            val locationMethod = FOLLOWUP_METHODS.firstOrNull { it.first == method }?.second
             
-            return FollowUpInstruction(
+            followUp = FollowUpInstruction(
                 followUpRequired = true,
                 timeframe = timeframe,
                 locationOrMethod = locationMethod,
-                verbatimQuote = sentence.trim()
+                verbatimQuote = sentence.text,
+                evidence = listOf(sentence.evidence)
             )
         }
         
-        return null
+        fun result(): FollowUpInstruction? = followUp
     }
     
     // ========================================================================
     // SAFETY ADVICE EXTRACTION
     // ========================================================================
     
-    private fun extractSafetyAdvice(
-        sentences: List<String>,
-        lowerTranscript: String
-    ): List<SafetyWarning> {
-        val warnings = mutableListOf<SafetyWarning>()
+    private class SafetyStage : Stage() {
+        private val warnings = LinkedHashMap<String, SafetyWarning>()
         
-        for (sentence in sentences) {
-            val lowerSentence = sentence.lowercase()
+        override fun add(sentence: Sentence) {
+            val keywords = sentence.keywords
             
-            // Check for safety trigger phrases
-            val hasSafetyTrigger = SAFETY_TRIGGERS.any { lowerSentence.contains(it) }
-            val hasSafetyCondition = SAFETY_CONDITIONS.any { lowerSentence.contains(it) }
+            // Must have both a trigger and a condition for high confidence,
+            // or strong emergency triggers alone
+            val isWarning = (keywords.has(Keyword.SAFETY_TRIGGER) && keywords.has(Keyword.SAFETY_CONDITION)) ||
+                    keywords.has(Keyword.EMERGENCY)
             
-            // Must have both a trigger and a condition for high confidence
-            if (hasSafetyTrigger && hasSafetyCondition) {
-                warnings.add(
-                    SafetyWarning(
-                        warning = sentence.trim(),
-                        verbatimQuote = sentence.trim()
-                    )
-                )
-            }
-            // Or strong emergency triggers alone
-            else if (lowerSentence.contains("a&e") || 
-                     lowerSentence.contains("999") ||
-                     lowerSentence.contains("emergency") ||
-                     lowerSentence.contains("ambulance")) {
-                warnings.add(
-                    SafetyWarning(
-                        warning = sentence.trim(),
-                        verbatimQuote = sentence.trim()
-                    )
+            val key = sentence.text.lowercase()
+            if (isWarning && key !in warnings) {
+                warnings[key] = SafetyWarning(
+                    warning = sentence.text,
+                    verbatimQuote = sentence.text,
+                    evidence = listOf(sentence.evidence)
                 )
             }
         }
         
-        return warnings.distinctBy { it.warning.lowercase() }
+        fun result(): List<SafetyWarning> = warnings.values.toList()
     }
     
     // ========================================================================
     // ADDITIONAL NOTES - CATCH-ALL (Prevents schema breakage)
     // ========================================================================
     
-    private fun extractAdditionalNotes(
-        sentences: List<String>,
-        lowerTranscript: String
-    ): List<String> {
-        val notes = mutableListOf<String>()
-        
-        // Lifestyle advice patterns
-        val lifestylePatterns = listOf(
-            "exercise", "walk", "walking", "activity",
-            "diet", "eat", "eating", "food", "drink", "water", "alcohol",
-            "sleep", "rest", "relax",
-            "stress", "work", "smoking", "smoke", "quit"
-        )
-        
-        // Reassurance patterns
-        val reassurancePatterns = listOf(
-            "nothing to worry", "don't worry", "not serious",
-            "common", "normal", "expected", "should improve",
-            "good news", "looking good"
-        )
+    private class AdditionalNotesStage : Stage() {
+        private val notes = mutableListOf<String>()
         
-        for (sentence in sentences) {
-            val lowerSentence = sentence.lowercase()
+        override fun add(sentence: Sentence) {
+            // Limit to prevent noise
+            if (notes.size >= MAX_ADDITIONAL_NOTES) return
             
-            // Check for lifestyle advice
-            val hasLifestyle = lifestylePatterns.any { lowerSentence.contains(it) }
-            val hasReassurance = reassurancePatterns.any { lowerSentence.contains(it) }
+            val keywords = sentence.keywords
             
-            if (hasLifestyle || hasReassurance) {
+            // Check for lifestyle advice or reassurance
+            if (keywords.has(Keyword.LIFESTYLE) || keywords.has(Keyword.REASSURANCE)) {
                 // Only add if not already captured elsewhere
-                val alreadyCaptured = MEDICATION_TRIGGERS.any { lowerSentence.contains(it) } ||
-                        TEST_REFERRAL_TRIGGERS.any { lowerSentence.contains(it) } ||
-                        FOLLOWUP_TRIGGERS.any { lowerSentence.contains(it) } ||
-                        SAFETY_TRIGGERS.any { lowerSentence.contains(it) }
+                val alreadyCaptured = keywords.has(Keyword.MEDICATION_TRIGGER) ||
+                        keywords.has(Keyword.TEST_REFERRAL) ||
+                        keywords.has(Keyword.FOLLOWUP) ||
+                        keywords.has(Keyword.SAFETY_TRIGGER)
                 
                 if (!alreadyCaptured) {
-                    notes.add(sentence.trim())
+                    notes.add(sentence.text)
                 }
             }
         }
         
-        return notes.take(5) // Limit to prevent noise
+        fun result(): List<String> = notes.toList()
     }
     
+    // Batches smaller than this (a segment's worth) aren't worth a fan-out
+    private const val PARALLEL_MIN_SENTENCES = 32
+    
+    private const val MAX_ADDITIONAL_NOTES = 5
+    
     // ========================================================================
     // UTILITY FUNCTIONS
     // ========================================================================
     
-    private fun splitIntoSentences(text: String): List<String> {
-        // Split on sentence boundaries while preserving the content
-        return text
-            .replace(Regex("""([.!?])\s+"""), "$1|||")
-            .split("|||")
-            .map { it.trim() }
-            .filter { it.isNotEmpty() && it.length > 3 }
-    }
+    private val ARTICLES = Regex("\\b(a|an|the)\\s+")
     
     /**
      * Find medication name with fuzzy matching to handle transcription errors
@@ -536,137 +855,56 @@ object SchemaGuidedExtractor {
      * - Misspellings: "moxosilin" -> "amoxicillin"
      * - Case variations
      * - Articles: "a amoxicillin" -> "amoxicillin"
+     * - Names only in the compiled lexicon, when one is loaded
+     * 
+     * Every name of one medication gives the same [MedicationName]: a
+     * mis-transcription is reported as the name it stands for.
      */
-    private fun findMedicationName(sentence: String): String? {
+    private fun findMedicationName(sentence: Sentence): MedicationName? {
+        val loaded = lexicon
+        
         // First try exact match
-        val exactMatch = COMMON_MEDICATIONS.firstOrNull { 
-            sentence.contains(it) 
+        val exactMatch = sentence.keywords.firstIndex(Keyword.MEDICATION)
+        if (exactMatch >= 0) {
+            return (loaded?.builtIn ?: BUILT_IN_MEDICATIONS)[exactMatch]
         }
-        if (exactMatch != null) {
-            return exactMatch.replaceFirstChar { it.uppercase() }
+        
+        // Compiled lexicon: word windows, spaces and misspellings included
+        if (loaded != null) {
+            return loaded.find(sentence.lower)
         }
         
         // Normalize sentence: remove common articles and extra spaces
-        val normalized = sentence
-            .replace(Regex("\\b(a|an|the)\\s+"), "") // Remove articles
+        val normalized = sentence.lower
+            .replace(ARTICLES, "") // Remove articles
             .replace(" ", "") // Remove all spaces
-            .lowercase()
         
-        // Check each medication
-        for (medication in COMMON_MEDICATIONS) {
-            val medNormalized = medication.replace(" ", "").lowercase()
-            
-            // Exact match after normalization
-            if (normalized.contains(medNormalized)) {
-                return medication.replaceFirstChar { it.uppercase() }
-            }
-            
-            // Fuzzy match for transcription errors (e.g., "moxosilin" -> "amoxicillin")
-            if (fuzzyMatch(medNormalized, normalized)) {
-                return medication.replaceFirstChar { it.uppercase() }
-            }
-        }
+        // One approximate scan for every name
+        val matches = COMPACT_MEDICATIONS.scan(normalized)
         
-        return null
-    }
-    
-    /**
-     * Simple fuzzy matching - checks if medication name appears in text
-     * with allowance for transcription errors (missing/extra characters)
-     * Handles cases like "moxosilin" -> "amoxicillin"
-     */
-    private fun fuzzyMatch(medication: String, text: String): Boolean {
-        // If medication is short, require exact match
-        if (medication.length < 6) return false
-        
-        // Check if medication appears as substring
-        if (text.contains(medication)) return true
-        
-        // Check for common transcription errors in medication names
-        // Map common misspellings
-        val commonErrors = mapOf(
-            "moxosilin" to "amoxicillin",
-            "moxocillin" to "amoxicillin",
-            "a moxosilin" to "amoxicillin",
-            "a moxocillin" to "amoxicillin",
-            "moxicillin" to "amoxicillin",
-            "amoxacillin" to "amoxicillin",
-            "amoxocillin" to "amoxicillin"
-        )
-        
-        // Check if text contains a common misspelling that maps to this medication
-        for ((misspelling, correct) in commonErrors) {
-            if (text.contains(misspelling) && medication == correct) {
-                return true
-            }
+        // Exact match after normalization
+        val exact = COMPACT_MEDICATIONS.closest(matches, exactOnly = true)
+        if (exact >= 0) {
+            return BUILT_IN_MEDICATIONS[exact]
         }
         
-        // Check similarity - if 75%+ of characters match in order, consider it a match
-        val similarity = calculateSimilarity(medication, text)
-        return similarity >= 0.75
-    }
-    
-    /**
-     * Calculate similarity between two strings (simple version)
-     * Returns value between 0.0 and 1.0
-     * Handles cases like "moxosilin" vs "amoxicillin"
-     */
-    private fun calculateSimilarity(str1: String, str2: String): Double {
-        if (str1.isEmpty() || str2.isEmpty()) return 0.0
-        
-        // Find longest common substring
-        val longer = if (str1.length > str2.length) str1 else str2
-        val shorter = if (str1.length > str2.length) str2 else str1
-        
-        // Check if shorter is contained in longer
-        if (longer.contains(shorter)) {
-            return shorter.length.toDouble() / longer.length
+        // Known mis-transcriptions
+        MEDICATION_MISSPELLINGS.entries.firstOrNull { normalized.contains(it.key) }?.let { (_, medication) ->
+            return BUILT_IN_MEDICATIONS[COMMON_MEDICATIONS.indexOf(medication)]
         }
         
-        // Check for longest common subsequence (characters in order, not necessarily consecutive)
-        // This handles "moxosilin" vs "amoxicillin" better
-        val lcsLength = longestCommonSubsequence(shorter, longer)
-        val similarity = lcsLength.toDouble() / longer.length
-        
-        // Also check if they start/end similarly (strong indicator)
-        val startSimilar = if (shorter.length >= 3 && longer.length >= 3) {
-            shorter.take(3) == longer.take(3)
-        } else false
-        
-        val endSimilar = if (shorter.length >= 3 && longer.length >= 3) {
-            shorter.takeLast(3) == longer.takeLast(3)
-        } else false
-        
-        // Boost similarity if start or end matches
-        val boostedSimilarity = if (startSimilar || endSimilar) {
-            similarity + 0.1
-        } else {
-            similarity
+        // Fuzzy match for other transcription errors (e.g., "ibuprofin" -> "ibuprofen").
+        // The scan matches substrings of the space-stripped sentence, which can
+        // start or end mid-word ("improve after" holds "proveaf", one edit from
+        // "provera"), so, like the lexicon's token windows, a candidate only
+        // counts if whole words of the sentence spell it. Articles stay in:
+        // "a moxa cillin" is "amoxacillin" split up.
+        val confirmed = COMPACT_MEDICATIONS.confirm(matches, sentence.lower, FUZZY_MAX_WORDS)
+        val closest = COMPACT_MEDICATIONS.closest(confirmed)
+        if (closest >= 0) {
+            return BUILT_IN_MEDICATIONS[closest]
         }
         
-        return minOf(boostedSimilarity, 1.0)
-    }
-    
-    /**
-     * Calculate longest common subsequence length
-     * Handles cases where characters match but aren't consecutive
-     */
-    private fun longestCommonSubsequence(str1: String, str2: String): Int {
-        val m = str1.length
-        val n = str2.length
-        val dp = Array(m + 1) { IntArray(n + 1) }
-        
-        for (i in 1..m) {
-            for (j in 1..n) {
-                if (str1[i - 1] == str2[j - 1]) {
-                    dp[i][j] = dp[i - 1][j - 1] + 1
-                } else {
-                    dp[i][j] = maxOf(dp[i - 1][j], dp[i][j - 1])
-                }
-            }
-        }
-        
-        return dp[m][n]
+        return null
     }
 }
-
@@ -1,5 +1,10 @@
 package com.example.medicalappointmentcompanion.model
 
+import com.example.medicalappointmentcompanion.whisper.BatchReport
+import com.example.medicalappointmentcompanion.whisper.DecodingParams
+import com.example.medicalappointmentcompanion.whisper.ModelOptions
+import com.example.medicalappointmentcompanion.whisper.TranscriptionTimings
+
 /**
  * Main application UI state
  */
@@ -11,12 +16,44 @@ data class AppState(
     val modelDownloadProgress: Float = 0f,
     val modelError: String? = null,
     
+    // Load-time options (flash attention); take effect at the next model load
+    val modelOptions: ModelOptions = ModelOptions.DEFAULT,
+    
+    // Set once the loaded model has been warmed up, so the first
+    // transcription runs at steady-state speed
+    val isModelReady: Boolean = false,
+    val modelWarmUpMs: Float? = null,
+    
     val isRecording: Boolean = false,
     val recordingDuration: Long = 0,
     
     val isTranscribing: Boolean = false,
     val transcriptionProgress: Float = 0f,
     
+    // Jobs in the background transcription queue
+    val pendingTranscriptionJobs: Int = 0,
+    
+    // Re-transcription of the whole archive (retranscribeArchive)
+    val isBatchTranscribing: Boolean = false,
+    val batchProgress: Float = 0f,
+    val lastBatchReport: BatchReport? = null,
+    
+    // Compress recordings in the background once they are transcribed
+    val compressAudioArchive: Boolean = true,
+    
+    // Persist each recording's log-mel so re-transcriptions skip the FFT stage
+    val cacheMelSpectrogram: Boolean = true,
+    
+    // Shrink the encoder window for short clips (quick notes)
+    val adaptiveAudioContext: Boolean = true,
+    
+    // Decoder strategy; null picks a preset for this device when the model loads
+    val decodingParams: DecodingParams? = null,
+    
+    // Prompt the transcriber with medication names so they are spelled correctly
+    val medicalVocabularyPrompt: Boolean = true,
+    val lastTranscriptionTimings: TranscriptionTimings? = null,
+    
     val currentAppointment: Appointment? = null,
     val appointments: List<Appointment> = emptyList(),
     
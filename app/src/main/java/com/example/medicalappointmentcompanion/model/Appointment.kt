@@ -38,7 +38,12 @@ data class Transcription(
     val segments: List<TranscriptionSegmentData> = emptyList(),
     val language: String = "en",
     val processedAt: Long = System.currentTimeMillis()
-)
+) {
+    companion object {
+        /** Joins the segments in [fullText]; evidence offsets depend on it */
+        const val SEGMENT_SEPARATOR = " "
+    }
+}
 
 /**
  * A segment of transcription with timing
@@ -61,6 +61,7 @@ data class AppointmentMetadata(
  * @param duration Exact duration as spoken (e.g., "for seven days", "until finished")
  * @param specialInstructions Exact instructions (e.g., "with food", "before bed")
  * @param verbatimQuote The exact quote from transcript for auditability
+ * @param evidence Where in the transcript and recording the quote was said
  */
 data class MedicationInstruction(
     val medicineName: String,
@@ -68,7 +69,8 @@ data class MedicationInstruction(
     val frequency: String? = null,
     val duration: String? = null,
     val specialInstructions: String? = null,
-    val verbatimQuote: String? = null
+    val verbatimQuote: String? = null,
+    val evidence: List<EvidenceSpan> = emptyList()
 )
 
 /**
@@ -84,12 +86,14 @@ data class MedicationInstruction(
  * @param reasonIfStated Only if EXPLICITLY stated
  * @param urgency Only if EXPLICITLY stated (null if not mentioned)
  * @param verbatimQuote The exact quote from transcript
+ * @param evidence Where in the transcript and recording the quote was said
  */
 data class TestOrReferral(
     val testOrReferralType: String,
     val reasonIfStated: String? = null,
     val urgency: String? = null,
-    val verbatimQuote: String? = null
+    val verbatimQuote: String? = null,
+    val evidence: List<EvidenceSpan> = emptyList()
 )
 
 /**
@@ -103,12 +107,14 @@ data class TestOrReferral(
  * @param timeframe Exact timeframe as spoken (e.g., "in two weeks")
  * @param locationOrMethod Exact location/method as spoken
  * @param verbatimQuote The exact quote from transcript
+ * @param evidence Where in the transcript and recording the quote was said
  */
 data class FollowUpInstruction(
     val followUpRequired: Boolean = true,
     val timeframe: String? = null,
     val locationOrMethod: String? = null,
-    val verbatimQuote: String? = null
+    val verbatimQuote: String? = null,
+    val evidence: List<EvidenceSpan> = emptyList()
 )
 
 /**
@@ -122,10 +128,29 @@ data class FollowUpInstruction(
  * 
  * @param warning Exact warning phrase as spoken
  * @param verbatimQuote The exact quote from transcript
+ * @param evidence Where in the transcript and recording the quote was said
  */
 data class SafetyWarning(
     val warning: String,
-    val verbatimQuote: String? = null
+    val verbatimQuote: String? = null,
+    val evidence: List<EvidenceSpan> = emptyList()
+)
+
+/**
+ * Where an extracted item was said
+ * 
+ * [length] chars from [offset] into transcript segment [segment], running
+ * on into the next segments if longer (segments are joined by a space, as
+ * in the full text), said from [startMs] to [endMs] when the segments were
+ * timed. Saved instead of the quote itself: the quote is read back from
+ * the transcript, and playback can seek straight to the item.
+ */
+data class EvidenceSpan(
+    val segment: Int,
+    val offset: Int,
+    val length: Int,
+    val startMs: Long? = null,
+    val endMs: Long? = null
 )
 
 /**
@@ -0,0 +1,33 @@
+package com.example.medicalappointmentcompanion.model
+
+import com.example.medicalappointmentcompanion.whisper.DecodingParams
+import java.util.UUID
+
+/**
+ * A recording waiting to be transcribed in the background
+ * 
+ * Jobs are persisted after every committed chunk, so a crash or process
+ * death only loses the chunk in flight: the job resumes at [committedMs]
+ * with the segments already decoded.
+ */
+data class TranscriptionJob(
+    val id: String = UUID.randomUUID().toString(),
+    val appointmentId: String,
+    val audioPath: String,
+    val priority: JobPriority,
+    val decodingParams: DecodingParams? = null,     // null = the context's params
+    val createdAt: Long = System.currentTimeMillis(),
+    val committedMs: Long = 0,
+    val segments: List<TranscriptionSegmentData> = emptyList(),
+    val attempts: Int = 0,
+    val failed: Boolean = false,
+    val lastError: String? = null
+)
+
+/**
+ * Scheduling priority, highest first
+ */
+enum class JobPriority {
+    FRESH_RECORDING,    // just recorded; the user is waiting for it
+    BACKLOG             // re-transcription of a stored recording
+}
@@ -0,0 +1,21 @@
+package com.example.medicalappointmentcompanion.storage
+
+import java.io.File
+import java.io.FileOutputStream
+
+/**
+ * Replace a file's contents so readers only ever see the old or the new
+ * version: the text is written and synced to a temporary file that is
+ * then renamed over the target. A crash mid-save leaves the old file.
+ */
+internal fun File.writeTextAtomically(text: String) {
+    val tmp = File(parentFile, "$name.tmp")
+    FileOutputStream(tmp).use { out ->
+        out.write(text.toByteArray())
+        out.fd.sync()
+    }
+    if (!tmp.renameTo(this)) {
+        tmp.delete()
+        throw RuntimeException("Failed to replace $name")
+    }
+}
@@ -0,0 +1,79 @@
+package com.example.medicalappointmentcompanion.storage
+
+import com.example.medicalappointmentcompanion.model.EvidenceSpan
+import com.example.medicalappointmentcompanion.model.Transcription
+import org.json.JSONArray
+import org.json.JSONObject
+
+/**
+ * Save an item's quote as its evidence spans, each a compact
+ * [segment, offset, length, startMs, endMs] array (-1 for a time that
+ * isn't known); an item without spans keeps its quote text
+ */
+internal fun JSONObject.putQuote(quote: String?, evidence: List<EvidenceSpan>) {
+    if (evidence.isEmpty()) {
+        put("verbatim_quote", quote ?: "")
+        return
+    }
+    put("evidence", JSONArray().apply {
+        evidence.forEach { span ->
+            put(JSONArray().apply {
+                put(span.segment)
+                put(span.offset)
+                put(span.length)
+                put(span.startMs ?: -1L)
+                put(span.endMs ?: -1L)
+            })
+        }
+    })
+}
+
+internal fun JSONObject.optEvidence(): List<EvidenceSpan> {
+    val arr = optJSONArray("evidence") ?: return emptyList()
+    return (0 until arr.length()).map { i ->
+        val span = arr.getJSONArray(i)
+        EvidenceSpan(
+            segment = span.getInt(0),
+            offset = span.getInt(1),
+            length = span.getInt(2),
+            startMs = span.optLong(3, -1).takeIf { it >= 0 },
+            endMs = span.optLong(4, -1).takeIf { it >= 0 }
+        )
+    }
+}
+
+/**
+ * Reads quotes back from the transcription their evidence points into
+ *
+ * Segments are joined by [Transcription.SEGMENT_SEPARATOR] in the full
+ * text, so where each one starts is worked out once and every span is
+ * then a single substring.
+ * A transcription without segments is one untimed segment.
+ */
+internal class EvidenceText(transcription: Transcription?) {
+    private val text = transcription?.fullText ?: ""
+    private val segmentOffsets: IntArray = transcription?.segments?.takeIf { it.isNotEmpty() }
+        ?.let { segments ->
+            val offsets = IntArray(segments.size)
+            for (i in 1 until segments.size) {
+                offsets[i] = offsets[i - 1] + segments[i - 1].text.length +
+                    Transcription.SEGMENT_SEPARATOR.length
+            }
+            offsets
+        } ?: intArrayOf(0)
+
+    /**
+     * The quote saved with [json]: its legacy text if it has one, else the
+     * text its evidence spans cover, or null if they don't fit the
+     * transcription
+     */
+    fun quote(json: JSONObject, evidence: List<EvidenceSpan>): String? {
+        json.optString("verbatim_quote").takeIf { it.isNotEmpty() }?.let { return it }
+        if (evidence.isEmpty()) return null
+        return evidence.map { span ->
+            val start = segmentOffsets.getOrNull(span.segment)?.plus(span.offset) ?: return null
+            if (span.offset < 0 || span.length < 0 || start + span.length > text.length) return null
+            text.substring(start, start + span.length)
+        }.joinToString(" ")
+    }
+}
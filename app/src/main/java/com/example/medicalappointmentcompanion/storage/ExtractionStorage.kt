@@ -28,7 +28,7 @@ class ExtractionStorage(private val context: Context) {
         return try {
             val file = File(extractionsDir, "$appointmentId.json")
             val json = extractionToJson(extraction)
-            file.writeText(json.toString(2))
+            file.writeTextAtomically(json.toString(2))
             Log.d(LOG_TAG, "Saved extraction for: $appointmentId")
             true
         } catch (e: Exception) {
@@ -39,12 +39,15 @@ class ExtractionStorage(private val context: Context) {
     
     /**
      * Load extraction from local storage
+     * 
+     * Quotes are saved as evidence spans into the transcript, so they are
+     * read back from the [transcription] the extraction came from.
      */
-    fun loadExtraction(appointmentId: String): MedicalExtraction? {
+    fun loadExtraction(appointmentId: String, transcription: Transcription): MedicalExtraction? {
         return try {
             val file = File(extractionsDir, "$appointmentId.json")
             if (!file.exists()) return null
-            jsonToExtraction(JSONObject(file.readText()))
+            jsonToExtraction(JSONObject(file.readText()), EvidenceText(transcription))
         } catch (e: Exception) {
             Log.e(LOG_TAG, "Failed to load extraction: $appointmentId", e)
             null
@@ -86,7 +89,7 @@ class ExtractionStorage(private val context: Context) {
                         put("frequency", med.frequency ?: "")
                         put("duration", med.duration ?: "")
                         put("special_instructions", med.specialInstructions ?: "")
-                        put("verbatim_quote", med.verbatimQuote ?: "")
+                        putQuote(med.verbatimQuote, med.evidence)
                     })
                 }
             })
@@ -98,7 +101,7 @@ class ExtractionStorage(private val context: Context) {
                         put("test_or_referral_type", test.testOrReferralType)
                         put("reason_if_stated", test.reasonIfStated ?: "")
                         put("urgency", test.urgency ?: "")
-                        put("verbatim_quote", test.verbatimQuote ?: "")
+                        putQuote(test.verbatimQuote, test.evidence)
                     })
                 }
             })
@@ -109,7 +112,7 @@ class ExtractionStorage(private val context: Context) {
                     put("follow_up_required", followUp.followUpRequired)
                     put("timeframe", followUp.timeframe ?: "")
                     put("location_or_method", followUp.locationOrMethod ?: "")
-                    put("verbatim_quote", followUp.verbatimQuote ?: "")
+                    putQuote(followUp.verbatimQuote, followUp.evidence)
                 }
             } ?: JSONObject.NULL)
             
@@ -117,8 +120,11 @@ class ExtractionStorage(private val context: Context) {
             put("safety_advice", JSONArray().apply {
                 extraction.safetyAdvice.forEach { warning ->
                     put(JSONObject().apply {
-                        put("warning", warning.warning)
-                        put("verbatim_quote", warning.verbatimQuote ?: "")
+                        // Usually the quote itself, which the evidence already gives
+                        if (warning.evidence.isEmpty() || warning.warning != warning.verbatimQuote) {
+                            put("warning", warning.warning)
+                        }
+                        putQuote(warning.verbatimQuote, warning.evidence)
                     })
                 }
             })
@@ -139,7 +145,7 @@ class ExtractionStorage(private val context: Context) {
     // JSON DESERIALIZATION
     // ========================================================================
     
-    private fun jsonToExtraction(json: JSONObject): MedicalExtraction {
+    private fun jsonToExtraction(json: JSONObject, quotes: EvidenceText): MedicalExtraction {
         // Appointment metadata
         val metadataJson = json.optJSONObject("appointment_metadata")
         val metadata = AppointmentMetadata(
@@ -152,13 +158,15 @@ class ExtractionStorage(private val context: Context) {
         val medications = json.optJSONArray("medication_instructions")?.let { arr ->
             (0 until arr.length()).map { i ->
                 val med = arr.getJSONObject(i)
+                val medEvidence = med.optEvidence()
                 MedicationInstruction(
                     medicineName = med.getString("medicine_name"),
                     dosage = med.optString("dosage").takeIf { it.isNotEmpty() },
                     frequency = med.optString("frequency").takeIf { it.isNotEmpty() },
                     duration = med.optString("duration").takeIf { it.isNotEmpty() },
                     specialInstructions = med.optString("special_instructions").takeIf { it.isNotEmpty() },
-                    verbatimQuote = med.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                    verbatimQuote = quotes.quote(med, medEvidence),
+                    evidence = medEvidence
                 )
             }
         } ?: emptyList()
@@ -167,22 +175,26 @@ class ExtractionStorage(private val context: Context) {
         val tests = json.optJSONArray("tests_and_referrals")?.let { arr ->
             (0 until arr.length()).map { i ->
                 val test = arr.getJSONObject(i)
+                val testEvidence = test.optEvidence()
                 TestOrReferral(
                     testOrReferralType = test.getString("test_or_referral_type"),
                     reasonIfStated = test.optString("reason_if_stated").takeIf { it.isNotEmpty() },
                     urgency = test.optString("urgency").takeIf { it.isNotEmpty() },
-                    verbatimQuote = test.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                    verbatimQuote = quotes.quote(test, testEvidence),
+                    evidence = testEvidence
                 )
             }
         } ?: emptyList()
         
         // Follow-up
         val followUp = json.optJSONObject("follow_up")?.let { fu ->
+            val fuEvidence = fu.optEvidence()
             FollowUpInstruction(
                 followUpRequired = fu.optBoolean("follow_up_required", true),
                 timeframe = fu.optString("timeframe").takeIf { it.isNotEmpty() },
                 locationOrMethod = fu.optString("location_or_method").takeIf { it.isNotEmpty() },
-                verbatimQuote = fu.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                verbatimQuote = quotes.quote(fu, fuEvidence),
+                evidence = fuEvidence
             )
         }
         
@@ -190,9 +202,12 @@ class ExtractionStorage(private val context: Context) {
         val safety = json.optJSONArray("safety_advice")?.let { arr ->
             (0 until arr.length()).map { i ->
                 val warning = arr.getJSONObject(i)
+                val warningEvidence = warning.optEvidence()
+                val warningQuote = quotes.quote(warning, warningEvidence)
                 SafetyWarning(
-                    warning = warning.getString("warning"),
-                    verbatimQuote = warning.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                    warning = warning.optString("warning").ifEmpty { warningQuote.orEmpty() },
+                    verbatimQuote = warningQuote,
+                    evidence = warningEvidence
                 )
             }
         } ?: emptyList()
@@ -0,0 +1,259 @@
+package com.example.medicalappointmentcompanion.storage
+
+import android.content.Context
+import android.util.Log
+import com.example.medicalappointmentcompanion.model.*
+import com.example.medicalappointmentcompanion.whisper.DecodingParams
+import com.example.medicalappointmentcompanion.whisper.SamplingStrategy
+import org.json.JSONArray
+import org.json.JSONObject
+import java.io.File
+import java.io.FileOutputStream
+import java.util.concurrent.ConcurrentHashMap
+
+private const val LOG_TAG = "JobStorage"
+
+/**
+ * Persistent transcription job queue
+ * 
+ * One JSON file per job, replaced atomically (temporary file + rename) so
+ * a job is never lost or half-written if the process dies mid-save. Chunks
+ * committed since are appended to a log next to it, one JSON line each,
+ * so progress costs only the new segments; a torn last line is ignored.
+ */
+class JobStorage(private val context: Context) {
+    
+    private val jobsDir: File by lazy {
+        File(context.filesDir, "jobs").also { it.mkdirs() }
+    }
+    
+    // Jobs this process is transcribing outside the queue; not persisted,
+    // so after process death they resume like any other job
+    private val claimed = ConcurrentHashMap.newKeySet<String>()
+    
+    /**
+     * Save or update a job
+     */
+    fun saveJob(job: TranscriptionJob): Boolean {
+        return try {
+            File(jobsDir, "${job.id}.json").writeTextAtomically(jobToJson(job).toString())
+            chunkLog(job.id).delete()
+            true
+        } catch (e: Exception) {
+            Log.e(LOG_TAG, "Failed to save job ${job.id}", e)
+            false
+        }
+    }
+    
+    /**
+     * Append a committed chunk: the job now resumes at [committedMs], after
+     * [segments]
+     */
+    fun appendChunk(id: String, committedMs: Long, segments: List<TranscriptionSegmentData>): Boolean {
+        return try {
+            val line = JSONObject().apply {
+                put("committedMs", committedMs)
+                put("segments", segmentsToJson(segments))
+            }
+            FileOutputStream(chunkLog(id), true).use { out ->
+                out.write((line.toString() + "\n").toByteArray())
+                out.fd.sync()
+            }
+            true
+        } catch (e: Exception) {
+            Log.e(LOG_TAG, "Failed to append chunk to job $id", e)
+            false
+        }
+    }
+    
+    /**
+     * Keep [loadAllJobs] from returning a job while it is transcribed in
+     * process; the claim only lasts until [release] or process death
+     */
+    fun claim(id: String) {
+        claimed.add(id)
+    }
+    
+    fun release(id: String) {
+        claimed.remove(id)
+    }
+    
+    /**
+     * Load every persisted job that isn't claimed, oldest first
+     */
+    fun loadAllJobs(): List<TranscriptionJob> {
+        return try {
+            jobsDir.listFiles { file -> file.extension == "json" }
+                ?.filterNot { file -> file.nameWithoutExtension in claimed }
+                ?.mapNotNull { file ->
+                    try {
+                        replayChunks(jsonToJob(JSONObject(file.readText())))
+                    } catch (e: Exception) {
+                        Log.e(LOG_TAG, "Dropping unreadable job ${file.name}", e)
+                        file.delete()
+                        null
+                    }
+                }
+                ?.sortedBy { it.createdAt }
+                ?: emptyList()
+        } catch (e: Exception) {
+            Log.e(LOG_TAG, "Failed to load jobs", e)
+            emptyList()
+        }
+    }
+    
+    /**
+     * Delete a finished job
+     */
+    fun deleteJob(id: String): Boolean {
+        return try {
+            chunkLog(id).delete()
+            val file = File(jobsDir, "$id.json")
+            if (file.exists()) file.delete() else true
+        } catch (e: Exception) {
+            Log.e(LOG_TAG, "Failed to delete job: $id", e)
+            false
+        }
+    }
+    
+    private fun chunkLog(id: String) = File(jobsDir, "$id.chunks")
+    
+    // Apply the chunks logged after the job file was written; a save
+    // interrupted before the log was removed leaves chunks it already has.
+    // A line torn by a crash mid-append ends the log, and the job is saved
+    // as read so later appends don't land behind it.
+    private fun replayChunks(job: TranscriptionJob): TranscriptionJob {
+        val log = chunkLog(job.id)
+        if (!log.exists()) return job
+        
+        var committedMs = job.committedMs
+        val segments = job.segments.toMutableList()
+        var torn = false
+        log.useLines { lines ->
+            for (line in lines) {
+                val chunk = try {
+                    JSONObject(line)
+                } catch (e: Exception) {
+                    torn = true
+                    break
+                }
+                val chunkMs = chunk.getLong("committedMs")
+                if (chunkMs > committedMs) {
+                    committedMs = chunkMs
+                    segments += jsonToSegments(chunk.optJSONArray("segments"))
+                }
+            }
+        }
+        val replayed = job.copy(committedMs = committedMs, segments = segments)
+        if (torn) {
+            Log.w(LOG_TAG, "Dropping a torn chunk of job ${job.id}")
+            saveJob(replayed)
+        }
+        return replayed
+    }
+    
+    // ========================================================================
+    // JSON Serialization
+    // ========================================================================
+    
+    private fun jobToJson(job: TranscriptionJob): JSONObject {
+        return JSONObject().apply {
+            put("id", job.id)
+            put("appointmentId", job.appointmentId)
+            put("audioPath", job.audioPath)
+            put("priority", job.priority.name)
+            put("createdAt", job.createdAt)
+            put("committedMs", job.committedMs)
+            put("attempts", job.attempts)
+            put("failed", job.failed)
+            put("lastError", job.lastError)
+            job.decodingParams?.let { put("decodingParams", paramsToJson(it)) }
+            put("segments", segmentsToJson(job.segments))
+        }
+    }
+    
+    private fun segmentsToJson(segments: List<TranscriptionSegmentData>): JSONArray {
+        return JSONArray().apply {
+            segments.forEach { segment ->
+                put(JSONObject().apply {
+                    put("text", segment.text)
+                    put("startMs", segment.startMs)
+                    put("endMs", segment.endMs)
+                })
+            }
+        }
+    }
+    
+    private fun jsonToSegments(arr: JSONArray?): List<TranscriptionSegmentData> {
+        if (arr == null) return emptyList()
+        return (0 until arr.length()).map { i ->
+            val seg = arr.getJSONObject(i)
+            TranscriptionSegmentData(
+                text = seg.getString("text"),
+                startMs = seg.getLong("startMs"),
+                endMs = seg.getLong("endMs")
+            )
+        }
+    }
+    
+    private fun jsonToJob(json: JSONObject): TranscriptionJob {
+        val segments = jsonToSegments(json.optJSONArray("segments"))
+        
+        return TranscriptionJob(
+            id = json.getString("id"),
+            appointmentId = json.getString("appointmentId"),
+            audioPath = json.getString("audioPath"),
+            priority = JobPriority.valueOf(json.optString("priority", JobPriority.BACKLOG.name)),
+            decodingParams = json.optJSONObject("decodingParams")?.let { jsonToParams(it) },
+            createdAt = json.optLong("createdAt", System.currentTimeMillis()),
+            committedMs = json.optLong("committedMs", 0),
+            segments = segments,
+            attempts = json.optInt("attempts", 0),
+            failed = json.optBoolean("failed", false),
+            lastError = json.optString("lastError").takeIf { it.isNotEmpty() }
+        )
+    }
+    
+    private fun paramsToJson(params: DecodingParams): JSONObject {
+        return JSONObject().apply {
+            put("strategy", params.strategy.name)
+            put("bestOf", params.bestOf)
+            put("beamSize", params.beamSize)
+            put("temperature", params.temperature.toDouble())
+            put("temperatureIncrement", params.temperatureIncrement.toDouble())
+            put("temperatureFallback", params.temperatureFallback)
+            put("entropyThreshold", params.entropyThreshold.toDouble())
+            put("logprobThreshold", params.logprobThreshold.toDouble())
+            put("noSpeechThreshold", params.noSpeechThreshold.toDouble())
+            put("maxSegmentLength", params.maxSegmentLength)
+            put("tokenDetails", params.tokenDetails)
+            put("tokenTimestamps", params.tokenTimestamps)
+            put("language", params.language ?: JSONObject.NULL)
+        }
+    }
+    
+    private fun jsonToParams(json: JSONObject): DecodingParams {
+        val defaults = DecodingParams()
+        return DecodingParams(
+            strategy = SamplingStrategy.valueOf(json.optString("strategy", defaults.strategy.name)),
+            bestOf = json.optInt("bestOf", defaults.bestOf),
+            beamSize = json.optInt("beamSize", defaults.beamSize),
+            temperature = json.optDouble("temperature", defaults.temperature.toDouble()).toFloat(),
+            temperatureIncrement = json.optDouble(
+                "temperatureIncrement", defaults.temperatureIncrement.toDouble()
+            ).toFloat(),
+            temperatureFallback = json.optBoolean("temperatureFallback", defaults.temperatureFallback),
+            entropyThreshold = json.optDouble("entropyThreshold", defaults.entropyThreshold.toDouble()).toFloat(),
+            logprobThreshold = json.optDouble("logprobThreshold", defaults.logprobThreshold.toDouble()).toFloat(),
+            noSpeechThreshold = json.optDouble("noSpeechThreshold", defaults.noSpeechThreshold.toDouble()).toFloat(),
+            maxSegmentLength = json.optInt("maxSegmentLength", defaults.maxSegmentLength),
+            tokenDetails = json.optBoolean("tokenDetails", defaults.tokenDetails),
+            tokenTimestamps = json.optBoolean("tokenTimestamps", defaults.tokenTimestamps),
+            language = if (json.has("language") && json.isNull("language")) {
+                null
+            } else {
+                json.optString("language", defaults.language)
+            }
+        )
+    }
+}
@@ -2,6 +2,7 @@ package com.example.medicalappointmentcompanion.storage
 
 import android.content.Context
 import android.util.Log
+import com.example.medicalappointmentcompanion.audio.AudioArchive
 import com.example.medicalappointmentcompanion.model.*
 import org.json.JSONArray
 import org.json.JSONObject
@@ -62,13 +63,31 @@ class LocalStorage(private val context: Context) {
         return File(audioDir, "${appointmentId}.wav").absolutePath
     }
     
+    /**
+     * Find the stored recording for an appointment, preferring the
+     * compressed archive if the WAV has already been encoded and the
+     * archive is complete
+     */
+    fun findAudioFile(appointmentId: String): File? {
+        val archive = File(audioDir, "${appointmentId}.${AudioArchive.EXTENSION}")
+        if (AudioArchive.isComplete(archive)) return archive
+        return File(audioDir, "${appointmentId}.wav").takeIf { it.exists() }
+    }
+    
+    /**
+     * Log-mel cache for an appointment's recording, kept next to the audio
+     * so re-transcriptions can skip the spectrogram stage
+     */
+    fun getMelCacheFile(appointmentId: String): File = File(audioDir, "${appointmentId}.mel")
+    
     /**
      * Save an appointment to local storage
      */
     fun saveAppointment(appointment: Appointment): Boolean {
         return try {
             val file = File(storageDir, "${appointment.id}.json")
-            file.writeText(appointmentToJson(appointment).toString(2))
+            // Transcription and extraction are replaced together or not at all
+            file.writeTextAtomically(appointmentToJson(appointment).toString(2))
             Log.d(LOG_TAG, "Saved appointment: ${appointment.id}")
             true
         } catch (e: Exception) {
@@ -114,19 +133,25 @@ class LocalStorage(private val context: Context) {
     }
     
     /**
-     * Delete an appointment and its audio file
+     * Delete an appointment, its audio file and mel cache
      */
     fun deleteAppointment(id: String): Boolean {
         return try {
             val jsonFile = File(storageDir, "$id.json")
-            val audioFile = File(audioDir, "$id.wav")
+            val audioFiles = listOf(
+                File(audioDir, "$id.wav"),
+                File(audioDir, "$id.${AudioArchive.EXTENSION}"),
+                getMelCacheFile(id)
+            )
             
             var success = true
             if (jsonFile.exists()) {
                 success = jsonFile.delete() && success
             }
-            if (audioFile.exists()) {
-                success = audioFile.delete() && success
+            for (audioFile in audioFiles) {
+                if (audioFile.exists()) {
+                    success = audioFile.delete() && success
+                }
             }
             
             Log.d(LOG_TAG, "Deleted appointment: $id, success=$success")
@@ -219,7 +244,7 @@ class LocalStorage(private val context: Context) {
                         put("frequency", med.frequency ?: "")
                         put("duration", med.duration ?: "")
                         put("special_instructions", med.specialInstructions ?: "")
-                        put("verbatim_quote", med.verbatimQuote ?: "")
+                        putQuote(med.verbatimQuote, med.evidence)
                     })
                 }
             })
@@ -231,7 +256,7 @@ class LocalStorage(private val context: Context) {
                         put("test_or_referral_type", test.testOrReferralType)
                         put("reason_if_stated", test.reasonIfStated ?: "")
                         put("urgency", test.urgency ?: "")
-                        put("verbatim_quote", test.verbatimQuote ?: "")
+                        putQuote(test.verbatimQuote, test.evidence)
                     })
                 }
             })
@@ -242,7 +267,7 @@ class LocalStorage(private val context: Context) {
                     put("follow_up_required", fu.followUpRequired)
                     put("timeframe", fu.timeframe ?: "")
                     put("location_or_method", fu.locationOrMethod ?: "")
-                    put("verbatim_quote", fu.verbatimQuote ?: "")
+                    putQuote(fu.verbatimQuote, fu.evidence)
                 }
             } ?: JSONObject.NULL)
             
@@ -250,8 +275,11 @@ class LocalStorage(private val context: Context) {
             put("safety_advice", JSONArray().apply {
                 extraction.safetyAdvice.forEach { warning ->
                     put(JSONObject().apply {
-                        put("warning", warning.warning)
-                        put("verbatim_quote", warning.verbatimQuote ?: "")
+                        // Usually the quote itself, which the evidence already gives
+                        if (warning.evidence.isEmpty() || warning.warning != warning.verbatimQuote) {
+                            put("warning", warning.warning)
+                        }
+                        putQuote(warning.verbatimQuote, warning.evidence)
                     })
                 }
             })
@@ -270,6 +298,7 @@ class LocalStorage(private val context: Context) {
     // ========================================================================
     
     private fun jsonToAppointment(json: JSONObject): Appointment {
+        val transcription = json.optJSONObject("transcription")?.let { jsonToTranscription(it) }
         return Appointment(
             id = json.getString("id"),
             title = json.getString("title"),
@@ -281,8 +310,8 @@ class LocalStorage(private val context: Context) {
             audioFilePath = json.optString("audioFilePath").takeIf { it.isNotEmpty() },
             notes = json.optString("notes").takeIf { it.isNotEmpty() },
             status = AppointmentStatus.valueOf(json.optString("status", "DRAFT")),
-            transcription = json.optJSONObject("transcription")?.let { jsonToTranscription(it) },
-            extraction = json.optJSONObject("extraction")?.let { jsonToExtraction(it) }
+            transcription = transcription,
+            extraction = json.optJSONObject("extraction")?.let { jsonToExtraction(it, transcription) }
         )
     }
     
@@ -308,7 +337,12 @@ class LocalStorage(private val context: Context) {
         )
     }
     
-    private fun jsonToExtraction(json: JSONObject): MedicalExtraction {
+    /**
+     * Quotes are read back from [transcription] through their evidence
+     */
+    private fun jsonToExtraction(json: JSONObject, transcription: Transcription?): MedicalExtraction {
+        val quotes = EvidenceText(transcription)
+        
         // Appointment metadata
         val metadataJson = json.optJSONObject("appointment_metadata")
         val metadata = AppointmentMetadata(
@@ -321,13 +355,15 @@ class LocalStorage(private val context: Context) {
         val medications = json.optJSONArray("medication_instructions")?.let { arr ->
             (0 until arr.length()).map { i ->
                 val med = arr.getJSONObject(i)
+                val medEvidence = med.optEvidence()
                 MedicationInstruction(
                     medicineName = med.getString("medicine_name"),
                     dosage = med.optString("dosage").takeIf { it.isNotEmpty() },
                     frequency = med.optString("frequency").takeIf { it.isNotEmpty() },
                     duration = med.optString("duration").takeIf { it.isNotEmpty() },
                     specialInstructions = med.optString("special_instructions").takeIf { it.isNotEmpty() },
-                    verbatimQuote = med.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                    verbatimQuote = quotes.quote(med, medEvidence),
+                    evidence = medEvidence
                 )
             }
         } ?: emptyList()
@@ -336,22 +372,26 @@ class LocalStorage(private val context: Context) {
         val tests = json.optJSONArray("tests_and_referrals")?.let { arr ->
             (0 until arr.length()).map { i ->
                 val test = arr.getJSONObject(i)
+                val testEvidence = test.optEvidence()
                 TestOrReferral(
                     testOrReferralType = test.getString("test_or_referral_type"),
                     reasonIfStated = test.optString("reason_if_stated").takeIf { it.isNotEmpty() },
                     urgency = test.optString("urgency").takeIf { it.isNotEmpty() },
-                    verbatimQuote = test.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                    verbatimQuote = quotes.quote(test, testEvidence),
+                    evidence = testEvidence
                 )
             }
         } ?: emptyList()
         
         // Follow-up
         val followUp = json.optJSONObject("follow_up")?.let { fu ->
+            val fuEvidence = fu.optEvidence()
             FollowUpInstruction(
                 followUpRequired = fu.optBoolean("follow_up_required", true),
                 timeframe = fu.optString("timeframe").takeIf { it.isNotEmpty() },
                 locationOrMethod = fu.optString("location_or_method").takeIf { it.isNotEmpty() },
-                verbatimQuote = fu.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                verbatimQuote = quotes.quote(fu, fuEvidence),
+                evidence = fuEvidence
             )
         }
         
@@ -359,9 +399,12 @@ class LocalStorage(private val context: Context) {
         val safety = json.optJSONArray("safety_advice")?.let { arr ->
             (0 until arr.length()).map { i ->
                 val warning = arr.getJSONObject(i)
+                val warningEvidence = warning.optEvidence()
+                val warningQuote = quotes.quote(warning, warningEvidence)
                 SafetyWarning(
-                    warning = warning.getString("warning"),
-                    verbatimQuote = warning.optString("verbatim_quote").takeIf { it.isNotEmpty() }
+                    warning = warning.optString("warning").ifEmpty { warningQuote.orEmpty() },
+                    verbatimQuote = warningQuote,
+                    evidence = warningEvidence
                 )
             }
         } ?: emptyList()
@@ -1,21 +1,41 @@
 package com.example.medicalappointmentcompanion.ui
 
 import android.app.Application
+import android.content.ComponentCallbacks2
 import android.util.Log
 import androidx.lifecycle.AndroidViewModel
 import androidx.lifecycle.viewModelScope
+import com.example.medicalappointmentcompanion.audio.AudioArchive
 import com.example.medicalappointmentcompanion.audio.AudioRecorder
+import com.example.medicalappointmentcompanion.audio.MelStream
 import com.example.medicalappointmentcompanion.audio.WaveHelper
+import com.example.medicalappointmentcompanion.extraction.IncrementalExtractor
+import com.example.medicalappointmentcompanion.extraction.MedicationLexicon
 import com.example.medicalappointmentcompanion.extraction.SchemaGuidedExtractor
 import com.example.medicalappointmentcompanion.model.AppState
 import com.example.medicalappointmentcompanion.model.Appointment
 import com.example.medicalappointmentcompanion.model.AppointmentStatus
+import com.example.medicalappointmentcompanion.model.JobPriority
+import com.example.medicalappointmentcompanion.model.MedicalExtraction
 import com.example.medicalappointmentcompanion.model.Transcription
+import com.example.medicalappointmentcompanion.model.TranscriptionJob
 import com.example.medicalappointmentcompanion.model.TranscriptionSegmentData
+import com.example.medicalappointmentcompanion.storage.JobStorage
 import com.example.medicalappointmentcompanion.storage.LocalStorage
+import com.example.medicalappointmentcompanion.whisper.BatchItem
+import com.example.medicalappointmentcompanion.whisper.BatchTranscriber
+import com.example.medicalappointmentcompanion.whisper.DecodingParams
+import com.example.medicalappointmentcompanion.whisper.ModelOptions
+import com.example.medicalappointmentcompanion.whisper.ScheduleDecision
+import com.example.medicalappointmentcompanion.whisper.StatePool
+import com.example.medicalappointmentcompanion.whisper.TranscriptionQueue
+import com.example.medicalappointmentcompanion.whisper.TranscriptionScheduler
+import com.example.medicalappointmentcompanion.whisper.TranscriptionSegment
 import com.example.medicalappointmentcompanion.whisper.WhisperContext
+import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
@@ -32,6 +52,9 @@ import java.util.UUID
 
 private const val LOG_TAG = "MainViewModel"
 
+// Sessions used to re-transcribe the archive; they share the thread budget
+private const val ARCHIVE_WORKERS = 2
+
 /**
  * ViewModel for the main screen
  * 
@@ -44,13 +67,20 @@ private const val LOG_TAG = "MainViewModel"
 class MainViewModel(application: Application) : AndroidViewModel(application) {
     
     private val storage = LocalStorage(application)
+    private val jobStorage = JobStorage(application)
     private val recorder = AudioRecorder(application)
     
     private var whisperContext: WhisperContext? = null
+    private var statePool: StatePool? = null
+    private var transcriptionQueue: TranscriptionQueue? = null
+    
+    // Shared by foreground transcriptions, the background queue and archive re-transcription
+    private val scheduler = TranscriptionScheduler(application)
     private var recordingTimerJob: Job? = null
     
     private var currentAppointmentId: String? = null
     private var currentAudioFile: File? = null
+    private var currentMelStream: MelStream? = null
     
     private val _state = MutableStateFlow(AppState())
     val state: StateFlow<AppState> = _state.asStateFlow()
@@ -58,10 +88,41 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
     init {
         loadAppointments()
         autoLoadModel()
+        loadMedicationLexicon()
+    }
+    
+    /**
+     * Map the compiled medication lexicon (compiling it on first run) and
+     * hand it to the extractor; it stays open for the life of the process.
+     * Extractions wait for the load rather than run without it.
+     */
+    private fun loadMedicationLexicon() {
+        val loading = CompletableDeferred<MedicationLexicon?>()
+        SchemaGuidedExtractor.useLexicon(loading)
+        viewModelScope.launch {
+            try {
+                val lexicon = withContext(Dispatchers.IO) {
+                    try {
+                        MedicationLexicon.load(getApplication())
+                    } catch (e: Exception) {
+                        Log.w(LOG_TAG, "Failed to load medication lexicon", e)
+                        null
+                    }
+                }
+                lexicon?.let { Log.d(LOG_TAG, "Medication lexicon: ${it.size} names") }
+                loading.complete(lexicon)
+            } finally {
+                // Cancelled: fall back to the built-in list (no-op once completed)
+                loading.complete(null)
+            }
+        }
     }
     
     /**
      * Automatically try to load model from known locations
+     * 
+     * Runs at startup, off the main thread, so the model is loaded and
+     * warmed up (see prepareModel) before the first recording ends.
      */
     private fun autoLoadModel() {
         viewModelScope.launch {
@@ -83,15 +144,17 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                 val assets = getApplication<Application>().assets
                 for (modelName in modelNames) {
                     try {
-                        assets.open(modelName).use { inputStream ->
-                            val outputFile = File(modelDir, modelName)
-                            outputFile.outputStream().use { outputStream ->
-                                inputStream.copyTo(outputStream)
+                        val outputFile = File(modelDir, modelName)
+                        withContext(Dispatchers.IO) {
+                            assets.open(modelName).use { inputStream ->
+                                outputFile.outputStream().use { outputStream ->
+                                    inputStream.copyTo(outputStream)
+                                }
                             }
-                            Log.d(LOG_TAG, "Copied model from assets to: ${outputFile.absolutePath}")
-                            loadModel(outputFile.absolutePath)
-                            return@launch
                         }
+                        Log.d(LOG_TAG, "Copied model from assets to: ${outputFile.absolutePath}")
+                        loadModel(outputFile.absolutePath)
+                        return@launch
                     } catch (e: Exception) {
                         // Model not in assets, try next one
                         Log.d(LOG_TAG, "Model $modelName not found in assets, trying next")
@@ -307,19 +370,12 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                         throw IllegalArgumentException("Model file not found: $modelPath")
                     }
                     
-                    whisperContext = WhisperContext.createFromFile(modelPath)
+                    whisperContext = WhisperContext.createFromFile(modelPath, _state.value.modelOptions)
                 }
                 
                 val systemInfo = WhisperContext.getSystemInfo()
                 Log.d(LOG_TAG, "Model loaded. System info: $systemInfo")
-                
-                _state.update { 
-                    it.copy(
-                        isModelLoaded = true, 
-                        isModelLoading = false,
-                        systemInfo = systemInfo
-                    ) 
-                }
+                whisperContext?.let { prepareModel(it, systemInfo) }
             } catch (e: Exception) {
                 Log.e(LOG_TAG, "Failed to load model", e)
                 _state.update { 
@@ -345,20 +401,14 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                 withContext(Dispatchers.IO) {
                     whisperContext = WhisperContext.createFromAsset(
                         getApplication<Application>().assets,
-                        assetPath
+                        assetPath,
+                        _state.value.modelOptions
                     )
                 }
                 
                 val systemInfo = WhisperContext.getSystemInfo()
                 Log.d(LOG_TAG, "Model loaded from asset. System info: $systemInfo")
-                
-                _state.update { 
-                    it.copy(
-                        isModelLoaded = true, 
-                        isModelLoading = false,
-                        systemInfo = systemInfo
-                    ) 
-                }
+                whisperContext?.let { prepareModel(it, systemInfo) }
             } catch (e: Exception) {
                 Log.e(LOG_TAG, "Failed to load model from asset", e)
                 _state.update { 
@@ -371,6 +421,40 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
         }
     }
     
+    /**
+     * Apply the transcription settings to a freshly loaded model, start
+     * the background queue, then allow recording and warm the model up
+     * 
+     * isModelLoaded is only set once the settings are applied, so no
+     * transcription can run without them. One requested during the warm-up
+     * queues behind it on the context's thread; isModelReady is the signal
+     * that the first transcription will run at steady-state speed.
+     */
+    private suspend fun prepareModel(context: WhisperContext, systemInfo: String) {
+        _state.update { it.copy(isModelReady = false, modelWarmUpMs = null) }
+        applyDecodingParams()
+        applyVocabularyPrompt()
+        startTranscriptionQueue(context)
+        _state.update { 
+            it.copy(
+                isModelLoaded = true, 
+                isModelLoading = false,
+                systemInfo = systemInfo
+            ) 
+        }
+        
+        val warmUpMs = try {
+            context.warmUp()
+        } catch (e: Exception) {
+            // Not fatal: the first transcription just runs cold
+            Log.w(LOG_TAG, "Model warm-up failed", e)
+            null
+        }
+        Log.d(LOG_TAG, "Model warm-up: $warmUpMs ms")
+        
+        _state.update { it.copy(isModelReady = true, modelWarmUpMs = warmUpMs) }
+    }
+    
     /**
      * Get the model storage directory
      */
@@ -425,8 +509,9 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                     ) 
                 }
                 
-                // Start audio recording
-                recorder.startRecording(currentAudioFile!!) { error ->
+                // Start audio recording, computing the mel as audio arrives
+                currentMelStream = whisperContext?.createMelStream()
+                recorder.startRecording(currentAudioFile!!, currentMelStream) { error ->
                     Log.e(LOG_TAG, "Recording error", error)
                     _state.update { 
                         it.copy(
@@ -483,7 +568,39 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                     }
                     Log.w(LOG_TAG, "Rejecting recording: amplitude too low ($maxAmplitudeShort)")
                 } else {
-                    transcribeAudio(audioData, duration)
+                    // Persisted first so a crash or process death mid-transcription
+                    // leaves a job the background queue resumes on the next start;
+                    // claimed meanwhile so a queue (re)started now doesn't take it too
+                    val job = currentAppointmentId?.let { id ->
+                        TranscriptionJob(
+                            appointmentId = id,
+                            audioPath = currentAudioFile!!.absolutePath,
+                            priority = JobPriority.FRESH_RECORDING
+                        )
+                    }
+                    job?.let {
+                        jobStorage.claim(it.id)
+                        withContext(Dispatchers.IO) { jobStorage.saveJob(it) }
+                    }
+                    
+                    try {
+                        val transcribed = transcribeAudio(
+                            audioData,
+                            duration,
+                            currentAppointmentId?.let { melCacheFor(it) },
+                            currentMelStream
+                        )
+                        
+                        if (job != null) {
+                            if (transcribed) {
+                                withContext(Dispatchers.IO) { jobStorage.deleteJob(job.id) }
+                            } else if (enqueueTranscription(job)) {
+                                Log.w(LOG_TAG, "Retrying ${job.appointmentId} in the background")
+                            }
+                        }
+                    } finally {
+                        job?.let { jobStorage.release(it.id) }
+                    }
                 }
             } else {
                 _state.update { 
@@ -493,6 +610,9 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                     ) 
                 }
             }
+            
+            currentMelStream?.close()
+            currentMelStream = null
         }
     }
     
@@ -503,6 +623,8 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
         viewModelScope.launch {
             recordingTimerJob?.cancel()
             recorder.cancelRecording()
+            currentMelStream?.close()
+            currentMelStream = null
             
             // Delete the draft appointment
             currentAppointmentId?.let { storage.deleteAppointment(it) }
@@ -535,69 +657,104 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
     // Transcription
     // ========================================================================
     
-    private suspend fun transcribeAudio(audioData: FloatArray, durationMs: Long) {
+    private suspend fun transcribeAudio(
+        audioData: FloatArray,
+        durationMs: Long,
+        melCache: File? = null,
+        melStream: MelStream? = null
+    ): Boolean {
+        // Diagnostic: Check audio data quality
+        val minVal = audioData.minOrNull() ?: 0f
+        val maxVal = audioData.maxOrNull() ?: 0f
+        val avgAbs = audioData.map { kotlin.math.abs(it) }.average()
+        val nonZeroCount = audioData.count { it != 0f }
+        
+        Log.d(LOG_TAG, "Audio diagnostics:")
+        Log.d(LOG_TAG, "  - Samples: ${audioData.size}")
+        Log.d(LOG_TAG, "  - Duration: ${audioData.size / 16000f}s")
+        Log.d(LOG_TAG, "  - Min: $minVal, Max: $maxVal")
+        Log.d(LOG_TAG, "  - Avg absolute: $avgAbs")
+        Log.d(LOG_TAG, "  - Non-zero samples: $nonZeroCount (${(nonZeroCount * 100f / audioData.size)}%)")
+        
+        if (avgAbs < 0.001f) {
+            Log.w(LOG_TAG, "WARNING: Audio appears to be silent or very quiet!")
+        }
+        
+        val audioCtx = if (_state.value.adaptiveAudioContext) {
+            WhisperContext.AUDIO_CTX_ADAPTIVE
+        } else {
+            WhisperContext.AUDIO_CTX_FULL
+        }
+        return runTranscription(durationMs) { context, schedule, onSegment ->
+            context.transcribeWithSegments(audioData, melCache, melStream, audioCtx, schedule, onSegment)
+        }
+    }
+    
+    /**
+     * Mel cache file for a stored recording, or null when caching is off
+     */
+    private fun melCacheFor(appointmentId: String): File? =
+        if (_state.value.cacheMelSpectrogram) storage.getMelCacheFile(appointmentId) else null
+    
+    /**
+     * Transcribe in one pass on the thread budget the scheduler allows now
+     * 
+     * The mel from capture or the cache covers the whole clip, so the run
+     * isn't split into chunks and the budget is only checked before it.
+     * Segments are extracted as whisper commits them, while it decodes
+     * the next window, so only the last sentence is left at the end.
+     * 
+     * @return true if the transcription was saved
+     */
+    private suspend fun runTranscription(
+        durationMs: Long,
+        transcribe: suspend (
+            WhisperContext,
+            ScheduleDecision,
+            (TranscriptionSegment) -> Unit
+        ) -> List<TranscriptionSegment>
+    ): Boolean {
         try {
-            // Diagnostic: Check audio data quality
-            val minVal = audioData.minOrNull() ?: 0f
-            val maxVal = audioData.maxOrNull() ?: 0f
-            val avgAbs = audioData.map { kotlin.math.abs(it) }.average()
-            val nonZeroCount = audioData.count { it != 0f }
-            
-            Log.d(LOG_TAG, "Audio diagnostics:")
-            Log.d(LOG_TAG, "  - Samples: ${audioData.size}")
-            Log.d(LOG_TAG, "  - Duration: ${audioData.size / 16000f}s")
-            Log.d(LOG_TAG, "  - Min: $minVal, Max: $maxVal")
-            Log.d(LOG_TAG, "  - Avg absolute: $avgAbs")
-            Log.d(LOG_TAG, "  - Non-zero samples: $nonZeroCount (${(nonZeroCount * 100f / audioData.size)}%)")
-            
-            if (avgAbs < 0.001f) {
-                Log.w(LOG_TAG, "WARNING: Audio appears to be silent or very quiet!")
-            }
-            
             val context = whisperContext ?: throw IllegalStateException("Model not loaded")
             
-            val segments = withContext(Dispatchers.Default) {
-                context.transcribeWithSegments(audioData)
-            }
-            
-            val fullText = segments.joinToString(" ") { it.text }
-            
-            val transcription = Transcription(
-                fullText = fullText,
-                segments = segments.map { 
-                    TranscriptionSegmentData(it.text, it.startMs, it.endMs) 
+            val extractor = IncrementalExtractor((durationMs / 1000).toInt())
+            val (segments, extraction) = withContext(Dispatchers.Default) {
+                val committed = Channel<TranscriptionSegment>(Channel.UNLIMITED)
+                val extracting = launch {
+                    for (segment in committed) {
+                        extractor.addSegment(TranscriptionSegmentData(segment.text, segment.startMs, segment.endMs))
+                    }
                 }
-            )
-            
-            // Extract medical info using schema-guided extraction
-            // (Calgary-Cambridge model aligned, no inference, exact phrases only)
-            val extraction = SchemaGuidedExtractor.extract(
-                transcript = fullText,
-                recordingDurationSeconds = (durationMs / 1000).toInt()
-            )
-            
-            // Update appointment
-            val updatedAppointment = _state.value.currentAppointment?.copy(
-                transcription = transcription,
-                extraction = extraction,
-                durationMs = durationMs,
-                status = AppointmentStatus.PROCESSED
-            )
+                val segments = try {
+                    transcribe(context, scheduler.awaitSlot(0)) { committed.trySend(it) }
+                } finally {
+                    committed.close()
+                }
+                extracting.join()
+                segments.map { TranscriptionSegmentData(it.text, it.startMs, it.endMs) } to extractor.finish()
+            }
+            val timings = context.getTimings()
+            Log.d(LOG_TAG, "Transcription timings: $timings")
+            Log.d(LOG_TAG, "Extraction ${extractor.timings}")
             
-            if (updatedAppointment != null) {
-                storage.saveAppointment(updatedAppointment)
+            val updatedAppointment = _state.value.currentAppointment?.let { appointment ->
+                applyTranscription(appointment, segments, durationMs, extraction)
             }
             
             _state.update { 
                 it.copy(
                     isTranscribing = false,
-                    currentAppointment = updatedAppointment
+                    currentAppointment = updatedAppointment,
+                    lastTranscriptionTimings = timings
                 ) 
             }
             
             loadAppointments()
             
-            Log.d(LOG_TAG, "Transcription complete: ${fullText.length} chars")
+            if (updatedAppointment != null && _state.value.compressAudioArchive) {
+                archiveRecording(updatedAppointment)
+            }
+            return true
             
         } catch (e: Exception) {
             Log.e(LOG_TAG, "Transcription failed", e)
@@ -607,23 +764,235 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
                     errorMessage = "Transcription failed: ${e.message}"
                 ) 
             }
+            return false
+        }
+    }
+    
+    /**
+     * Save a finished transcription and its extraction to the appointment
+     * 
+     * Every path extracts as segments are committed, so the extraction is
+     * ready when the transcription ends and is only saved here.
+     */
+    private suspend fun applyTranscription(
+        appointment: Appointment,
+        segments: List<TranscriptionSegmentData>,
+        durationMs: Long,
+        extraction: MedicalExtraction
+    ): Appointment {
+        val fullText = segments.joinToString(Transcription.SEGMENT_SEPARATOR) { it.text }
+        
+        val transcription = Transcription(
+            fullText = fullText,
+            segments = segments
+        )
+        
+        val updatedAppointment = appointment.copy(
+            transcription = transcription,
+            extraction = extraction,
+            durationMs = durationMs,
+            status = AppointmentStatus.PROCESSED
+        )
+        withContext(Dispatchers.IO) {
+            storage.saveAppointment(updatedAppointment)
+        }
+        
+        Log.d(LOG_TAG, "Transcription complete: ${fullText.length} chars")
+        return updatedAppointment
+    }
+    
+    // ========================================================================
+    // Background Queue
+    // ========================================================================
+    
+    /**
+     * Start the background queue on the loaded model, resuming any jobs a
+     * previous run didn't finish
+     */
+    private suspend fun startTranscriptionQueue(context: WhisperContext) {
+        transcriptionQueue?.stop()
+        statePool?.release()
+        
+        val pool = StatePool.create(context, size = 1)
+        val queue = TranscriptionQueue(pool, jobStorage, viewModelScope, scheduler) { job, durationMs, extraction ->
+            onQueuedTranscription(job, durationMs, extraction)
+        }
+        statePool = pool
+        transcriptionQueue = queue
+        
+        val resumed = queue.start()
+        _state.update { it.copy(pendingTranscriptionJobs = resumed) }
+    }
+    
+    private suspend fun enqueueTranscription(job: TranscriptionJob): Boolean {
+        val queue = transcriptionQueue ?: return false
+        queue.enqueue(job)
+        _state.update { it.copy(pendingTranscriptionJobs = it.pendingTranscriptionJobs + 1) }
+        return true
+    }
+    
+    private suspend fun onQueuedTranscription(job: TranscriptionJob, durationMs: Long, extraction: MedicalExtraction) {
+        val appointment = withContext(Dispatchers.IO) {
+            storage.loadAppointment(job.appointmentId)
+        }
+        if (appointment == null) {
+            Log.w(LOG_TAG, "Appointment ${job.appointmentId} was deleted, dropping its transcription")
+        } else {
+            val updated = applyTranscription(appointment, job.segments, durationMs, extraction)
+            if (_state.value.currentAppointment?.id == updated.id) {
+                _state.update { it.copy(currentAppointment = updated) }
+            }
+            if (_state.value.compressAudioArchive) {
+                archiveRecording(updated)
+            }
+            loadAppointments()
+        }
+        _state.update { it.copy(pendingTranscriptionJobs = (it.pendingTranscriptionJobs - 1).coerceAtLeast(0)) }
+    }
+    
+    /**
+     * Compress a transcribed recording in the background
+     * 
+     * Runs after transcription so encoding never delays the result. Once
+     * the archive is verified, the appointment as it is stored now (it may
+     * have changed while encoding) is re-saved pointing at it, and only
+     * then is the WAV deleted.
+     */
+    private fun archiveRecording(appointment: Appointment) {
+        val wavFile = appointment.audioFilePath?.let { File(it) } ?: return
+        if (!wavFile.exists() || AudioArchive.isArchive(wavFile)) return
+        
+        viewModelScope.launch {
+            val archived = withContext(Dispatchers.IO) {
+                val archiveFile = AudioArchive.compress(wavFile) ?: return@withContext null
+                val current = storage.loadAppointment(appointment.id)
+                if (current == null) {
+                    // Deleted while encoding
+                    archiveFile.delete()
+                    return@withContext null
+                }
+                val archived = current.copy(audioFilePath = archiveFile.absolutePath)
+                if (!storage.saveAppointment(archived)) return@withContext null
+                if (!wavFile.delete()) {
+                    Log.w(LOG_TAG, "Archived ${wavFile.name} but couldn't delete the original")
+                }
+                archived
+            } ?: return@launch
+            
+            _state.update { state ->
+                val current = state.currentAppointment
+                if (current?.id == archived.id) {
+                    state.copy(currentAppointment = current.copy(audioFilePath = archived.audioFilePath))
+                } else state
+            }
+        }
+    }
+    
+    /**
+     * Enable or disable background compression of new recordings
+     */
+    fun setAudioCompression(enabled: Boolean) {
+        _state.update { it.copy(compressAudioArchive = enabled) }
+    }
+    
+    /**
+     * Enable or disable the reduced encoder window for short clips
+     */
+    fun setAdaptiveAudioContext(enabled: Boolean) {
+        _state.update { it.copy(adaptiveAudioContext = enabled) }
+    }
+    
+    /**
+     * Change the load-time model options, e.g. flash attention. They are
+     * applied the next time the model is loaded.
+     */
+    fun setModelOptions(options: ModelOptions) {
+        _state.update { it.copy(modelOptions = options) }
+    }
+    
+    /**
+     * Change the decoding strategy, e.g. [DecodingParams.FAST] on slow devices
+     */
+    fun setDecodingParams(params: DecodingParams) {
+        _state.update { it.copy(decodingParams = params) }
+        viewModelScope.launch { applyDecodingParams() }
+    }
+    
+    private suspend fun applyDecodingParams() {
+        val context = whisperContext ?: return
+        val params = _state.value.decodingParams ?: DecodingParams.forDevice()
+        context.setDecodingParams(params)
+        _state.update { it.copy(decodingParams = params) }
+        Log.d(LOG_TAG, "Decoding params: $params")
+    }
+    
+    /**
+     * Enable or disable prompting the transcriber with medication names
+     */
+    fun setMedicalVocabularyPrompt(enabled: Boolean) {
+        _state.update { it.copy(medicalVocabularyPrompt = enabled) }
+        viewModelScope.launch { applyVocabularyPrompt() }
+    }
+    
+    private suspend fun applyVocabularyPrompt() {
+        val context = whisperContext ?: return
+        if (_state.value.medicalVocabularyPrompt) {
+            val tokens = context.setVocabularyPrompt(SchemaGuidedExtractor.medicationVocabulary)
+            Log.d(LOG_TAG, "Medical vocabulary prompt: $tokens tokens")
+        } else {
+            context.clearVocabularyPrompt()
         }
     }
     
     /**
-     * Transcribe an existing audio file
+     * Enable or disable the per-recording log-mel cache
+     */
+    fun setMelCache(enabled: Boolean) {
+        _state.update { it.copy(cacheMelSpectrogram = enabled) }
+    }
+    
+    /**
+     * Transcribe an existing audio file (WAV or compressed archive)
      */
     fun transcribeFile(file: File) {
         viewModelScope.launch {
             _state.update { it.copy(isTranscribing = true) }
             
+            // Stored recordings are re-transcribed in the background queue
+            val isStored = file.parentFile == storage.getAudioDirectory()
+            if (isStored) {
+                val job = TranscriptionJob(
+                    appointmentId = file.nameWithoutExtension,
+                    audioPath = file.absolutePath,
+                    priority = JobPriority.BACKLOG
+                )
+                if (enqueueTranscription(job)) {
+                    _state.update { it.copy(isTranscribing = false) }
+                    return@launch
+                }
+            }
+            
+            // Only stored recordings get a cache entry
+            val melCache = if (isStored) melCacheFor(file.nameWithoutExtension) else null
+            
             try {
+                if (AudioArchive.isArchive(file)) {
+                    // Decoded natively straight into whisper
+                    val duration = withContext(Dispatchers.IO) {
+                        WaveHelper.getDuration(AudioArchive.sampleCount(file).toInt()) * 1000
+                    }
+                    runTranscription(duration.toLong()) { context, schedule, onSegment ->
+                        context.transcribeArchiveWithSegments(file, melCache, schedule, onSegment)
+                    }
+                    return@launch
+                }
+                
                 val audioData = withContext(Dispatchers.IO) {
                     WaveHelper.decodeWaveFile(file)
                 }
                 
                 val duration = WaveHelper.getDuration(audioData.size) * 1000
-                transcribeAudio(audioData, duration.toLong())
+                transcribeAudio(audioData, duration.toLong(), melCache)
                 
             } catch (e: Exception) {
                 Log.e(LOG_TAG, "Failed to transcribe file", e)
@@ -637,6 +1006,73 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
         }
     }
     
+    // ========================================================================
+    // Archive Re-transcription
+    // ========================================================================
+    
+    /**
+     * Re-transcribe every stored recording with the loaded model, e.g.
+     * after a model update, replacing each appointment's transcription
+     * and extraction
+     * 
+     * The batch splits the shared scheduler's budget between its [workers],
+     * so the background queue is stopped meanwhile and resumes its
+     * persisted jobs afterwards.
+     */
+    fun retranscribeArchive(workers: Int = ARCHIVE_WORKERS) {
+        val context = whisperContext ?: return
+        if (_state.value.isBatchTranscribing) return
+        
+        viewModelScope.launch {
+            _state.update { it.copy(isBatchTranscribing = true, batchProgress = 0f) }
+            val queue = transcriptionQueue
+            queue?.stop()
+            try {
+                val items = withContext(Dispatchers.IO) {
+                    storage.loadAllAppointments().mapNotNull { appointment ->
+                        storage.findAudioFile(appointment.id)?.let { BatchItem(appointment.id, it) }
+                    }
+                }
+                
+                val batch = BatchTranscriber(context, scheduler, workers) { item, segments, durationMs, extraction ->
+                    onBatchTranscription(item, segments, durationMs, extraction)
+                }
+                val report = batch.run(items) { done, total ->
+                    _state.update { it.copy(batchProgress = done.toFloat() / total) }
+                }
+                
+                _state.update { it.copy(lastBatchReport = report) }
+                loadAppointments()
+                
+            } catch (e: Exception) {
+                Log.e(LOG_TAG, "Archive re-transcription failed", e)
+                _state.update { it.copy(errorMessage = "Re-transcription failed: ${e.message}") }
+            } finally {
+                _state.update { it.copy(isBatchTranscribing = false) }
+                if (isActive && queue != null && queue === transcriptionQueue) {
+                    val resumed = queue.start()
+                    _state.update { it.copy(pendingTranscriptionJobs = resumed) }
+                }
+            }
+        }
+    }
+    
+    private suspend fun onBatchTranscription(
+        item: BatchItem,
+        segments: List<TranscriptionSegmentData>,
+        durationMs: Long,
+        extraction: MedicalExtraction
+    ) {
+        val appointment = withContext(Dispatchers.IO) {
+            storage.loadAppointment(item.appointmentId)
+        } ?: return
+        
+        val updated = applyTranscription(appointment, segments, durationMs, extraction)
+        if (_state.value.currentAppointment?.id == updated.id) {
+            _state.update { it.copy(currentAppointment = updated) }
+        }
+    }
+    
     // ========================================================================
     // Appointments
     // ========================================================================
@@ -683,8 +1119,23 @@ class MainViewModel(application: Application) : AndroidViewModel(application) {
         _state.update { it.copy(errorMessage = null, modelError = null) }
     }
     
+    /**
+     * Free the model's compute buffers when the system runs low on memory
+     * or the app leaves the foreground; the weights stay loaded, so the
+     * next transcription only pays for re-allocating them
+     */
+    fun onTrimMemory(level: Int) {
+        if (level < ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW) return
+        val context = whisperContext ?: return
+        viewModelScope.launch {
+            context.trimMemory()
+            Log.d(LOG_TAG, "onTrimMemory($level): ${context.memoryStats}")
+        }
+    }
+    
     override fun onCleared() {
         super.onCleared()
+        transcriptionQueue?.stop()
         viewModelScope.launch {
             whisperContext?.release()
         }
@@ -0,0 +1,176 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import android.os.SystemClock
+import android.util.Log
+import com.example.medicalappointmentcompanion.audio.AudioArchive
+import com.example.medicalappointmentcompanion.audio.WHISPER_SAMPLE_RATE
+import com.example.medicalappointmentcompanion.extraction.IncrementalExtractor
+import com.example.medicalappointmentcompanion.model.MedicalExtraction
+import com.example.medicalappointmentcompanion.model.TranscriptionSegmentData
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+import java.io.File
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+import kotlin.coroutines.cancellation.CancellationException
+
+private const val LOG_TAG = "BatchTranscriber"
+
+/**
+ * Re-transcription of the whole appointment archive, e.g. after a model
+ * update
+ *
+ * Recordings are handed to up to [workers] sessions of a [StatePool]
+ * sharing the loaded model. A recording is decoded whole when a worker
+ * picks it up and dropped once it is transcribed, so at most [workers]
+ * recordings are in memory at a time, never the whole archive. Before
+ * every 30 s chunk a worker asks the app's shared [scheduler] for its
+ * share of the thread budget, and waits while the budget has no room
+ * for it.
+ *
+ * Results are handed to [onRecording], which saves them; nothing is
+ * written here. Extraction keeps up chunk by chunk, so each recording's
+ * is ready with its transcription.
+ */
+class BatchTranscriber(
+    private val context: WhisperContext,
+    private val scheduler: TranscriptionScheduler,
+    private val workers: Int = scheduler.maxConcurrency,
+    private val onRecording: suspend (BatchItem, List<TranscriptionSegmentData>, Long, MedicalExtraction) -> Unit
+) {
+
+    /**
+     * Transcribe every item, calling [onProgress] with (done, total)
+     * after each recording
+     */
+    suspend fun run(
+        items: List<BatchItem>,
+        onProgress: (Int, Int) -> Unit = { _, _ -> }
+    ): BatchReport {
+        if (items.isEmpty()) return BatchReport(0, 0, 0, 0, 0)
+
+        val start = SystemClock.elapsedRealtime()
+        val queue = Channel<BatchItem>(Channel.UNLIMITED).apply {
+            items.forEach { trySend(it) }
+            close()
+        }
+        val done = AtomicInteger()
+        val failed = AtomicInteger()
+        val audioMs = AtomicLong()
+        val throttledMs = AtomicLong()
+
+        val pool = StatePool.create(
+            context,
+            size = minOf(workers, items.size),
+            totalThreads = scheduler.maxThreads
+        )
+        try {
+            coroutineScope {
+                repeat(pool.size) { worker ->
+                    launch(Dispatchers.Default) {
+                        for (item in queue) {
+                            try {
+                                val durationMs = pool.withSession { session ->
+                                    transcribe(item, session) {
+                                        val waitStart = SystemClock.elapsedRealtime()
+                                        scheduler.awaitSlot(worker, pool.size).also {
+                                            throttledMs.addAndGet(SystemClock.elapsedRealtime() - waitStart)
+                                        }
+                                    }
+                                }
+                                audioMs.addAndGet(durationMs)
+                            } catch (e: CancellationException) {
+                                throw e
+                            } catch (e: Exception) {
+                                Log.e(LOG_TAG, "Failed to re-transcribe ${item.appointmentId}", e)
+                                failed.incrementAndGet()
+                            }
+                            onProgress(done.incrementAndGet(), items.size)
+                        }
+                    }
+                }
+            }
+        } finally {
+            withContext(NonCancellable) { pool.release() }
+        }
+
+        val report = BatchReport(
+            recordings = items.size - failed.get(),
+            failed = failed.get(),
+            audioMs = audioMs.get(),
+            wallMs = SystemClock.elapsedRealtime() - start,
+            throttledMs = throttledMs.get()
+        )
+        Log.d(LOG_TAG, report.toString())
+        return report
+    }
+
+    /**
+     * @return Duration of the recording in ms
+     */
+    private suspend fun transcribe(
+        item: BatchItem,
+        session: TranscriptionSession,
+        awaitSchedule: suspend () -> ScheduleDecision
+    ): Long {
+        val samples = withContext(Dispatchers.IO) { AudioArchive.decodeRecording(item.audio) }
+        val durationMs = samples.size * 1000L / WHISPER_SAMPLE_RATE
+        val segments = mutableListOf<TranscriptionSegmentData>()
+        val extractor = IncrementalExtractor((durationMs / 1000).toInt())
+
+        var committedMs = 0L
+        while (committedMs < durationMs) {
+            val schedule = awaitSchedule()
+            val step = session.transcribeFrom(samples, committedMs, schedule = schedule)
+            Log.d(LOG_TAG, "${item.appointmentId} chunk at $committedMs ms: ${session.getTimings()}")
+            for (segment in step.segments) {
+                val committed = TranscriptionSegmentData(segment.text, segment.startMs, segment.endMs)
+                segments += committed
+                extractor.addSegment(committed)
+            }
+            committedMs = step.committedMs
+        }
+
+        val extraction = extractor.finish()
+        Log.d(LOG_TAG, "${item.appointmentId} ${extractor.timings}")
+        onRecording(item, segments, durationMs, extraction)
+        return durationMs
+    }
+}
+
+/**
+ * A stored recording to re-transcribe
+ */
+data class BatchItem(
+    val appointmentId: String,
+    val audio: File
+)
+
+/**
+ * Outcome of a [BatchTranscriber] run
+ */
+data class BatchReport(
+    val recordings: Int,
+    val failed: Int,
+    val audioMs: Long,
+    val wallMs: Long,
+    val throttledMs: Long
+) {
+    /** Throughput: hours of audio transcribed per hour of wall time */
+    val audioHoursPerWallHour: Float
+        get() = if (wallMs > 0) audioMs.toFloat() / wallMs else 0f
+
+    override fun toString(): String = String.format(
+        "Batch: %d recordings (%d failed), %.2f h audio in %.1f min, %.1f audio-h/wall-h, %.0f s thermal pauses",
+        recordings,
+        failed,
+        audioMs / 3_600_000f,
+        wallMs / 60_000f,
+        audioHoursPerWallHour,
+        throttledMs / 1000f
+    )
+}
@@ -0,0 +1,98 @@
+package com.example.medicalappointmentcompanion.whisper
+
+/**
+ * Sampling strategy of the whisper decoder
+ */
+enum class SamplingStrategy(internal val nativeValue: Int) {
+    GREEDY(0),
+    BEAM_SEARCH(1)
+}
+
+/**
+ * Decoding strategy for whisper_full, set once per context with
+ * [WhisperContext.setDecodingParams]
+ *
+ * When a window's output fails the entropy or log-probability threshold
+ * whisper re-decodes it at temperature + [temperatureIncrement], up to
+ * 1.0. Each re-decode costs roughly a full decode of the window, so the
+ * thresholds and [temperatureFallback] are the main latency/accuracy knob.
+ * The number of re-decodes is reported in [TranscriptionTimings.fallbacks].
+ * The presets are mirrored natively in decoding.cpp for batch_transcribe.
+ *
+ * @param bestOf Candidates sampled per fallback attempt (greedy only)
+ * @param beamSize Beam width (beam search only)
+ * @param entropyThreshold Re-decode when token entropy falls below this (repetition)
+ * @param logprobThreshold Re-decode when the average log probability falls below this
+ * @param noSpeechThreshold Treat a window as silence above this no-speech probability
+ * @param maxSegmentLength Split segments longer than this many characters; 0 = no limit
+ * @param tokenDetails Return each segment's tokens with their probabilities
+ * @param tokenTimestamps Also time each token. Times come from the audio
+ *        itself, so these runs recompute the mel instead of using the cache;
+ *        implied by [maxSegmentLength]
+ * @param language Spoken language code, or null to auto-detect
+ */
+data class DecodingParams(
+    val strategy: SamplingStrategy = SamplingStrategy.GREEDY,
+    val bestOf: Int = 5,
+    val beamSize: Int = 5,
+    val temperature: Float = 0f,
+    val temperatureIncrement: Float = 0.2f,
+    val temperatureFallback: Boolean = true,
+    val entropyThreshold: Float = 2.8f,
+    val logprobThreshold: Float = -1.5f,
+    val noSpeechThreshold: Float = 0.3f,
+    val maxSegmentLength: Int = 0,
+    val tokenDetails: Boolean = false,
+    val tokenTimestamps: Boolean = false,
+    val language: String? = "en"
+) {
+    init {
+        require(bestOf >= 1) { "bestOf must be at least 1" }
+        require(beamSize >= 1) { "beamSize must be at least 1" }
+        require(temperature in 0f..1f) { "temperature must be in [0, 1]" }
+        require(!temperatureFallback || temperatureIncrement > 0f) {
+            "temperatureIncrement must be positive when fallback is enabled"
+        }
+        require(maxSegmentLength >= 0) { "maxSegmentLength must not be negative" }
+    }
+    
+    companion object {
+        /**
+         * Lowest latency: single greedy pass, never re-decoded
+         */
+        val FAST = DecodingParams(
+            bestOf = 1,
+            temperatureFallback = false
+        )
+        
+        /**
+         * Greedy with fallback and thresholds relaxed for quiet audio;
+         * the app's long-standing default
+         */
+        val BALANCED = DecodingParams()
+        
+        /**
+         * Beam search with whisper's stock thresholds, which trigger
+         * fallback more readily
+         */
+        val ACCURATE = DecodingParams(
+            strategy = SamplingStrategy.BEAM_SEARCH,
+            entropyThreshold = 2.4f,
+            logprobThreshold = -1.0f,
+            noSpeechThreshold = 0.6f
+        )
+        
+        /**
+         * Preset for a device with the given number of high-performance
+         * cores: re-decodes are skipped where a decode pass is already slow
+         */
+        fun forDevice(highPerfCores: Int = WhisperCpuConfig.preferredThreadCount): DecodingParams =
+            if (highPerfCores <= 2) FAST else BALANCED
+    }
+}
+
+/**
+ * Temperature step passed to whisper; 0 turns fallback off
+ */
+internal val DecodingParams.nativeTemperatureIncrement: Float
+    get() = if (temperatureFallback) temperatureIncrement else 0f
@@ -0,0 +1,27 @@
+package com.example.medicalappointmentcompanion.whisper
+
+/**
+ * Load-time options of a [WhisperContext]; changing them means loading
+ * the model again
+ *
+ * whisper.cpp only exposes the attention implementation at load time: the
+ * KV cache is always F16 and sized to the model's text context. What it
+ * holds per transcription is set by [DecodingParams] (one sequence per
+ * beam or best-of candidate) and by the encoder window (audio_ctx).
+ *
+ * @param flashAttention Run attention as ggml's fused flash-attention
+ *        kernel, which streams the KV cache once per decoder step instead
+ *        of materialising the whole attention matrix. Cuts memory traffic
+ *        and the compute buffers' peak size, most with beam search and
+ *        long windows. Compare with `WhisperBenchmarkTest` on the target
+ *        device before changing the default.
+ */
+data class ModelOptions(
+    val flashAttention: Boolean = false
+) {
+    override fun toString(): String = if (flashAttention) "flash-attn" else "default"
+
+    companion object {
+        val DEFAULT = ModelOptions()
+    }
+}
@@ -0,0 +1,53 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Decoder for the packed result buffer built by the native result_pack()
+ *
+ * Layout (little-endian, 32-bit fields, times in 10 ms units):
+ * header `n_segments | n_tokens | text_bytes | flags`, then the segment
+ * table, the token table and finally the UTF-8 text the tables point into.
+ */
+internal object PackedResults {
+    
+    private const val HEADER_BYTES = 4 * 4
+    private const val SEGMENT_BYTES = 6 * 4
+    private const val TOKEN_BYTES = 6 * 4
+    
+    fun decode(packed: ByteArray): List<TranscriptionSegment> {
+        val buffer = ByteBuffer.wrap(packed).order(ByteOrder.LITTLE_ENDIAN)
+        val segmentCount = buffer.getInt(0)
+        val tokenCount = buffer.getInt(4)
+        
+        val tokensAt = HEADER_BYTES + segmentCount * SEGMENT_BYTES
+        val textAt = tokensAt + tokenCount * TOKEN_BYTES
+        
+        fun text(offset: Int, length: Int) = String(packed, textAt + offset, length, Charsets.UTF_8)
+        
+        val tokens = (0 until tokenCount).map { k ->
+            val at = tokensAt + k * TOKEN_BYTES
+            val t0 = buffer.getInt(at + 8)
+            val t1 = buffer.getInt(at + 12)
+            TranscriptionToken(
+                id = buffer.getInt(at),
+                text = text(buffer.getInt(at + 16), buffer.getInt(at + 20)),
+                probability = buffer.getFloat(at + 4),
+                startMs = if (t0 >= 0) t0 * 10L else -1L,
+                endMs = if (t1 >= 0) t1 * 10L else -1L
+            )
+        }
+        
+        return (0 until segmentCount).map { i ->
+            val at = HEADER_BYTES + i * SEGMENT_BYTES
+            val firstToken = buffer.getInt(at + 16)
+            TranscriptionSegment(
+                text = text(buffer.getInt(at + 8), buffer.getInt(at + 12)),
+                startMs = buffer.getInt(at) * 10L,
+                endMs = buffer.getInt(at + 4) * 10L,
+                tokens = tokens.subList(firstToken, firstToken + buffer.getInt(at + 20))
+            )
+        }
+    }
+}
@@ -0,0 +1,59 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import kotlinx.coroutines.channels.Channel
+
+/**
+ * Fixed set of transcription sessions sharing one loaded model
+ *
+ * Each session has its own whisper state and thread, so up to [size]
+ * recordings decode in parallel without loading the model again. The
+ * CPU threads are split evenly between the sessions.
+ */
+class StatePool private constructor(
+    private val sessions: List<TranscriptionSession>,
+    val threadsPerSession: Int
+) {
+
+    private val idle = Channel<TranscriptionSession>(Channel.UNLIMITED).apply {
+        sessions.forEach { trySend(it) }
+    }
+
+    val size: Int get() = sessions.size
+
+    /**
+     * Run [block] on a freshly reset session, waiting for one to be free
+     */
+    suspend fun <T> withSession(block: suspend (TranscriptionSession) -> T): T {
+        val session = idle.receive()
+        try {
+            session.reset()
+            return block(session)
+        } finally {
+            idle.trySend(session)
+        }
+    }
+
+    /**
+     * Release every session; the pool can't be used afterwards
+     */
+    suspend fun release() {
+        idle.close()
+        sessions.forEach { it.release() }
+    }
+
+    companion object {
+        /**
+         * Create [size] sessions on [context], dividing [totalThreads]
+         * between them
+         */
+        suspend fun create(
+            context: WhisperContext,
+            size: Int,
+            totalThreads: Int = WhisperCpuConfig.preferredThreadCount
+        ): StatePool {
+            require(size >= 1) { "StatePool needs at least one session" }
+            val sessions = List(size) { context.createSession() }
+            return StatePool(sessions, (totalThreads / size).coerceAtLeast(1))
+        }
+    }
+}
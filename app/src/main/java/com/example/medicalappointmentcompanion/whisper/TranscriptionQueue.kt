@@ -0,0 +1,204 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import android.util.Log
+import com.example.medicalappointmentcompanion.audio.AudioArchive
+import com.example.medicalappointmentcompanion.audio.WHISPER_SAMPLE_RATE
+import com.example.medicalappointmentcompanion.extraction.IncrementalExtractor
+import com.example.medicalappointmentcompanion.model.JobPriority
+import com.example.medicalappointmentcompanion.model.MedicalExtraction
+import com.example.medicalappointmentcompanion.model.TranscriptionJob
+import com.example.medicalappointmentcompanion.model.TranscriptionSegmentData
+import com.example.medicalappointmentcompanion.storage.JobStorage
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import java.io.File
+import kotlin.coroutines.cancellation.CancellationException
+
+private const val LOG_TAG = "TranscriptionQueue"
+
+/**
+ * Persistent background transcription queue on a [StatePool]
+ *
+ * Jobs are written to [JobStorage] before they are scheduled, and every
+ * committed chunk is appended to them, so pending work survives failures
+ * and process restarts ([start]) and long recordings resume from the last
+ * committed chunk, prompted with the text committed before it.
+ * Each worker takes the highest-priority job; a backlog job yields its
+ * session between chunks when a fresh recording is waiting. With a
+ * [scheduler], each chunk runs on the thread budget it allows.
+ *
+ * Extraction runs alongside, one chunk's segments at a time, so
+ * [onComplete] gets the finished extraction with the transcription.
+ */
+class TranscriptionQueue(
+    private val pool: StatePool,
+    private val jobStorage: JobStorage,
+    private val scope: CoroutineScope,
+    private val scheduler: TranscriptionScheduler? = null,
+    private val onComplete: suspend (TranscriptionJob, Long, MedicalExtraction) -> Unit
+) {
+
+    private val lock = Mutex()
+    private val pending = mutableListOf<TranscriptionJob>()   // guarded by lock
+    private val wakeups = Channel<Unit>(Channel.UNLIMITED)
+    private var workers: List<Job> = emptyList()
+
+    /**
+     * Reload persisted jobs and start the workers
+     *
+     * @return Number of jobs resumed
+     */
+    suspend fun start(): Int {
+        val restored = withContext(Dispatchers.IO) { jobStorage.loadAllJobs() }
+            .filterNot { it.failed }
+        lock.withLock { restored.forEach { putPending(it) } }
+        restored.forEach { _ -> wakeups.trySend(Unit) }
+
+        workers = List(pool.size) { index -> scope.launch(Dispatchers.Default) { workLoop(index) } }
+        if (restored.isNotEmpty()) {
+            Log.d(LOG_TAG, "Resumed ${restored.size} jobs")
+        }
+        return restored.size
+    }
+
+    /**
+     * Persist a job and schedule it
+     */
+    suspend fun enqueue(job: TranscriptionJob) {
+        withContext(Dispatchers.IO) { jobStorage.saveJob(job) }
+        lock.withLock { putPending(job) }
+        wakeups.trySend(Unit)
+        Log.d(LOG_TAG, "Queued ${job.priority} job for ${job.appointmentId}")
+    }
+
+    /**
+     * Number of jobs waiting for a session
+     */
+    suspend fun pendingCount(): Int = lock.withLock { pending.size }
+
+    /**
+     * Stop the workers; jobs in flight stay persisted and resume on [start]
+     */
+    fun stop() {
+        workers.forEach { it.cancel() }
+        workers = emptyList()
+    }
+
+    private suspend fun workLoop(worker: Int) {
+        while (scope.isActive) {
+            val job = takeNext()
+            if (job == null) {
+                wakeups.receive()
+                continue
+            }
+            try {
+                pool.withSession { session -> run(job, session, worker) }
+            } catch (e: CancellationException) {
+                throw e
+            } catch (e: Exception) {
+                fail(job, e)
+            }
+        }
+    }
+
+    // Add or replace a job by id, so a job is never queued twice; guarded by lock
+    private fun putPending(job: TranscriptionJob) {
+        pending.removeAll { it.id == job.id }
+        pending.add(job)
+    }
+
+    private suspend fun takeNext(): TranscriptionJob? = lock.withLock {
+        pending.minWithOrNull(compareBy({ it.priority.ordinal }, { it.createdAt }))
+            ?.also { pending.remove(it) }
+    }
+
+    private suspend fun hasWaitingAbove(priority: JobPriority): Boolean = lock.withLock {
+        pending.any { it.priority < priority }
+    }
+
+    private suspend fun run(job: TranscriptionJob, session: TranscriptionSession, worker: Int) {
+        job.decodingParams?.let { session.setDecodingParams(it) }
+
+        val samples = withContext(Dispatchers.IO) { AudioArchive.decodeRecording(File(job.audioPath)) }
+        val durationMs = samples.size * 1000L / WHISPER_SAMPLE_RATE
+        var committedMs = job.committedMs
+        val segments = job.segments.toMutableList()
+
+        // Catch up on segments committed before a pause or restart, and
+        // prompt the reset session with their text
+        val extractor = IncrementalExtractor((durationMs / 1000).toInt())
+        segments.forEach { extractor.addSegment(it) }
+        if (segments.isNotEmpty()) {
+            session.restoreContext(promptTail(segments))
+        }
+
+        while (committedMs < durationMs) {
+            val schedule = scheduler?.awaitSlot(worker)
+            val step = session.transcribeFrom(samples, committedMs, pool.threadsPerSession, schedule)
+            Log.d(LOG_TAG, "${job.appointmentId} chunk at $committedMs ms: ${session.getTimings()}")
+            val committed = step.segments.map { TranscriptionSegmentData(it.text, it.startMs, it.endMs) }
+            committedMs = step.committedMs
+            segments += committed
+            withContext(Dispatchers.IO) { jobStorage.appendChunk(job.id, committedMs, committed) }
+            committed.forEach { extractor.addSegment(it) }
+
+            if (!step.done && hasWaitingAbove(job.priority)) {
+                Log.d(LOG_TAG, "Pausing ${job.appointmentId} at $committedMs ms for a fresh recording")
+                lock.withLock { putPending(job.copy(committedMs = committedMs, segments = segments)) }
+                wakeups.trySend(Unit)
+                return
+            }
+        }
+
+        val current = job.copy(committedMs = committedMs, segments = segments)
+        val extraction = extractor.finish()
+        Log.d(LOG_TAG, "${current.appointmentId} ${extractor.timings}")
+        onComplete(current, durationMs, extraction)
+        withContext(Dispatchers.IO) { jobStorage.deleteJob(current.id) }
+        Log.d(LOG_TAG, "Finished ${current.appointmentId}: ${current.segments.size} segments")
+    }
+
+    private suspend fun fail(job: TranscriptionJob, e: Exception) {
+        // Reload what was committed before the failure
+        val latest = withContext(Dispatchers.IO) {
+            jobStorage.loadAllJobs().firstOrNull { it.id == job.id }
+        } ?: job
+        val attempts = latest.attempts + 1
+        val failed = attempts >= MAX_ATTEMPTS
+        val updated = latest.copy(attempts = attempts, failed = failed, lastError = e.message)
+        withContext(Dispatchers.IO) { jobStorage.saveJob(updated) }
+
+        if (failed) {
+            Log.e(LOG_TAG, "Giving up on ${job.appointmentId} after $attempts attempts", e)
+        } else {
+            Log.w(LOG_TAG, "Job for ${job.appointmentId} failed (attempt $attempts), retrying", e)
+            lock.withLock { putPending(updated) }
+            wakeups.trySend(Unit)
+        }
+    }
+
+    // The committed text a session would still carry; the native side trims
+    // it to the prompt limit
+    private fun promptTail(segments: List<TranscriptionSegmentData>): String {
+        val tail = StringBuilder()
+        for (segment in segments.asReversed()) {
+            if (tail.length >= PROMPT_TAIL_CHARS) break
+            tail.insert(0, segment.text.trimStart()).insert(0, ' ')
+        }
+        return tail.toString()
+    }
+
+    companion object {
+        const val MAX_ATTEMPTS = 3
+
+        // Comfortably more text than fits in whisper's n_text_ctx / 2 prompt
+        private const val PROMPT_TAIL_CHARS = 2000
+    }
+}
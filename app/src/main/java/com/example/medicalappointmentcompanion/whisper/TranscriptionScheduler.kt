@@ -0,0 +1,234 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import android.content.Context
+import android.os.BatteryManager
+import android.os.Build
+import android.os.PowerManager
+import android.os.SystemClock
+import android.util.Log
+import kotlinx.coroutines.delay
+import java.io.File
+
+private const val LOG_TAG = "TranscriptionScheduler"
+
+/**
+ * Thermal- and battery-aware thread budget for long transcriptions
+ *
+ * Running every big core flat out makes the SoC throttle part-way through
+ * a long recording, after which throughput collapses. Between chunks the
+ * queue and the batch transcriber ask [next] for a budget: the scheduler
+ * reads the thermal headroom (0 = cool, 1 = about to throttle hard) and
+ * steps the total thread count down one at a time while headroom is above
+ * [HIGH_WATERMARK], back up once it is below [LOW_WATERMARK], and pauses
+ * at [PAUSE_HEADROOM]. Holding just under the throttling point keeps the
+ * sustained rate higher than bursting into it. A foreground transcription
+ * runs in one pass, so it asks once, before it starts.
+ *
+ * Sessions running in parallel share the budget, so concurrency drops as
+ * the thread count does. One scheduler is shared by everything that
+ * transcribes, so its thermal state covers all of it; a caller running
+ * its own sessions splits the budget between them with [awaitSlot]. On battery below [LOW_BATTERY_PERCENT], or in
+ * battery saver, the budget is capped at half the threads.
+ *
+ * Headroom comes from PowerManager.getThermalHeadroom (Android 11+), the
+ * thermal status (Android 10) or /sys/class/thermal when [context] is null
+ * or neither is available (older devices, Linux hosts).
+ */
+class TranscriptionScheduler(
+    private val context: Context?,
+    val maxThreads: Int = WhisperCpuConfig.preferredThreadCount,
+    val maxConcurrency: Int = 1
+) {
+
+    init {
+        require(maxThreads >= 1) { "TranscriptionScheduler needs at least one thread" }
+        require(maxConcurrency >= 1) { "TranscriptionScheduler needs at least one session" }
+    }
+
+    private var threads = maxThreads                // guarded by this
+    private var lastUpdate = 0L                     // guarded by this
+    private var current = decision(maxThreads, 0f, null, false, "initial")   // guarded by this
+
+    /**
+     * Budget for the next chunk. Re-evaluated at most every
+     * [MIN_INTERVAL_MS]; calls in between return the last decision.
+     */
+    @Synchronized
+    fun next(): ScheduleDecision {
+        val now = SystemClock.elapsedRealtime()
+        if (lastUpdate != 0L && now - lastUpdate < MIN_INTERVAL_MS) {
+            return current
+        }
+        lastUpdate = now
+
+        val headroom = readHeadroom()
+        val battery = readBattery()
+        val powerSave = isPowerSaveMode()
+
+        val reason: String
+        when {
+            headroom.isNaN() -> reason = "no thermal data"
+            headroom >= PAUSE_HEADROOM -> {
+                threads = 0
+                reason = "paused, throttling"
+            }
+            headroom > HIGH_WATERMARK -> {
+                threads = (threads - 1).coerceAtLeast(1)
+                reason = "step down"
+            }
+            headroom < LOW_WATERMARK -> {
+                threads = (threads + 1).coerceAtMost(maxThreads)
+                reason = "step up"
+            }
+            else -> {
+                // Resume from a pause at the lowest level
+                threads = threads.coerceAtLeast(1)
+                reason = "hold"
+            }
+        }
+
+        val onLowBattery = battery != null && !battery.charging && battery.percent <= LOW_BATTERY_PERCENT
+        val cap = if (onLowBattery || powerSave) (maxThreads / 2).coerceAtLeast(1) else maxThreads
+        val budget = threads.coerceAtMost(cap)
+        val capped = when {
+            budget == threads -> reason
+            powerSave -> "$reason, battery saver"
+            else -> "$reason, low battery"
+        }
+
+        val updated = decision(budget, headroom, battery?.percent, battery?.charging ?: false, capped)
+        if (updated.threads != current.threads || updated.concurrency != current.concurrency) {
+            Log.d(LOG_TAG, "Schedule: $updated")
+        }
+        current = updated
+        return updated
+    }
+
+    /**
+     * Wait until the budget has room for session [index] (0-based) of the
+     * [sessions] a caller splits it between, then return the decision it
+     * should run the next chunk with
+     */
+    suspend fun awaitSlot(index: Int, sessions: Int = maxConcurrency): ScheduleDecision {
+        var decision = next().splitBetween(sessions)
+        while (index >= decision.concurrency) {
+            delay(MIN_INTERVAL_MS)
+            decision = next().splitBetween(sessions)
+        }
+        return decision
+    }
+
+    private fun ScheduleDecision.splitBetween(sessions: Int) = copy(concurrency = minOf(sessions, threads))
+
+    private fun decision(threads: Int, headroom: Float, batteryPercent: Int?, charging: Boolean, reason: String) =
+        ScheduleDecision(
+            threads = threads,
+            concurrency = minOf(maxConcurrency, threads),
+            headroom = headroom,
+            batteryPercent = batteryPercent,
+            charging = charging,
+            reason = reason
+        )
+
+    private fun readHeadroom(): Float {
+        val powerManager = context?.getSystemService(PowerManager::class.java)
+        if (powerManager != null) {
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.R) {
+                // NaN when unsupported or polled faster than once a second
+                val headroom = powerManager.getThermalHeadroom(FORECAST_SECONDS)
+                if (!headroom.isNaN()) return headroom
+            }
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+                return statusHeadroom(powerManager.currentThermalStatus)
+            }
+        }
+        return sysfsHeadroom()
+    }
+
+    private fun readBattery(): BatteryState? {
+        val batteryManager = context?.getSystemService(BatteryManager::class.java) ?: return null
+        val percent = batteryManager.getIntProperty(BatteryManager.BATTERY_PROPERTY_CAPACITY)
+        if (percent <= 0) return null
+        return BatteryState(percent, batteryManager.isCharging)
+    }
+
+    private fun isPowerSaveMode(): Boolean =
+        context?.getSystemService(PowerManager::class.java)?.isPowerSaveMode ?: false
+
+    private data class BatteryState(val percent: Int, val charging: Boolean)
+
+    companion object {
+        /** Step the budget down above this headroom... */
+        const val HIGH_WATERMARK = 0.85f
+
+        /** ...and back up below this one */
+        const val LOW_WATERMARK = 0.65f
+
+        /** Pause all sessions at or above this headroom */
+        const val PAUSE_HEADROOM = 1.0f
+
+        const val LOW_BATTERY_PERCENT = 20
+
+        const val MIN_INTERVAL_MS = 2_000L
+
+        private const val FORECAST_SECONDS = 10
+
+        // sysfs fallback: headroom rises linearly from COOL to THROTTLE °C
+        private const val COOL_TEMP_C = 40f
+        private const val THROTTLE_TEMP_C = 85f
+
+        /**
+         * Rough headroom for a PowerManager thermal status
+         */
+        private fun statusHeadroom(status: Int): Float = when (status) {
+            PowerManager.THERMAL_STATUS_NONE -> 0.5f
+            PowerManager.THERMAL_STATUS_LIGHT -> 0.75f
+            PowerManager.THERMAL_STATUS_MODERATE -> 0.9f
+            else -> 1.0f
+        }
+
+        /**
+         * Headroom from the hottest /sys/class/thermal zone, NaN if none
+         * is readable
+         */
+        private fun sysfsHeadroom(): Float {
+            val zones = File("/sys/class/thermal").listFiles { file -> file.name.startsWith("thermal_zone") }
+                ?: return Float.NaN
+            val hottest = zones.mapNotNull { zone ->
+                try {
+                    File(zone, "temp").readText().trim().toInt() / 1000f
+                } catch (e: Exception) {
+                    null
+                }
+            }.maxOrNull() ?: return Float.NaN
+            return ((hottest - COOL_TEMP_C) / (THROTTLE_TEMP_C - COOL_TEMP_C)).coerceAtLeast(0f)
+        }
+    }
+}
+
+/**
+ * Thread budget for the next chunk(s): [threads] in total, split between
+ * up to [concurrency] sessions. Zero threads means wait.
+ */
+data class ScheduleDecision(
+    val threads: Int,
+    val concurrency: Int,
+    val headroom: Float,
+    val batteryPercent: Int?,
+    val charging: Boolean,
+    val reason: String
+) {
+    val isPaused: Boolean get() = threads == 0
+
+    /** Threads for each of the [concurrency] sessions */
+    val threadsPerSession: Int get() = if (concurrency == 0) 0 else threads / concurrency
+
+    override fun toString(): String = String.format(
+        "%d threads x %d sessions, headroom %.2f, battery %s (%s)",
+        threadsPerSession,
+        concurrency,
+        headroom,
+        batteryPercent?.let { "$it%" + if (charging) " charging" else "" } ?: "n/a",
+        reason
+    )
+}
@@ -0,0 +1,195 @@
+package com.example.medicalappointmentcompanion.whisper
+
+import com.example.medicalappointmentcompanion.audio.WHISPER_SAMPLE_RATE
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.withContext
+import java.util.concurrent.Executors
+
+/**
+ * Streaming transcription of one recording in consecutive chunks
+ *
+ * Each chunk is decoded on the session's own whisper state and prompted
+ * with the vocabulary plus the tail of the text decoded so far, so later
+ * chunks don't start cold and drift into fallback re-decodes. Segment
+ * times are relative to the start of the recording. Call [reset] before
+ * reusing the session for a different appointment.
+ *
+ * Sessions only share the model with their [WhisperContext], so each runs
+ * on its own thread, in parallel with the context and other sessions.
+ * Decoding params and vocabulary are taken from the context on creation
+ * and on [reset].
+ */
+class TranscriptionSession internal constructor(
+    private val context: WhisperContext,
+    private var ptr: Long
+) {
+
+    // Single-threaded dispatcher to ensure thread safety
+    private val dispatcher = Executors.newSingleThreadExecutor().asCoroutineDispatcher()
+
+    // Scheduler decision behind the last chunk, reported in getTimings
+    @Volatile
+    private var lastSchedule: ScheduleDecision? = null
+
+    /**
+     * Transcribe the next [length] 16kHz samples of the recording
+     */
+    suspend fun transcribeChunk(
+        samples: FloatArray,
+        length: Int = samples.size,
+        numThreads: Int = WhisperCpuConfig.preferredThreadCount
+    ): List<TranscriptionSegment> = serialized {
+        context.touch()
+        try {
+            if (!WhisperLib.sessionTranscribe(ptr, numThreads, samples, length)) {
+                throw RuntimeException("Failed to transcribe session chunk")
+            }
+
+            PackedResults.decode(WhisperLib.getSessionResults(ptr, context.includeTokens))
+                .filterNot { isBlankSegment(it.text) }
+        } finally {
+            context.touch()
+        }
+    }
+
+    /**
+     * Transcribe the chunk of a whole recording that starts at [fromMs]
+     * 
+     * A segment running into the chunk boundary is likely cut mid-word, so
+     * it is held back and [ChunkStep.committedMs] points at its start; the
+     * next call decodes it again together with the audio that follows.
+     * 
+     * With a [schedule] the chunk runs on its per-session thread count,
+     * and the decision is reported in [getTimings].
+     */
+    suspend fun transcribeFrom(
+        samples: FloatArray,
+        fromMs: Long,
+        numThreads: Int = WhisperCpuConfig.preferredThreadCount,
+        schedule: ScheduleDecision? = null
+    ): ChunkStep {
+        val durationMs = samples.size * 1000L / WHISPER_SAMPLE_RATE
+        val start = (fromMs * WHISPER_SAMPLE_RATE / 1000).toInt()
+        val end = minOf(start + CHUNK_SAMPLES, samples.size)
+        val isLast = end == samples.size
+
+        seek(fromMs)
+        lastSchedule = schedule
+        val segments = transcribeChunk(
+            samples.copyOfRange(start, end),
+            numThreads = schedule?.threadsPerSession?.coerceAtLeast(1) ?: numThreads
+        )
+
+        val cut = segments.lastOrNull()
+            ?.takeIf { !isLast && segments.size > 1 && it.startMs > fromMs }
+        return ChunkStep(
+            segments = if (cut != null) segments.dropLast(1) else segments,
+            committedMs = when {
+                isLast -> durationMs
+                cut != null -> cut.startMs
+                else -> end * 1000L / WHISPER_SAMPLE_RATE
+            },
+            done = isLast
+        )
+    }
+
+    /**
+     * Start the next chunk at [startMs] into the recording, keeping the
+     * carried context (resuming, or re-decoding a cut-off segment)
+     */
+    suspend fun seek(startMs: Long) = serialized {
+        WhisperLib.sessionSeek(ptr, startMs / 10)
+    }
+
+    /**
+     * Carry the already committed [text] into the next chunk, so a
+     * recording resumed on a freshly reset session keeps its prompt
+     */
+    suspend fun restoreContext(text: String) = serialized {
+        WhisperLib.sessionRestoreContext(ptr, text)
+    }
+
+    /**
+     * Drop the carried context, restart segment times at zero and take
+     * the context's current decoding params and vocabulary
+     */
+    suspend fun reset() = serialized {
+        WhisperLib.sessionReset(ptr)
+        lastSchedule = null
+    }
+
+    /**
+     * Decode with [params] instead of the context's until the next [reset]
+     */
+    suspend fun setDecodingParams(params: DecodingParams) = serialized {
+        WhisperLib.sessionSetDecodingParams(
+            ptr,
+            params.strategy.nativeValue,
+            params.bestOf,
+            params.beamSize,
+            params.temperature,
+            params.nativeTemperatureIncrement,
+            params.entropyThreshold,
+            params.logprobThreshold,
+            params.noSpeechThreshold,
+            params.maxSegmentLength,
+            params.tokenTimestamps,
+            params.language
+        )
+    }
+
+    /**
+     * Total time, decode counters and schedule of the last chunk
+     */
+    suspend fun getTimings(): TranscriptionTimings = serialized {
+        TranscriptionTimings.fromNative(WhisperLib.sessionGetTimings(ptr)).copy(schedule = lastSchedule)
+    }
+
+    /**
+     * Free the session's KV caches and compute buffers, keeping the carried
+     * context; the next chunk re-allocates them. Waits for a chunk in
+     * progress.
+     * 
+     * @return Bytes reclaimed
+     */
+    suspend fun trimMemory(): Long {
+        if (ptr == 0L) return 0L
+        return withContext(dispatcher) {
+            if (ptr == 0L) 0L else WhisperLib.sessionTrimMemory(ptr)
+        }
+    }
+
+    /**
+     * Release the session's whisper state
+     */
+    suspend fun release() {
+        withContext(dispatcher) {
+            if (ptr != 0L) {
+                WhisperLib.freeSession(ptr)
+                ptr = 0
+            }
+        }
+        context.forgetSession(this)
+        dispatcher.close()
+    }
+
+    private suspend fun <T> serialized(block: () -> T): T = withContext(dispatcher) {
+        require(ptr != 0L) { "TranscriptionSession has been released" }
+        block()
+    }
+
+    companion object {
+        /** One whisper window per chunk */
+        const val CHUNK_SAMPLES = WHISPER_SAMPLE_RATE * 30
+    }
+}
+
+/**
+ * Result of [TranscriptionSession.transcribeFrom]: the segments to keep
+ * and where the next chunk starts
+ */
+data class ChunkStep(
+    val segments: List<TranscriptionSegment>,
+    val committedMs: Long,
+    val done: Boolean
+)
@@ -1,12 +1,20 @@
 package com.example.medicalappointmentcompanion.whisper
 
 import android.content.res.AssetManager
+import android.os.SystemClock
 import android.util.Log
+import com.example.medicalappointmentcompanion.audio.MelStream
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
 import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.runBlocking
 import kotlinx.coroutines.withContext
+import java.io.File
 import java.io.InputStream
 import java.util.concurrent.Executors
 
@@ -19,14 +27,114 @@ private const val LOG_TAG = "WhisperContext"
  * 
  * Whisper contexts are NOT thread-safe - all operations on a context
  * must be serialized. This class handles serialization automatically.
+ * 
+ * Besides the model weights, the context and each session hold KV caches
+ * and compute buffers. After [idleTimeoutMs] without a transcription these
+ * are freed ([trimMemory]), and re-allocated by the next transcription,
+ * whose [TranscriptionTimings.resumeMs] shows what that cost.
  */
-class WhisperContext private constructor(private var ptr: Long) {
+class WhisperContext private constructor(
+    private var ptr: Long,
+    val options: ModelOptions
+) {
     
     // Single-threaded dispatcher to ensure thread safety
     private val scope: CoroutineScope = CoroutineScope(
         Executors.newSingleThreadExecutor().asCoroutineDispatcher()
     )
     
+    // Whether segments come with their tokens (DecodingParams.tokenDetails)
+    @Volatile
+    internal var includeTokens = false
+        private set
+    
+    // Scheduler decision behind the last transcription, reported in getTimings
+    @Volatile
+    private var lastSchedule: ScheduleDecision? = null
+    
+    // Open sessions, released before the model they share
+    private val sessions = mutableSetOf<TranscriptionSession>()
+    
+    /**
+     * Free compute buffers after this long without a transcription on the
+     * context or any of its sessions; 0 keeps them resident
+     */
+    @Volatile
+    var idleTimeoutMs: Long = DEFAULT_IDLE_TIMEOUT_MS
+    
+    @Volatile
+    private var lastUsed = SystemClock.elapsedRealtime()
+    
+    // Whether buffers were freed since the last use
+    @Volatile
+    private var trimmed = false
+    
+    private var stats = MemoryStats()   // guarded by this
+    
+    private val watchdogScope = CoroutineScope(SupervisorJob() + Dispatchers.Default)
+    
+    init {
+        watchdogScope.launch {
+            while (isActive) {
+                delay(IDLE_CHECK_INTERVAL_MS)
+                val timeout = idleTimeoutMs
+                if (timeout > 0 && !trimmed && SystemClock.elapsedRealtime() - lastUsed >= timeout) {
+                    Log.d(LOG_TAG, "Idle for ${timeout / 1000} s, freeing compute buffers")
+                    trimMemory()
+                }
+            }
+        }
+    }
+    
+    /**
+     * Set the decoding strategy used by every later transcription on this
+     * context. Stored natively, so it only needs to be passed again when
+     * it changes.
+     */
+    suspend fun setDecodingParams(params: DecodingParams) = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        WhisperLib.setDecodingParams(
+            ptr,
+            params.strategy.nativeValue,
+            params.bestOf,
+            params.beamSize,
+            params.temperature,
+            params.nativeTemperatureIncrement,
+            params.entropyThreshold,
+            params.logprobThreshold,
+            params.noSpeechThreshold,
+            params.maxSegmentLength,
+            params.tokenTimestamps,
+            params.language
+        )
+        includeTokens = params.tokenDetails || params.tokenTimestamps
+    }
+    
+    /**
+     * Bias decoding toward the spelling of [terms] (e.g. medication names)
+     * with a prompt of the form "[prefix] term, term, ...". The prompt is
+     * tokenized once here and reused by every later transcription; terms
+     * are taken in order until [maxTokens] is reached.
+     * 
+     * @return Number of prompt tokens cached
+     */
+    suspend fun setVocabularyPrompt(
+        terms: List<String>,
+        prefix: String = DEFAULT_PROMPT_PREFIX,
+        maxTokens: Int = DEFAULT_PROMPT_TOKENS
+    ): Int = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        WhisperLib.setPrompt(ptr, prefix, terms.toTypedArray(), maxTokens)
+    }
+    
+    /**
+     * Stop prompting transcriptions with a vocabulary
+     */
+    suspend fun clearVocabularyPrompt() = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        WhisperLib.setPrompt(ptr, null, null, 0)
+    }
+    
     /**
      * Transcribe audio data to text
      * 
@@ -40,10 +148,12 @@ class WhisperContext private constructor(private var ptr: Long) {
     ): String = withContext(scope.coroutineContext) {
         require(ptr != 0L) { "WhisperContext has been released" }
         
-        val numThreads = WhisperCpuConfig.preferredThreadCount
+        val numThreads = threadsFor(null)
         Log.d(LOG_TAG, "Transcribing with $numThreads threads, ${data.size} samples")
         
-        WhisperLib.fullTranscribe(ptr, numThreads, data)
+        touch()
+        WhisperLib.fullTranscribe(ptr, numThreads, data, null, 0L, AUDIO_CTX_FULL, null)
+        touch()
         
         val segmentCount = WhisperLib.getTextSegmentCount(ptr)
         Log.d(LOG_TAG, "Transcription complete: $segmentCount segments")
@@ -74,32 +184,186 @@ class WhisperContext private constructor(private var ptr: Long) {
     
     /**
      * Get transcription segments with timing information
+     * 
+     * @param melCache Optional log-mel cache file for this recording; reused when
+     *                 it matches the model's mel configuration, written otherwise
+     * @param melStream Mel computed during capture of [data], used instead of
+     *                  recomputing it when there is no cache hit
+     * @param audioCtx Encoder window: [AUDIO_CTX_FULL], [AUDIO_CTX_ADAPTIVE]
+     *                 (shrunk to fit clips up to 20s) or an explicit position count
+     * @param schedule Scheduler decision to run on; its whole thread budget
+     *                 is used and it is reported in [getTimings]
+     * @param onSegment Called with each non-blank segment (without tokens)
+     *                  as soon as whisper commits it, on the context's
+     *                  thread; keep it short
      */
-    suspend fun transcribeWithSegments(data: FloatArray): List<TranscriptionSegment> = 
+    suspend fun transcribeWithSegments(
+        data: FloatArray,
+        melCache: File? = null,
+        melStream: MelStream? = null,
+        audioCtx: Int = AUDIO_CTX_FULL,
+        schedule: ScheduleDecision? = null,
+        onSegment: ((TranscriptionSegment) -> Unit)? = null
+    ): List<TranscriptionSegment> = 
         withContext(scope.coroutineContext) {
             require(ptr != 0L) { "WhisperContext has been released" }
             
-            val numThreads = WhisperCpuConfig.preferredThreadCount
-            WhisperLib.fullTranscribe(ptr, numThreads, data)
+            val numThreads = threadsFor(schedule)
+            touch()
+            WhisperLib.fullTranscribe(
+                ptr, numThreads, data, melCache?.absolutePath, melStream?.ptr ?: 0L, audioCtx,
+                segmentListener(onSegment)
+            )
+            touch()
             
-            val segmentCount = WhisperLib.getTextSegmentCount(ptr)
-            (0 until segmentCount)
-                .map { i ->
-                    TranscriptionSegment(
-                        text = WhisperLib.getTextSegment(ptr, i),
-                        startMs = WhisperLib.getTextSegmentT0(ptr, i) * 10,
-                        endMs = WhisperLib.getTextSegmentT1(ptr, i) * 10
-                    )
-                }
-                .filter { segment ->
-                    // Filter out blank audio segments and empty/whitespace-only segments
-                    val text = segment.text.trim()
-                    text.isNotEmpty() && 
-                    !text.equals("[BLANK_AUDIO]", ignoreCase = true) &&
-                    !text.equals("BLANK_AUDIO", ignoreCase = true) &&
-                    !text.equals("[BLANK]", ignoreCase = true)
-                }
+            readSegments()
+        }
+    
+    /**
+     * Transcribe a compressed archive recording, decoded natively
+     * straight into whisper without an intermediate WAV or Java array.
+     * On a mel cache hit the archive is not decoded at all.
+     * [onSegment] is as for [transcribeWithSegments].
+     */
+    suspend fun transcribeArchiveWithSegments(
+        archive: File,
+        melCache: File? = null,
+        schedule: ScheduleDecision? = null,
+        onSegment: ((TranscriptionSegment) -> Unit)? = null
+    ): List<TranscriptionSegment> =
+        withContext(scope.coroutineContext) {
+            require(ptr != 0L) { "WhisperContext has been released" }
+            
+            val numThreads = threadsFor(schedule)
+            touch()
+            val decoded = WhisperLib.transcribeArchive(
+                ptr, numThreads, archive.absolutePath, melCache?.absolutePath, segmentListener(onSegment)
+            )
+            touch()
+            if (!decoded) {
+                throw RuntimeException("Failed to decode archive: ${archive.name}")
+            }
+            
+            readSegments()
+        }
+    
+    /**
+     * Start an incremental mel spectrogram matching this model's band count,
+     * to be fed by the recorder while capturing
+     */
+    fun createMelStream(): MelStream {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        return MelStream(WhisperLib.getModelMelBands(ptr))
+    }
+    
+    /**
+     * Stage timings and schedule of the last transcription on this context
+     */
+    suspend fun getTimings(): TranscriptionTimings = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        TranscriptionTimings.fromNative(WhisperLib.getTimings(ptr)).copy(schedule = lastSchedule)
+    }
+    
+    // Runs on the context's thread, before the transcription it is for
+    private fun threadsFor(schedule: ScheduleDecision?): Int {
+        lastSchedule = schedule
+        return schedule?.threads?.coerceAtLeast(1) ?: WhisperCpuConfig.preferredThreadCount
+    }
+    
+    /**
+     * Run one encode of a second of silence and a prompt pass, so weights
+     * are paged in and buffers sized before the first real transcription,
+     * which then runs at steady-state speed. The prompt pass also times
+     * the decoder for [TranscriptionTimings.promptEstimateMs], so set the
+     * vocabulary prompt first.
+     * 
+     * @return Warm-up time in ms
+     */
+    suspend fun warmUp(numThreads: Int = WhisperCpuConfig.preferredThreadCount): Float =
+        withContext(scope.coroutineContext) {
+            require(ptr != 0L) { "WhisperContext has been released" }
+            touch()
+            val warmUpMs = WhisperLib.warmUp(ptr, numThreads)
+            touch()
+            if (warmUpMs < 0) {
+                throw RuntimeException("Model warm-up failed")
+            }
+            warmUpMs
+        }
+    
+    private fun segmentListener(onSegment: ((TranscriptionSegment) -> Unit)?): SegmentListener? =
+        onSegment?.let { forward ->
+            SegmentListener { text, startMs, endMs ->
+                if (!isBlankSegment(text)) forward(TranscriptionSegment(text, startMs, endMs))
+            }
+        }
+    
+    private fun readSegments(): List<TranscriptionSegment> =
+        PackedResults.decode(WhisperLib.getResults(ptr, includeTokens))
+            .filterNot { isBlankSegment(it.text) }
+    
+    /**
+     * Open a streaming session that transcribes consecutive chunks of one
+     * recording, carrying decoded text from chunk to chunk as context.
+     * Sessions share this context's model but decode on their own threads.
+     */
+    suspend fun createSession(): TranscriptionSession = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        val sessionPtr = WhisperLib.createSession(ptr)
+        if (sessionPtr == 0L) {
+            throw RuntimeException("Failed to create transcription session")
+        }
+        TranscriptionSession(this@WhisperContext, sessionPtr).also {
+            synchronized(sessions) { sessions.add(it) }
+        }
+    }
+    
+    internal fun forgetSession(session: TranscriptionSession) {
+        synchronized(sessions) { sessions.remove(session) }
+    }
+    
+    /**
+     * Mark the model as in use, postponing the idle trim. Called before
+     * and after every transcription, here and by the sessions.
+     */
+    internal fun touch() {
+        lastUsed = SystemClock.elapsedRealtime()
+        trimmed = false
+    }
+    
+    /**
+     * Free the KV caches, compute buffers and last results of the context
+     * and all its sessions, keeping the model weights, e.g. when the app
+     * goes idle or on onTrimMemory. Waits for transcriptions in progress;
+     * the next one re-allocates what it needs.
+     * 
+     * @return Bytes reclaimed, as measured by the process's resident set
+     */
+    suspend fun trimMemory(): Long {
+        val sessionBytes = synchronized(sessions) { sessions.toList() }.sumOf { it.trimMemory() }
+        val contextBytes = withContext(scope.coroutineContext) {
+            if (ptr == 0L) 0L else WhisperLib.trimMemory(ptr)
         }
+        trimmed = true
+        
+        val reclaimed = sessionBytes + contextBytes
+        val updated = synchronized(this) {
+            stats = stats.copy(
+                trims = stats.trims + 1,
+                lastReclaimedBytes = reclaimed,
+                totalReclaimedBytes = stats.totalReclaimedBytes + reclaimed
+            )
+            stats
+        }
+        Log.d(LOG_TAG, "Trimmed: $updated")
+        return reclaimed
+    }
+    
+    /**
+     * Totals of the idle and memory-pressure trims so far
+     */
+    val memoryStats: MemoryStats
+        get() = synchronized(this) { stats }
     
     /**
      * Benchmark memory copy performance
@@ -115,12 +379,39 @@ class WhisperContext private constructor(private var ptr: Long) {
         WhisperLib.benchGgmlMulMat(nthreads)
     }
     
+    /**
+     * Benchmark native resampling throughput (samples/second)
+     */
+    suspend fun benchResampler(): String = withContext(scope.coroutineContext) {
+        WhisperLib.benchResampler()
+    }
+    
+    /**
+     * Benchmark archive compression ratio and encode/decode speed
+     * 
+     * @param tmpDir Writable directory for the temporary archive (e.g. cacheDir)
+     */
+    suspend fun benchArchive(tmpDir: File): String = withContext(scope.coroutineContext) {
+        WhisperLib.benchArchive(tmpDir.absolutePath)
+    }
+    
+    /**
+     * Benchmark the built-in mel spectrogram against the bridge's vectorized
+     * one-shot and capture-time paths
+     */
+    suspend fun benchMel(nthreads: Int, minutes: Int = 20): String = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext has been released" }
+        WhisperLib.benchMel(ptr, nthreads, minutes)
+    }
+    
     /**
      * Release native resources
      * 
      * After calling this method, the context cannot be used.
      */
     suspend fun release() = withContext(scope.coroutineContext) {
+        watchdogScope.cancel()
+        synchronized(sessions) { sessions.toList() }.forEach { it.release() }
         if (ptr != 0L) {
             Log.d(LOG_TAG, "Releasing WhisperContext")
             WhisperLib.freeContext(ptr)
@@ -140,46 +431,93 @@ class WhisperContext private constructor(private var ptr: Long) {
     }
     
     companion object {
+        /** Full 30s encoder window, as whisper trains and decodes by default */
+        const val AUDIO_CTX_FULL = 0
+        
+        /**
+         * Encoder window sized to the clip for inputs up to 20s, with a
+         * floor, a trailing margin and a full-window retry if nothing is heard
+         */
+        const val AUDIO_CTX_ADAPTIVE = -1
+        
+        // Also DECODING_PROMPT_PREFIX / _TOKENS in decoding.h, for batch_transcribe
+        const val DEFAULT_PROMPT_PREFIX = "Medications discussed:"
+        
+        /**
+         * Vocabulary prompt budget. whisper keeps at most half its text
+         * context (224 tokens) as prompt, and every prompt token is
+         * re-processed at the start of each 30s window.
+         */
+        const val DEFAULT_PROMPT_TOKENS = 128
+        
+        /**
+         * Idle time before compute buffers are freed. Re-allocating them
+         * costs far less than a transcription, but is not free, so short
+         * pauses within an appointment keep them.
+         */
+        const val DEFAULT_IDLE_TIMEOUT_MS = 3 * 60_000L
+        
+        private const val IDLE_CHECK_INTERVAL_MS = 30_000L
+        
         /**
          * Create context from a model file path
          */
-        fun createFromFile(filePath: String): WhisperContext {
-            Log.d(LOG_TAG, "Creating context from file: $filePath")
-            val ptr = WhisperLib.initContext(filePath)
+        fun createFromFile(filePath: String, options: ModelOptions = ModelOptions.DEFAULT): WhisperContext {
+            Log.d(LOG_TAG, "Creating context from file: $filePath ($options)")
+            val ptr = WhisperLib.initContext(filePath, options.flashAttention)
             if (ptr == 0L) {
                 throw RuntimeException("Failed to create WhisperContext from file: $filePath")
             }
-            return WhisperContext(ptr)
+            return WhisperContext(ptr, options)
         }
         
         /**
          * Create context from an InputStream
          */
-        fun createFromInputStream(stream: InputStream): WhisperContext {
-            Log.d(LOG_TAG, "Creating context from InputStream")
-            val ptr = WhisperLib.initContextFromInputStream(stream)
+        fun createFromInputStream(stream: InputStream, options: ModelOptions = ModelOptions.DEFAULT): WhisperContext {
+            Log.d(LOG_TAG, "Creating context from InputStream ($options)")
+            val ptr = WhisperLib.initContextFromInputStream(stream, options.flashAttention)
             if (ptr == 0L) {
                 throw RuntimeException("Failed to create WhisperContext from InputStream")
             }
-            return WhisperContext(ptr)
+            return WhisperContext(ptr, options)
         }
         
         /**
          * Create context from an APK asset
          */
-        fun createFromAsset(assetManager: AssetManager, assetPath: String): WhisperContext {
-            Log.d(LOG_TAG, "Creating context from asset: $assetPath")
-            val ptr = WhisperLib.initContextFromAsset(assetManager, assetPath)
+        fun createFromAsset(
+            assetManager: AssetManager,
+            assetPath: String,
+            options: ModelOptions = ModelOptions.DEFAULT
+        ): WhisperContext {
+            Log.d(LOG_TAG, "Creating context from asset: $assetPath ($options)")
+            val ptr = WhisperLib.initContextFromAsset(assetManager, assetPath, options.flashAttention)
             if (ptr == 0L) {
                 throw RuntimeException("Failed to create WhisperContext from asset: $assetPath")
             }
-            return WhisperContext(ptr)
+            return WhisperContext(ptr, options)
         }
         
         /**
          * Get whisper system info string
          */
         fun getSystemInfo(): String = WhisperLib.getSystemInfo()
+        
+        /**
+         * Resident memory of the whole process, model and buffers included
+         */
+        fun readMemoryUsage(): MemoryUsage {
+            val values = WhisperLib.getMemoryUsage()
+            return MemoryUsage(residentBytes = values[0], peakResidentBytes = values[1])
+        }
+        
+        /**
+         * Restart [MemoryUsage.peakResidentBytes] from the current resident
+         * set; false where the kernel doesn't allow it, in which case the
+         * peak covers the whole process lifetime
+         */
+        fun resetPeakMemory(): Boolean = WhisperLib.resetPeakMemory()
     }
     
     private fun formatTimestamp(t: Long, comma: Boolean = false): String {
@@ -196,12 +534,133 @@ class WhisperContext private constructor(private var ptr: Long) {
     }
 }
 
+/**
+ * Blank audio markers and empty/whitespace-only segments
+ */
+internal fun isBlankSegment(text: String): Boolean {
+    val trimmed = text.trim()
+    return trimmed.isEmpty() ||
+        trimmed.equals("[BLANK_AUDIO]", ignoreCase = true) ||
+        trimmed.equals("BLANK_AUDIO", ignoreCase = true) ||
+        trimmed.equals("[BLANK]", ignoreCase = true)
+}
+
 /**
  * Represents a transcribed segment with timing
+ * 
+ * [tokens] is only filled when [DecodingParams.tokenDetails] or
+ * [DecodingParams.tokenTimestamps] is set.
  */
 data class TranscriptionSegment(
     val text: String,
     val startMs: Long,
+    val endMs: Long,
+    val tokens: List<TranscriptionToken> = emptyList()
+)
+
+/**
+ * A decoded text token with whisper's probability for it
+ * 
+ * Times are -1 unless [DecodingParams.tokenTimestamps] is set. A token may
+ * hold part of a multi-byte character, so join segment text, not tokens.
+ */
+data class TranscriptionToken(
+    val id: Int,
+    val text: String,
+    val probability: Float,
+    val startMs: Long,
     val endMs: Long
 )
 
+/**
+ * Whether the last transcription used the log-mel cache
+ */
+enum class MelCacheStatus {
+    NOT_USED,
+    MISS,
+    HIT
+}
+
+/**
+ * Per-stage timings of a transcription, in milliseconds, plus decode
+ * counters: [windows] 30s windows decoded, [fallbacks] re-decodes at
+ * a higher temperature after a window failed the decoding thresholds and
+ * [promptTokens] vocabulary prompt tokens.
+ * [threads] is the thread count used; [schedule] is the scheduler's
+ * decision behind it when the chunk ran under a [TranscriptionScheduler].
+ * 
+ * Every decode attempt starts with a prompt pass, which whisper gives no
+ * callback around: [encodeMs] is the encoder plus each window's first
+ * prompt pass, and [decodeMs] the rest of whisper's work, fallback prompt
+ * passes included. [promptEstimateMs] estimates all the prompt passes from
+ * the decoder speed measured by [WhisperContext.warmUp] (null before it);
+ * it is not measured and not taken out of the other stages.
+ * [resumeMs] is the time spent re-allocating compute buffers freed by
+ * [WhisperContext.trimMemory], 0 if they were resident.
+ */
+data class TranscriptionTimings(
+    val totalMs: Float,
+    val melMs: Float,
+    val encodeMs: Float,
+    val decodeMs: Float,
+    val promptEstimateMs: Float?,
+    val melCache: MelCacheStatus,
+    val audioCtx: Int,
+    val audioCtxRetries: Int,
+    val windows: Int,
+    val fallbacks: Int,
+    val promptTokens: Int,
+    val threads: Int,
+    val resumeMs: Float,
+    val schedule: ScheduleDecision? = null
+) {
+    companion object {
+        /**
+         * Unpack the array returned by WhisperLib.getTimings
+         */
+        internal fun fromNative(values: FloatArray) = TranscriptionTimings(
+            totalMs = values[0],
+            melMs = values[1],
+            encodeMs = values[2],
+            decodeMs = values[3],
+            promptEstimateMs = values[4].takeIf { it >= 0 },
+            melCache = when (values[5].toInt()) {
+                1 -> MelCacheStatus.HIT
+                0 -> MelCacheStatus.MISS
+                else -> MelCacheStatus.NOT_USED
+            },
+            audioCtx = values[6].toInt(),
+            audioCtxRetries = values[7].toInt(),
+            windows = values[8].toInt(),
+            fallbacks = values[9].toInt(),
+            promptTokens = values[10].toInt(),
+            threads = values[11].toInt(),
+            resumeMs = values[12]
+        )
+    }
+}
+
+/**
+ * Compute buffers freed by [WhisperContext.trimMemory]; the resident set
+ * shrink is approximate, as other threads allocate at the same time
+ */
+data class MemoryStats(
+    val trims: Int = 0,
+    val lastReclaimedBytes: Long = 0,
+    val totalReclaimedBytes: Long = 0
+) {
+    override fun toString(): String = String.format(
+        "%d trims, last %.1f MB, total %.1f MB reclaimed",
+        trims,
+        lastReclaimedBytes / (1024f * 1024f),
+        totalReclaimedBytes / (1024f * 1024f)
+    )
+}
+
+/**
+ * Resident set size of the process, in bytes
+ */
+data class MemoryUsage(
+    val residentBytes: Long,
+    val peakResidentBytes: Long
+)
@@ -57,24 +57,104 @@ internal class WhisperLib {
         }
         
         // JNI methods - Context management
-        external fun initContextFromInputStream(inputStream: InputStream): Long
-        external fun initContextFromAsset(assetManager: AssetManager, assetPath: String): Long
-        external fun initContext(modelPath: String): Long
+        external fun initContextFromInputStream(inputStream: InputStream, flashAttn: Boolean): Long
+        external fun initContextFromAsset(assetManager: AssetManager, assetPath: String, flashAttn: Boolean): Long
+        external fun initContext(modelPath: String, flashAttn: Boolean): Long
         external fun freeContext(contextPtr: Long)
         
         // JNI methods - Transcription
-        external fun fullTranscribe(contextPtr: Long, numThreads: Int, audioData: FloatArray)
+        external fun setDecodingParams(
+            contextPtr: Long,
+            strategy: Int,
+            bestOf: Int,
+            beamSize: Int,
+            temperature: Float,
+            temperatureInc: Float,
+            entropyThold: Float,
+            logprobThold: Float,
+            noSpeechThold: Float,
+            maxLen: Int,
+            tokenTimestamps: Boolean,
+            language: String?
+        )
+        external fun setPrompt(contextPtr: Long, prefix: String?, terms: Array<String>?, maxTokens: Int): Int
+        external fun fullTranscribe(
+            contextPtr: Long,
+            numThreads: Int,
+            audioData: FloatArray,
+            melCachePath: String?,
+            melStreamPtr: Long,
+            audioCtx: Int,
+            listener: SegmentListener?
+        )
+        external fun transcribeArchive(
+            contextPtr: Long,
+            numThreads: Int,
+            archivePath: String,
+            melCachePath: String?,
+            listener: SegmentListener?
+        ): Boolean
+        external fun warmUp(contextPtr: Long, numThreads: Int): Float
+        external fun getTimings(contextPtr: Long): FloatArray
+        external fun trimMemory(contextPtr: Long): Long
+        external fun getMemoryUsage(): LongArray
+        external fun resetPeakMemory(): Boolean
+        
+        // JNI methods - Streaming session
+        external fun createSession(contextPtr: Long): Long
+        external fun sessionTranscribe(sessionPtr: Long, numThreads: Int, audioData: FloatArray, length: Int): Boolean
+        external fun sessionReset(sessionPtr: Long)
+        external fun sessionSeek(sessionPtr: Long, offset: Long)
+        external fun sessionRestoreContext(sessionPtr: Long, text: String)
+        external fun sessionSetDecodingParams(
+            sessionPtr: Long,
+            strategy: Int,
+            bestOf: Int,
+            beamSize: Int,
+            temperature: Float,
+            temperatureInc: Float,
+            entropyThold: Float,
+            logprobThold: Float,
+            noSpeechThold: Float,
+            maxLen: Int,
+            tokenTimestamps: Boolean,
+            language: String?
+        )
+        external fun sessionGetTimings(sessionPtr: Long): FloatArray
+        external fun sessionTrimMemory(sessionPtr: Long): Long
+        external fun freeSession(sessionPtr: Long)
         
         // JNI methods - Results
+        external fun getResults(contextPtr: Long, withTokens: Boolean): ByteArray
+        external fun getSessionResults(sessionPtr: Long, withTokens: Boolean): ByteArray
         external fun getTextSegmentCount(contextPtr: Long): Int
         external fun getTextSegment(contextPtr: Long, index: Int): String
         external fun getTextSegmentT0(contextPtr: Long, index: Int): Long
         external fun getTextSegmentT1(contextPtr: Long, index: Int): Long
         
+        // JNI methods - Audio conversion
+        external fun createResampler(inRate: Int, outRate: Int): Long
+        external fun resamplerProcess(resamplerPtr: Long, pcm: ShortArray, length: Int, channels: Int): FloatArray
+        external fun resamplerFlush(resamplerPtr: Long): FloatArray
+        external fun freeResampler(resamplerPtr: Long)
+        external fun convertToWhisper(pcm: ShortArray, channels: Int, sampleRate: Int): FloatArray
+        external fun archiveEncodeWave(wavPath: String, archivePath: String): Long
+        external fun archiveDecode(archivePath: String): FloatArray?
+        external fun archiveCheck(archivePath: String): Boolean
+        
+        // JNI methods - Mel spectrogram
+        external fun getModelMelBands(contextPtr: Long): Int
+        external fun createMelStream(nMel: Int): Long
+        external fun melStreamPush(streamPtr: Long, samples: FloatArray, length: Int)
+        external fun freeMelStream(streamPtr: Long)
+        
         // JNI methods - System info
         external fun getSystemInfo(): String
         external fun benchMemcpy(nthread: Int): String
         external fun benchGgmlMulMat(nthread: Int): String
+        external fun benchResampler(): String
+        external fun benchArchive(tmpDir: String): String
+        external fun benchMel(contextPtr: Long, nthread: Int, minutes: Int): String
         
         private fun isArmEabiV7a(): Boolean = Build.SUPPORTED_ABIS[0] == "armeabi-v7a"
         private fun isArmEabiV8a(): Boolean = Build.SUPPORTED_ABIS[0] == "arm64-v8a"
@@ -88,3 +168,11 @@ internal class WhisperLib {
     }
 }
 
+/**
+ * Called from [WhisperLib.fullTranscribe] and [WhisperLib.transcribeArchive]
+ * with each segment as whisper commits it, on the transcribing thread.
+ * Text is as whisper returns it, blank segments included.
+ */
+internal fun interface SegmentListener {
+    fun onSegment(text: String, startMs: Long, endMs: Long)
+}
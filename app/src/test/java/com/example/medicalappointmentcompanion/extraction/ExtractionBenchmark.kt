@@ -0,0 +1,214 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import com.example.medicalappointmentcompanion.extraction.SchemaGuidedExtractor.Quantity
+import java.io.File
+
+/**
+ * Extraction micro-benchmark on a synthetic consultation transcript
+ *
+ * Reports the full [SchemaGuidedExtractor.extract] time and its split
+ * across the extraction stages, the same transcript streamed one sentence
+ * per segment, the quantity patterns (dosage, frequency, duration,
+ * timeframe) evaluated the old way (a Regex compiled per pattern per
+ * sentence) against the compiled pattern set with a check that both
+ * agree, the native approximate medication matcher against plain
+ * dynamic programming, and best-candidate lookups in a compiled
+ * medication lexicon of the built-in names.
+ *
+ * ExtractionBenchmarkTest runs it on the host JVM and fails if the
+ * compiled patterns and the old regexes disagree.
+ */
+object ExtractionBenchmark {
+
+    // The space after each sentence of the synthetic transcript
+    private val SENTENCE_GAP = Regex("""(?<=[.?]) """)
+
+    // Clinician and patient lines of the kind the extractor looks for,
+    // plus small talk it should skip
+    private val SENTENCES = listOf(
+        "I'm going to prescribe amoxicillin 500mg three times a day for 7 days.",
+        "Take it with food and finish the course.",
+        "So how have you been sleeping since the last visit?",
+        "We'll start you on omeprazole 20 mg once daily in the morning.",
+        "Take two tablets every 4 to 6 hours as needed for the pain.",
+        "I'd like you to have a blood test this week.",
+        "Come back and see me in 2 weeks if it's not settling.",
+        "If you get chest pain or your breathing gets worse, go to A&E.",
+        "It's very common and nothing to worry about.",
+        "Keep taking the metformin 1000 milligrams twice a day with meals.",
+        "Use the salbutamol inhaler when needed, up to 4 times a day.",
+        "I'll refer you to the dermatology clinic for a review.",
+        "Yeah it's been a busy few weeks at work to be honest.",
+        "Try to cut down on alcohol and walk for 30 minutes a day."
+    )
+
+    // Dosages as a transcript can space them: the old regexes took any
+    // whitespace between number and unit
+    internal val WHITESPACE_SENTENCES = listOf(
+        "Take amoxicillin 500  mg three times a day.",
+        "Take 2\ttablets every 4 hours.",
+        "Use 10 \n ml at night.",
+        "Half a tablet, so 2.5   milligrams, once daily."
+    )
+
+    // The extractor's quantity regexes before they were compiled into
+    // SchemaGuidedExtractor.QUANTITIES, kept as written as the baseline
+    private const val REGEX_DOSAGE =
+        """(\d+(?:\.\d+)?)\s*(mg|milligrams?|mcg|micrograms?|ml|millilitres?|tablets?|pills?|capsules?)"""
+
+    private val REGEX_FREQUENCY = listOf(
+        "once a day", "twice a day", "three times a day", "four times a day",
+        "once daily", "twice daily", "three times daily",
+        "every morning", "every evening", "every night", "at night", "at bedtime",
+        "every \\d+ hours?", "every \\d+ to \\d+ hours?",
+        "in the morning", "in the evening", "with breakfast", "with lunch", "with dinner",
+        "with food", "with meals", "after food", "before food", "on an empty stomach",
+        "as needed", "when needed", "when required", "as required", "prn"
+    )
+
+    private val REGEX_DURATION = listOf(
+        "for \\d+ days?", "for \\d+ weeks?", "for \\d+ months?",
+        "for a week", "for two weeks", "for a month",
+        "until finished", "until gone", "until the course is complete",
+        "until you feel better", "until symptoms improve",
+        "long term", "ongoing", "indefinitely", "permanently"
+    )
+
+    private val REGEX_TIMEFRAME = listOf(
+        "in \\d+ days?", "in \\d+ weeks?", "in \\d+ months?",
+        "in a week", "in two weeks", "in a month", "in a fortnight",
+        "next week", "next month",
+        "after \\d+ days?", "after \\d+ weeks?"
+    )
+
+    suspend fun run(minutes: Int = 30, iterations: Int = 5): String {
+        val transcript = syntheticTranscript(minutes)
+        val sentences = transcript.split(". ").map { it.lowercase() }
+
+        // Full extraction, after a warm-up run builds the matchers
+        SchemaGuidedExtractor.extract(transcript)
+        val extractMs = medianMs(iterations) { SchemaGuidedExtractor.extract(transcript) }
+        val whole = IncrementalExtractor()
+        whole.addSegment(transcript)
+        whole.finish()
+
+        // Streamed: one segment per sentence, as a transcription commits them
+        val streamed = IncrementalExtractor()
+        var segmentMs = 0.0
+        for (sentence in transcript.split(SENTENCE_GAP)) {
+            val start = System.nanoTime()
+            streamed.addSegment(sentence)
+            segmentMs = maxOf(segmentMs, (System.nanoTime() - start) / 1e6)
+        }
+        streamed.finish()
+
+        // Quantity patterns: per-call Regex vs. the compiled set
+        val agree = quantityMismatches().isEmpty()
+        val regexMs = medianMs(iterations) { sentences.forEach { regexQuantities(it) } }
+        val compiledMs = medianMs(iterations) { sentences.forEach { compiledQuantities(it) } }
+        
+        // Lexicon: one best-candidate lookup per sentence
+        val lexiconFile = File.createTempFile("bench", ".mlex")
+        val lexicon = if (MedicationLexicon.compile(SchemaGuidedExtractor.lexiconEntries, lexiconFile)) {
+            MedicationLexicon.open(lexiconFile)
+        } else null
+        val lexiconMs = lexicon?.use { lex -> medianMs(iterations) { sentences.forEach { lex.find(it) } } }
+        lexiconFile.delete()
+
+        return buildString {
+            append(String.format(
+                "extraction bench: %d min transcript, %d chars, %d sentences\n",
+                minutes, transcript.length, sentences.size
+            ))
+            append(String.format(
+                "extract: %.1f ms (%.2f ms per transcript minute)\n",
+                extractMs, extractMs / minutes
+            ))
+            append("whole transcript: ${whole.timings}\n")
+            append(String.format(
+                "streamed by sentence: %.1f ms total, slowest segment %.2f ms\n",
+                streamed.timings.totalMs, segmentMs
+            ))
+            append(String.format(
+                "quantity patterns: regex %.1f ms, compiled %.1f ms, %.1fx, %s\n",
+                regexMs, compiledMs, regexMs / compiledMs.coerceAtLeast(1e-3),
+                if (agree) "results agree" else "RESULTS DIFFER"
+            ))
+            append(SchemaGuidedExtractor.COMPACT_MEDICATIONS.bench(minutes))
+            if (lexiconMs != null) {
+                append(String.format(
+                    "lexicon: %.1f ms, %.2f us per sentence\n",
+                    lexiconMs, lexiconMs * 1000 / sentences.size
+                ))
+            }
+        }
+    }
+
+    /**
+     * About 150 spoken words a minute
+     */
+    private fun syntheticTranscript(minutes: Int): String {
+        val words = 150 * minutes
+        val sentences = mutableListOf<String>()
+        var count = 0
+        var i = 0
+        while (count < words) {
+            val sentence = SENTENCES[i++ % SENTENCES.size]
+            sentences += sentence
+            count += sentence.count { it == ' ' } + 1
+        }
+        return sentences.joinToString(" ")
+    }
+
+    /**
+     * Sentences (by default those of the synthetic transcript) whose
+     * dosage, frequency, duration or timeframe the compiled patterns read
+     * differently from the old regexes, with both readings
+     */
+    internal fun quantityMismatches(
+        sentences: List<String> = SENTENCES
+    ): List<String> = sentences.map { it.lowercase() }.mapNotNull { sentence ->
+        val regex = regexQuantities(sentence)
+        val compiled = compiledQuantities(sentence)
+        if (regex == compiled) null else "\"$sentence\": regex $regex, compiled $compiled"
+    }
+
+    internal fun compiledQuantities(sentence: String): List<String?> {
+        val matches = SchemaGuidedExtractor.QUANTITIES.match(sentence)
+        return listOf(
+            matches.leftmostMatch(Quantity.DOSAGE),
+            matches.firstMatch(Quantity.FREQUENCY),
+            matches.firstMatch(Quantity.DURATION),
+            matches.lastMatch(Quantity.TIMEFRAME)
+        ).map { range -> range?.let { sentence.substring(it) } }
+    }
+
+    /**
+     * The extractor's previous approach: compile and search one Regex per
+     * pattern for every sentence, taking the first frequency and duration
+     * pattern that matches and the last timeframe one
+     */
+    private fun regexQuantities(sentence: String): List<String?> {
+        val dosage = Regex(REGEX_DOSAGE, RegexOption.IGNORE_CASE)
+        var timeframe: String? = null
+        for (pattern in REGEX_TIMEFRAME) {
+            Regex(pattern, RegexOption.IGNORE_CASE).find(sentence)?.let { timeframe = it.value }
+        }
+        return listOf(
+            dosage.find(sentence)?.value,
+            REGEX_FREQUENCY.firstNotNullOfOrNull { Regex(it, RegexOption.IGNORE_CASE).find(sentence)?.value },
+            REGEX_DURATION.firstNotNullOfOrNull { Regex(it, RegexOption.IGNORE_CASE).find(sentence)?.value },
+            timeframe
+        )
+    }
+
+    private inline fun medianMs(iterations: Int, block: () -> Unit): Double {
+        val times = DoubleArray(iterations) {
+            val start = System.nanoTime()
+            block()
+            (System.nanoTime() - start) / 1e6
+        }
+        times.sort()
+        return times[iterations / 2]
+    }
+}
@@ -0,0 +1,51 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.ClassRule
+import org.junit.Test
+
+/**
+ * Runs [ExtractionBenchmark] on the host JVM and checks the compiled
+ * quantity patterns read every sentence as the old regexes did: the
+ * benchmark's, the harness corpus's and ones with runs of whitespace
+ *
+ * Needs the host libmedextract, which the test task builds first.
+ */
+class ExtractionBenchmarkTest {
+
+    companion object {
+        @ClassRule
+        @JvmField
+        val library = HostLibraryRule()
+
+        private const val MINUTES = 10
+        private const val ITERATIONS = 3
+        private val SENTENCE_GAP = Regex("""(?<=[.?!])\s+""")
+    }
+
+    @Test
+    fun compiledQuantitiesMatchRegexBaseline() = runBlocking {
+        println(ExtractionBenchmark.run(MINUTES, ITERATIONS))
+        assertEquals(emptyList<String>(), ExtractionBenchmark.quantityMismatches())
+    }
+
+    @Test
+    fun compiledQuantitiesMatchRegexBaselineOnHarnessTranscripts() {
+        val sentences = ExtractionCorpus.all()
+            .flatMap { consultation -> consultation.segments }
+            .flatMap { segment -> segment.text.split(SENTENCE_GAP) }
+            .distinct()
+        assertEquals(emptyList<String>(), ExtractionBenchmark.quantityMismatches(sentences))
+    }
+
+    @Test
+    fun whitespaceRunsReadAsOneSpace() {
+        assertEquals(emptyList<String>(), ExtractionBenchmark.quantityMismatches(ExtractionBenchmark.WHITESPACE_SENTENCES))
+
+        // The old regexes only allowed extra whitespace inside a dosage
+        val (_, frequency, duration, _) = ExtractionBenchmark.compiledQuantities("take it once  a day\tfor 5\n days")
+        assertEquals("once  a day", frequency)
+        assertEquals("for 5\n days", duration)
+    }
+}
@@ -0,0 +1,284 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import com.example.medicalappointmentcompanion.model.TranscriptionSegmentData
+import kotlin.random.Random
+
+/**
+ * Synthetic GP consultations of 1 to 60 minutes, with the extraction each
+ * should give
+ *
+ * Each consultation is small talk and history-taking with clinical scenes
+ * placed through it: prescriptions (some split over two sentences, some
+ * with a mis-transcribed name), tests, safety-netting and one follow-up
+ * near the end, plus a few mentions that are not instructions at all.
+ * The ground truth is known by construction. Generation is seeded, so a
+ * consultation is the same on every run and reports can be compared.
+ *
+ * Filler sentences contain none of the extractor's keywords, and scenes
+ * only the ones they are about, so a difference from the ground truth is
+ * the extractor's and not the corpus's.
+ */
+internal object ExtractionCorpus {
+
+    val MINUTES = listOf(1, 5, 10, 20, 30, 45, 60)
+
+    private const val WORDS_PER_MINUTE = 150
+    private const val MS_PER_WORD = 60_000L / WORDS_PER_MINUTE
+    private const val SEED = 20240601
+
+    /**
+     * A medication as it should be extracted: lower-case generic name and
+     * the dosage, frequency and duration phrases as spoken
+     */
+    data class ExpectedMedication(
+        val name: String,
+        val dosage: String?,
+        val frequency: String?,
+        val duration: String?
+    )
+
+    class Expected(
+        val medications: List<ExpectedMedication>,
+        val tests: Set<String>,
+        val followUpTimeframe: String?,
+        val safety: Set<String>
+    )
+
+    class Consultation(
+        val id: String,
+        val minutes: Int,
+        val segments: List<TranscriptionSegmentData>,
+        val expected: Expected
+    ) {
+        val chars: Int get() = segments.sumOf { it.text.length + 1 } - 1
+    }
+
+    // Sentences said together and what they should yield
+    private class Scene(
+        val sentences: List<String>,
+        val medication: ExpectedMedication? = null,
+        val test: String? = null,
+        val followUpTimeframe: String? = null,
+        val safety: String? = null
+    )
+
+    // Name as spoken (maybe mis-transcribed), then dosage, frequency, duration
+    private class Prescription(
+        val name: String,
+        val dosage: String?,
+        val frequency: String?,
+        val duration: String?,
+        val misheard: String? = null
+    )
+
+    // ========================================================================
+    // SCENES
+    // ========================================================================
+
+    private val PRESCRIPTIONS = listOf(
+        Prescription("amoxicillin", "500 milligrams", "three times a day", "for 7 days", misheard = "amoxacillin"),
+        Prescription("ramipril", "5 milligrams", "once a day", null),
+        Prescription("atorvastatin", "20 mg", "at night", null),
+        Prescription("metformin", "500 milligrams", "twice a day", null),
+        Prescription("omeprazole", "20 mg", "once daily", "for 4 weeks", misheard = "omeprazol"),
+        Prescription("sertraline", "50 milligrams", "every morning", null, misheard = "sertralin"),
+        Prescription("ibuprofen", "400 mg", "three times daily", "for 5 days", misheard = "ibuprofin"),
+        Prescription("paracetamol", "2 tablets", "every 4 to 6 hours", null),
+        Prescription("amlodipine", "5 mg", "once a day", "long term"),
+        Prescription("levothyroxine", "50 micrograms", "every morning", null),
+        Prescription("salbutamol", null, "as needed", null),
+        Prescription("prednisolone", "40 mg", "once a day", "for 5 days"),
+        Prescription("fluconazole", "150 mg", null, null),
+        Prescription("doxycycline", "100 mg", "twice daily", "for 7 days"),
+        Prescription("naproxen", "500 milligrams", "twice a day", null),
+        Prescription("citalopram", "20 mg", "once daily", null),
+        Prescription("gabapentin", "300 mg", "three times a day", null),
+        Prescription("lansoprazole", "30 mg", "before food", null),
+        Prescription("bisoprolol", "2.5 mg", "once a day", "long term"),
+        Prescription("cetirizine", "10 mg", "once a day", null),
+        Prescription("folic acid", "400 micrograms", "once a day", null),
+        Prescription("apixaban", "5 mg", "twice a day", "long term"),
+        Prescription("trimethoprim", "200 mg", "twice a day", "for 3 days"),
+        Prescription("mirtazapine", "15 mg", "at night", null)
+    )
+
+    /**
+     * A prescription in one of the ways a clinician says it
+     */
+    private fun medicationScene(p: Prescription, random: Random): Scene {
+        val spoken = if (p.misheard != null && random.nextInt(4) == 0) p.misheard else p.name
+        val details = listOfNotNull(p.dosage, p.frequency, p.duration).joinToString(" ")
+        val expected = ExpectedMedication(p.name, p.dosage, p.frequency, p.duration)
+        val sentences = when (random.nextInt(4)) {
+            // Trigger, name and details in one sentence
+            0 -> listOf("I'm going to prescribe $spoken $details.")
+            1 -> listOf("Take $spoken $details.")
+            // Name in one sentence, details in the next
+            2 -> if (details.isEmpty()) listOf("I'm going to prescribe $spoken.") else listOf(
+                "I'm going to start you on $spoken.",
+                "You'll take it as $details."
+            )
+            // Trigger in the sentence before the name
+            else -> listOf(
+                "We'll make a change to your medication.",
+                "${spoken.replaceFirstChar { it.uppercase() }} $details."
+            )
+        }
+        return Scene(sentences, medication = expected)
+    }
+
+    // Test as the extractor names it, then how it's said
+    private val TESTS = listOf(
+        "blood test" to "I'd like you to have a blood test this week.",
+        "x-ray" to "We'll get an x-ray of your knee.",
+        "ecg" to "The nurse will do an ecg before you leave.",
+        "ultrasound" to "I'd like you to have an ultrasound of your abdomen.",
+        "urine sample" to "Please drop in a urine sample tomorrow.",
+        "mri" to "I'm going to request an mri of your lower back.",
+        "endoscopy" to "You'll need an endoscopy to look at your stomach lining.",
+        "echocardiogram" to "We'll arrange an echocardiogram to look at your heart valves.",
+        "stool sample" to "Please hand in a stool sample this week.",
+        "colonoscopy" to "I'm going to arrange a colonoscopy for you."
+    )
+
+    private val SAFETY = listOf(
+        "If you get chest pain or your breathing gets worse, go to A&E.",
+        "If you develop a rash, stop taking it straight away.",
+        "If you have a fever over 38 degrees, ring the surgery.",
+        "Should you feel dizzy or faint, sit down and call us.",
+        "If you notice any bleeding, ring us the same day.",
+        "If the swelling spreads, you need to call 999.",
+        "Watch out for any vomiting or diarrhoea.",
+        "If you become confused or drowsy, ring for an ambulance.",
+        "Look out for a high temperature.",
+        "If your ankles get swollen, let me know."
+    )
+
+    // Timeframe as the extractor reports it, then how it's said
+    private val FOLLOW_UPS = listOf(
+        "in 2 weeks" to "Come back and see me in 2 weeks.",
+        "in 3 months" to "I'd like to see you again in 3 months.",
+        "in 4 weeks" to "Book a review with reception in 4 weeks.",
+        "next month" to "Let's follow up next month."
+    )
+
+    // Mentions that are not instructions: nothing should be extracted
+    private val DISTRACTORS = listOf(
+        "My sister was on sertraline years ago and she hated it.",
+        "I had an x-ray on that knee a few years back.",
+        "My father used to give us paracetamol for everything."
+    )
+
+    // Small talk and history-taking, free of every keyword
+    private val FILLER = listOf(
+        "How was the drive over here?",
+        "The traffic on the bridge was terrible.",
+        "My daughter has just moved to Galway for college.",
+        "I have been feeling tired most afternoons.",
+        "Tell me a bit more about when that began.",
+        "Has anyone else at home been unwell?",
+        "I was up a few times last night with it.",
+        "We had a lovely weekend down in Kerry.",
+        "The dog has been keeping me busy.",
+        "I suppose it comes and goes.",
+        "That sounds really frustrating for you.",
+        "Any pain anywhere else?",
+        "It was a bit better over the summer.",
+        "I have been trying to get out for a swim.",
+        "My husband thinks I am making a fuss about nothing.",
+        "Okay, and how long has this been going on?",
+        "Right, let me just have a listen to your chest.",
+        "Breathe in and out slowly for me.",
+        "Lovely, you can pop your top back on.",
+        "I know the waiting room was packed earlier.",
+        "We are all a bit run down this time of year.",
+        "I used to play a lot of hurling when I was younger.",
+        "My mother had something similar years ago.",
+        "Is it there all the time or only now and then?",
+        "Mostly on the left side, I think.",
+        "It catches me when I bend down to the cupboard."
+    )
+
+    // ========================================================================
+    // GENERATION
+    // ========================================================================
+
+    fun all(): List<Consultation> = MINUTES.map { generate(it) }
+
+    /**
+     * A consultation of about [minutes] length at a typical speaking rate
+     */
+    fun generate(minutes: Int): Consultation {
+        val random = Random(SEED + minutes)
+        val words = WORDS_PER_MINUTE * minutes
+
+        // Clinical content grows with the visit, a few items per ten minutes
+        val scenes = mutableListOf<Scene>()
+        PRESCRIPTIONS.shuffled(random).take(minOf(PRESCRIPTIONS.size, 1 + minutes / 3))
+            .forEach { scenes += medicationScene(it, random) }
+        TESTS.shuffled(random).take(minOf(TESTS.size, 1 + minutes / 8))
+            .forEach { (test, sentence) -> scenes += Scene(listOf(sentence), test = test) }
+        SAFETY.shuffled(random).take(minOf(SAFETY.size, 1 + minutes / 8))
+            .forEach { scenes += Scene(listOf(it), safety = it) }
+        DISTRACTORS.shuffled(random).take(minOf(DISTRACTORS.size, minutes / 15))
+            .forEach { scenes += Scene(listOf(it)) }
+        scenes.shuffle(random)
+        val (timeframe, followUp) = FOLLOW_UPS[random.nextInt(FOLLOW_UPS.size)]
+
+        // Filler between the scenes up to the length, the follow-up last
+        val sentences = mutableListOf<String>()
+        val sceneWords = scenes.sumOf { scene -> scene.sentences.sumOf { wordCount(it) } } + wordCount(followUp)
+        val fillerWords = maxOf(0, words - sceneWords)
+        var fillerSoFar = 0
+        scenes.forEachIndexed { i, scene ->
+            // Spread the filler evenly; always at least one sentence between
+            // scenes so a trigger never carries over into the next scene
+            val target = fillerWords.toLong() * (i + 1) / (scenes.size + 1)
+            do {
+                val filler = FILLER[random.nextInt(FILLER.size)]
+                sentences += filler
+                fillerSoFar += wordCount(filler)
+            } while (fillerSoFar < target)
+            sentences += scene.sentences
+        }
+        while (fillerSoFar < fillerWords) {
+            val filler = FILLER[random.nextInt(FILLER.size)]
+            sentences += filler
+            fillerSoFar += wordCount(filler)
+        }
+        sentences += followUp
+
+        val expected = Expected(
+            medications = scenes.mapNotNull { it.medication },
+            tests = scenes.mapNotNull { it.test }.toSet(),
+            followUpTimeframe = timeframe,
+            safety = scenes.mapNotNull { it.safety }.map { normalizeQuote(it) }.toSet()
+        )
+        return Consultation("consultation-${minutes}min", minutes, segment(sentences, random), expected)
+    }
+
+    /**
+     * Whisper-like segments: one or two sentences each, timed by word count
+     */
+    private fun segment(sentences: List<String>, random: Random): List<TranscriptionSegmentData> {
+        val segments = mutableListOf<TranscriptionSegmentData>()
+        var timeMs = 0L
+        var i = 0
+        while (i < sentences.size) {
+            val count = if (i + 1 < sentences.size && random.nextBoolean()) 2 else 1
+            val text = sentences.subList(i, i + count).joinToString(" ")
+            val endMs = timeMs + wordCount(text) * MS_PER_WORD
+            segments += TranscriptionSegmentData(text, timeMs, endMs)
+            timeMs = endMs
+            i += count
+        }
+        return segments
+    }
+
+    private fun wordCount(text: String): Int = text.count { it == ' ' } + 1
+
+    /**
+     * A quote compared without case or its closing punctuation
+     */
+    fun normalizeQuote(quote: String): String = quote.trim().trimEnd('.', '?', '!').lowercase()
+}
@@ -0,0 +1,357 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import com.example.medicalappointmentcompanion.extraction.ExtractionCorpus.Consultation
+import com.example.medicalappointmentcompanion.model.MedicalExtraction
+import kotlinx.coroutines.runBlocking
+import org.json.JSONArray
+import org.json.JSONObject
+import org.junit.Assert.assertTrue
+import org.junit.ClassRule
+import org.junit.Test
+import java.io.File
+
+/**
+ * Extraction benchmark and accuracy harness, run on the host JVM
+ *
+ * Runs [SchemaGuidedExtractor] over the [ExtractionCorpus] consultations
+ * (1 to 60 minutes), once with the built-in medication list and once with
+ * the [MedicationLexicon] the app compiles (the shipped CSV,
+ * medication.lexicon, plus the built-in names), and reports per
+ * consultation:
+ * - latency: median whole-transcript extraction over [ITERATIONS] runs,
+ *   the slowest segment when streamed, and the per-stage split
+ * - allocations: JVM heap bytes allocated by one extraction, over every
+ *   thread (native allocations are not counted)
+ * - accuracy: precision and recall per category against the ground truth,
+ *   and per medication field (dosage, frequency, duration)
+ *
+ * The report is written as JSON (extraction.harness.report). If a
+ * baseline report exists (extraction.harness.baseline), any precision or
+ * recall below it fails the test and latency changes are listed, so an
+ * extraction change is checked against the numbers before it.
+ *
+ * Needs the host libmedextract, which the test task builds first (see
+ * the README).
+ */
+class ExtractionHarnessTest {
+
+    companion object {
+        @ClassRule
+        @JvmField
+        val library = HostLibraryRule()
+
+        private const val ITERATIONS = 7
+        private const val ACCURACY_TOLERANCE = 0.005
+
+        // Reported as a change, not a failure: shared machines are noisy
+        private const val LATENCY_CHANGE = 1.25
+    }
+
+    @Test
+    fun extractionHarness() = runBlocking<Unit> {
+        val corpus = ExtractionCorpus.all()
+        val report = JSONObject()
+            .put("iterations", ITERATIONS)
+            .put("timestamp", System.currentTimeMillis())
+
+        val configs = JSONObject()
+        configs.put("builtin", runConfig(corpus))
+
+        val csv = File(checkNotNull(System.getProperty("medication.lexicon")) { "medication.lexicon not set" })
+        val lexiconFile = File.createTempFile("harness", ".mlex")
+        try {
+            val compiled = csv.inputStream().use { input ->
+                MedicationLexicon.compileWithBuiltIn(input, lexiconFile, File.createTempFile("harness", ".csv"))
+            }
+            check(compiled) { "Failed to compile $csv with the built-in names" }
+            MedicationLexicon.open(lexiconFile)!!.use { lexicon ->
+                SchemaGuidedExtractor.useLexicon(lexicon)
+                try {
+                    configs.put("lexicon", runConfig(corpus))
+                } finally {
+                    SchemaGuidedExtractor.useLexicon(null)
+                }
+            }
+        } finally {
+            lexiconFile.delete()
+        }
+        report.put("configs", configs)
+
+        val regressions = mutableListOf<String>()
+        val changes = mutableListOf<String>()
+        System.getProperty("extraction.harness.baseline")?.let { File(it) }?.takeIf { it.exists() }?.let {
+            compare(JSONObject(it.readText()), report, regressions, changes)
+        }
+        report.put("regressions", JSONArray(regressions))
+        report.put("latencyChanges", JSONArray(changes))
+
+        val out = File(System.getProperty("extraction.harness.report") ?: "build/reports/extraction-harness.json")
+        out.parentFile?.mkdirs()
+        out.writeText(report.toString(2))
+        println(summary(report))
+        println("Extraction harness report: ${out.absolutePath}")
+
+        assertTrue("Accuracy below baseline:\n" + regressions.joinToString("\n"), regressions.isEmpty())
+    }
+
+    // ========================================================================
+    // RUNS
+    // ========================================================================
+
+    private suspend fun runConfig(corpus: List<Consultation>): JSONObject {
+        val consultations = JSONArray()
+        val totals = Counts()
+        for (consultation in corpus) {
+            val result = runConsultation(consultation, totals)
+            consultations.put(result)
+        }
+        return JSONObject()
+            .put("consultations", consultations)
+            .put("accuracy", totals.toJson())
+    }
+
+    private suspend fun runConsultation(consultation: Consultation, totals: Counts): JSONObject {
+        val segments = consultation.segments
+
+        // Warm-up builds the matchers and the lazy lists
+        SchemaGuidedExtractor.extract(segments)
+
+        val times = DoubleArray(ITERATIONS)
+        var extraction: MedicalExtraction? = null
+        for (i in 0 until ITERATIONS) {
+            val start = System.nanoTime()
+            extraction = SchemaGuidedExtractor.extract(segments)
+            times[i] = (System.nanoTime() - start) / 1e6
+        }
+        times.sort()
+
+        val allocatedBefore = allocatedBytes()
+        SchemaGuidedExtractor.extract(segments)
+        val allocated = if (allocatedBefore < 0) -1L else allocatedBytes() - allocatedBefore
+
+        // Streamed one segment at a time, as a transcription commits them
+        val streamed = IncrementalExtractor()
+        var slowestSegmentMs = 0.0
+        for (segment in segments) {
+            val start = System.nanoTime()
+            streamed.addSegment(segment)
+            slowestSegmentMs = maxOf(slowestSegmentMs, (System.nanoTime() - start) / 1e6)
+        }
+        streamed.finish()
+        val timings = streamed.timings
+
+        val counts = Counts()
+        score(extraction!!, consultation.expected, counts)
+        totals.add(counts)
+
+        return JSONObject()
+            .put("id", consultation.id)
+            .put("minutes", consultation.minutes)
+            .put("chars", consultation.chars)
+            .put("segments", segments.size)
+            .put("extractMs", times[ITERATIONS / 2])
+            .put("extractMsMin", times[0])
+            .put("extractMsMax", times[ITERATIONS - 1])
+            .put("allocatedBytes", allocated)
+            .put("streamedTotalMs", timings.totalMs.toDouble())
+            .put("streamedSlowestSegmentMs", slowestSegmentMs)
+            .put("stagesMs", JSONObject()
+                .put("scan", timings.scanMs.toDouble())
+                .put("medications", timings.medicationsMs.toDouble())
+                .put("tests", timings.testsMs.toDouble())
+                .put("followUp", timings.followUpMs.toDouble())
+                .put("safety", timings.safetyMs.toDouble())
+                .put("notes", timings.notesMs.toDouble()))
+            .put("accuracy", counts.toJson())
+    }
+
+    /**
+     * Heap bytes allocated so far by every live thread (the extraction
+     * stages fan out over Dispatchers.Default), or -1 if the JVM can't say.
+     * Looked up at run time: android.jar has no java.lang.management.
+     */
+    private fun allocatedBytes(): Long = try {
+        val bean = Class.forName("java.lang.management.ManagementFactory")
+            .getMethod("getThreadMXBean").invoke(null)
+        val beanClass = Class.forName("com.sun.management.ThreadMXBean")
+        val ids = beanClass.getMethod("getAllThreadIds").invoke(bean) as LongArray
+        val bytes = beanClass.getMethod("getThreadAllocatedBytes", LongArray::class.java).invoke(bean, ids) as LongArray
+        bytes.filter { it > 0 }.sum()
+    } catch (e: ReflectiveOperationException) {
+        -1
+    }
+
+    // ========================================================================
+    // SCORING
+    // ========================================================================
+
+    private class Count(var tp: Int = 0, var fp: Int = 0, var fn: Int = 0) {
+        fun add(other: Count) {
+            tp += other.tp
+            fp += other.fp
+            fn += other.fn
+        }
+
+        fun toJson(): JSONObject = JSONObject()
+            .put("tp", tp)
+            .put("fp", fp)
+            .put("fn", fn)
+            .put("precision", if (tp + fp == 0) 1.0 else tp.toDouble() / (tp + fp))
+            .put("recall", if (tp + fn == 0) 1.0 else tp.toDouble() / (tp + fn))
+    }
+
+    private class Counts {
+        val categories = linkedMapOf(
+            "medications" to Count(), "dosage" to Count(), "frequency" to Count(), "duration" to Count(),
+            "tests" to Count(), "followUp" to Count(), "followUpTimeframe" to Count(), "safety" to Count()
+        )
+
+        operator fun get(category: String): Count = categories.getValue(category)
+
+        fun add(other: Counts) {
+            for ((category, count) in categories) count.add(other[category])
+        }
+
+        fun toJson(): JSONObject = JSONObject().also { json ->
+            for ((category, count) in categories) json.put(category, count.toJson())
+        }
+    }
+
+    private fun score(actual: MedicalExtraction, expected: ExtractionCorpus.Expected, counts: Counts) {
+        // Medications by name, then each field of the ones found
+        val expectedByName = expected.medications.associateBy { it.name }
+        val found = mutableSetOf<String>()
+        for (medication in actual.medicationInstructions) {
+            val name = medication.medicineName.lowercase()
+            val truth = expectedByName[name]
+            if (truth == null || !found.add(name)) {
+                counts["medications"].fp++
+                continue
+            }
+            counts["medications"].tp++
+            scoreField(medication.dosage, truth.dosage, counts["dosage"])
+            scoreField(medication.frequency, truth.frequency, counts["frequency"])
+            scoreField(medication.duration, truth.duration, counts["duration"])
+        }
+        for (truth in expected.medications) {
+            if (truth.name in found) continue
+            counts["medications"].fn++
+            if (truth.dosage != null) counts["dosage"].fn++
+            if (truth.frequency != null) counts["frequency"].fn++
+            if (truth.duration != null) counts["duration"].fn++
+        }
+
+        scoreSet(actual.testsAndReferrals.map { it.testOrReferralType.lowercase() }, expected.tests, counts["tests"])
+        scoreSet(
+            actual.safetyAdvice.map { ExtractionCorpus.normalizeQuote(it.warning) },
+            expected.safety, counts["safety"]
+        )
+
+        val followUp = actual.followUp
+        when {
+            followUp != null && expected.followUpTimeframe != null -> {
+                counts["followUp"].tp++
+                scoreField(followUp.timeframe, expected.followUpTimeframe, counts["followUpTimeframe"])
+            }
+            followUp != null -> counts["followUp"].fp++
+            expected.followUpTimeframe != null -> {
+                counts["followUp"].fn++
+                counts["followUpTimeframe"].fn++
+            }
+        }
+    }
+
+    private fun scoreSet(actual: List<String>, expected: Set<String>, count: Count) {
+        val found = actual.toSet()
+        count.tp += found.count { it in expected }
+        count.fp += actual.size - found.count { it in expected }
+        count.fn += expected.count { it !in found }
+    }
+
+    private fun scoreField(actual: String?, expected: String?, count: Count) {
+        val value = actual?.trim()?.lowercase()
+        when {
+            value != null && value == expected -> count.tp++
+            value != null -> {
+                count.fp++
+                if (expected != null) count.fn++
+            }
+            expected != null -> count.fn++
+        }
+    }
+
+    // ========================================================================
+    // REPORTING
+    // ========================================================================
+
+    /**
+     * Precision or recall below the baseline's is a regression; a median
+     * latency further than LATENCY_CHANGE either way is a change
+     */
+    private fun compare(baseline: JSONObject, report: JSONObject, regressions: MutableList<String>, changes: MutableList<String>) {
+        val baseConfigs = baseline.getJSONObject("configs")
+        val configs = report.getJSONObject("configs")
+        for (config in configs.keys()) {
+            if (!baseConfigs.has(config)) continue
+            val base = baseConfigs.getJSONObject(config)
+            val current = configs.getJSONObject(config)
+
+            val baseAccuracy = base.getJSONObject("accuracy")
+            val accuracy = current.getJSONObject("accuracy")
+            for (category in accuracy.keys()) {
+                if (!baseAccuracy.has(category)) continue
+                for (metric in listOf("precision", "recall")) {
+                    val was = baseAccuracy.getJSONObject(category).getDouble(metric)
+                    val now = accuracy.getJSONObject(category).getDouble(metric)
+                    if (now < was - ACCURACY_TOLERANCE) {
+                        regressions += String.format("%s %s %s: %.3f -> %.3f", config, category, metric, was, now)
+                    }
+                }
+            }
+
+            val baseRuns = base.getJSONArray("consultations")
+            val runs = current.getJSONArray("consultations")
+            for (i in 0 until minOf(baseRuns.length(), runs.length())) {
+                val was = baseRuns.getJSONObject(i)
+                val now = runs.getJSONObject(i)
+                if (was.getString("id") != now.getString("id")) continue
+                val ratio = now.getDouble("extractMs") / was.getDouble("extractMs").coerceAtLeast(1e-3)
+                if (ratio > LATENCY_CHANGE || ratio < 1 / LATENCY_CHANGE) {
+                    changes += String.format(
+                        "%s %s: %.2f ms -> %.2f ms (%.2fx)",
+                        config, now.getString("id"), was.getDouble("extractMs"), now.getDouble("extractMs"), ratio
+                    )
+                }
+            }
+        }
+    }
+
+    private fun summary(report: JSONObject): String = buildString {
+        val configs = report.getJSONObject("configs")
+        for (config in configs.keys()) {
+            val current = configs.getJSONObject(config)
+            append("[$config]\n")
+            val runs = current.getJSONArray("consultations")
+            for (i in 0 until runs.length()) {
+                val run = runs.getJSONObject(i)
+                append(String.format(
+                    "  %2d min: extract %.2f ms, slowest segment %.3f ms, %d KB allocated\n",
+                    run.getInt("minutes"), run.getDouble("extractMs"),
+                    run.getDouble("streamedSlowestSegmentMs"), run.getLong("allocatedBytes") / 1024
+                ))
+            }
+            val accuracy = current.getJSONObject("accuracy")
+            for (category in accuracy.keys()) {
+                val count = accuracy.getJSONObject(category)
+                append(String.format(
+                    "  %-18s precision %.3f, recall %.3f\n",
+                    category, count.getDouble("precision"), count.getDouble("recall")
+                ))
+            }
+        }
+        for (key in listOf("regressions", "latencyChanges")) {
+            val list = report.getJSONArray(key)
+            for (i in 0 until list.length()) append("$key: ${list.getString(i)}\n")
+        }
+    }
+}
@@ -0,0 +1,68 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.ClassRule
+import org.junit.Test
+
+/**
+ * Approximate medication matching without a lexicon: a mis-transcribed
+ * name is still found, but a substring straddling words is not a name
+ *
+ * Needs the host libmedextract, which the test task builds first.
+ */
+class FuzzyMedicationMatchTest {
+
+    companion object {
+        @ClassRule
+        @JvmField
+        val library = HostLibraryRule()
+
+        // test_transcripts/synthetic_medical_transcripts.md, transcript 1
+        private const val TRANSCRIPT_1 =
+            "Right, so based on your symptoms, I think you have a chest infection. " +
+            "I'm going to prescribe you amoxicillin. " +
+            "Take amoxicillin 500 milligrams three times a day for seven days. " +
+            "Make sure you take it with food to avoid stomach problems. " +
+            "If you develop a rash or have trouble breathing, stop taking it immediately and come back to see me. " +
+            "If your symptoms don't improve after three days, or if you develop a fever, come back. " +
+            "Otherwise, you should start feeling better within a few days. Any questions?"
+    }
+
+    private fun medications(transcript: String): List<String> = runBlocking {
+        SchemaGuidedExtractor.extract(transcript).medicationInstructions.map { it.medicineName.lowercase() }
+    }
+
+    @Test
+    fun rashWarningIsNotEvorel() {
+        // "develop a rash" was one edit from "evorel" as a substring
+        assertEquals(
+            emptyList<String>(),
+            medications("If you develop a rash or have trouble breathing, stop taking it immediately.")
+        )
+    }
+
+    @Test
+    fun improveAfterIsNotProvera() {
+        // "improve after" holds "proveaf", one edit from "provera"
+        assertEquals(
+            emptyList<String>(),
+            medications(
+                "I'm going to prescribe you something for that. " +
+                "If your symptoms don't improve after three days, or if you develop a fever, come back."
+            )
+        )
+    }
+
+    @Test
+    fun transcriptOneHasOnlyAmoxicillin() {
+        assertEquals(listOf("amoxicillin"), medications(TRANSCRIPT_1))
+    }
+
+    @Test
+    fun misTranscribedNamesStillMatch() {
+        assertEquals(listOf("ibuprofen"), medications("Take ibuprofin 400 mg three times daily."))
+        assertEquals(listOf("sertraline"), medications("I'm going to start you on sertralin."))
+        assertEquals(listOf("amoxicillin"), medications("Take a moxa cillin 500 milligrams three times a day."))
+    }
+}
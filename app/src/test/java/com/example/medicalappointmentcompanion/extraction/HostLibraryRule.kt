@@ -0,0 +1,32 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import org.junit.rules.ExternalResource
+
+/**
+ * Loads the host-built libmedextract before a test class runs
+ *
+ * The Gradle test task builds it first (buildHostExtraction), so a missing
+ * library is a broken build, not a reason to skip: the class fails with
+ * where the library was looked for.
+ *
+ * ```
+ * companion object {
+ *     @ClassRule @JvmField val library = HostLibraryRule()
+ * }
+ * ```
+ */
+class HostLibraryRule : ExternalResource() {
+
+    override fun before() {
+        try {
+            System.loadLibrary("medextract")
+        } catch (e: UnsatisfiedLinkError) {
+            throw AssertionError(
+                "Host libmedextract not found on java.library.path " +
+                    "(${System.getProperty("java.library.path")}); " +
+                    "build it with ./gradlew :app:buildHostExtraction (see README)",
+                e
+            )
+        }
+    }
+}
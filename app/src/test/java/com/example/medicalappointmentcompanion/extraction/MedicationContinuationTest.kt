@@ -0,0 +1,47 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.ClassRule
+import org.junit.Test
+
+/**
+ * Details in the sentence after a medication is named are only taken for
+ * it when the sentence refers back to it
+ *
+ * Needs the host libmedextract, which the test task builds first.
+ */
+class MedicationContinuationTest {
+
+    companion object {
+        @ClassRule
+        @JvmField
+        val library = HostLibraryRule()
+
+        private const val NAMED = "I'm going to start you on ramipril."
+    }
+
+    @Test
+    fun referenceBackContinuesTheMedication() = runBlocking {
+        val details = "Take it once a day."
+        val medications = SchemaGuidedExtractor.extract("$NAMED $details").medicationInstructions
+        assertEquals(1, medications.size)
+
+        val ramipril = medications[0]
+        assertEquals("once a day", ramipril.frequency)
+        assertEquals("$NAMED $details", ramipril.verbatimQuote)
+    }
+
+    @Test
+    fun unrelatedDetailsDoNotContinueTheMedication() = runBlocking {
+        val unrelated = "My father was on 20 milligrams twice a day for years."
+        val medications = SchemaGuidedExtractor.extract("$NAMED $unrelated").medicationInstructions
+        assertEquals(1, medications.size)
+
+        val ramipril = medications[0]
+        assertNull(ramipril.dosage)
+        assertNull(ramipril.frequency)
+        assertEquals(NAMED, ramipril.verbatimQuote)
+    }
+}
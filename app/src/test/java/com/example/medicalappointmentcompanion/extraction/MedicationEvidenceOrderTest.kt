@@ -0,0 +1,36 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import kotlinx.coroutines.runBlocking
+import org.junit.Assert.assertEquals
+import org.junit.ClassRule
+import org.junit.Test
+
+/**
+ * A medication mentioned before it is prescribed is merged into the
+ * prescription's record; its quote and evidence still come first
+ *
+ * Needs the host libmedextract, which the test task builds first.
+ */
+class MedicationEvidenceOrderTest {
+
+    companion object {
+        @ClassRule
+        @JvmField
+        val library = HostLibraryRule()
+
+        private const val EARLIER = "Ramipril once a day has helped your blood pressure."
+        private const val PRESCRIBED = "I'm going to prescribe ramipril 10 milligrams."
+    }
+
+    @Test
+    fun earlierMentionIsQuotedFirst() = runBlocking {
+        val medications = SchemaGuidedExtractor.extract("$EARLIER $PRESCRIBED").medicationInstructions
+        assertEquals(1, medications.size)
+
+        val ramipril = medications[0]
+        assertEquals("$EARLIER $PRESCRIBED", ramipril.verbatimQuote)
+        assertEquals(listOf(0, EARLIER.length + 1), ramipril.evidence.map { it.offset })
+        assertEquals("once a day", ramipril.frequency)
+        assertEquals("10 milligrams", ramipril.dosage)
+    }
+}
@@ -0,0 +1,26 @@
+package com.example.medicalappointmentcompanion.extraction
+
+import org.junit.Assert.assertEquals
+import org.junit.Test
+import java.io.File
+
+/**
+ * batch_transcribe prompts with tools/medication_vocabulary.txt so that its
+ * transcripts match the app's; the file must list the app's vocabulary
+ * prompt terms, in order
+ */
+class MedicationVocabularyTest {
+
+    @Test
+    fun toolVocabularyMatchesApp() {
+        val file = File(System.getProperty("medication.vocabulary") ?: "src/main/cpp/tools/medication_vocabulary.txt")
+        val terms = file.readLines()
+            .map { it.trim() }
+            .filter { it.isNotEmpty() && !it.startsWith("#") }
+        assertEquals(
+            "Regenerate ${file.name} from SchemaGuidedExtractor.medicationVocabulary",
+            SchemaGuidedExtractor.medicationVocabulary,
+            terms
+        )
+    }
+}